@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * Vertical-counter debouncer for up to 32 inputs packed in one word.
+ *
+ * Bit i of c1:c0 is a 2-bit counter for input i: the number of consecutive
+ * samples that differed from the stable state. A sample equal to the stable
+ * state clears it; the third differing sample in a row flips the stable bit
+ * and clears it. That is the old per-input `changeCount >= 3` rule, done for
+ * every input with a handful of logic instructions and no branches.
+ */
+
+#define VDEB_SAMPLES  3u    // consecutive differing samples needed (fixed by the 2-bit counter)
+
+typedef struct {
+    uint32_t stable;        // debounced state, bit i = input i
+    uint32_t c0, c1;        // counter bit 0 / bit 1 of each input
+} VDebounce;
+
+static inline void vdeb_init(VDebounce *d, uint32_t sample) {
+    d->stable = sample;
+    d->c0 = d->c1 = 0;
+}
+
+/* Feed one sample; returns the inputs whose stable state just changed */
+static inline uint32_t vdeb_update(VDebounce *d, uint32_t sample) {
+    uint32_t delta = sample ^ d->stable;        // differs from stable: count, else clear
+    uint32_t c1 = (d->c1 ^ d->c0) & delta;
+    uint32_t c0 = ~d->c0 & delta;
+    uint32_t changed = c1 & c0;                 // counter reached 3
+    d->stable ^= changed;
+    d->c0 = c0 & ~changed;
+    d->c1 = c1 & ~changed;
+    return changed;
+}
+
+/* Set the inputs in mask to their level in sample and restart their count
+ * (a change accepted elsewhere, e.g. by the EXTI front end) */
+static inline void vdeb_accept(VDebounce *d, uint32_t mask, uint32_t sample) {
+    d->stable = (d->stable & ~mask) | (sample & mask);
+    d->c0 &= ~mask;
+    d->c1 &= ~mask;
+}
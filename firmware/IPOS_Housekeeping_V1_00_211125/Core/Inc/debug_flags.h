@@ -5,5 +5,17 @@
 
 extern uint8_t verboseLogging;
 
+#ifndef USB_CMD_RX_SIZE
+#define USB_CMD_RX_SIZE     256u    // received bytes not yet parsed; MUST be a power of two
+#endif
+#define USB_CMD_LINE_MAX    64u     // longest command line
+#ifndef USB_CMD_RETRY_MS
+#define USB_CMD_RETRY_MS    50u     // vTaskUsbLogger queue wait; then UsbCommand_Retry()
+#endif
+
+void UsbCommand_Receive(const uint8_t *buf, uint32_t len);   // CDC_Receive_FS (ISR)
+void UsbCommand_Poll(void);                                  // vTaskUsbLogger, on EVT_USB_RX
+void UsbCommand_Retry(void);                                 // vTaskUsbLogger, on queue timeout
 void UsbCommand_Process(const char *cmd);
+void UsbCommand_PrintHelp(void);
 
@@ -0,0 +1,48 @@
+/**
+ * @addtogroup input_handling
+ * @{
+ * @file error_rules.h
+ * @brief The safety rule table and the rule vector it is evaluated against.
+ *
+ * errorRules[] (error_rules.c) is data for sr_eval() (safety_rules.h). The
+ * rule vector is the debounced inputs (INPUT_BIT()) plus the software
+ * conditions below; CheckErrorRules() in inputs.c builds it and applies the
+ * rule actions. The table has no other dependencies, so the host tests
+ * replay it against input traces.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "inputs.h"
+#include "safety_rules.h"
+
+/* Software conditions packed above the inputs in the rule vector */
+enum {
+    RULE_IN_SW_LATCH = NUM_INPUTS,  ///< swLatchForceError
+    RULE_IN_TEMP_FAULT,             ///< tempFaultActive (unless the thermo check is bypassed)
+    RULE_IN_COUNT
+};
+_Static_assert(RULE_IN_COUNT <= 32, "rule vector is one 32-bit word");
+
+#define SAFETY_INPUTS   (INPUT_BIT(INPUT_DOOR) | INPUT_BIT(INPUT_ESTOP) | \
+                         INPUT_BIT(INPUT_KEY)  | INPUT_BIT(INPUT_BDO))
+#define RELAY_INPUTS    (INPUT_BIT(INPUT_RELAY1_ON) | INPUT_BIT(INPUT_RELAY2_ON))
+#define LATCH_ERR_INPUTS (INPUT_BIT(INPUT_DOOR_LATCH_ERR) | INPUT_BIT(INPUT_ESTOP_LATCH_ERR) | \
+                         INPUT_BIT(INPUT_KEY_LATCH_ERR)  | INPUT_BIT(INPUT_BDO_LATCH_ERR) |   \
+                         INPUT_BIT(INPUT_RELAY_LATCH_ERR))
+#define POWER_INPUTS    (INPUT_BIT(INPUT_12V_PWR_GOOD) | INPUT_BIT(INPUT_24V_PWR_GOOD) | \
+                         INPUT_BIT(INPUT_12V_FUSE_GOOD))
+
+/** Index of each rule in errorRules[] (bit in the rule state masks) */
+enum {
+    RULE_DOOR_RELAYS,
+    RULE_RELAY_CONTACTS,
+    RULE_LATCH,
+    RULE_POWER,
+    RULE_TEMPERATURE,
+    NUM_ERROR_RULES
+};
+
+extern const SafetyRule errorRules[NUM_ERROR_RULES];
+
+/** @} */
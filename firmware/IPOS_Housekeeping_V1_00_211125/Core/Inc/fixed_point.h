@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Small helpers for signed fixed-point values with `frac` fractional bits
+ * (Q.2 = 0.25 units, Q.4 = 0.0625 units), so temperatures can be compared
+ * and printed without float or the soft-float printf path.
+ */
+
+#define FX_STR_MAX  12u     // "-8191.9375" + NUL
+
+/* Value of a whole number in Q.frac, for thresholds: FX_FROM_INT(60, 2) == 240 */
+#define FX_FROM_INT(n, frac)  ((int32_t)(n) * (1L << (frac)))
+
+/* Round to the nearest integer, halves away from zero (as lroundf()) */
+static inline int32_t fx_round(int32_t v, uint8_t frac) {
+    if (frac == 0)
+        return v;
+    int32_t half = 1L << (frac - 1u);
+    return v < 0 ? -((-v + half) >> frac) : (v + half) >> frac;
+}
+
+/*
+ * Format v as decimal text with `decimals` digits after the point, the same
+ * text printf("%.*f") gives for the equivalent float: exact ties round to
+ * even. frac <= 8 and decimals <= 4. Returns out, for use as a %s argument.
+ */
+static inline const char *fx_format(char *out, size_t size, int32_t v, uint8_t frac, uint8_t decimals) {
+    static const uint16_t pow10[] = { 1, 10, 100, 1000, 10000 };
+    uint32_t mag = v < 0 ? (uint32_t)-v : (uint32_t)v;
+    uint32_t scaled = mag * pow10[decimals];        // < 2^31 for |v| < 2^17
+    uint32_t q = scaled >> frac;
+
+    if (frac) {
+        uint32_t rem  = scaled & ((1u << frac) - 1u);
+        uint32_t half = 1u << (frac - 1u);
+        if (rem > half || (rem == half && (q & 1u)))
+            q++;
+    }
+
+    uint32_t ip = q / pow10[decimals];
+    uint32_t fp = q % pow10[decimals];
+    if (decimals)
+        snprintf(out, size, "%s%lu.%0*lu", v < 0 ? "-" : "", (unsigned long)ip, (int)decimals, (unsigned long)fp);
+    else
+        snprintf(out, size, "%s%lu", v < 0 ? "-" : "", (unsigned long)ip);
+    return out;
+}
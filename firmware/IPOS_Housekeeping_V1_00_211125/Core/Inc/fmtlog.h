@@ -0,0 +1,103 @@
+/**
+ * @addtogroup fmtlog
+ * @{
+ * @file fmtlog.h
+ * @brief Deferred-format logging: format ID + raw arguments, formatted on the host.
+ *
+ * `FLOG("fault at %d mA", ma)` does not format anything. The format string
+ * is placed in the `.ipos_fmt` section, which the linker script marks
+ * `(INFO)`: it stays in the ELF file but is never loaded into flash. The
+ * string's offset in that section is its ID. At run time the call stores
+ * the ID, the millisecond tick and the arguments as 32-bit words in a RAM
+ * ring, which takes a few dozen cycles and no vsnprintf().
+ *
+ * While `STREAM ON` is active the ring is sent as @ref TLM_REC_FMT records;
+ * `tools/telemetry_decode.py --elf firmware.elf` looks the IDs up in the
+ * same ELF and prints the text. Entries logged before streaming (boot, ABCC
+ * start-up) wait in the ring until then.
+ *
+ * Argument rules (each argument becomes one word):
+ * - integers, enums and pointers are truncated to 32 bits (no `%ll`);
+ * - `float` and `double` are stored as `float` bits, so `%f` works;
+ * - `%s` stores the pointer; the host reads the string from the ELF, so
+ *   only strings in flash (literals, const tables) can be printed.
+ *
+ * Entry layout in the ring and in the record (little-endian words):
+ *
+ * | Word | Content |
+ * |------|---------|
+ * | 0 | bits 0–19 format ID, 20–23 argument count, 24–27 level (0 = none) |
+ * | 1 | HAL tick (ms) |
+ * | 2.. | arguments |
+ */
+
+#pragma once
+#include <stdint.h>
+
+#ifndef FMTLOG_RING_WORDS
+#define FMTLOG_RING_WORDS   1024u   // MUST be a power of two (4 KB)
+#endif
+#define FMTLOG_MAX_ARGS     8u
+
+/** @brief Optional level carried in the entry header (ABCC severities + 1). */
+enum {
+    FMTLOG_LVL_NONE    = 0,
+    FMTLOG_LVL_FATAL   = 1,
+    FMTLOG_LVL_ERROR   = 2,
+    FMTLOG_LVL_WARNING = 3,
+    FMTLOG_LVL_INFO    = 4,
+    FMTLOG_LVL_DEBUG   = 5,
+};
+
+void     FmtLog_Write(uint32_t hdr, ...);
+void     FmtLog_Drain(void);
+uint32_t FmtLog_Dropped(void);
+
+/** @brief Log with a level; `fmt` must be a string literal. */
+#define FLOG_LEVEL(level, fmt, ...) do {                                        \
+    static const char flog_fmt_[] __attribute__((section(".ipos_fmt"), used)) = fmt; \
+    FmtLog_Write(FLOG_HDR_(flog_fmt_, FLOG_NARGS_(__VA_ARGS__), level)          \
+                 FLOG_MAP_(__VA_ARGS__));                                       \
+} while (0)
+
+/** @brief Log without a level; `fmt` must be a string literal. */
+#define FLOG(...)   FLOG_LEVEL(FMTLOG_LVL_NONE, __VA_ARGS__)
+
+#define FLOG_STR_(x)    FLOG_STR2_(x)
+#define FLOG_STR2_(x)   #x
+
+/* ---- implementation helpers ---- */
+
+static inline uint32_t flog_f32_(float f) {
+    union { float f; uint32_t u; } c = { f };
+    return c.u;
+}
+
+/* Every branch must compile for every type, hence the inner _Generic */
+#define FLOG_ARG_(x) _Generic((x),                                              \
+    float:   flog_f32_(_Generic((x), float: (x), double: (x), default: 0.0f)),  \
+    double:  flog_f32_((float)_Generic((x), float: (x), double: (x), default: 0.0)), \
+    default: (uint32_t)(uintptr_t)(x))
+
+/* "+" rather than "|" lets the linker fold the whole header into one
+ * relocated constant; the format section must stay below 1 MB */
+#define FLOG_HDR_(fmt, n, level) \
+    ((uint32_t)(uintptr_t)(fmt) + (((uint32_t)(n) << 20) | ((uint32_t)(level) << 24)))
+
+#define FLOG_NARGS_(...)  FLOG_NARGS2_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define FLOG_NARGS2_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#define FLOG_CAT_(a, b)   FLOG_CAT2_(a, b)
+#define FLOG_CAT2_(a, b)  a##b
+#define FLOG_MAP_(...)    FLOG_CAT_(FLOG_MAP_, FLOG_NARGS_(__VA_ARGS__))(__VA_ARGS__)
+#define FLOG_MAP_0()
+#define FLOG_MAP_1(a)       , FLOG_ARG_(a)
+#define FLOG_MAP_2(a, ...)  , FLOG_ARG_(a) FLOG_MAP_1(__VA_ARGS__)
+#define FLOG_MAP_3(a, ...)  , FLOG_ARG_(a) FLOG_MAP_2(__VA_ARGS__)
+#define FLOG_MAP_4(a, ...)  , FLOG_ARG_(a) FLOG_MAP_3(__VA_ARGS__)
+#define FLOG_MAP_5(a, ...)  , FLOG_ARG_(a) FLOG_MAP_4(__VA_ARGS__)
+#define FLOG_MAP_6(a, ...)  , FLOG_ARG_(a) FLOG_MAP_5(__VA_ARGS__)
+#define FLOG_MAP_7(a, ...)  , FLOG_ARG_(a) FLOG_MAP_6(__VA_ARGS__)
+#define FLOG_MAP_8(a, ...)  , FLOG_ARG_(a) FLOG_MAP_7(__VA_ARGS__)
+
+/** @} */
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include "debounce.h"
+
+/*
+ * Timer-paced DMA oversampling of the input ports (input_dma.c), the
+ * alternative to the EXTI front end in input_edge.c.
+ *
+ * TIM8 requests one DMA2 transfer per port and period, copying each port's
+ * IDR into a circular buffer with no CPU involved. vTaskInputs processes
+ * the block collected since its last wake: a change is accepted once the
+ * pin has been steady for INPUT_OVERSAMPLE_SETTLE_MS, and a burst that
+ * returns to the old level is counted as a glitch, with its shortest pulse.
+ */
+
+#ifndef INPUT_OVERSAMPLE
+#define INPUT_OVERSAMPLE            0       // 0 = EXTI + 10 ms poll only; 1 = sample by DMA, EXTI + poll if it fails
+#endif
+#ifndef INPUT_OVERSAMPLE_HZ
+#define INPUT_OVERSAMPLE_HZ         10000u  // samples per second; MUST divide 1000000
+#endif
+#ifndef INPUT_OVERSAMPLE_DEPTH
+#define INPUT_OVERSAMPLE_DEPTH      256u    // samples per port buffer, power of two (25.6 ms at 10 kHz)
+#endif
+#ifndef INPUT_OVERSAMPLE_SETTLE_MS
+#define INPUT_OVERSAMPLE_SETTLE_MS  5u      // steady time before a change counts
+#endif
+#ifndef INPUT_OVERSAMPLE_BLOCK_MS
+#define INPUT_OVERSAMPLE_BLOCK_MS   2u      // longest gap between two blocks
+#endif
+#ifndef INPUT_OVERSAMPLE_STALL_MS
+#define INPUT_OVERSAMPLE_STALL_MS   10u     // no new sample for this long: stop, fall back to EXTI + poll
+#endif
+
+typedef struct {
+    uint32_t samples;       // samples processed per port
+    uint32_t overruns;      // blocks dropped because the task fell a buffer behind
+    uint32_t accepted;      // changes accepted
+    uint32_t glitches;      // bursts that settled back to the old level
+} InputDmaStats;
+
+typedef struct {
+    uint32_t edges;         // raw transitions seen
+    uint32_t glitches;      // rejected bursts
+    uint32_t minPulseUs;    // shortest time between two transitions, 0 = none yet
+} InputChatter;
+
+uint8_t  InputDma_Init(void);
+uint8_t  InputDma_Running(void);
+uint32_t InputDma_Update(VDebounce *d);
+uint32_t InputDma_TakeGlitches(void);
+uint32_t InputDma_TimeUs(uint32_t input);
+uint32_t InputDma_WaitTicks(uint32_t maxTicks);
+void     InputDma_GetStats(InputDmaStats *out);
+void     InputDma_GetChatter(uint32_t input, InputChatter *out);
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include "cmsis_os2.h"
+#include "debounce.h"
+
+/*
+ * Interrupt-driven front end for the safety inputs (input_edge.c).
+ *
+ * Both edges of the interlock and latch-error pins raise EXTI. The ISR
+ * stamps them with the DWT cycle counter, queues them and wakes
+ * vTaskInputs, which accepts a change once the pin has been quiet for
+ * INPUT_EDGE_SETTLE_MS. The 10 ms poll and its vertical counter keep
+ * running as a cross-check for every input.
+ */
+
+#ifndef INPUT_EDGE_SETTLE_MS
+#define INPUT_EDGE_SETTLE_MS    5u      // quiet time after the last edge before a change counts
+#endif
+#ifndef INPUT_EDGE_QUEUE_SIZE
+#define INPUT_EDGE_QUEUE_SIZE   256u    // bytes, 32 edges; MUST be a power of two
+#endif
+#define INPUT_EDGE_FLAG         0x0001u // thread flag set by the ISR
+
+typedef struct {
+    uint32_t edges;         // EXTI interrupts that reported an armed input
+    uint32_t overflows;     // edges lost to a full queue
+    uint32_t accepted;      // changes accepted from edges
+    uint32_t pollCaught;    // armed-input changes only the poll saw
+} InputEdgeStats;
+
+void     InputEdge_Init(osThreadId_t task);
+void     InputEdge_IRQHandler(void);
+void     EXTI9_5_IRQHandler(void);       // defined in input_edge.c (CubeMX does not own it)
+uint32_t InputEdge_Update(VDebounce *d);
+void     InputEdge_PollCheck(uint32_t polled);
+uint32_t InputEdge_TimeUs(uint32_t input);
+uint32_t InputEdge_WaitTicks(uint32_t maxTicks);
+void     InputEdge_GetStats(InputEdgeStats *out);
@@ -74,6 +74,29 @@ extern const char *inputNames[NUM_INPUTS];
 /** Current debounced logic state of each input. */
 extern uint8_t stableState[NUM_INPUTS];
 
+/** Where an input is wired (GPIO port and GPIO_PIN_x mask). */
+typedef struct {
+    GPIO_TypeDef *port;
+    uint16_t      pin;
+} InputPin;
+
+/** Pin of each input, from the CubeMX defines (InputName order). */
+extern const InputPin inputPins[NUM_INPUTS];
+
+/** Bit of an input in the vectors returned by Inputs_Sample() and friends. */
+#define INPUT_BIT(name)   (1UL << (name))
+
+/** Raw level of every input from one read of each GPIO port's IDR. */
+uint32_t Inputs_Sample(void);
+
+#define INPUT_MAX_PORTS  8u     // GPIOA..GPIOK on the F439; 5 are used today
+
+/** The distinct ports the inputs are on, in the order Inputs_Gather() expects. */
+uint32_t Inputs_Ports(GPIO_TypeDef *ports[INPUT_MAX_PORTS]);
+
+/** Input vector from IDR values captured elsewhere, one per Inputs_Ports() entry. */
+uint32_t Inputs_Gather(const uint32_t idr[]);
+
 
 // -----------------------------------------------------------------------------
 // Event System
@@ -94,7 +117,9 @@ typedef enum {
     EVT_FLASH_STATUS,
     EVT_FLASH_ID,
     EVT_FLASH_TEST,
-	EVT_HELP
+	EVT_HELP,
+    EVT_LINK_STATS,     ///< Print link health counters (newState = 1: clear afterwards)
+    EVT_USB_RX,         ///< USB command bytes received (UsbCommand_Poll())
 } InputEventType_t;
 
 
@@ -119,29 +144,10 @@ typedef struct {
     const char *msg;        /**< Associated message */
     uint8_t newState;       /**< New logic state if applicable */
     uint8_t input;          /**< Input index */
+    uint32_t t_us;          /**< EVT_INPUT_CHANGE from an edge: time of the first edge (µs), else 0 */
 } InputEvent_t;
 
 
-/**
- * @typedef ErrorConditionFn
- * @brief Function pointer type for evaluating fault conditions.
- * @return 1 if fault active, 0 if OK.
- */
-typedef uint8_t (*ErrorConditionFn)(void);
-
-/**
- * @struct ErrorConditionFn
- * @brief Structure representing a queued event for USB or logging output.
- */
-typedef struct {
-    ErrorConditionFn condition;
-    const char *msgActive;
-    const char *msgCleared;
-    uint8_t active;
-} ErrorRule_t;
-
-
-
 // -----------------------------------------------------------------------------
 // Task Prototypes
 // -----------------------------------------------------------------------------
@@ -157,7 +163,7 @@ void vTaskUsbLogger(void *argument);
 // -----------------------------------------------------------------------------
 
 void SetOutputsToKnownState(void);
-void SetLatchesToFaultState(void);
+void SetAllLatchesToFaultState(void);
 void PulseOutput(GPIO_TypeDef *port, uint16_t pin, uint32_t ms);
 void Print_AllInputs(void);
 void PrintTruPulseStatus(void);
@@ -180,8 +186,7 @@ uint8_t Input_GetState(InputName input);
 // Condition Evaluation Functions
 // -----------------------------------------------------------------------------
 
-uint8_t Cond_RelayContactsMatch(void);
-uint8_t Cond_LatchError(void);
+uint8_t Cond_TemperatureSafe(void);
 
 /**
  * @brief Return human-readable string for a given input’s state.
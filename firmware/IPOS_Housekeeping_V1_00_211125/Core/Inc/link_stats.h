@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Link health counters, kept by master_link (F4) and slave_link (M40).
+ *
+ * Each field has a single writer (link task / main loop, or the UART error
+ * ISR), so a reader may copy the block without a lock; a torn copy is at
+ * worst one event off.
+ *
+ * `rtt_hist[i]` counts round trips of i..i+1 buckets of LINK_RTT_BUCKET_US;
+ * the last bucket also takes everything slower. On the master a round trip
+ * is request queued -> tagged reply parsed (retransmitted requests are not
+ * sampled, their reply cannot be matched to one send). On the slave it is
+ * the previous poll -> reply queued, i.e. an upper bound on how long a
+ * request waited for the main loop plus its handling.
+ *
+ * The block is all uint32_t so it can be exported as a UINT32 array.
+ */
+#ifndef LINK_RTT_BUCKET_US
+#define LINK_RTT_BUCKET_US 100u
+#endif
+#ifndef LINK_RTT_BUCKETS
+#define LINK_RTT_BUCKETS   32u      // 0 .. 3.1 ms, last bucket open-ended
+#endif
+
+typedef struct {
+    uint32_t frames_rx;             // valid frames decoded
+    uint32_t frames_tx;             // frames handed to the TX queue
+    uint32_t resyncs;               // partial or invalid frames discarded by the parser
+    uint32_t overruns;              // UART overrun errors + RX DMA laps + bytes lost to a full RX ring
+    uint32_t uart_errors;           // HAL_UART_ErrorCallback invocations
+    uint32_t tx_dropped;            // frames refused by a full TX queue
+    uint32_t retries;               // retransmissions (master only)
+    uint32_t timeouts;              // requests given up after all retries (master only)
+    uint32_t rtt_max_us;            // slowest round trip seen
+    uint32_t rtt_hist[LINK_RTT_BUCKETS];
+} LinkStats;
+
+#define LINK_STATS_WORDS (sizeof(LinkStats) / sizeof(uint32_t))
+
+static inline void link_stats_clear(LinkStats *s) {
+    memset(s, 0, sizeof(*s));
+}
+
+/* Record one round trip */
+static inline void link_stats_rtt(LinkStats *s, uint32_t us) {
+    uint32_t i = us / LINK_RTT_BUCKET_US;
+    s->rtt_hist[(i < LINK_RTT_BUCKETS) ? i : (LINK_RTT_BUCKETS - 1u)]++;
+    if (us > s->rtt_max_us) s->rtt_max_us = us;
+}
@@ -47,6 +47,9 @@ void Log_EraseAll(void);
 #define RECS_PER_SECTOR (SECTOR_SIZE / REC_SIZE) /**< Records stored per 4KB sector */
 #define LOG_CAPACITY    (LOG_SECTORS * RECS_PER_SECTOR) /**< Total number of records */
 #define COMMIT_VAL      0x7E       /**< Commit marker written after record is valid */
+#ifndef LOG_DUMP_STALL_MS
+#define LOG_DUMP_STALL_MS 1000     /**< Log_Dump() gives up after the host reads nothing this long */
+#endif
 /** @} */
 
 /* -------------------------------------------------------------------------- */
@@ -132,6 +135,17 @@ int Log_ReadLastN(uint32_t n, LogRec *out, uint32_t max_out);
  */
 int Log_CountValid(void);
 
+/**
+ * @brief Stream the whole log to the USB host, oldest record first.
+ *
+ * Reads a sector's worth of records per SPI transaction and paces the
+ * output by the USB TX ring instead of fixed delays.
+ *
+ * @param binary 0 = text lines, 1 = @ref TLM_REC_LOGDUMP records
+ * @return Number of records sent
+ */
+uint32_t Log_Dump(uint8_t binary);
+
 /**
  * @brief FreeRTOS task responsible for writing queued log messages to flash.
  *
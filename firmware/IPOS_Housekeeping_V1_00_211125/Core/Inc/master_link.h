@@ -3,6 +3,9 @@
 #pragma once
 #include <stdint.h>
 #include "stm32f4xx_hal.h"
+#include "protocol.h"
+#include "link_stats.h"
+#include "cycle_sync.h"
 
 void master_link_init(UART_HandleTypeDef *huart);
 void master_link_start(void);
@@ -13,6 +16,37 @@ void master_link_attach_task_handle(void *task_handle);
 HAL_StatusTypeDef master_write_u16(uint8_t var_id, uint16_t value);
 HAL_StatusTypeDef master_read_u16 (uint8_t var_id);
 
+/* Batched variants: one frame / one round trip for up to PROTO_MAX_PAIRS variables */
+HAL_StatusTypeDef master_write_multi(const ProtoPair *pairs, uint8_t n);
+HAL_StatusTypeDef master_read_multi (const uint8_t *var_ids, uint8_t n);
+
+/* Pipelined variants: tagged, return immediately (HAL_BUSY when the window is full).
+ * Replies are matched by tag; overdue requests are retried, then reported via master_on_timeout(). */
+HAL_StatusTypeDef master_submit_write      (uint8_t var_id, uint16_t value);
+HAL_StatusTypeDef master_submit_read       (uint8_t var_id);
+HAL_StatusTypeDef master_submit_write_multi(const ProtoPair *pairs, uint8_t n);
+HAL_StatusTypeDef master_submit_read_multi (const uint8_t *var_ids, uint8_t n);
+uint8_t           master_inflight(void);
+
+/* Framing in use: PROTO_V1 until the slave accepts the HELLO offer, then PROTO_V2 */
+uint8_t master_link_version(void);
+
+/* Negotiated USART2 rate in bit/s (115200 until the slave confirms a faster one) */
+uint32_t master_link_baud(uint16_t *fallbacks);
+
+/* All sends above only queue the frame for TX DMA; this reports queue usage */
+void master_link_tx_stats(uint8_t *queued, uint8_t *high_water, uint16_t *dropped);
+
+/* Link health: frames, resyncs, overruns, retries, timeouts and RTT histogram */
+void master_link_get_stats(LinkStats *out);
+void master_link_clear_stats(void);   // also clears the cycle statistics
+
+/* Arrival interval and jitter of the slave's PD cycle markers (CMD_CYCLE) */
+void master_link_get_cycle_stats(CycleStats *out);
+
 /* App callbacks (weak) — called in TASK context */
 void master_on_ack (uint8_t var_id, uint16_t value);
 void master_on_data(uint8_t var_id, uint16_t value);
+void master_on_notify(uint8_t var_id, uint16_t value);   // unsolicited change pushed by the slave
+void master_on_timeout(uint8_t cmd, uint8_t var_id);
+void master_on_cycle(uint8_t seq, uint16_t period_us);   // new Profinet PD cycle on the slave
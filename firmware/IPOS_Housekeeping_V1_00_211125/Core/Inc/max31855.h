@@ -5,6 +5,7 @@
 #include "main.h"
 #include "cmsis_os.h"
 #include <stdint.h>
+#include "fixed_point.h"
 
 /* ---------------- Pin mapping ---------------- */
 #define MAX31855_SCK_GPIO_Port   GPIOB
@@ -16,13 +17,18 @@
 
 /* ---------------- Sampling and limits ---------------- */
 #define MAX31855_SAMPLE_PERIOD_MS   5000      // 5 seconds
-#define MAX31855_TEMP_MIN_C         0.0f     // °C lower limit
-#define MAX31855_TEMP_MAX_C         60.0f     // °C upper limit
+#define MAX31855_TEMP_MIN_C         0         // °C lower limit
+#define MAX31855_TEMP_MAX_C         60        // °C upper limit
+
+/* ---------------- Fixed-point units (see fixed_point.h) ---------------- */
+#define MAX31855_TC_FRAC            2         // tc_q2: 0.25 °C per LSB
+#define MAX31855_CJ_FRAC            4         // cj_q4: 0.0625 °C per LSB
+#define MAX31855_TC_FROM_C(c)       FX_FROM_INT(c, MAX31855_TC_FRAC)
 
 /* ---------------- Data structure ---------------- */
 typedef struct {
-    float tc_c;         // Thermocouple temperature (°C)
-    float cj_c;         // Cold-junction temperature (°C)
+    int16_t tc_q2;      // Thermocouple temperature, 0.25 °C units (raw 14-bit value)
+    int16_t cj_q4;      // Cold-junction temperature, 0.0625 °C units (raw 12-bit value)
     uint8_t fault;      // Fault bits [0=OC,1=SCG,2=SCV]
     uint8_t flag;       // Fault flag (1 = MAX31855 internal fault)
     uint8_t rangeFault; // 1 = Out-of-range temperature
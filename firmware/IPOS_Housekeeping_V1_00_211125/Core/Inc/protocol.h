@@ -18,36 +18,82 @@
 #define VAR_STATUS_ACTIVE   6   // Master writes (to PLC all active messages)
 #define VAR_STATUS_DEBUG_TRU   7   // Master writes (to PLC all debug status)
 
+/* Batched frames carry up to PROTO_MAX_PAIRS (var_id, value) pairs */
+#define PROTO_MAX_PAIRS     8u
+#define PROTO_MAX_FRAME     (5u + 3u * PROTO_MAX_PAIRS)   // STX CMD [TAG] N [VAR LSB MSB]*N ETX
+
+/* Optional transaction tag: CMD | PROTO_TAG_FLAG is followed by a TAG byte that
+ * the slave echoes in its reply, so replies can be matched out of order */
+#define PROTO_TAG_FLAG      0x40u
+
+/* Framing versions: v1 = STX..ETX, v2 = COBS + CRC16 between 0x00 delimiters.
+ * v2 carries CMD [TAG] body CRC16(LSB MSB); the delimiters give the length. */
+#define PROTO_V1            1u
+#define PROTO_V2            2u
+#define PROTO_V2_DELIM      0x00u
+#define PROTO_V2_MAX_WIRE   (PROTO_MAX_FRAME + 3u)        // 00 COBS(CMD..body CRC16) 00
+
 typedef enum {
-    CMD_READ  = 0x01u,
-    CMD_WRITE = 0x02u,
-    CMD_ACK   = 0x06u,
+    CMD_READ        = 0x01u,
+    CMD_WRITE       = 0x02u,
+    CMD_ACK         = 0x06u,
+    CMD_NOTIFY      = 0x08u,   // unsolicited slave -> master change notification
+    CMD_HELLO       = 0x09u,   // framing negotiation, always sent as v1
+    CMD_BAUD        = 0x0Au,   // baud-rate step request / answer (see baud_neg.h)
+    CMD_ECHO        = 0x0Bu,   // link check: the slave returns the frame unchanged
+    CMD_CYCLE       = 0x0Cu,   // slave -> master PD cycle marker (see cycle_sync.h)
+    CMD_READ_MULTI  = 0x11u,
+    CMD_WRITE_MULTI = 0x12u,
+    CMD_ACK_MULTI   = 0x16u,
+    CMD_NOTIFY_MULTI= 0x18u,   // slave -> master batch of changed registers
 } ProtoCmd;
 
+typedef struct {
+    uint8_t  var_id;
+    uint16_t value;
+} ProtoPair;
+
 typedef struct {
     uint8_t  cmd;
     uint8_t  var_id;
     uint16_t value;     // valid only if has_value==true
     bool     has_value; // true for WRITE/ACK and for READ reply on master
+    uint8_t  count;     // number of valid entries in pairs[] (multi frames only)
+    bool     tagged;    // frame carried a transaction tag
+    uint8_t  tag;       // valid only if tagged==true
+    ProtoPair pairs[PROTO_MAX_PAIRS];
 } ProtoFrame;
 
 /* Role selects the expected length for frames */
 typedef enum { ROLE_MASTER, ROLE_SLAVE } ProtoRole;
 
 typedef struct {
-    uint8_t  buf[8];
+    uint8_t  buf[PROTO_V2_MAX_WIRE];
     uint8_t  idx;
     uint8_t  expected;
     ProtoRole role;
+    uint8_t  version;   // PROTO_V1 or PROTO_V2
+    uint32_t resyncs;   // partial or invalid frames discarded (not cleared by proto_reset)
 } ProtoParser;
 
 extern volatile uint8_t usbReadyFlag;
 
+#ifndef USB_TX_RING_SIZE
+#define USB_TX_RING_SIZE 2048u  // MUST be a power of two
+#endif
+#define USB_TX_PACKET    64u    // CDC full-speed bulk packet
+
 void UsbPrintf(const char *fmt, ...);
+uint16_t UsbTxWrite(const uint8_t *data, uint16_t len);  // non-blocking, whole or nothing
+uint16_t UsbTxSpace(void);                                // free bytes in the TX ring
+uint32_t UsbTxDropped(uint16_t *high_water);             // messages lost to a full ring
+void UsbTxComplete(void);                                 // from CDC_TransmitCplt_FS()
+void UsbTxReset(void);                                    // from CDC_Init_FS() / CDC_DeInit_FS()
 
 void UsbLog(const char *fmt, ...);
 
-void proto_init(ProtoParser *p, ProtoRole role);
+void proto_init(ProtoParser *p, ProtoRole role);       // v1 (STX/ETX) parser
+void proto_init_v2(ProtoParser *p, ProtoRole role);    // v2 (COBS + CRC16) parser
 void proto_reset(ProtoParser *p);
 
 /* Feed bytes one by one; returns true when a full, valid frame is ready in *out */
@@ -58,6 +104,36 @@ size_t proto_build_write (uint8_t var_id, uint16_t value, uint8_t out[8]);
 size_t proto_build_read  (uint8_t var_id,                  uint8_t out[8]);
 size_t proto_build_ack   (uint8_t var_id, uint16_t value,  uint8_t out[8]);
 size_t proto_build_readr (uint8_t var_id, uint16_t value,  uint8_t out[8]); // read reply
+size_t proto_build_notify(uint8_t var_id, uint16_t value,  uint8_t out[8]); // unsolicited change
+size_t proto_build_hello (uint8_t version,                  uint8_t out[8]); // master: highest version supported
+size_t proto_build_hello_reply(uint8_t version,             uint8_t out[8]); // slave: version agreed
+size_t proto_build_baud  (uint8_t rate_idx,                 uint8_t out[8]); // master: rate to switch to
+size_t proto_build_baud_reply(uint8_t rate_idx,             uint8_t out[8]); // slave: rate switched to
+size_t proto_build_echo  (uint8_t seq,    uint16_t value,   uint8_t out[8]); // both directions
+size_t proto_build_cycle (uint8_t seq,    uint16_t period_us, uint8_t out[8]); // slave: PD cycle marker
+
+/* Batched builders (return number of bytes written to out[PROTO_MAX_FRAME], 0 if n is invalid) */
+size_t proto_build_write_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]);
+size_t proto_build_read_multi (const uint8_t *var_ids, uint8_t n, uint8_t out[PROTO_MAX_FRAME]);
+size_t proto_build_ack_multi  (const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]);
+size_t proto_build_readr_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]); // read reply
+size_t proto_build_notify_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]); // changed registers
+
+/* Convert a built frame of length n into its tagged form in place (needs room for n+1 bytes).
+ * Returns the new length. */
+size_t proto_tag(uint8_t tag, uint8_t *frame, size_t n);
+
+/* Re-encode a built v1 frame (STX..ETX) as a v2 wire frame. Returns the wire length, 0 if invalid. */
+size_t proto_encode_v2(const uint8_t *frame, size_t n, uint8_t out[PROTO_V2_MAX_WIRE]);
+
+/* Slave: whether a v1 HELLO may renegotiate the framing. On v2, STX..ETX look-alikes
+ * inside COBS payloads can parse as HELLO, so it is only taken once no v2 frame has
+ * arrived for quiet_ms (v2_quiet_ms = time since the last one). */
+bool proto_hello_allowed(uint8_t link_version, uint32_t v2_quiet_ms, uint32_t quiet_ms);
+
+/* Any payload as 00 COBS(payload CRC16) 00, e.g. USB telemetry records */
+#define PROTO_COBS_MAX(n)   ((n) + 5u + ((n) + 2u) / 254u)
+size_t proto_frame_cobs(const uint8_t *raw, size_t len, uint8_t *out);
 void UsbSendRaw(const char *data, int len);
 
 
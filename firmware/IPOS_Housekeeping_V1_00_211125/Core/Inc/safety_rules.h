@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * Table-driven safety rules over the packed input vector.
+ *
+ * A rule is armed while every input in armSet is 1 and every input in
+ * armClear is 0. Once it has been armed for graceMs, it is active (a
+ * fault) whenever an input in okSet is 0 or an input in okClear is 1.
+ * Disarming restarts the grace time. The vector is the debounced inputs
+ * (INPUT_BIT()) plus any software conditions the caller packs above them.
+ *
+ * Rule state is a bitmask per property plus one timestamp array, so a
+ * pass is a few loads and logic ops per rule and touches nothing else.
+ * Nothing here touches the HAL or the RTOS: the caller passes the vector
+ * and the time, so a rule table can be replayed against a recorded input
+ * trace on a host.
+ */
+
+#define SR_MAX_RULES        32u
+
+/* Actions the caller applies for an active rule */
+#define SR_ACT_FORCE_LATCH  0x01u   // swLatchForceError = 1, every pass while active
+#define SR_ACT_LASER_OFF    0x02u   // laserLatchedOff = 1 + laser_disable(), every pass while active
+#define SR_ACT_LATCH_FAULT  0x04u   // latch outputs to fault state, once on entry
+
+typedef struct {
+    uint32_t    armSet;         // inputs that must be 1 for the rule to apply
+    uint32_t    armClear;       // inputs that must be 0 for the rule to apply
+    uint32_t    okSet;          // once armed: inputs that must be 1 ...
+    uint32_t    okClear;        // ... and inputs that must be 0, else active
+    uint16_t    graceMs;        // armed time before a fault counts
+    uint8_t     actions;        // SR_ACT_*
+    uint16_t    logFault;       // flash log code on entry, 0 = none
+    uint16_t    logClear;       // flash log code on exit, 0 = none
+    const char *logFaultText;
+    const char *logClearText;
+    const char *msgActive;      // USB message on entry
+    const char *msgCleared;     // USB message on exit
+} SafetyRule;
+
+typedef struct {
+    uint32_t armed;                     // bit r: rule r armed
+    uint32_t active;                    // bit r: rule r active
+    uint32_t armedAt[SR_MAX_RULES];     // ms when rule r was armed
+} SafetyRuleState;
+
+static inline void sr_init(SafetyRuleState *s) {
+    s->armed = s->active = 0;
+}
+
+/* Evaluate every rule against v at time now (ms); returns the rules whose
+ * active bit changed (s->active holds the new state) */
+static inline uint32_t sr_eval(const SafetyRule *rules, uint32_t n, SafetyRuleState *s,
+                               uint32_t v, uint32_t now) {
+    uint32_t armed = 0, active = 0;
+    for (uint32_t r = 0; r < n; r++) {
+        const SafetyRule *x = &rules[r];
+        uint32_t bit = 1u << r;
+        if ((v & x->armSet) != x->armSet || (v & x->armClear))
+            continue;
+        armed |= bit;
+        if (!(s->armed & bit))
+            s->armedAt[r] = now;
+        uint32_t bad = (~v & x->okSet) | (v & x->okClear);
+        if (bad && now - s->armedAt[r] >= x->graceMs)
+            active |= bit;
+    }
+    uint32_t changed = active ^ s->active;
+    s->armed  = armed;
+    s->active = active;
+    return changed;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Sample numbering for timer-paced circular DMA streams (input_dma.c).
+ *
+ * One timer update starts sample n in every stream, and each stream writes
+ * it at index n % depth. A second timer counts the updates, so `ticks` is
+ * the number of samples started. NDTR only gives each stream's write index,
+ * i.e. its sample count modulo depth; the count itself is the number with
+ * that residue just at or below ticks + 1 (a stream is at most a few bus
+ * cycles behind the update, and never a whole buffer). The slowest stream
+ * bounds what is complete in all of them.
+ *
+ * Sample numbers, ticks and their differences are 32-bit and wrap together,
+ * which is why depth must be a power of two. The caller reads every NDTR
+ * first, then the tick counter, and passes them in, so the arithmetic runs
+ * on a host with simulated counters.
+ */
+
+/* Samples stream has written, from its NDTR and the tick count read after it */
+static inline uint32_t sring_stream_written(uint32_t ticks, uint32_t ndtr, uint32_t depth) {
+    uint32_t head = (depth - ndtr) & (depth - 1u);  // NDTR == 0 is only seen just before the reload
+    return ticks + 1u - ((ticks + 1u - head) & (depth - 1u));
+}
+
+/* Samples written by every stream (the slowest one's count) */
+static inline uint32_t sring_written(uint32_t ticks, const uint32_t *ndtr, uint32_t streams, uint32_t depth) {
+    uint32_t written = 0;
+    for (uint32_t s = 0; s < streams; s++) {
+        uint32_t w = sring_stream_written(ticks, ndtr[s], depth);
+        if (s == 0 || (int32_t)(w - written) < 0)
+            written = w;
+    }
+    return written;
+}
+
+/* Buffer index of sample `no` */
+static inline uint32_t sring_index(uint32_t no, uint32_t depth) {
+    return no & (depth - 1u);
+}
+
+/*
+ * True if the reader at sample `next` can no longer trust the buffer: the
+ * streams are within `margin` samples of overwriting it (or the counts
+ * went backwards, e.g. after a restart). The reader then resumes at the
+ * newest sample, written - 1.
+ */
+static inline bool sring_lapped(uint32_t written, uint32_t next, uint32_t depth, uint32_t margin) {
+    return written - next > depth - margin;
+}
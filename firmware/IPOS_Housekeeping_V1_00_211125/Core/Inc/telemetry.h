@@ -0,0 +1,52 @@
+/**
+ * @addtogroup telemetry
+ * @{
+ * @file telemetry.h
+ * @brief Binary telemetry records on the USB CDC port (`STREAM ON`).
+ *
+ * Each record is framed like a v2 link frame, 0x00 COBS(record CRC16) 0x00,
+ * and queued on the USB TX ring. Record layout (little-endian):
+ *
+ * | Offset | Field | Description |
+ * |--------|-------|-------------|
+ * | 0 | type | @ref TlmRecordType |
+ * | 1 | seq  | Record counter, wraps; gaps mean dropped records |
+ * | 2–5 | t_us | Microsecond timestamp (wraps after ~71 min) |
+ * | 6.. | payload | Depends on type (see @ref TlmRecordType) |
+ *
+ * `tools/telemetry_decode.py` turns the stream back into text or CSV.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "max31855.h"
+
+/** @brief Record types and their payloads. */
+typedef enum {
+    TLM_REC_INPUTS = 1,   ///< u32 bitmap, bit i = stableState[i] (InputName order)
+    TLM_REC_STATUS = 2,   ///< u16 debug, u16 debug2 (TruPulse), u16 active status words
+    TLM_REC_THERMO = 3,   ///< u32 raw MAX31855 word, u8 rangeFault
+    TLM_REC_LOG    = 4,   ///< u16 code, u8 flags, message text (no terminator)
+    TLM_REC_TEXT   = 5,   ///< UsbPrintf() output while streaming
+    TLM_REC_FMT    = 6,   ///< FLOG() entries, u32 words (see fmtlog.h)
+    TLM_REC_LOGDUMP = 7,  ///< `LOG BIN`: whole 33-byte LogRec records as stored; empty = end
+} TlmRecordType;
+
+#define TLM_HDR_SIZE      6u
+#define TLM_MAX_PAYLOAD   256u
+#ifndef TLM_SNAPSHOT_MS
+#define TLM_SNAPSHOT_MS   100u      // periodic INPUTS + STATUS records while streaming
+#endif
+
+void    Telemetry_Enable(uint8_t on);
+uint8_t Telemetry_Active(void);
+
+void Telemetry_Inputs(uint32_t bitmap);
+void Telemetry_Status(uint16_t debug, uint16_t debug2, uint16_t active);
+void Telemetry_Thermo(const MAX31855_Data *d);
+void Telemetry_Log(uint16_t code, uint8_t flags, const char *msg);
+uint8_t Telemetry_Text(const char *text, uint16_t len);
+void Telemetry_Fmt(const uint32_t *words, uint16_t nwords);
+uint8_t Telemetry_LogRecs(const void *recs, uint16_t len);
+
+/** @} */
@@ -9,16 +9,46 @@
 #pragma once
 #include "cmsis_os2.h"
 #include <stdint.h>
+#include <stdbool.h>
 
-/* Payload for ACK/DATA messages */
+/* Latest-value mailboxes, one per var_id (0 .. MBOX_MAX_VARS-1).
+ * Written only by the uart_master task; any task may read without a lock. */
+#ifndef MBOX_MAX_VARS
+#define MBOX_MAX_VARS    15u    // ACK and DATA flags must fit in 30 thread-flag bits
+#endif
+#ifndef MBOX_MAX_READERS
+#define MBOX_MAX_READERS 4u
+#endif
+
+/* Thread flags set on subscribed readers: "var X updated" / "any var updated" */
+#define MBOX_FLAG_DATA(var_id)  (1UL << (var_id))                    // READ reply or NOTIFY
+#define MBOX_FLAG_ACK(var_id)   (1UL << (MBOX_MAX_VARS + (var_id)))  // write acknowledged
+#define MBOX_FLAGS_DATA_ANY     ((1UL << MBOX_MAX_VARS) - 1UL)
+#define MBOX_FLAGS_ACK_ANY      (MBOX_FLAGS_DATA_ANY << MBOX_MAX_VARS)
+#define MBOX_FLAG_CYCLE         (1UL << (2u * MBOX_MAX_VARS))        // slave PD cycle marker
+
+/* Snapshot of one mailbox */
 typedef struct {
-    uint8_t  var_id;
     uint16_t value;
-} VarFrame;
+    uint32_t seq;       // number of updates so far, 0 = never received
+    uint32_t tick;      // osKernelGetTickCount() at the last update
+} VarMailbox;
+
+/* The slave pushes PORTB / PORTC / STATUS_PLC changes (CMD_NOTIFY), so reads of
+ * those variables only need to run as a keep-alive at this period */
+#ifndef UART_KEEPALIVE_MS
+#define UART_KEEPALIVE_MS 1000u
+#endif
+
+/* Mailbox readers (any task). Return false if var_id has no mailbox. */
+bool mbox_read_data(uint8_t var_id, VarMailbox *out);   // last READ reply / NOTIFY
+bool mbox_read_ack (uint8_t var_id, VarMailbox *out);   // last write acknowledged
+void mbox_read_cycle(VarMailbox *out);                  // last PD cycle marker: value = period in µs
 
-/* Queues exposed to the rest of your app */
-extern osMessageQueueId_t gAckQueue;
-extern osMessageQueueId_t gDataQueue;
+/* Register the calling thread for the given MBOX_FLAG_* bits, then wait with
+ * osThreadFlagsWait(); compare VarMailbox.seq to skip values already seen.
+ * Waiting on MBOX_FLAG_CYCLE runs a task in phase with the Profinet PD cycle. */
+bool mbox_subscribe(uint32_t flags);
 
-/* Create task + queues; provide UART handle */
+/* Create the uart_master task (link I/O + mailbox updates); provide UART handle */
 void UartMaster_StartTasks(void *uart_handle /* UART_HandleTypeDef* */);
@@ -71,6 +71,22 @@
 
 extern void StartEthernetTask(void);
 
+/** 1 = run the PortA/B/C + status exchange with the M40 over the UART link.
+ *  Off by default: the task lets the PLC drive PortB / Job_Sel_Out and the
+ *  latch reset / force events, alongside the USB commands and the button. */
+#ifndef APP_UART_SYNC
+#define APP_UART_SYNC 0
+#endif
+/** Exchange period (ms) while the M40 sends no PD cycle markers */
+#ifndef APP_UART_PERIOD_MS
+#define APP_UART_PERIOD_MS 100u
+#endif
+/** No reply or notification for this long (ms): report the link as lost.
+ *  Two keep-alive reads fit in it, so one lost reply is not enough. */
+#ifndef APP_UART_LINK_LOST_MS
+#define APP_UART_LINK_LOST_MS (2u * UART_KEEPALIVE_MS)
+#endif
+
 /* -------------------------------------------------------------------------- */
 /* Global Variables                                                           */
 /* -------------------------------------------------------------------------- */
@@ -193,6 +209,7 @@ void vTaskMonitor(void *argument)
 
         // --- Normal operation ---
         MAX31855_Data d;
+        char t[FX_STR_MAX];
         osMutexAcquire(g_ThermoMutex, osWaitForever);
         d = g_ThermoData;
         osMutexRelease(g_ThermoMutex);
@@ -203,7 +220,8 @@ void vTaskMonitor(void *argument)
             {
                 // Print only once when bypass is first enabled
                 if (!lastBypassState) {
-                    UsbPrintf("[DEBUG] Thermocouple check bypassed (%.2f degC)\r\n", d.tc_c);
+                    UsbPrintf("[DEBUG] Thermocouple check bypassed (%s degC)\r\n",
+                              fx_format(t, sizeof(t), d.tc_q2, MAX31855_TC_FRAC, 2));
                     lastBypassState = true;
                 }
             }
@@ -216,11 +234,13 @@ void vTaskMonitor(void *argument)
                 }
 
                 if (d.flag) {
-                    UsbPrintf("Sensor fault %.2f °C\r\n", d.fault);
+                    UsbPrintf("Sensor fault 0x%02X\r\n", d.fault);
                 } else if (d.rangeFault) {
-                    UsbPrintf("Temperature out of range: %.2f degC\r\n", d.tc_c);
+                    UsbPrintf("Temperature out of range: %s degC\r\n",
+                              fx_format(t, sizeof(t), d.tc_q2, MAX31855_TC_FRAC, 2));
                 } else {
-                    UsbPrintf("Temperature normal: %.2f degC\r\n", d.tc_c);
+                    UsbPrintf("Temperature normal: %s degC\r\n",
+                              fx_format(t, sizeof(t), d.tc_q2, MAX31855_TC_FRAC, 2));
                 }
             }
         }
@@ -251,226 +271,175 @@ static void vTaskBlink(void *argument) {
     }
 }
 
+#if APP_UART_SYNC
+/**
+ * @brief Prints a status word as grouped binary and decimal.
+ */
+static void print_word(const char *what, uint16_t value, int bits)
+{
+    char bin_str[40];
+    to_binary_str_grouped(value, bits, bin_str, sizeof(bin_str));
+    UsbPrintf("%s = %s (dec=%u)\r\n", what, bin_str, value);
+}
+
 /**
  * @brief Main UART communication and PLC synchronization logic.
  *
- * Performs periodic read/write of PortA/B/C and STATUS registers,
- * monitors PLC connection status, and handles reset latch events.
+ * Runs one exchange per Profinet PD cycle (MBOX_FLAG_CYCLE from the M40),
+ * or every @ref APP_UART_PERIOD_MS while no markers arrive:
+ * - one tagged WRITE_MULTI with PortA plus every status word whose value
+ *   has not been acknowledged yet
+ * - one tagged READ_MULTI of PortB, PortC and STATUS_PLC, only as a
+ *   keep-alive every @ref UART_KEEPALIVE_MS, or every exchange while the
+ *   link is down: the M40 pushes changes of these (CMD_NOTIFY)
+ *
+ * Replies and the M40's change notifications land in the variable
+ * mailboxes; new values are applied to the outputs as soon as they arrive.
+ * STATUS_PLC bit 0 / bit 1 rising edges trigger the latch reset / force
+ * tasks. Monitors the link and reports when it is lost or re-established.
  */
-//static void vTaskAppUartLogic(void *argument)
-//{
-//    char bin_str[17];
-//    VarFrame f;
-//
-//    // Remember last values
-//    static uint16_t lastPortA  = 0xFFFF;
-//    static uint16_t lastPortB  = 0xFFFF;
-//    static uint16_t lastPortC  = 0xFFFF;
-//    static uint16_t lastStatusPLC = 0xFFFF;
-//    static uint16_t lastWrittenStatus = 0xFFFF;
-//    static uint16_t lastActiveStatus = 0xFFFF;
-//
-//    // Adaptive delay
-//    uint32_t delayMs = 500;
-//    uint8_t  activeCounter = 0;
-//
-//    // Link monitoring
-//    uint32_t lastRxTick = osKernelGetTickCount();
-//    bool slaveOnline = false;
-//    //bool wasOnline   = false;
-//
-//    for (;;)
-//    {
-//        bool changed = false;
-//        bool gotFrame = false;
-//
-//        /* Flush stale queue data */
-//        while (osMessageQueueGet(gAckQueue,  &f, NULL, 0) == osOK) {}
-//        while (osMessageQueueGet(gDataQueue, &f, NULL, 0) == osOK) {}
-//
-//        /* Always perform polling — even if offline */
-//        uint32_t now = osKernelGetTickCount();
-//
-//        /* 1. Write PortA */
-//        uint16_t newPortA = PortA_Read();
-//        master_write_u16(VAR_PORTA, newPortA);
-//        if (osMessageQueueGet(gAckQueue, &f, NULL, 50) == osOK)
-//        {
-//            gotFrame = true;
-//            if (f.value != lastPortA)
-//            {
-//            	// Build grouped binary string (e.g., "0000 1111 0000 0000")
-//				char bin_str[40];
-//				to_binary_str_grouped(f.value, 10, bin_str, sizeof(bin_str));
-//            	//to_binary_str(f.value, 10, bin_str, sizeof(bin_str));
-//                UsbPrintf("ACK: PortA set to %s (dec=%u)\r\n", bin_str, f.value);
-//                HAL_GPIO_TogglePin(LD1_GPIO_Port, LD1_Pin);
-//                lastPortA = f.value;
-//                changed = true;
-//            }
-//        }
-//
-//        /* 2. Read PortB */
-//        master_read_u16(VAR_PORTB);
-//        if (osMessageQueueGet(gDataQueue, &f, NULL, 50) == osOK)
-//        {
-//            gotFrame = true;
-//            if (f.value != lastPortB)
-//            {
-//				char bin_str[40];
-//				to_binary_str_grouped(f.value, 10, bin_str, sizeof(bin_str));
-//                //to_binary_str(f.value, 10, bin_str, sizeof(bin_str));
-//                UsbPrintf("DATA: PortB = %s (dec=%u)\r\n", bin_str, f.value);
-//                lastPortB = f.value;
-//                PortB_Write(f.value);
-//                changed = true;
-//            }
-//        }
-//
-//        /* 3. Read PortC */
-//        master_read_u16(VAR_PORTC);
-//        if (osMessageQueueGet(gDataQueue, &f, NULL, 50) == osOK)
-//        {
-//            gotFrame = true;
-//            if (f.value != lastPortC)
-//            {
-//				char bin_str[40];
-//				to_binary_str_grouped(f.value, 8, bin_str, sizeof(bin_str));
-//                //to_binary_str(f.value, 8, bin_str, sizeof(bin_str));
-//                UsbPrintf("DATA: Job Sel out (PortC) = %s (dec=%u)\r\n", bin_str, f.value);
-//                lastPortC = f.value;
-//                Job_Sel_Out_Write((uint8_t)f.value);
-//                changed = true;
-//            }
-//        }
-//
-//        /* 4. Write STATUS_DEBUG */
-//        uint16_t newStatus = App_BuildDebugStatusWord();
-//        if (newStatus != lastWrittenStatus)
-//        {
-//            master_write_u16(VAR_STATUS_DEBUG, newStatus);
-//            if (osMessageQueueGet(gAckQueue, &f, NULL, 50) == osOK)
-//            {
-//                gotFrame = true;
-//                char bin_str[40];
-//                to_binary_str_grouped(f.value, 16, bin_str, sizeof(bin_str));
-//                UsbPrintf("ACK: STATUS_DEBUG (to PLC) = %s (dec=%u)\r\n", bin_str, f.value);
-//            }
-//            lastWrittenStatus = newStatus;
-//            changed = true;
-//        }
-//
-//        /* 4b. Write STATUS_ACTIVE */
-//        uint16_t newActiveStatus = App_BuildActiveStatusWord();   // your new function
-//
-//        if (newActiveStatus != lastActiveStatus)
-//        {
-//            master_write_u16(VAR_STATUS_ACTIVE, newActiveStatus);
-//            if (osMessageQueueGet(gAckQueue, &f, NULL, 50) == osOK)
-//            {
-//                gotFrame = true;
-//				char bin_str[40];
-//				to_binary_str_grouped(f.value, 16, bin_str, sizeof(bin_str));
-//                //to_binary_str(f.value, 16, bin_str, sizeof(bin_str));
-//                UsbPrintf("ACK: STATUS_ACTIVE (to PLC) = %s (dec=%u)\r\n", bin_str, f.value);
-//            }
-//            lastActiveStatus = newActiveStatus;
-//            changed = true;
-//        }
-//
-//        /* 4c. Write STATUS_DEBUG2 */
-//        uint16_t newDebug2Status = App_BuildDebug2StatusWord();
-//        static uint16_t lastDebug2Status = 0xFFFF;
-//
-//        if (newDebug2Status != lastDebug2Status)
-//        {
-//            master_write_u16(VAR_STATUS_DEBUG2, newDebug2Status);
-//            if (osMessageQueueGet(gAckQueue, &f, NULL, 50) == osOK)
-//            {
-//                gotFrame = true;
-//				char bin_str[40];
-//				to_binary_str_grouped(f.value, 16, bin_str, sizeof(bin_str));
-//               // to_binary_str(f.value, 16, bin_str, sizeof(bin_str));
-//                UsbPrintf("ACK: STATUS_DEBUG2 (to PLC) = %s (dec=%u)\r\n", bin_str, f.value);
-//            }
-//            lastDebug2Status = newDebug2Status;
-//            changed = true;
-//        }
-//
-//
-//        /* 5. Read STATUS_PLC */
-//        master_read_u16(VAR_STATUS_PLC);
-//        if (osMessageQueueGet(gDataQueue, &f, NULL, 50) == osOK)
-//        {
-//            gotFrame = true;
-//
-//            if (f.value != lastStatusPLC)
-//            {
-//                char bin_str[40];
-//                to_binary_str_grouped(f.value, 16, bin_str, sizeof(bin_str));
-//                UsbPrintf("DATA: STATUS_PLC (from PLC) = %s (dec=%u)\r\n",
-//                          bin_str, (unsigned int)f.value);
-//
-//                lastStatusPLC = f.value;
-//                changed = true;
-//
-//                /* --- Bit 0: Reset latches --- */
-//                static bool resetPrev = false;
-//                bool resetNow = (f.value & (1U << 0));
-//
-//                if (resetNow && !resetPrev)
-//                {
-//                    osEventFlagsSet(ResetLatchEvent, 0x01);
-//                    UsbPrintf("[PLC] Bit0 rising edge → LATCH RESET triggered\r\n");
-//                }
-//                resetPrev = resetNow;
-//
-//                /* --- Bit 1: Force latch error --- */
-//                static bool faultPrev = false;
-//                bool faultNow = (f.value & (1U << 1));
-//
-//                if (faultNow && !faultPrev)
-//                {
-//                    osEventFlagsSet(ForceLatchEvent, 0x01);
-//                    UsbPrintf("[PLC] Bit1 rising edge → LATCH FAULT triggered\r\n");
-//                }
-//                faultPrev = faultNow;
-//            }
-//        }
-//
-//
-//        /* Link state tracking */
-//        if (gotFrame) {
-//            lastRxTick = now;
-//            if (!slaveOnline) {
-//                slaveOnline = true;
-//                UsbPrintf("[Master] Link re-established\r\n");
-//            }
-//        } else if ((now - lastRxTick) > 2000) {
-//            if (slaveOnline) {
-//                slaveOnline = false;
-//                UsbPrintf("[Master] Link lost – no response\r\n");
-//            }
-//        }
-//
-//        /* Adaptive delay */
-//        if (changed)
-//        {
-//            delayMs = 100;
-//            activeCounter = 5;
-//        }
-//        else if (activeCounter > 0)
-//        {
-//            activeCounter--;
-//        }
-//        else
-//        {
-//            delayMs = 500;
-//        }
-//
-//        osDelay(delayMs);
-//    }
-//}
+static void vTaskAppUartLogic(void *argument)
+{
+    static const uint8_t readIds[] = { VAR_PORTB, VAR_PORTC, VAR_STATUS_PLC };
+    uint32_t seenB = 0, seenC = 0, seenPlc = 0, seenAckA = 0;
+    uint16_t lastPortA = 0xFFFF, lastPortB = 0xFFFF, lastPortC = 0xFFFF, lastStatusPLC = 0xFFFF;
+    bool resetPrev = false, faultPrev = false;
+    (void)argument;
+
+    // Link monitoring
+    uint32_t lastRxTick = osKernelGetTickCount();
+    uint32_t lastExchange = lastRxTick - APP_UART_PERIOD_MS;
+    uint32_t lastRead = lastRxTick - UART_KEEPALIVE_MS;
+    bool slaveOnline = false;
+
+    mbox_subscribe(MBOX_FLAG_CYCLE | MBOX_FLAG_DATA(VAR_PORTB) | MBOX_FLAG_DATA(VAR_PORTC) |
+                   MBOX_FLAG_DATA(VAR_STATUS_PLC));
+
+    for (;;)
+    {
+        uint32_t fl = osThreadFlagsWait(MBOX_FLAG_CYCLE | MBOX_FLAGS_DATA_ANY, osFlagsWaitAny, APP_UART_PERIOD_MS);
+        uint32_t now = osKernelGetTickCount();
+        bool gotFrame = false;
+        VarMailbox m;
+
+        /* 1. Exchange: PD cycle started, or no marker within the period */
+        if ((!(fl & osFlagsError) && (fl & MBOX_FLAG_CYCLE)) || (now - lastExchange) >= APP_UART_PERIOD_MS)
+        {
+            lastExchange = now;
+            ProtoPair out[4];
+            uint8_t n = 0;
+            out[n].var_id = VAR_PORTA;
+            out[n].value  = PortA_Read();
+            n++;
+
+            /* Status words only until the M40 has acknowledged the current value */
+            static const uint8_t statusIds[] = { VAR_STATUS_DEBUG, VAR_STATUS_ACTIVE, VAR_STATUS_DEBUG_TRU };
+            const uint16_t status[] = { App_BuildDebugStatusWord(), App_BuildActiveStatusWord(),
+                                        App_BuildDebug2StatusWord() };
+            for (uint8_t i = 0; i < 3; i++)
+            {
+                if (!mbox_read_ack(statusIds[i], &m) || m.seq == 0 || m.value != status[i])
+                {
+                    out[n].var_id = statusIds[i];
+                    out[n].value  = status[i];
+                    n++;
+                }
+            }
+            master_submit_write_multi(out, n);      // HAL_BUSY: window full, next cycle retries
+
+            /* Keep-alive read: recovers a lost notification and proves the link */
+            if (!slaveOnline || (now - lastRead) >= UART_KEEPALIVE_MS)
+            {
+                if (master_submit_read_multi(readIds, sizeof(readIds)) == HAL_OK)
+                    lastRead = now;
+            }
+        }
+
+        /* 2. PortA acknowledged */
+        if (mbox_read_ack(VAR_PORTA, &m) && m.seq != seenAckA)
+        {
+            seenAckA = m.seq;
+            gotFrame = true;
+            if (m.value != lastPortA)
+            {
+                print_word("ACK: PortA set to", m.value, 10);
+                HAL_GPIO_TogglePin(LD1_GPIO_Port, LD1_Pin);
+                lastPortA = m.value;
+            }
+        }
+
+        /* 3. PortB */
+        if (mbox_read_data(VAR_PORTB, &m) && m.seq != seenB)
+        {
+            seenB = m.seq;
+            gotFrame = true;
+            if (m.value != lastPortB)
+            {
+                print_word("DATA: PortB", m.value, 10);
+                lastPortB = m.value;
+                PortB_Write(m.value);
+            }
+        }
+
+        /* 4. PortC */
+        if (mbox_read_data(VAR_PORTC, &m) && m.seq != seenC)
+        {
+            seenC = m.seq;
+            gotFrame = true;
+            if (m.value != lastPortC)
+            {
+                print_word("DATA: Job Sel out (PortC)", m.value, 8);
+                lastPortC = m.value;
+                Job_Sel_Out_Write((uint8_t)m.value);
+            }
+        }
+
+        /* 5. STATUS_PLC */
+        if (mbox_read_data(VAR_STATUS_PLC, &m) && m.seq != seenPlc)
+        {
+            seenPlc = m.seq;
+            gotFrame = true;
+            if (m.value != lastStatusPLC)
+            {
+                print_word("DATA: STATUS_PLC (from PLC)", m.value, 16);
+                lastStatusPLC = m.value;
+
+                /* --- Bit 0: Reset latches --- */
+                bool resetNow = (m.value & (1U << 0));
+                if (resetNow && !resetPrev)
+                {
+                    osEventFlagsSet(ResetLatchEvent, 0x01);
+                    UsbPrintf("[PLC] Bit0 rising edge → LATCH RESET triggered\r\n");
+                }
+                resetPrev = resetNow;
+
+                /* --- Bit 1: Force latch error --- */
+                bool faultNow = (m.value & (1U << 1));
+                if (faultNow && !faultPrev)
+                {
+                    osEventFlagsSet(ForceLatchEvent, 0x01);
+                    UsbPrintf("[PLC] Bit1 rising edge → LATCH FAULT triggered\r\n");
+                }
+                faultPrev = faultNow;
+            }
+        }
+
+        /* Link state tracking */
+        if (gotFrame) {
+            lastRxTick = now;
+            if (!slaveOnline) {
+                slaveOnline = true;
+                UsbPrintf("[Master] Link re-established\r\n");
+            }
+        } else if ((now - lastRxTick) > APP_UART_LINK_LOST_MS) {
+            if (slaveOnline) {
+                slaveOnline = false;
+                UsbPrintf("[Master] Link lost – no response\r\n");
+            }
+        }
+    }
+}
+#endif /* APP_UART_SYNC */
 
 /* =====================================================================
  *                   Task: ABCC (M40) SPI Driver
@@ -696,12 +665,14 @@ void App_Start(void) {
         .stack_size = 2048
     });
 
-//    /* App logic task */
-//    osThreadNew(vTaskAppUartLogic, NULL, &(const osThreadAttr_t){
-//        .name = "app_Uart_logic",
-//        .priority = osPriorityNormal,
-//        .stack_size = 1024
-//    });
+#if APP_UART_SYNC
+    /* App logic task */
+    osThreadNew(vTaskAppUartLogic, NULL, &(const osThreadAttr_t){
+        .name = "app_Uart_logic",
+        .priority = osPriorityNormal,
+        .stack_size = 1024
+    });
+#endif
 
     osThreadNew(vTaskBlink, NULL, &(const osThreadAttr_t){
         .name = "blink_task",
@@ -0,0 +1,72 @@
+/**
+ * @file error_rules.c
+ * @brief Safety rule table: door/relays, relay contacts, latch, power, temperature.
+ *
+ * @ingroup input_handling
+ * @{
+ */
+
+#include "error_rules.h"
+#include "error_codes.h"
+
+/**
+ * @brief The safety rules, evaluated by CheckErrorRules() with sr_eval().
+ *
+ * - Door/relays: once the safeties have been closed for 1 s, both relay
+ *   feedbacks must be ON.
+ * - Relay contacts: 50 ms after both relays are ON (safeties closed),
+ *   NO1 must be closed and NC1 open.
+ * - Latch: no hardware latch error line and no forced software error.
+ * - Power: 12 V, 24 V and the 12 V fuse good.
+ * - Temperature: no thermocouple fault (Cond_TemperatureSafe() keeps the
+ *   hysteresis and the laser enable/disable).
+ */
+const SafetyRule errorRules[NUM_ERROR_RULES] = {
+    [RULE_DOOR_RELAYS] = {
+        .armSet     = SAFETY_INPUTS,
+        .okSet      = RELAY_INPUTS,
+        .graceMs    = 1000,
+        .msgActive  = "ERROR: DOOR active but Relay1 or Relay2 is OFF!",
+        .msgCleared = "INFO: DOOR+Relay1+Relay2 condition OK",
+    },
+    [RULE_RELAY_CONTACTS] = {
+        .armSet       = SAFETY_INPUTS | RELAY_INPUTS,
+        .okSet        = INPUT_BIT(INPUT_NO1),
+        .okClear      = INPUT_BIT(INPUT_NC1),
+        .graceMs      = 50,
+        .actions      = SR_ACT_FORCE_LATCH,
+        .logFault     = LOGCODE_RELAY_FAULT,
+        .logClear     = LOGCODE_RELAY_CLEAR,
+        .logFaultText = "Relay contacts mismatch",
+        .logClearText = "Relay contacts OK",
+        .msgActive    = "ERROR: Relay1+Relay2 ON but contacts NO1/NC1 mismatch!",
+        .msgCleared   = "INFO: Relay1+Relay2 contacts match (NO1=1, NC1=0)",
+    },
+    [RULE_LATCH] = {
+        .okClear      = LATCH_ERR_INPUTS | INPUT_BIT(RULE_IN_SW_LATCH),
+        .actions      = SR_ACT_LATCH_FAULT | SR_ACT_LASER_OFF,
+        .logFault     = LOGCODE_LATCH_FAULT,
+        .logClear     = LOGCODE_LATCH_CLEAR,
+        .logFaultText = "Latch fault triggered",
+        .logClearText = "Latch fault cleared",
+        .msgActive    = "ERROR: Latch error detected — Laser DISABLED!",
+        .msgCleared   = "INFO: Latch error cleared (requires RESET to re-enable)",
+    },
+    [RULE_POWER] = {
+        .okSet        = POWER_INPUTS,
+        .actions      = SR_ACT_FORCE_LATCH | SR_ACT_LASER_OFF,
+        .logFault     = LOGCODE_POWER_FAULT,
+        .logClear     = LOGCODE_POWER_CLEAR,
+        .logFaultText = "Power fault detected",
+        .logClearText = "Power rails OK",
+        .msgActive    = "ERROR: 12V, 24V or 12V Fuse power fault - Laser DISABLED!",
+        .msgCleared   = "INFO: Power rails OK (12V, 24V & 12V Fuse good)",
+    },
+    [RULE_TEMPERATURE] = {
+        .okClear    = INPUT_BIT(RULE_IN_TEMP_FAULT),
+        .msgActive  = "ERROR: Laser temperature out of range - Laser DISABLED!",
+        .msgCleared = "INFO: Laser temperature within safe range",
+    },
+};
+
+/** @} */
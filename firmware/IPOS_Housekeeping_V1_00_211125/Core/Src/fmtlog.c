@@ -0,0 +1,132 @@
+/**
+ * @file fmtlog.c
+ * @defgroup fmtlog Deferred-Format Log
+ * @brief RAM ring of (format ID, arguments) entries, sent as telemetry records.
+ *
+ * FmtLog_Write() is the run-time half of FLOG(): it copies the header, the
+ * tick and the argument words into a word ring with interrupts masked, so
+ * any task or ISR may log. A full ring drops the new entry and counts it;
+ * once a drain has made room, the count is logged as an entry itself.
+ *
+ * FmtLog_Drain() moves whole entries into one @ref TLM_REC_FMT record per
+ * call. It is called from vTaskInputs while STREAM mode is on, which is the
+ * only consumer.
+ *
+ * @ingroup IPOS_Firmware
+ * @{
+ */
+
+#include "fmtlog.h"
+#include "telemetry.h"
+#include "stm32f4xx_hal.h"
+#include <stdarg.h>
+
+#define FMTLOG_MASK     (FMTLOG_RING_WORDS - 1u)
+#define FMTLOG_NARGS(h) (((h) >> 20) & 0xFu)
+
+static uint32_t fmtRing[FMTLOG_RING_WORDS];
+static volatile uint32_t fmtHead;      ///< producer index (words, free-running)
+static volatile uint32_t fmtTail;      ///< consumer index (words, free-running)
+static volatile uint32_t fmtDropped;   ///< entries lost because the ring was full
+
+/** Staging buffer for one record; only FmtLog_Drain() uses it */
+static uint32_t fmtOut[TLM_MAX_PAYLOAD / 4u];
+
+static const char fmtDropMsg[] __attribute__((section(".ipos_fmt"), used)) =
+    "[FLOG] %lu entries dropped (ring full)";
+
+/** @brief Append one entry; returns 0 (and counts a drop if asked) if it did not fit. */
+static uint8_t fmtlog_put(uint32_t hdr, va_list ap, uint8_t countDrop)
+{
+    uint32_t n = FMTLOG_NARGS(hdr);
+    uint32_t t = HAL_GetTick();
+    uint8_t ok = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t h = fmtHead;
+    if (FMTLOG_RING_WORDS - (h - fmtTail) >= n + 2u) {
+        fmtRing[h++ & FMTLOG_MASK] = hdr;
+        fmtRing[h++ & FMTLOG_MASK] = t;
+        for (uint32_t i = 0; i < n; i++)
+            fmtRing[h++ & FMTLOG_MASK] = va_arg(ap, uint32_t);
+        fmtHead = h;
+        ok = 1;
+    } else if (countDrop) {
+        fmtDropped++;
+    }
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+/** @brief fmtlog_put() with the arguments passed inline. */
+static uint8_t fmtlog_putv(uint8_t countDrop, uint32_t hdr, ...)
+{
+    va_list ap;
+    va_start(ap, hdr);
+    uint8_t ok = fmtlog_put(hdr, ap, countDrop);
+    va_end(ap);
+    return ok;
+}
+
+/**
+ * @brief Store one entry (called by FLOG()).
+ *
+ * The arguments arrive as `uint32_t` words (FLOG() converts them), so the
+ * call site only loads registers; up to three go in r1–r3.
+ *
+ * @param hdr Format ID, argument count and level (see fmtlog.h)
+ * @param ... `FMTLOG_NARGS(hdr)` argument words
+ */
+void FmtLog_Write(uint32_t hdr, ...)
+{
+    va_list ap;
+    va_start(ap, hdr);
+    (void)fmtlog_put(hdr, ap, 1);
+    va_end(ap);
+}
+
+/**
+ * @brief Send the oldest entries as one TLM_REC_FMT record.
+ *
+ * Takes as many whole entries as fit in TLM_MAX_PAYLOAD. Does nothing while
+ * STREAM mode is off, so the entries stay in the ring until the host
+ * starts listening.
+ */
+void FmtLog_Drain(void)
+{
+    if (!Telemetry_Active())
+        return;
+
+    uint32_t tail = fmtTail;
+    uint32_t head = fmtHead;
+    uint16_t w = 0;
+    while (tail != head) {
+        uint32_t len = FMTLOG_NARGS(fmtRing[tail & FMTLOG_MASK]) + 2u;
+        if (w + len > TLM_MAX_PAYLOAD / 4u)
+            break;
+        for (uint32_t i = 0; i < len; i++)
+            fmtOut[w++] = fmtRing[tail++ & FMTLOG_MASK];
+    }
+    if (w == 0)
+        return;
+    fmtTail = tail;     // release the space only after the copy
+
+    Telemetry_Fmt(fmtOut, w);
+
+    uint32_t lost = fmtDropped;
+    if (lost && fmtlog_putv(0, FLOG_HDR_(fmtDropMsg, 1, FMTLOG_LVL_WARNING), lost)) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        fmtDropped -= lost;
+        __set_PRIMASK(primask);
+    }
+}
+
+/** @brief Entries dropped so far and not yet reported. */
+uint32_t FmtLog_Dropped(void)
+{
+    return fmtDropped;
+}
+
+/** @} */
@@ -0,0 +1,375 @@
+/**
+ * @file input_dma.c
+ * @defgroup input_dma Input Oversampling
+ * @brief Timer-triggered DMA sampling of the input ports.
+ *
+ * Selected with @ref INPUT_OVERSAMPLE instead of the EXTI front end and the
+ * 10 ms poll. TIM8 runs at @ref INPUT_OVERSAMPLE_HZ and raises one DMA
+ * request per used GPIO port each period (update and CC1..CC4, CCRs 1..4,
+ * so the ports are read a few timer clocks apart). Each request moves that
+ * port's IDR into its own circular buffer on DMA2, the only controller
+ * that can reach the AHB1 GPIO ports. Sampling is paced by hardware and
+ * costs no CPU.
+ *
+ * vTaskInputs calls InputDma_Update() every few milliseconds. It walks the
+ * new samples of all ports in step, gathers a sample into an input vector
+ * only when some port changed, and tracks each input's bursts of
+ * transitions:
+ *
+ * - after @ref INPUT_OVERSAMPLE_SETTLE_MS without a transition the burst
+ *   ends; if the level differs from the debounced state the change is
+ *   accepted (vdeb_accept()), stamped with the burst's first transition;
+ * - a burst that ends at the old level is a glitch. It is counted, with
+ *   the shortest pulse seen, so sub-millisecond chatter on the relay
+ *   contacts shows up that a 10 ms poll would never see.
+ *
+ * Sample n is taken at a fixed offset of n periods from the timer start,
+ * so timestamps need no clock reads. TIM5, clocked by TIM8's update, counts
+ * the samples started; with each stream's NDTR it gives the exact number of
+ * samples written (sample_ring.h), so a task that falls a buffer behind
+ * resumes at the newest sample with its number known. If the samples stop
+ * arriving the timers are stopped and InputDma_Running() turns 0;
+ * vTaskInputs then falls back to EXTI and polling.
+ *
+ * @ingroup IPOS_Firmware
+ * @{
+ */
+
+#include "input_dma.h"
+#include "inputs.h"
+#include "sample_ring.h"
+#include "stm32f4xx_hal.h"
+
+#define PERIOD_US       (1000000u / INPUT_OVERSAMPLE_HZ)
+#define SETTLE_SAMPLES  (INPUT_OVERSAMPLE_SETTLE_MS * 1000u / PERIOD_US)
+#define DEPTH           INPUT_OVERSAMPLE_DEPTH
+#define LAP_MARGIN      (INPUT_OVERSAMPLE_HZ / 1000u)   // samples that may land while a block is processed
+
+_Static_assert(1000000u % INPUT_OVERSAMPLE_HZ == 0, "sample period must be whole microseconds");
+_Static_assert((DEPTH & (DEPTH - 1u)) == 0, "buffer depth must be a power of two");
+_Static_assert(DEPTH > INPUT_OVERSAMPLE_STALL_MS * INPUT_OVERSAMPLE_HZ / 1000u,
+               "buffer must hold more than a stall window");
+
+/** TIM8 DMA requests on DMA2 channel 7, one per port */
+static const struct {
+    DMA_Stream_TypeDef *stream;
+    uint32_t            dier;   ///< TIM8 request enable
+} dmaSlots[] = {
+    { DMA2_Stream1, TIM_DIER_UDE },
+    { DMA2_Stream2, TIM_DIER_CC1DE },
+    { DMA2_Stream3, TIM_DIER_CC2DE },
+    { DMA2_Stream4, TIM_DIER_CC3DE },
+    { DMA2_Stream7, TIM_DIER_CC4DE },
+};
+#define DMA_SLOTS   (sizeof(dmaSlots) / sizeof(dmaSlots[0]))
+
+static DMA_HandleTypeDef hdma[DMA_SLOTS];
+static volatile uint16_t sampleBuf[DMA_SLOTS][DEPTH];  ///< written by DMA only
+static uint32_t portCount;
+static uint8_t  running;
+
+/* Task side */
+static uint32_t sampleNo;               ///< next sample to process, at sring_index() in every buffer
+static uint32_t lastTick;               ///< kernel tick of the last new sample
+static uint32_t t0Us;                   ///< ms_now() time base at sample 0, µs
+static uint16_t prevIdr[DMA_SLOTS];
+static uint32_t raw;                    ///< input vector of the last sample
+static uint32_t pending;                ///< inputs inside a burst
+static uint32_t firstNo[NUM_INPUTS];    ///< first transition of the burst
+static uint32_t lastNo[NUM_INPUTS];     ///< latest transition of the burst
+static uint32_t acceptUs[NUM_INPUTS];
+static uint32_t glitchMask;
+static InputChatter chatter[NUM_INPUTS];
+static InputDmaStats stats;
+
+/**
+ * @brief Start TIM8, its TIM5 sample counter and one circular DMA stream
+ *        per input port.
+ *
+ * Call from vTaskInputs after the input scan is set up.
+ *
+ * @return 1 if sampling runs, 0 if it could not be started (too many
+ *         ports, or a DMA error)
+ */
+uint8_t InputDma_Init(void)
+{
+    GPIO_TypeDef *ports[INPUT_MAX_PORTS];
+    portCount = Inputs_Ports(ports);
+    if (portCount == 0 || portCount > DMA_SLOTS)
+        return 0;
+
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    __HAL_RCC_TIM8_CLK_ENABLE();
+    __HAL_RCC_TIM5_CLK_ENABLE();
+
+    uint32_t idr[INPUT_MAX_PORTS];
+    uint32_t dier = 0;
+    for (uint32_t p = 0; p < portCount; p++) {
+        DMA_HandleTypeDef *h = &hdma[p];
+        h->Instance                 = dmaSlots[p].stream;
+        h->Init.Channel             = DMA_CHANNEL_7;
+        h->Init.Direction           = DMA_PERIPH_TO_MEMORY;
+        h->Init.PeriphInc           = DMA_PINC_DISABLE;
+        h->Init.MemInc              = DMA_MINC_ENABLE;
+        h->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+        h->Init.MemDataAlignment    = DMA_MDATAALIGN_HALFWORD;
+        h->Init.Mode                = DMA_CIRCULAR;
+        h->Init.Priority            = DMA_PRIORITY_MEDIUM;
+        h->Init.FIFOMode            = DMA_FIFOMODE_DISABLE;
+        if (HAL_DMA_Init(h) != HAL_OK ||
+            HAL_DMA_Start(h, (uint32_t)&ports[p]->IDR, (uint32_t)sampleBuf[p], DEPTH) != HAL_OK)
+            return 0;
+        idr[p] = prevIdr[p] = (uint16_t)ports[p]->IDR;
+        dier |= dmaSlots[p].dier;
+    }
+    raw = Inputs_Gather(idr);
+
+    uint32_t clk = HAL_RCC_GetPCLK2Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1)
+        clk *= 2u;                          // APB2 timers run at 2x a divided PCLK2
+
+    TIM8->CR1  = 0;
+    TIM8->PSC  = 0;
+    TIM8->ARR  = clk / INPUT_OVERSAMPLE_HZ - 1u;    // 16799 at 168 MHz
+    TIM8->CCR1 = 1;                         // compare requests right after the update
+    TIM8->CCR2 = 2;
+    TIM8->CCR3 = 3;
+    TIM8->CCR4 = 4;
+    TIM8->EGR  = TIM_EGR_UG;                // load PSC/ARR before any request is enabled
+    TIM8->SR   = 0;
+    TIM8->CR2  = TIM_TRGO_UPDATE;           // after the UG, which TIM5 must not count
+    TIM8->DIER = dier;
+
+    // TIM5 (32 bit) counts TIM8 updates on ITR3: the number of samples started
+    TIM5->CR1  = 0;
+    TIM5->PSC  = 0;
+    TIM5->ARR  = 0xFFFFFFFFu;
+    TIM5->SMCR = TIM_TS_ITR3 | TIM_SLAVEMODE_EXTERNAL1;
+    TIM5->CNT  = 0;
+    TIM5->CR1  = TIM_CR1_CEN;
+
+    sampleNo = 0;
+    pending  = 0;
+    lastTick = osKernelGetTickCount();
+    t0Us     = ms_now() * 1000u;
+    TIM8->CR1 = TIM_CR1_CEN;
+    running  = 1;
+    return 1;
+}
+
+/** @brief 0 once sampling has stopped (never started, or stalled). */
+uint8_t InputDma_Running(void)
+{
+    return running;
+}
+
+static void stop(void)
+{
+    TIM8->CR1  = 0;
+    TIM8->DIER = 0;
+    TIM5->CR1  = 0;
+    for (uint32_t p = 0; p < portCount; p++)
+        HAL_DMA_Abort(&hdma[p]);
+    running = 0;
+}
+
+/**
+ * Number of samples every stream has written; @p dmaError is set if a
+ * stream was disabled by a transfer error
+ */
+static uint32_t samples_written(uint8_t *dmaError)
+{
+    uint32_t ndtr[DMA_SLOTS];
+    *dmaError = 0;
+
+    // All NDTRs before TIM5, close together: no stream may be ahead of the count
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t p = 0; p < portCount; p++)
+        ndtr[p] = __HAL_DMA_GET_COUNTER(&hdma[p]);
+    uint32_t ticks = TIM5->CNT;
+    __set_PRIMASK(primask);
+
+    for (uint32_t p = 0; p < portCount; p++)
+        if (!(hdma[p].Instance->CR & DMA_SxCR_EN))
+            *dmaError = 1;
+    return sring_written(ticks, ndtr, portCount, DEPTH);
+}
+
+/** End the bursts of @p mask: accept changes, count the rest as glitches */
+static uint32_t settle(VDebounce *d, uint32_t mask)
+{
+    pending &= ~mask;
+    uint32_t changed = mask & (raw ^ d->stable);
+    uint32_t returned = mask & ~changed;
+    vdeb_accept(d, changed, raw);
+
+    for (uint32_t m = changed; m; m &= m - 1u) {
+        uint32_t i = (uint32_t)__builtin_ctz(m);
+        acceptUs[i] = t0Us + firstNo[i] * PERIOD_US;
+        stats.accepted++;
+    }
+    for (uint32_t m = returned; m; m &= m - 1u) {
+        chatter[__builtin_ctz(m)].glitches++;
+        stats.glitches++;
+    }
+    glitchMask |= returned;
+    return changed;
+}
+
+/** Inputs in @p mask that have had no transition for a settle window */
+static uint32_t quiet(uint32_t mask)
+{
+    uint32_t q = 0;
+    for (uint32_t m = mask; m; m &= m - 1u) {
+        uint32_t i = (uint32_t)__builtin_ctz(m);
+        if (sampleNo - lastNo[i] >= SETTLE_SAMPLES)
+            q |= INPUT_BIT(i);
+    }
+    return q;
+}
+
+/**
+ * @brief Process the samples taken since the last call.
+ *
+ * @param d Input debouncer; accepted inputs take the sampled level
+ * @return INPUT_BIT() mask of inputs whose debounced state changed
+ */
+uint32_t InputDma_Update(VDebounce *d)
+{
+    if (!running)
+        return 0;
+
+    uint32_t now = osKernelGetTickCount();
+    uint8_t dmaError;
+    uint32_t written = samples_written(&dmaError);
+    uint32_t ready = written - sampleNo;
+    uint32_t changed = 0;
+
+    if (dmaError) {
+        stop();
+        return 0;
+    }
+    if (sring_lapped(written, sampleNo, DEPTH, LAP_MARGIN)) {
+        // The DMA lapped us, or is about to: skip to the newest sample and
+        // restart every input that disagrees with the debounced state
+        stats.overruns++;
+        sampleNo = written - 1u;
+        uint32_t idx = sring_index(sampleNo, DEPTH);
+        uint32_t idr[INPUT_MAX_PORTS];
+        for (uint32_t p = 0; p < portCount; p++)
+            idr[p] = prevIdr[p] = sampleBuf[p][idx];
+        raw = Inputs_Gather(idr);
+        pending = raw ^ d->stable;
+        for (uint32_t m = pending; m; m &= m - 1u) {
+            uint32_t i = (uint32_t)__builtin_ctz(m);
+            firstNo[i] = lastNo[i] = sampleNo;
+        }
+        ready = 1;
+    } else if (ready == 0) {
+        if ((now - lastTick) * 1000u / osKernelGetTickFreq() >= INPUT_OVERSAMPLE_STALL_MS)
+            stop();
+        return 0;
+    }
+    lastTick = now;
+    stats.samples += ready;
+
+    for (; ready; ready--) {
+        uint32_t idx = sring_index(sampleNo, DEPTH);
+        uint32_t diff = 0;
+        for (uint32_t p = 0; p < portCount; p++)
+            diff |= sampleBuf[p][idx] ^ prevIdr[p];
+
+        if (diff) {
+            uint32_t idr[INPUT_MAX_PORTS];
+            for (uint32_t p = 0; p < portCount; p++)
+                idr[p] = prevIdr[p] = sampleBuf[p][idx];
+            uint32_t v = Inputs_Gather(idr);
+            uint32_t edges = v ^ raw;
+
+            // A burst that was already over ends before the new one starts
+            uint32_t over = quiet(pending & edges);
+            if (over)
+                changed |= settle(d, over);
+
+            for (uint32_t m = edges; m; m &= m - 1u) {
+                uint32_t i = (uint32_t)__builtin_ctz(m);
+                InputChatter *c = &chatter[i];
+                c->edges++;
+                if (pending & INPUT_BIT(i)) {
+                    uint32_t us = (sampleNo - lastNo[i]) * PERIOD_US;
+                    if (c->minPulseUs == 0 || us < c->minPulseUs)
+                        c->minPulseUs = us;
+                } else {
+                    firstNo[i] = sampleNo;
+                }
+                lastNo[i] = sampleNo;
+            }
+            pending |= edges;
+            raw = v;
+        }
+
+        sampleNo++;
+    }
+
+    uint32_t over = quiet(pending);
+    if (over)
+        changed |= settle(d, over);
+    return changed;
+}
+
+/** @brief Inputs with a glitch since the last call (then cleared). */
+uint32_t InputDma_TakeGlitches(void)
+{
+    uint32_t g = glitchMask;
+    glitchMask = 0;
+    return g;
+}
+
+/**
+ * @brief Time of the first transition of the last change accepted for @p input.
+ * @return Microseconds on the ms_now() time base
+ */
+uint32_t InputDma_TimeUs(uint32_t input)
+{
+    return input < NUM_INPUTS ? acceptUs[input] : 0;
+}
+
+/**
+ * @brief How long the task may sleep before the next block is due.
+ * @param maxTicks Ticks until the next 10 ms tick of the task
+ * @return Kernel ticks, at most @p maxTicks
+ */
+uint32_t InputDma_WaitTicks(uint32_t maxTicks)
+{
+    uint32_t freq = osKernelGetTickFreq();
+    uint32_t wait = INPUT_OVERSAMPLE_BLOCK_MS * freq / 1000u;
+
+    for (uint32_t m = pending; m; m &= m - 1u) {
+        uint32_t age = sampleNo - lastNo[__builtin_ctz(m)];
+        if (age >= SETTLE_SAMPLES)
+            return 0;
+        uint32_t us = (SETTLE_SAMPLES - age) * PERIOD_US;
+        uint32_t t = (us * (freq / 1000u) + 999u) / 1000u;
+        if (t < wait)
+            wait = t;
+    }
+    if (wait == 0)
+        wait = 1;
+    return wait < maxTicks ? wait : maxTicks;
+}
+
+/** @brief Copy the sampling counters. */
+void InputDma_GetStats(InputDmaStats *out)
+{
+    *out = stats;
+}
+
+/** @brief Copy the transition counters of one input. */
+void InputDma_GetChatter(uint32_t input, InputChatter *out)
+{
+    if (input < NUM_INPUTS)
+        *out = chatter[input];
+}
+
+/** @} */
@@ -0,0 +1,262 @@
+/**
+ * @file input_edge.c
+ * @defgroup input_edge Input Edge Capture
+ * @brief EXTI front end for the safety inputs, stamped with the cycle counter.
+ *
+ * The 10 ms poll in vTaskInputs needs three samples to accept a change, so
+ * an ESTOP press could take ~40 ms to reach the safety rules. The pins
+ * listed in edgeInputList[] therefore also interrupt on both edges:
+ *
+ * - the ISR reads DWT->CYCCNT, clears its EXTI lines and queues one
+ *   {cycles, inputs} entry in a lock-free byte ring (ISR writes, task
+ *   reads), then wakes vTaskInputs with @ref INPUT_EDGE_FLAG;
+ * - InputEdge_Update() (task) drains the ring and accepts an input once its
+ *   pin has had no edge for @ref INPUT_EDGE_SETTLE_MS and its level still
+ *   differs from the debounced state. Contact bounce only restarts the
+ *   wait, so the reaction time is about one settle window.
+ *
+ * The poll keeps running for every input and catches anything the edges
+ * missed (queue overflow, a lost interrupt); InputEdge_PollCheck() counts
+ * those cases. A change is accepted once, by whichever path sees it first,
+ * since both update the same VDebounce.
+ *
+ * Timestamps are microseconds on the ms_now() time base, extended from
+ * the 32-bit cycle counter by the task, which runs far more often than the
+ * counter wraps (~25 s at 168 MHz).
+ *
+ * @ingroup IPOS_Firmware
+ * @{
+ */
+
+#include "input_edge.h"
+#include "inputs.h"
+#include "ring_buffer.h"
+#include "stm32f4xx_hal.h"
+
+/**
+ * Inputs armed on EXTI. Each needs its own EXTI line in 5..14: lines 0..4
+ * have no handler here and line 15 is the latch-reset button (PA15), so
+ * RELAY2_ON (PE15) and the remaining inputs stay poll-only.
+ */
+static const uint8_t edgeInputList[] = {
+    INPUT_DOOR, INPUT_ESTOP, INPUT_KEY, INPUT_BDO,
+    INPUT_DOOR_LATCH_ERR, INPUT_ESTOP_LATCH_ERR, INPUT_KEY_LATCH_ERR, INPUT_BDO_LATCH_ERR,
+    INPUT_RELAY_LATCH_ERR,
+};
+
+#define EDGE_LINES_USABLE   0x7FE0u     // EXTI lines 5..14
+
+/** One queued interrupt */
+typedef struct {
+    uint32_t cyc;       ///< DWT->CYCCNT at entry to the ISR
+    uint32_t inputs;    ///< INPUT_BIT() of every armed input whose line fired
+} InputEdge;
+
+static uint8_t edgeStorage[INPUT_EDGE_QUEUE_SIZE];
+static RingBuffer edgeRing = { edgeStorage, INPUT_EDGE_QUEUE_SIZE, 0, 0 };
+
+static osThreadId_t edgeTask;
+static uint32_t edgeLines;              ///< EXTI lines owned by this module
+static uint8_t  lineInput[16];          ///< EXTI line -> InputName
+static uint32_t armedMask;              ///< INPUT_BIT() of the armed inputs
+
+static volatile uint32_t statEdges, statOverflows;     // ISR
+static uint32_t statAccepted, statPollCaught;          // task
+
+/* Task side */
+static uint32_t pending;                ///< inputs with edges not yet settled
+static uint32_t firstCyc[NUM_INPUTS];   ///< first edge of the current burst
+static uint32_t lastCyc[NUM_INPUTS];    ///< latest edge of the current burst
+static uint32_t acceptUs[NUM_INPUTS];   ///< first-edge time of the last accepted change
+
+/* Microsecond clock extended from CYCCNT; advanced by the task only */
+static uint32_t perUs, settleCyc, refCyc, refUs, refRem;
+
+static void clock_advance(void)
+{
+    uint32_t now = DWT->CYCCNT;
+    uint32_t d = (now - refCyc) + refRem;
+    refCyc = now;
+    refUs += d / perUs;
+    refRem = d % perUs;
+}
+
+/** @brief Time of a cycle stamp taken before the last clock_advance(). */
+static uint32_t cyc_to_us(uint32_t cyc)
+{
+    return refUs - (refCyc - cyc) / perUs;
+}
+
+/**
+ * @brief Arm EXTI on the safety inputs and start the cycle counter.
+ *
+ * Call from vTaskInputs after the input scan is set up.
+ *
+ * @param task Thread to wake on an edge
+ */
+void InputEdge_Init(osThreadId_t task)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    perUs     = SystemCoreClock / 1000000u;
+    settleCyc = INPUT_EDGE_SETTLE_MS * 1000u * perUs;
+    refCyc    = DWT->CYCCNT;
+    refUs     = ms_now() * 1000u;
+    refRem    = 0;
+    edgeTask  = task;
+
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+
+    GPIO_InitTypeDef gi = {0};
+    gi.Mode = GPIO_MODE_IT_RISING_FALLING;
+    gi.Pull = GPIO_NOPULL;                  // as configured by CubeMX
+    for (uint32_t k = 0; k < sizeof(edgeInputList); k++) {
+        uint8_t in = edgeInputList[k];
+        const InputPin *p = &inputPins[in];
+        if (!(p->pin & EDGE_LINES_USABLE) || (edgeLines & p->pin))
+            continue;                       // no handler, or line already taken: poll only
+        lineInput[__builtin_ctz(p->pin)] = in;
+        edgeLines |= p->pin;
+        armedMask |= INPUT_BIT(in);
+        gi.Pin = p->pin;
+        HAL_GPIO_Init(p->port, &gi);
+    }
+    __HAL_GPIO_EXTI_CLEAR_IT(edgeLines);
+
+    HAL_NVIC_SetPriority(EXTI9_5_IRQn, 5, 0);      // may call osThreadFlagsSet()
+    HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+    HAL_NVIC_SetPriority(EXTI15_10_IRQn, 5, 0);    // shared with the reset button
+    HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+}
+
+/**
+ * @brief Queue the edges of our EXTI lines and wake the input task.
+ *
+ * Called from EXTI9_5_IRQHandler() and from EXTI15_10_IRQHandler() before
+ * the HAL handles the reset button; other lines are left alone.
+ */
+void InputEdge_IRQHandler(void)
+{
+    uint32_t cyc = DWT->CYCCNT;
+    uint32_t pr = EXTI->PR & edgeLines;
+    if (pr == 0)
+        return;
+    EXTI->PR = pr;                          // write 1 to clear
+
+    InputEdge e = { cyc, 0 };
+    for (uint32_t l = pr; l; l &= l - 1u)
+        e.inputs |= INPUT_BIT(lineInput[__builtin_ctz(l)]);
+
+    statEdges++;
+    if (rb_space(&edgeRing) >= sizeof(e))
+        rb_write_n(&edgeRing, (const uint8_t *)&e, sizeof(e));
+    else
+        statOverflows++;                    // the poll will still see the change
+
+    if (edgeTask)
+        osThreadFlagsSet(edgeTask, INPUT_EDGE_FLAG);
+}
+
+/** EXTI lines 5..9 are only used by the safety inputs. */
+void EXTI9_5_IRQHandler(void)
+{
+    InputEdge_IRQHandler();
+}
+
+/**
+ * @brief Drain queued edges and accept inputs that have settled.
+ *
+ * @param d Input debouncer; accepted inputs take the current level and
+ *          restart their poll count (vdeb_accept())
+ * @return INPUT_BIT() mask of inputs whose debounced state changed
+ */
+uint32_t InputEdge_Update(VDebounce *d)
+{
+    InputEdge e;
+    while (rb_count(&edgeRing) >= sizeof(e)) {
+        rb_read_n(&edgeRing, (uint8_t *)&e, sizeof(e));
+        for (uint32_t m = e.inputs; m; m &= m - 1u) {
+            uint32_t i = (uint32_t)__builtin_ctz(m);
+            if (!(pending & INPUT_BIT(i)))
+                firstCyc[i] = e.cyc;
+            lastCyc[i] = e.cyc;
+        }
+        pending |= e.inputs;
+    }
+    clock_advance();                        // after the drain: every stamp is in the past
+
+    uint32_t quiet = 0;
+    for (uint32_t m = pending; m; m &= m - 1u) {
+        uint32_t i = (uint32_t)__builtin_ctz(m);
+        if (refCyc - lastCyc[i] >= settleCyc)
+            quiet |= INPUT_BIT(i);
+    }
+    if (quiet == 0)
+        return 0;
+    pending &= ~quiet;
+
+    uint32_t level = Inputs_Sample();
+    uint32_t changed = quiet & (level ^ d->stable);   // a glitch that came back is no change
+    vdeb_accept(d, changed, level);
+
+    for (uint32_t m = changed; m; m &= m - 1u) {
+        uint32_t i = (uint32_t)__builtin_ctz(m);
+        acceptUs[i] = cyc_to_us(firstCyc[i]);
+        statAccepted++;
+    }
+    return changed;
+}
+
+/**
+ * @brief Cross-check: count armed inputs whose change the poll found first.
+ * @param polled Changed mask returned by vdeb_update()
+ */
+void InputEdge_PollCheck(uint32_t polled)
+{
+    for (uint32_t m = polled & armedMask; m; m &= m - 1u) {
+        pending &= ~INPUT_BIT(__builtin_ctz(m));
+        statPollCaught++;
+    }
+}
+
+/**
+ * @brief Time of the first edge of the last change accepted for @p input.
+ * @return Microseconds on the ms_now() time base
+ */
+uint32_t InputEdge_TimeUs(uint32_t input)
+{
+    return input < NUM_INPUTS ? acceptUs[input] : 0;
+}
+
+/**
+ * @brief How long the task may sleep before the next input settles.
+ * @param maxTicks Ticks until the next poll
+ * @return Kernel ticks, at most @p maxTicks
+ */
+uint32_t InputEdge_WaitTicks(uint32_t maxTicks)
+{
+    if (pending == 0)
+        return maxTicks;
+
+    uint32_t now = DWT->CYCCNT;
+    uint32_t cycPerTick = SystemCoreClock / osKernelGetTickFreq();
+    uint32_t wait = maxTicks;
+    for (uint32_t m = pending; m; m &= m - 1u) {
+        uint32_t age = now - lastCyc[__builtin_ctz(m)];
+        uint32_t t = age >= settleCyc ? 0 : (settleCyc - age + cycPerTick - 1u) / cycPerTick;
+        if (t < wait)
+            wait = t;
+    }
+    return wait;
+}
+
+/** @brief Copy the edge counters. */
+void InputEdge_GetStats(InputEdgeStats *out)
+{
+    out->edges      = statEdges;
+    out->overflows  = statOverflows;
+    out->accepted   = statAccepted;
+    out->pollCaught = statPollCaught;
+}
+
+/** @} */
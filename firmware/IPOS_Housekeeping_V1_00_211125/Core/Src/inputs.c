@@ -29,6 +29,14 @@
 #include "error_codes.h"
 
 #include "safety_utils.h"
+#include "master_link.h"   // master_link_get_stats()
+#include "telemetry.h"     // STREAM mode records
+#include "fmtlog.h"        // FmtLog_Drain(), FLOG_LEVEL()
+#include "debug_flags.h"   // UsbCommand_Poll(), UsbCommand_PrintHelp()
+#include "debounce.h"      // vertical-counter debouncer
+#include "input_edge.h"    // EXTI edge capture
+#include "input_dma.h"     // timer/DMA oversampling (INPUT_OVERSAMPLE)
+#include "error_rules.h"   // errorRules[], sr_eval()
 
 volatile bool systemReady = false;
 
@@ -43,10 +51,11 @@ extern uint8_t laserLatchedOff;   // software latch
 volatile uint8_t swLatchFaultActive = 0;  // 1 = fault latched
 volatile uint8_t swLatchForceError = 0;  // 1 = force latch error regardless of inputs
 
-#define TEMP_TRIP_HIGH_C   60.0f
-#define TEMP_TRIP_CLEAR_C  58.0f
-#define TEMP_TRIP_LOW_C    10.0f
-#define TEMP_TRIP_LOW_CLR  12.0f
+/* Hysteresis thresholds in whole °C, compared in MAX31855 0.25 °C units */
+#define TEMP_TRIP_HIGH_C   60
+#define TEMP_TRIP_CLEAR_C  58
+#define TEMP_TRIP_LOW_C    10
+#define TEMP_TRIP_LOW_CLR  12
 
 /**
  * @brief Enables or disables temperature checks.
@@ -125,241 +134,15 @@ const char *inputNames[NUM_INPUTS] = {
 };
 
 uint8_t stableState[NUM_INPUTS];
-uint8_t changeCount[NUM_INPUTS];
+/** Debouncer state; .stable is stableState[] as one word */
+static VDebounce inputDebounce;
 
 // -----------------------------------------------------------------------------
 // Error condition functions
 // -----------------------------------------------------------------------------
 
-// contactor relay check
 #define MS_TO_TICKS(ms)       ((ms) * osKernelGetTickFreq() / 1000U)
 
-#define CONTACTOR_RELAY_GRACE_MS   50
-
-static uint32_t relayCheckTick = 0;
-
-// -----------------------------------------------------------------------------
-// Condition check functions
-// -----------------------------------------------------------------------------
-
-/**
- * @brief Verify relay contact feedback consistency.
- *
- * Checks NO1 and NC1 contact states after both relay coils are ON.
- * A short grace period (50 ms) avoids false trips.
- * If mismatch persists, logs a fault and forces latch error.
- *
- * @return 0 if contacts match (OK), 1 if mismatch detected (fault).
- */
-
-uint8_t Cond_RelayContactsMatch(void)
-{
-    static uint8_t lastFault = 0;
-    static uint32_t relayCheckTick = 0;
-
-    if (!systemReady)
-        return 0;   // ignore during startup grace
-
-    // ---------------------------------------------------------
-    // Skip entirely unless all safeties are active
-    // ---------------------------------------------------------
-    if (!AllSafetiesActive()) {
-        lastFault = 0;
-        relayCheckTick = 0;
-        return 0;
-    }
-
-    uint8_t relay1 = stableState[INPUT_RELAY1_ON];
-    uint8_t relay2 = stableState[INPUT_RELAY2_ON];
-    uint8_t no1    = stableState[INPUT_NO1];
-    uint8_t nc1    = stableState[INPUT_NC1];
-
-    // ---------------------------------------------------------
-    // 1. No relays ON  → nothing to check
-    // ---------------------------------------------------------
-    if (!(relay1 && relay2)) {
-        relayCheckTick = 0;
-        lastFault = 0;
-        return 0;
-    }
-
-    // ---------------------------------------------------------
-    // 2. Relays ON → start / check timing
-    // ---------------------------------------------------------
-    if (relayCheckTick == 0)
-        relayCheckTick = osKernelGetTickCount();
-
-    if ((osKernelGetTickCount() - relayCheckTick) <= MS_TO_TICKS(CONTACTOR_RELAY_GRACE_MS))
-        return 0;   // still within grace period, let contacts settle
-
-    // ---------------------------------------------------------
-    // 3. After grace → verify contacts
-    // ---------------------------------------------------------
-    if (no1 == 1 && nc1 == 0) {
-        if (lastFault && logQueue) {
-            LogMsg_t m = { .code = LOGCODE_RELAY_CLEAR, .flags = 0 };
-            strcpy(m.msg, "Relay contacts OK");
-            osMessageQueuePut(logQueue, &m, 0, 0);
-        }
-        lastFault = 0;
-        return 0;
-    } else {
-        // 💬 Print once, immediately before reporting fault
-        if (!lastFault) {
-            UsbPrintf("[DEBUG] BEFORE FAULT: R1=%u R2=%u NO1=%u NC1=%u\r\n",
-                      relay1, relay2, no1, nc1);
-        }
-
-        if (!lastFault && logQueue) {
-            LogMsg_t m = { .code = LOGCODE_RELAY_FAULT, .flags = 1 };
-            strcpy(m.msg, "Relay contacts mismatch");
-            osMessageQueuePut(logQueue, &m, 0, 0);
-        }
-
-        lastFault = 1;
-        swLatchForceError = 1;
-        return 1;
-    }
-}
-
-
-/**
- * @brief Verify that door interlock requires both relays ON.
- *
- * When the door switch is active, both relay feedbacks must be ON.
- * A short delay is allowed for relays to settle before faulting.
- *
- * @return 0 if condition OK, 1 if relays not active while door is open.
- */
-#define DOOR_RELAY_GRACE_MS   50
-
-uint8_t Cond_DoorRequiresRelays(void)
-{
-    static uint32_t safetiesStableTick = 0;
-
-    if (!systemReady)
-        return 0;
-
-    // Check if all safeties active
-    if (!AllSafetiesActive()) {
-        safetiesStableTick = 0;
-        return 0;
-    }
-
-    // Wait until all safeties have been ON for at least 1 s
-    if (safetiesStableTick == 0)
-        safetiesStableTick = osKernelGetTickCount();
-
-    if ((osKernelGetTickCount() - safetiesStableTick) < MS_TO_TICKS(1000))
-        return 0;  // still within arming grace period
-
-    // --- Door/relay logic ---
-    uint8_t door   = stableState[INPUT_DOOR];        // 1 = closed
-    uint8_t relay1 = stableState[INPUT_RELAY1_ON];
-    uint8_t relay2 = stableState[INPUT_RELAY2_ON];
-
-    // When the door is open (0), relays are expected OFF, no fault
-    if (!door) {
-        safetiesStableTick = 0;  // reset timer so next close waits another 1 s
-        return 0;
-    }
-
-    // Door is closed AND system armed → relays must be ON
-    if (door && !(relay1 && relay2)) {
-        return 1;   // fault
-    }
-
-    return 0;
-}
-
-
-
-/**
- * @brief Check 12 V and 24 V rails and fuse status.
- *
- * Logs and forces laser disable if any rail or fuse is not good.
- *
- * @return 0 if power rails OK, 1 if any power fault detected.
- */
-static uint8_t Cond_PowerGood(void)
-{
-    static uint8_t lastFault = 0;
-    uint8_t ok12 = stableState[INPUT_12V_PWR_GOOD];
-    uint8_t ok24 = stableState[INPUT_24V_PWR_GOOD];
-    uint8_t ok12vF = stableState[INPUT_12V_FUSE_GOOD];
-
-    if (ok12 && ok24 && ok12vF) {
-        if (lastFault && logQueue) {
-            LogMsg_t m = { .code = LOGCODE_POWER_CLEAR, .flags = 0 };
-            strcpy(m.msg, "Power rails OK");
-            osMessageQueuePut(logQueue, &m, 0, 0);
-        }
-        lastFault = 0;
-        return 0;   // OK
-    }
-
-    if (!lastFault && logQueue) {
-        LogMsg_t m = { .code = LOGCODE_POWER_FAULT, .flags = 1 };
-        strcpy(m.msg, "Power fault detected");
-        osMessageQueuePut(logQueue, &m, 0, 0);
-    }
-    lastFault = 1;
-
-    swLatchForceError = 1;
-    laserLatchedOff   = 1;
-    laser_disable();
-    return 1;
-}
-
-/**
- * @brief Evaluate latch fault inputs and software flags.
- *
- * Monitors all hardware latch error lines and software latch overrides.
- * If a latch error occurs, disables laser, logs fault, and sets
- * `swLatchFaultActive = 1`.
- *
- * @return 0 if no fault, 1 if latch fault active.
- */
-uint8_t Cond_LatchError(void)
-{
-    static uint8_t lastFault = 0;
-
-    uint8_t currentFault =
-        swLatchForceError ||
-        stableState[INPUT_DOOR_LATCH_ERR] ||
-        stableState[INPUT_ESTOP_LATCH_ERR] ||
-        stableState[INPUT_KEY_LATCH_ERR] ||
-        stableState[INPUT_BDO_LATCH_ERR] ||
-        stableState[INPUT_RELAY_LATCH_ERR];
-
-    if (currentFault) {
-        if (!lastFault) {
-            swLatchFaultActive = 1;
-            laserLatchedOff = 1;
-            SetAllLatchesToFaultState();
-            laser_disable();
-            UsbPrintf("[FAULT] Latch error detected (forced=%u)\r\n", swLatchForceError);
-
-            if (logQueue) {
-                LogMsg_t m = { .code = LOGCODE_LATCH_FAULT, .flags = 1 };
-                strcpy(m.msg, "Latch fault triggered");
-                osMessageQueuePut(logQueue, &m, 0, 0);
-            }
-        }
-        lastFault = 1;
-        return 1;
-    }
-
-    if (lastFault && logQueue) {
-        LogMsg_t m = { .code = LOGCODE_LATCH_CLEAR, .flags = 0 };
-        strcpy(m.msg, "Latch fault cleared");
-        osMessageQueuePut(logQueue, &m, 0, 0);
-    }
-
-    lastFault = 0;
-    return 0;
-}
-
 /**
  * @brief Check laser thermocouple temperature for safety.
  *
@@ -370,7 +153,7 @@ uint8_t Cond_LatchError(void)
  *
  * @return 1 if temperature safe, 0 if fault active.
  */
-float lastTripTemp = 0.0f;   // captures temperature at fault
+int16_t lastTripTemp = 0;   // captures temperature at fault (0.25 °C units)
 uint8_t tempFaultActive = 0;
 
 uint8_t Cond_TemperatureSafe(void)
@@ -401,7 +184,9 @@ uint8_t Cond_TemperatureSafe(void)
         // Optional: very low-rate print to avoid spam
         static uint8_t last = 0;
         if (!last && verboseLogging) {
-            UsbPrintf("[THERMO] Bypass active -> skipping checks at %.2f degC\r\n", d.tc_c);
+            char t[FX_STR_MAX];
+            UsbPrintf("[THERMO] Bypass active -> skipping checks at %s degC\r\n",
+                      fx_format(t, sizeof(t), d.tc_q2, MAX31855_TC_FRAC, 2));
         }
         last = 1;
         return 1;
@@ -414,18 +199,23 @@ uint8_t Cond_TemperatureSafe(void)
     // ---------- Hysteresis handling ----------
     if (!tempFaultActive) {
         // Trip condition
-        if (d.flag || d.tc_c > TEMP_TRIP_HIGH_C || d.tc_c < TEMP_TRIP_LOW_C) {
+        if (d.flag ||
+            d.tc_q2 > MAX31855_TC_FROM_C(TEMP_TRIP_HIGH_C) ||
+            d.tc_q2 < MAX31855_TC_FROM_C(TEMP_TRIP_LOW_C)) {
+            char t[FX_STR_MAX];
             tempFaultActive = 1;
-            lastTripTemp = d.tc_c;
+            lastTripTemp = d.tc_q2;
             swLatchForceError = 1;
             laserLatchedOff   = 1;
             laser_disable();
 
-            UsbPrintf("[THERMO] Fault: %.2f degC -> Laser DISABLED\r\n", lastTripTemp);
+            UsbPrintf("[THERMO] Fault: %s degC -> Laser DISABLED\r\n",
+                      fx_format(t, sizeof(t), lastTripTemp, MAX31855_TC_FRAC, 2));
 
             if (logQueue) {
                 LogMsg_t m = { .code = LOGCODE_OVERTEMP, .flags = tempFaultActive };
-                snprintf(m.msg, sizeof(m.msg), "Overtemp %.1fC -> Disabled", d.tc_c);
+                snprintf(m.msg, sizeof(m.msg), "Overtemp %sC -> Disabled",
+                         fx_format(t, sizeof(t), d.tc_q2, MAX31855_TC_FRAC, 1));
                 osMessageQueuePut(logQueue, &m, 0, 0);
             }
             return 0;
@@ -433,16 +223,19 @@ uint8_t Cond_TemperatureSafe(void)
     } else {
         // Recovery condition
         if (!d.flag &&
-            d.tc_c < TEMP_TRIP_CLEAR_C &&
-            d.tc_c > TEMP_TRIP_LOW_CLR) {
+            d.tc_q2 < MAX31855_TC_FROM_C(TEMP_TRIP_CLEAR_C) &&
+            d.tc_q2 > MAX31855_TC_FROM_C(TEMP_TRIP_LOW_CLR)) {
 
+            char t[FX_STR_MAX];
             tempFaultActive = 0;
             laser_enable();
-            UsbPrintf("[THERMO] Cleared: %.2f degC -> Laser ENABLED\r\n", d.tc_c);
+            UsbPrintf("[THERMO] Cleared: %s degC -> Laser ENABLED\r\n",
+                      fx_format(t, sizeof(t), d.tc_q2, MAX31855_TC_FRAC, 2));
 
             if (logQueue) {
                 LogMsg_t m = { .code = 2002, .flags = 0 };
-                snprintf(m.msg, sizeof(m.msg), "Temp normal %.1fC -> Enabled", d.tc_c);
+                snprintf(m.msg, sizeof(m.msg), "Temp normal %sC -> Enabled",
+                         fx_format(t, sizeof(t), d.tc_q2, MAX31855_TC_FRAC, 1));
                 osMessageQueuePut(logQueue, &m, 0, 0);
             }
         }
@@ -456,47 +249,7 @@ uint8_t Cond_TemperatureSafe(void)
 // Error rules
 // -----------------------------------------------------------------------------
 
-/**
- * @brief Evaluate all defined error conditions and queue USB messages.
- *
- * Called periodically by `vTaskInputs()` to detect transitions
- * between fault-active and fault-cleared states.
- */
-static ErrorRule_t errorRules[] = {
-    {
-        .condition  = Cond_DoorRequiresRelays,
-        .msgActive  = "ERROR: DOOR active but Relay1 or Relay2 is OFF!",
-        .msgCleared = "INFO: DOOR+Relay1+Relay2 condition OK",
-        .active     = 0
-    },
-    {
-        .condition  = Cond_RelayContactsMatch,
-        .msgActive  = "ERROR: Relay1+Relay2 ON but contacts NO1/NC1 mismatch!",
-        .msgCleared = "INFO: Relay1+Relay2 contacts match (NO1=1, NC1=0)",
-        .active     = 0
-    },
-    {
-        .condition  = Cond_LatchError,
-        .msgActive  = "ERROR: Latch error detected — Laser DISABLED!",
-        .msgCleared = "INFO: Latch error cleared (requires RESET to re-enable)",
-        .active     = 0
-    },
-    {
-        .condition  = Cond_PowerGood,
-        .msgActive  = "ERROR: 12V, 24V or 12V Fuse power fault - Laser DISABLED!",
-        .msgCleared = "INFO: Power rails OK (12V, 24V & 12V Fuse good)",
-        .active     = 0
-    },
-	{
-	    .condition  = Cond_TemperatureSafe,
-	    .msgActive  = "ERROR: Laser temperature out of range - Laser DISABLED!",
-	    .msgCleared = "INFO: Laser temperature within safe range",
-	    .active     = 0
-	},
-
-};
-
-#define NUM_ERROR_RULES (sizeof(errorRules) / sizeof(errorRules[0]))
+static SafetyRuleState ruleState;
 
 // -----------------------------------------------------------------------------
 // Status word builders
@@ -519,9 +272,9 @@ uint16_t App_BuildDebugStatusWord(void)
 //    if (stableState[INPUT_BDO])           w |= (1 << 3); // change to laser 1 ??
     if (stableState[INPUT_RELAY1_ON])     w |= (1 << 4);
     if (stableState[INPUT_RELAY2_ON])     w |= (1 << 5);
-    if (errorRules[0].active)             w |= (1 << 6);   // Door/relay fault
-    if (errorRules[1].active)             w |= (1 << 7);   // Contact mismatch
-    if (errorRules[2].active)             w |= (1 << 8);   // Latch error
+    if (ruleState.active & (1u << RULE_DOOR_RELAYS))    w |= (1 << 6);   // Door/relay fault
+    if (ruleState.active & (1u << RULE_RELAY_CONTACTS)) w |= (1 << 7);   // Contact mismatch
+    if (ruleState.active & (1u << RULE_LATCH))          w |= (1 << 8);   // Latch error
     if (stableState[INPUT_12V_PWR_GOOD])  w |= (1 << 9);
     if (stableState[INPUT_24V_PWR_GOOD])  w |= (1 << 10);
     if (stableState[INPUT_12V_FUSE_GOOD])  w |= (1 << 11);
@@ -582,7 +335,7 @@ uint16_t App_BuildActiveStatusWord(void)
     // -----------------------------------------------------------------
 	// Add rounded temperature (°C) into upper byte (bits 15..8)
 	// -----------------------------------------------------------------
-	int tempInt = (int)lroundf(g_ThermoData.tc_c);   // round to nearest °C
+	int tempInt = (int)fx_round(g_ThermoData.tc_q2, MAX31855_TC_FRAC);   // round to nearest °C
 
 	if (tempInt < 0)       tempInt = 0;
 	if (tempInt > 255)     tempInt = 255;            // cap to 8 bits
@@ -596,72 +349,198 @@ uint16_t App_BuildActiveStatusWord(void)
 // Helpers
 // -----------------------------------------------------------------------------
 
-static inline uint8_t ReadInput(InputName name)
+/**
+ * @brief Where each input is wired, in InputName order.
+ *
+ * Taken from the CubeMX pin defines, so a pin moved in the .ioc moves here
+ * too. InputScan_Init() turns it into the per-scan port list and shifts;
+ * input_edge.c arms EXTI from it.
+ */
+const InputPin inputPins[NUM_INPUTS] = {
+    [INPUT_DOOR]                = { ILOCK_DOOR_SW_ON_GPIO_Port,       ILOCK_DOOR_SW_ON_Pin },
+    [INPUT_DOOR_LATCH_ERR]      = { ILOCK_DOOR_LATCH_ERROR_GPIO_Port, ILOCK_DOOR_LATCH_ERROR_Pin },
+    [INPUT_ESTOP]               = { ILOCK_ESTOP_SW_ON_GPIO_Port,      ILOCK_ESTOP_SW_ON_Pin },
+    [INPUT_ESTOP_LATCH_ERR]     = { ILOCK_ESTOP_LATCH_ERROR_GPIO_Port, ILOCK_ESTOP_LATCH_ERROR_Pin },
+    [INPUT_KEY]                 = { ILOCK_KEY_SW_ON_GPIO_Port,        ILOCK_KEY_SW_ON_Pin },
+    [INPUT_KEY_LATCH_ERR]       = { ILOCK_KEY_LATCH_ERROR_GPIO_Port,  ILOCK_KEY_LATCH_ERROR_Pin },
+    [INPUT_BDO]                 = { ILOCK_BDO_SW_ON_GPIO_Port,        ILOCK_BDO_SW_ON_Pin },
+    [INPUT_BDO_LATCH_ERR]       = { ILOCK_BDO_LATCH_ERROR_GPIO_Port,  ILOCK_BDO_LATCH_ERROR_Pin },
+    [INPUT_RELAY1_ON]           = { LASER_RELAY1_ON_GPIO_Port,        LASER_RELAY1_ON_Pin },
+    [INPUT_RELAY2_ON]           = { LASER_RELAY2_ON_GPIO_Port,        LASER_RELAY2_ON_Pin },
+    [INPUT_RELAY_LATCH_ERR]     = { LASER_LATCH_ERROR_GPIO_Port,      LASER_LATCH_ERROR_Pin },
+    [INPUT_NO1]                 = { NO_1_GPIO_Port,                   NO_1_Pin },
+    [INPUT_NC1]                 = { NC_1_GPIO_Port,                   NC_1_Pin },
+    [INPUT_12V_PWR_GOOD]        = { PWR_GOOD_12V_GPIO_Port,           PWR_GOOD_12V_Pin },
+    [INPUT_24V_PWR_GOOD]        = { PWR_GOOD_24V_GPIO_Port,           PWR_GOOD_24V_Pin },
+    [INPUT_12V_FUSE_GOOD]       = { FUSE_12V_GOOD_GPIO_Port,          FUSE_12V_GOOD_Pin },
+    [INPUT_TRU_LAS_DEACTIVATED] = { TRU_LAS_DEACTIVATED_GPIO_Port,    TRU_LAS_DEACTIVATED_Pin },
+    [INPUT_TRU_SYS_FAULT]       = { TRU_SYSTEM_FAULT_GPIO_Port,       TRU_SYSTEM_FAULT_Pin },
+    [INPUT_TRU_BEAM_DELIVERY]   = { TRU_BEAM_DELIVERY_GPIO_Port,      TRU_BEAM_DELIVERY_Pin },
+    [INPUT_TRU_EMISS_WARN]      = { TRU_EMM_WARN_GPIO_Port,           TRU_EMM_WARN_Pin },
+    [INPUT_TRU_ALARM]           = { TRU_ALARM_GPIO_Port,              TRU_ALARM_Pin },
+    [INPUT_TRU_MONITOR]         = { TRU_MONITOR_GPIO_Port,            TRU_MONITOR_Pin },
+    [INPUT_TRU_TEMPERATURE]     = { TRU_TEMPERATURE_GPIO_Port,        TRU_TEMPERATURE_Pin },
+};
+
+_Static_assert(NUM_INPUTS <= 32, "input vector is one 32-bit word");
+
+/* Built once from inputPins[] by InputScan_Init() */
+static GPIO_TypeDef *scanPorts[INPUT_MAX_PORTS];   ///< distinct ports, each read once per scan
+static uint8_t scanPortCount;
+static uint8_t scanPortOf[NUM_INPUTS];             ///< input -> index into scanPorts[]
+static uint8_t scanShift[NUM_INPUTS];              ///< input -> pin number in that IDR
+
+/**
+ * @brief Group inputPins[] by port and precompute each input's shift.
+ */
+static void InputScan_Init(void)
 {
-    switch (name) {
-        case INPUT_DOOR:              return HAL_GPIO_ReadPin(ILOCK_DOOR_SW_ON_GPIO_Port, ILOCK_DOOR_SW_ON_Pin);
-        case INPUT_DOOR_LATCH_ERR:    return HAL_GPIO_ReadPin(ILOCK_DOOR_LATCH_ERROR_GPIO_Port, ILOCK_DOOR_LATCH_ERROR_Pin);
-        case INPUT_ESTOP:             return HAL_GPIO_ReadPin(ILOCK_ESTOP_SW_ON_GPIO_Port, ILOCK_ESTOP_SW_ON_Pin);
-        case INPUT_ESTOP_LATCH_ERR:   return HAL_GPIO_ReadPin(ILOCK_ESTOP_LATCH_ERROR_GPIO_Port, ILOCK_ESTOP_LATCH_ERROR_Pin);
-        case INPUT_KEY:               return HAL_GPIO_ReadPin(ILOCK_KEY_SW_ON_GPIO_Port, ILOCK_KEY_SW_ON_Pin);
-        case INPUT_KEY_LATCH_ERR:     return HAL_GPIO_ReadPin(ILOCK_KEY_LATCH_ERROR_GPIO_Port, ILOCK_KEY_LATCH_ERROR_Pin);
-        case INPUT_BDO:               return HAL_GPIO_ReadPin(ILOCK_BDO_SW_ON_GPIO_Port, ILOCK_BDO_SW_ON_Pin);
-        case INPUT_BDO_LATCH_ERR:     return HAL_GPIO_ReadPin(ILOCK_BDO_LATCH_ERROR_GPIO_Port, ILOCK_BDO_LATCH_ERROR_Pin);
-        case INPUT_RELAY1_ON:         return HAL_GPIO_ReadPin(LASER_RELAY1_ON_GPIO_Port, LASER_RELAY1_ON_Pin);
-        case INPUT_RELAY2_ON:         return HAL_GPIO_ReadPin(LASER_RELAY2_ON_GPIO_Port, LASER_RELAY2_ON_Pin);
-        case INPUT_RELAY_LATCH_ERR:   return HAL_GPIO_ReadPin(LASER_LATCH_ERROR_GPIO_Port, LASER_LATCH_ERROR_Pin);
-        case INPUT_NO1: 			  return HAL_GPIO_ReadPin(NO_1_GPIO_Port, NO_1_Pin);
-        case INPUT_NC1: 			  return HAL_GPIO_ReadPin(NC_1_GPIO_Port, NC_1_Pin);
-        case INPUT_12V_PWR_GOOD: 	  return HAL_GPIO_ReadPin(PWR_GOOD_12V_GPIO_Port, PWR_GOOD_12V_Pin);
-        case INPUT_24V_PWR_GOOD: 	  return HAL_GPIO_ReadPin(PWR_GOOD_24V_GPIO_Port, PWR_GOOD_24V_Pin);
-        case INPUT_12V_FUSE_GOOD: 	  		return HAL_GPIO_ReadPin(FUSE_12V_GOOD_GPIO_Port, FUSE_12V_GOOD_Pin);
-        case INPUT_TRU_LAS_DEACTIVATED: 	return HAL_GPIO_ReadPin(TRU_LAS_DEACTIVATED_GPIO_Port, TRU_LAS_DEACTIVATED_Pin);
-        case INPUT_TRU_SYS_FAULT: 	  		return HAL_GPIO_ReadPin(TRU_SYSTEM_FAULT_GPIO_Port, TRU_SYSTEM_FAULT_Pin);
-        case INPUT_TRU_BEAM_DELIVERY: 	  	return HAL_GPIO_ReadPin(TRU_BEAM_DELIVERY_GPIO_Port, TRU_BEAM_DELIVERY_Pin);
-        case INPUT_TRU_EMISS_WARN: 	  		return HAL_GPIO_ReadPin(TRU_EMM_WARN_GPIO_Port, TRU_EMM_WARN_Pin);
-        case INPUT_TRU_ALARM: 	  			return HAL_GPIO_ReadPin(TRU_ALARM_GPIO_Port, TRU_ALARM_Pin);
-        case INPUT_TRU_MONITOR: 	  		return HAL_GPIO_ReadPin(TRU_MONITOR_GPIO_Port, TRU_MONITOR_Pin);
-        case INPUT_TRU_TEMPERATURE: 	  	return HAL_GPIO_ReadPin(TRU_TEMPERATURE_GPIO_Port, TRU_TEMPERATURE_Pin);
-        default: return 0;
+    scanPortCount = 0;
+    for (uint32_t i = 0; i < NUM_INPUTS; i++) {
+        uint8_t p = 0;
+        while (p < scanPortCount && scanPorts[p] != inputPins[i].port)
+            p++;
+        if (p == scanPortCount && scanPortCount < INPUT_MAX_PORTS)
+            scanPorts[scanPortCount++] = inputPins[i].port;
+        scanPortOf[i] = p;
+        scanShift[i]  = (uint8_t)__builtin_ctz(inputPins[i].pin);
     }
 }
 
+/**
+ * @brief Sample every input at once.
+ *
+ * Reads each used port's IDR exactly once, back to back, so all inputs on a
+ * port come from the same instant and the ports are a few bus cycles apart.
+ * The bits are then gathered into InputName order.
+ *
+ * @return Bit i = raw level of input i (INPUT_BIT(i))
+ */
+uint32_t Inputs_Sample(void)
+{
+    uint32_t idr[INPUT_MAX_PORTS];
+    for (uint32_t p = 0; p < scanPortCount; p++)
+        idr[p] = scanPorts[p]->IDR;
+    return Inputs_Gather(idr);
+}
+
+/**
+ * @brief Gather port samples into InputName order.
+ * @param idr One IDR value per port, in Inputs_Ports() order
+ * @return Bit i = raw level of input i (INPUT_BIT(i))
+ */
+uint32_t Inputs_Gather(const uint32_t idr[])
+{
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < NUM_INPUTS; i++)
+        v |= ((idr[scanPortOf[i]] >> scanShift[i]) & 1u) << i;
+    return v;
+}
+
+/**
+ * @brief List the ports Inputs_Sample() reads (valid after InputScan_Init()).
+ * @param ports Receives up to INPUT_MAX_PORTS port pointers
+ * @return Number of ports
+ */
+uint32_t Inputs_Ports(GPIO_TypeDef *ports[INPUT_MAX_PORTS])
+{
+    for (uint32_t p = 0; p < scanPortCount; p++)
+        ports[p] = scanPorts[p];
+    return scanPortCount;
+}
+
+/**
+ * @brief The debounced input states as a bitmap.
+ * @return Bit i = stableState[i] (InputName order)
+ */
+static inline uint32_t InputsBitmap(void)
+{
+    return inputDebounce.stable;
+}
+
 // -----------------------------------------------------------------------------
 // Error rules
 // -----------------------------------------------------------------------------
 
+/** @brief Debounced inputs plus the software conditions the rules test. */
+static uint32_t RuleVector(void)
+{
+    uint32_t v = InputsBitmap();
+    if (swLatchForceError)
+        v |= INPUT_BIT(RULE_IN_SW_LATCH);
+    if (tempFaultActive && !debugBypassThermoCheck)
+        v |= INPUT_BIT(RULE_IN_TEMP_FAULT);
+    return v;
+}
+
+static void RuleLog(uint16_t code, uint8_t flags, const char *text)
+{
+    if (code == 0 || !logQueue)
+        return;
+    LogMsg_t m = { .code = code, .flags = flags };
+    strncpy(m.msg, text, sizeof(m.msg) - 1);
+    osMessageQueuePut(logQueue, &m, 0, 0);
+}
+
 /**
- * @brief Evaluate all defined error conditions and queue USB messages.
+ * @brief Evaluate errorRules[], apply their actions and queue USB messages.
  *
- * Called periodically by `vTaskInputs()` to detect transitions
- * between fault-active and fault-cleared states.
+ * Called by `vTaskInputs()` on every poll and input change. A rule that
+ * becomes active or clears queues its message and flash log entry once;
+ * the latch and laser actions of active rules are reapplied every pass.
+ * Actions can set swLatchForceError, which the latch rule tests, so the
+ * rules run a second time when that changed the vector. After a RESET
+ * under a fault that still forces the latch, the latch rule clears and
+ * re-enters, and the latches go back to the fault state.
  */
 static void CheckErrorRules(void)
 {
 	if (!systemReady)
 	        return;  // Skip checks during startup grace period
 
-    for (int i = 0; i < NUM_ERROR_RULES; i++) {
-        uint8_t nowActive = errorRules[i].condition();
+    (void)Cond_TemperatureSafe();           // updates tempFaultActive
+
+    uint32_t now = ms_now();
+    uint32_t v = RuleVector();
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t changed = sr_eval(errorRules, NUM_ERROR_RULES, &ruleState, v, now);
+
+        for (uint32_t m = changed; m; m &= m - 1u) {
+            uint32_t r = (uint32_t)__builtin_ctz(m);
+            const SafetyRule *rule = &errorRules[r];
+            uint8_t nowActive = (ruleState.active >> r) & 1u;
 
-        if (nowActive && !errorRules[i].active) {
-            // Transition: became active
             InputEvent_t evt = {0};
             evt.type = EVT_ERROR;
-            evt.msg  = errorRules[i].msgActive;
-
+            evt.msg  = nowActive ? rule->msgActive : rule->msgCleared;
             osMessageQueuePut(inputEventQueue, &evt, 0, 0);
-            errorRules[i].active = 1;
+
+            if (nowActive) {
+                UsbPrintf("[FAULT] Rule %lu active, inputs 0x%08lX\r\n", r, v);
+                RuleLog(rule->logFault, 1, rule->logFaultText);
+                if (rule->actions & SR_ACT_LATCH_FAULT) {
+                    swLatchFaultActive = 1;
+                    SetAllLatchesToFaultState();
+                }
+            } else {
+                RuleLog(rule->logClear, 0, rule->logClearText);
+            }
         }
-        else if (!nowActive && errorRules[i].active) {
-            // Transition: became inactive
-            InputEvent_t evt = {0};
-            evt.type = EVT_ERROR;
-            evt.msg  = errorRules[i].msgCleared;
 
-            osMessageQueuePut(inputEventQueue, &evt, 0, 0);
-            errorRules[i].active = 0;
+        for (uint32_t m = ruleState.active; m; m &= m - 1u) {
+            uint8_t act = errorRules[__builtin_ctz(m)].actions;
+            if (act & SR_ACT_FORCE_LATCH)
+                swLatchForceError = 1;
+            if (act & SR_ACT_LASER_OFF) {
+                laserLatchedOff = 1;
+                laser_disable();
+            }
         }
+
+        uint32_t after = RuleVector();
+        if (after == v)
+            break;
+        v = after;
     }
 }
 
@@ -693,11 +572,11 @@ static void CheckErrorRules(void)
 void vTaskInputs(void *argument)
 {
     const uint32_t startupDelayMs = 3000;      // Grace period after boot
-    const uint32_t debounceLimit  = 3;         // ~30 ms debounce
     const uint32_t powerCheckPeriod = MS_TO_TICKS(500);
 
     uint32_t startTick = osKernelGetTickCount();
     uint32_t lastPowerCheck = startTick;
+    uint32_t lastSnapshot = startTick;
 
     static uint8_t prevOk12 = 5, prevOk24 = 5, prevOk12f = 5; // 5 = unknown startup state
 
@@ -707,14 +586,25 @@ void vTaskInputs(void *argument)
     // -------------------------------------------------------------------------
     // Initialize input states
     // -------------------------------------------------------------------------
-    for (int i = 0; i < NUM_INPUTS; i++) {
-        stableState[i] = ReadInput((InputName)i);
-        changeCount[i] = 0;
-    }
+    InputScan_Init();
+    uint32_t sample = Inputs_Sample();
+    vdeb_init(&inputDebounce, sample);
+    for (int i = 0; i < NUM_INPUTS; i++)
+        stableState[i] = (sample >> i) & 1u;
+    uint8_t oversample = INPUT_OVERSAMPLE && InputDma_Init();
+    if (!oversample)
+        InputEdge_Init(osThreadGetId());
+    UsbPrintf("[INIT] Inputs sampled by %s\r\n", oversample ? "timer DMA" : "EXTI + 10 ms poll");
+
+    const uint32_t pollPeriod = MS_TO_TICKS(10);
+    uint32_t nextPoll = osKernelGetTickCount();
 
     for (;;)
     {
         uint32_t now = osKernelGetTickCount();
+        uint8_t poll = ((int32_t)(now - nextPoll) >= 0);
+        if (poll)
+            nextPoll += pollPeriod;
 
         // ---------------------------------------------------------------------
         // Determine when to enable full error monitoring
@@ -727,31 +617,72 @@ void vTaskInputs(void *argument)
         // ---------------------------------------------------------------------
         // Input debouncing and event generation
         // ---------------------------------------------------------------------
-        for (int i = 0; i < NUM_INPUTS; i++) {
-            uint8_t raw = ReadInput((InputName)i);
+        // Oversampled inputs change INPUT_OVERSAMPLE_SETTLE_MS after their
+        // last transition. Otherwise armed inputs change ~INPUT_EDGE_SETTLE_MS
+        // after their last edge; the poll changes any input after
+        // VDEB_SAMPLES (3) differing samples in a row (~30 ms) and catches
+        // whatever the edges missed.
+        if (oversample && !InputDma_Running()) {
+            oversample = 0;
+            InputEdge_Init(osThreadGetId());
+            UsbPrintf("[%lu ms] Input DMA stalled, back to EXTI + poll\r\n", ms_now());
+        }
+        uint32_t edgeChanged = oversample ? InputDma_Update(&inputDebounce)
+                                          : InputEdge_Update(&inputDebounce);
+        uint32_t changed = edgeChanged;
+        if (poll && !oversample) {
+            uint32_t polled = vdeb_update(&inputDebounce, Inputs_Sample());
+            InputEdge_PollCheck(polled);
+            changed |= polled;
+        }
+        uint8_t anyChanged = (changed != 0);
+        while (changed) {
+            uint32_t i = (uint32_t)__builtin_ctz(changed);
+            changed &= changed - 1u;                // next set bit
+            stableState[i] = (inputDebounce.stable >> i) & 1u;
 
-            if (raw != stableState[i]) {
-                changeCount[i]++;
-                if (changeCount[i] >= debounceLimit) {
-                    stableState[i] = raw;
+            InputEvent_t evt = {0};
+            evt.type     = EVT_INPUT_CHANGE;
+            evt.input    = (InputName)i;
+            evt.newState = stableState[i];
+            if (edgeChanged & INPUT_BIT(i))
+                evt.t_us = oversample ? InputDma_TimeUs(i) : InputEdge_TimeUs(i);
+            osMessageQueuePut(inputEventQueue, &evt, 0, 0);
+        }
 
-                    InputEvent_t evt = {0};
-                    evt.type     = EVT_INPUT_CHANGE;
-                    evt.input    = (InputName)i;
-                    evt.newState = raw;
-                    osMessageQueuePut(inputEventQueue, &evt, 0, 0);
+        // Rejected bursts (contact chatter), visible in the STREAM log
+        if (oversample) {
+            for (uint32_t g = InputDma_TakeGlitches(); g; g &= g - 1u) {
+                uint32_t i = (uint32_t)__builtin_ctz(g);
+                InputChatter c;
+                InputDma_GetChatter(i, &c);
+                FLOG_LEVEL(FMTLOG_LVL_WARNING, "[INPUT] %s glitch #%lu, shortest pulse %lu us",
+                           inputNames[i], c.glitches, c.minPulseUs);
+            }
+        }
 
-                    changeCount[i] = 0;
-                }
-            } else {
-                changeCount[i] = 0;
+        // ---------------------------------------------------------------------
+        // STREAM mode: input bitmap on every change, a periodic snapshot and
+        // the next batch of FLOG() entries
+        // ---------------------------------------------------------------------
+        if (Telemetry_Active()) {
+            if (anyChanged)
+                Telemetry_Inputs(InputsBitmap());
+            if ((now - lastSnapshot) >= MS_TO_TICKS(TLM_SNAPSHOT_MS)) {
+                lastSnapshot = now;
+                if (!anyChanged)
+                    Telemetry_Inputs(InputsBitmap());
+                Telemetry_Status(App_BuildDebugStatusWord(),
+                                 App_BuildDebug2StatusWord(),
+                                 App_BuildActiveStatusWord());
             }
+            FmtLog_Drain();
         }
 
         // ---------------------------------------------------------------------
         // Only check errors after the grace period
         // ---------------------------------------------------------------------
-        if (systemReady) {
+        if (systemReady && (poll || anyChanged)) {
             CheckErrorRules();
         }
 
@@ -780,7 +711,14 @@ void vTaskInputs(void *argument)
             }
         }
 
-        osDelay(10);  // 10 ms loop tick
+        // Sleep until the next poll, the next input settles, or an edge
+        uint32_t left = nextPoll - osKernelGetTickCount();
+        if ((int32_t)left > 0) {
+            if (oversample)
+                osDelay(InputDma_WaitTicks(left));
+            else
+                osThreadFlagsWait(INPUT_EDGE_FLAG, osFlagsWaitAny, InputEdge_WaitTicks(left));
+        }
     }
 }
 
@@ -801,11 +739,23 @@ void vTaskUsbLogger(void *argument)
 {
     InputEvent_t evt;
     for (;;) {
-        if (osMessageQueueGet(inputEventQueue, &evt, NULL, osWaitForever) == osOK) {
+        if (osMessageQueueGet(inputEventQueue, &evt, NULL, USB_CMD_RETRY_MS) == osOK) {
             switch (evt.type) {
             case EVT_INPUT_CHANGE:
-                // Core inputs always log; others only when verboseLogging is ON
-                if (IsCoreInput(evt.input) || verboseLogging) {
+                // Core inputs always log; others only when verboseLogging is ON.
+                // While streaming, vTaskInputs already sent an INPUTS record.
+                if (Telemetry_Active())
+                    break;
+                if (!(IsCoreInput(evt.input) || verboseLogging))
+                    break;
+                if (evt.t_us) {
+                    // Accepted from an edge: print the time of the first edge
+                    UsbPrintf("[%lu.%03lu ms] %s changed to %s (%d)\r\n",
+                              evt.t_us / 1000u, evt.t_us % 1000u,
+                              inputNames[evt.input],
+                              InputStateToString(evt.input, evt.newState),
+                              evt.newState);
+                } else {
                     UsbPrintf("[%lu ms] %s changed to %s (%d)\r\n",
                               ms_now(),
                               inputNames[evt.input],
@@ -838,8 +788,10 @@ void vTaskUsbLogger(void *argument)
             {
                 MAX31855_Data d;
 
+                char t[FX_STR_MAX];
                 if (tempFaultActive)
-                    UsbPrintf("Last over-temp at %.2f degC\r\n", lastTripTemp);
+                    UsbPrintf("Last over-temp at %s degC\r\n",
+                              fx_format(t, sizeof(t), lastTripTemp, MAX31855_TC_FRAC, 2));
 
                 if (g_ThermoMutex) {
                     osMutexAcquire(g_ThermoMutex, osWaitForever);
@@ -856,7 +808,8 @@ void vTaskUsbLogger(void *argument)
                              "TEMP: SENSOR FAULT (0x%02X)\r\n", d.fault);
                 } else {
                     snprintf(buf, sizeof(buf),
-                             "BDO Temperature: %.2f degC \r\n", d.tc_c,
+                             "BDO Temperature: %s degC (%s)\r\n",
+                             fx_format(t, sizeof(t), d.tc_q2, MAX31855_TC_FRAC, 2),
                              d.rangeFault ? "OUT OF RANGE" : "OK");
                 }
 
@@ -865,41 +818,15 @@ void vTaskUsbLogger(void *argument)
             }
 
             case EVT_LOG_DUMP:
-            {
-                LogRec recs[10];
-                int n = Log_ReadLastN(10, recs, 10);
-
-                UsbPrintf("\r\n---- LAST %d LOG ENTRIES ----\r\n", n);
-                for (int i = n - 1; i >= 0; i--) {
-                    UsbPrintf("#%lu  t=%lu  code=%u  flags=0x%X  msg=%s\r\n",
-                              recs[i].seq, recs[i].ms, recs[i].code, recs[i].flags, recs[i].msg);
-                    osDelay(10); // small delay to avoid USB buffer overflow
-                }
-                UsbPrintf("-----------------------------\r\n");
+                Log_Dump(evt.newState);     // newState: 0 = text, 1 = binary
                 break;
-            }
 
             case EVT_HELP:
-			{
-				UsbPrintf("Available commands:\r\n");
-				UsbPrintf("  HELP           - Show this help menu\r\n");
-				UsbPrintf(	"  VERBOSE ON     - Enable detailed input logging\r\n");
-				UsbPrintf(	"  VERBOSE OFF    - Disable detailed input logging\r\n");
-				UsbPrintf(	"  STATUS DEBUG   - Print input states\r\n");
-				UsbPrintf(	"  START	      - not enabled yet\r\n");
-				UsbPrintf(	"  TruPulse		  - Display status of the TruPulse monitor pins\r\n");
-				UsbPrintf(	"  BDO TEMP       - Show current thermocouple temperature\r\n");
-				UsbPrintf(	"  LOG DUMP       - Last 10 stored error messages from Flash Memory\r\n");
-				UsbPrintf(	"  FLASH TEST     - test flash memory (will erase current log\r\n");
-				UsbPrintf(	"  FLASH ID       - reply with id of fitted flash memory\r\n");
-				UsbPrintf(	"  FLASH STATUS   - reply with memoty info\r\n");
-				UsbPrintf(	"  LOG ERASE      - erase flash memory\r\n");
-				UsbPrintf(	"  BYPASS_THERMO X - Disable(1)/enable(0) TC range/fault checks; '?' to query\r\n");
-				UsbPrintf(	"  RESET           - Reset any latch faults, if they are hardware issue will not reset\r\n");
-				UsbPrintf("-----------------------------\r\n");
-
-				break;
-			}
+                UsbCommand_PrintHelp();     // generated from the command table
+                break;
+            case EVT_USB_RX:
+                UsbCommand_Poll();          // assemble and run command lines
+                break;
             case EVT_FLASH_TEST:
             {
                 UsbPrintf("\r\n[FLASH] Starting self-test...\r\n");
@@ -964,9 +891,60 @@ void vTaskUsbLogger(void *argument)
 
                 break;
             }
+
+            case EVT_LINK_STATS:
+            {
+                LinkStats st;
+                uint8_t queued, high_water;
+                uint16_t fallbacks;
+                CycleStats cyc;
+                master_link_get_stats(&st);
+                master_link_get_cycle_stats(&cyc);
+                master_link_tx_stats(&queued, &high_water, NULL);
+                uint32_t baud = master_link_baud(&fallbacks);
+
+                UsbPrintf("\r\n==== LINK STATS ====\r\n");
+                UsbPrintf("Framing       : v%u\r\n", master_link_version());
+                UsbPrintf("Baud          : %lu (fallbacks %u)\r\n", baud, fallbacks);
+                UsbPrintf("Frames RX/TX  : %lu / %lu\r\n", st.frames_rx, st.frames_tx);
+                UsbPrintf("Resyncs       : %lu\r\n", st.resyncs);
+                UsbPrintf("Overruns      : %lu\r\n", st.overruns);
+                UsbPrintf("UART errors   : %lu\r\n", st.uart_errors);
+                UsbPrintf("TX dropped    : %lu (queue %u, high water %u)\r\n", st.tx_dropped, queued, high_water);
+                UsbPrintf("Retries       : %lu\r\n", st.retries);
+                UsbPrintf("Timeouts      : %lu\r\n", st.timeouts);
+                UsbPrintf("In flight     : %u\r\n", master_inflight());
+                UsbPrintf("RTT max       : %lu us\r\n", st.rtt_max_us);
+                UsbPrintf("RTT histogram (%u us buckets):\r\n", LINK_RTT_BUCKET_US);
+                for (uint32_t i = 0; i < LINK_RTT_BUCKETS; i++) {
+                    if (st.rtt_hist[i] == 0) continue;
+                    if (i == LINK_RTT_BUCKETS - 1)
+                        UsbPrintf("  >= %5lu us : %lu\r\n", i * LINK_RTT_BUCKET_US, st.rtt_hist[i]);
+                    else
+                        UsbPrintf("  %5lu us    : %lu\r\n", i * LINK_RTT_BUCKET_US, st.rtt_hist[i]);
+                }
+                if (cyc.cycles) {
+                    UsbPrintf("PD cycles     : %lu (missed %lu)\r\n", cyc.cycles, cyc.missed);
+                    UsbPrintf("PD period     : %lu us, jitter max %lu us\r\n", cyc.period_us, cyc.jitter_max_us);
+                    for (uint32_t i = 0; i < CYCLE_JITTER_BUCKETS; i++) {
+                        if (cyc.jitter_hist[i] == 0) continue;
+                        UsbPrintf("  %s%4lu us : %lu\r\n", (i == CYCLE_JITTER_BUCKETS - 1) ? ">=" : "  ",
+                                  i * CYCLE_JITTER_BUCKET_US, cyc.jitter_hist[i]);
+                    }
+                }
+                UsbPrintf("====================\r\n");
+
+                if (evt.newState) {
+                    master_link_clear_stats();
+                    UsbPrintf("[LINK] Counters cleared\r\n");
+                }
+                break;
+            }
             default:
                 break;
             }
+        } else {
+            UsbCommand_Retry();     // USB bytes whose EVT_USB_RX did not fit in the queue
         }
     }
 }
@@ -1243,6 +1221,26 @@ void Print_AllInputs(void)
                       state);                                  // raw numeric
         }
     }
+
+    if (InputDma_Running()) {
+        InputDmaStats ds;
+        InputDma_GetStats(&ds);
+        UsbPrintf("  Samples %lu (overruns %lu), accepted %lu, glitches %lu\r\n",
+                  ds.samples, ds.overruns, ds.accepted, ds.glitches);
+        for (int i = 0; i < NUM_INPUTS; i++) {
+            InputChatter c;
+            InputDma_GetChatter((uint32_t)i, &c);
+            if (c.glitches)
+                UsbPrintf("    %s: %lu edges, %lu glitches, shortest pulse %lu us\r\n",
+                          inputNames[i], c.edges, c.glitches, c.minPulseUs);
+        }
+        return;
+    }
+
+    InputEdgeStats es;
+    InputEdge_GetStats(&es);
+    UsbPrintf("  Edges %lu (lost %lu), accepted %lu, poll first %lu\r\n",
+              es.edges, es.overflows, es.accepted, es.pollCaught);
 }
 
 /**
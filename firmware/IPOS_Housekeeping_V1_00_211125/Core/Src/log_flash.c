@@ -27,6 +27,8 @@
  */
 
 #include "log_flash.h"
+#include "telemetry.h"
+#include "protocol.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -131,20 +133,138 @@ int Log_ReadLastN(uint32_t n, LogRec *out, uint32_t max_out)
     return count;
 }
 
+/* -------------------------------------------------------------------------- */
+/*                        Bulk reads (status and dump)                        */
+/* -------------------------------------------------------------------------- */
+
+/** One chunk of RECS_PER_SECTOR records (~4 KB), read in a single SPI transaction */
+static LogRec chunkBuf[RECS_PER_SECTOR];
+
+/** @brief Read chunk @p c (records c*RECS_PER_SECTOR...) into chunkBuf. */
+static void read_chunk(uint32_t c)
+{
+    W25Q_Read(slot_addr(c * RECS_PER_SECTOR), (uint8_t*)chunkBuf, sizeof(chunkBuf));
+}
+
 int Log_CountValid(void)
 {
     int count = 0;
-    LogRec r;
 
-    for (uint32_t i = 0; i < LOG_CAPACITY; i++)
+    for (uint32_t c = 0; c < LOG_SECTORS; c++)
     {
-        W25Q_Read(LOG_BASE + (i * REC_SIZE), (uint8_t*)&r, sizeof(LogRec));
-        if (r.commit == COMMIT_VAL)
-            count++;
+        read_chunk(c);
+        for (uint32_t i = 0; i < RECS_PER_SECTOR; i++)
+            if (chunkBuf[i].commit == COMMIT_VAL)
+                count++;
     }
     return count;
 }
 
+/**
+ * @brief Queue bytes for the host, waiting for room in the USB TX ring.
+ *
+ * Polls every millisecond instead of sleeping a fixed time per record, so
+ * the dump runs as fast as the host reads. Gives up if the ring makes no
+ * progress for LOG_DUMP_STALL_MS (host not reading, cable pulled).
+ *
+ * @return 1 if queued, 0 on a stall
+ */
+static uint8_t dump_write(uint8_t binary, const void *data, uint16_t len)
+{
+    uint32_t need = binary ? PROTO_COBS_MAX(TLM_HDR_SIZE + len) : len;
+    uint32_t start = HAL_GetTick();
+
+    for (;;) {
+        if (UsbTxSpace() >= need) {
+            uint8_t ok;
+            if (binary)
+                ok = Telemetry_LogRecs(data, len);
+            else if (Telemetry_Active())
+                ok = Telemetry_Text(data, len);     // keep the binary stream decodable
+            else
+                ok = UsbTxWrite(data, len) != 0;
+            if (ok)
+                return 1;
+        }
+        if (HAL_GetTick() - start >= LOG_DUMP_STALL_MS)
+            return 0;
+        osDelay(1);
+    }
+}
+
+/**
+ * @brief Send the whole log to the host, oldest record first.
+ *
+ * Reads one chunk of RECS_PER_SECTOR records per SPI transaction and sends
+ * the committed ones in batches of up to TLM_MAX_PAYLOAD bytes: formatted
+ * lines, or with @p binary the raw records as @ref TLM_REC_LOGDUMP records
+ * (an empty one marks the end). Runs in vTaskUsbLogger; records appended
+ * meanwhile may or may not be included.
+ *
+ * The chunk after the one holding the newest record is the oldest, since
+ * Log_Append() erases a sector only when it starts writing into it.
+ *
+ * @param binary 0 = text (`LOG DUMP`), 1 = binary (`LOG BIN`)
+ * @return Number of records sent
+ */
+uint32_t Log_Dump(uint8_t binary)
+{
+    static char line[TLM_MAX_PAYLOAD];    // one batch = at most one telemetry record
+    uint16_t n = 0;
+    uint32_t sent = 0;
+    uint32_t newest = (wr_index + LOG_CAPACITY - 1u) % LOG_CAPACITY;
+    uint32_t first = newest / RECS_PER_SECTOR + 1u;
+
+    if (!binary) {
+        n = (uint16_t)snprintf(line, sizeof(line), "\r\n---- LOG DUMP (oldest first) ----\r\n");
+    }
+
+    for (uint32_t k = 0; k < LOG_SECTORS; k++) {
+        read_chunk((first + k) % LOG_SECTORS);
+        for (uint32_t i = 0; i < RECS_PER_SECTOR; i++) {
+            const LogRec *r = &chunkBuf[i];
+            if (r->commit != COMMIT_VAL)
+                continue;
+
+            if (binary) {
+                if (n + REC_SIZE > TLM_MAX_PAYLOAD) {
+                    if (!dump_write(1, line, n)) return sent;
+                    n = 0;
+                }
+                memcpy(&line[n], r, REC_SIZE);
+                n += REC_SIZE;
+            } else {
+                char t[80];
+                int len = snprintf(t, sizeof(t), "#%lu  t=%lu  code=%u  flags=0x%X  msg=%.*s\r\n",
+                                   r->seq, r->ms, r->code, r->flags, (int)sizeof(r->msg), r->msg);
+                if (len >= (int)sizeof(t)) len = sizeof(t) - 1;
+                if (n + (size_t)len > sizeof(line)) {
+                    if (!dump_write(0, line, n)) return sent;
+                    n = 0;
+                }
+                memcpy(&line[n], t, (size_t)len);
+                n += (uint16_t)len;
+            }
+            sent++;
+        }
+    }
+
+    if (binary) {
+        if (n && !dump_write(1, line, n)) return sent;
+        dump_write(1, line, 0);                 // end marker
+    } else {
+        char t[40];
+        int len = snprintf(t, sizeof(t), "---- %lu entries ----\r\n", sent);
+        if (n + (size_t)len > sizeof(line)) {
+            if (!dump_write(0, line, n)) return sent;
+            n = 0;
+        }
+        memcpy(&line[n], t, (size_t)len);
+        dump_write(0, line, (uint16_t)(n + len));
+    }
+    return sent;
+}
+
 /* -------------------------------------------------------------------------- */
 /*                          FreeRTOS log writer task                          */
 /* -------------------------------------------------------------------------- */
@@ -161,6 +281,7 @@ void vTaskLogWriter(void *argument)
     for (;;) {
         if (osMessageQueueGet(logQueue, &msg, NULL, osWaitForever) == osOK) {
             Log_Append(msg.code, msg.flags, msg.msg);
+            Telemetry_Log(msg.code, msg.flags, msg.msg);
         }
     }
 }
@@ -4,8 +4,9 @@
  * @brief UART-based master communication interface for PLC or slave device.
  *
  * This module provides the low-level UART link layer between the STM32 master
- * controller and the external PLC or slave node. It uses DMA-based reception,
- * a circular ring buffer, and a protocol parser to decode incoming frames.
+ * controller and the external PLC or slave node. It uses circular DMA reception
+ * (parsed in place) or, optionally, one-shot DMA into a ring buffer, and a
+ * protocol parser to decode incoming frames.
  *
  * @details
  * The **Master Link** module handles the byte stream from the UART peripheral,
@@ -18,9 +19,18 @@
  * ### Responsibilities
  * - Initialize UART DMA reception and parser state
  * - Handle DMA-to-ring-buffer data transfer
- * - Decode incoming protocol frames (ACK/DATA)
+ * - Decode incoming protocol frames (ACK/DATA/NOTIFY)
  * - Provide `master_write_u16()` and `master_read_u16()` APIs
+ * - Provide batched `master_write_multi()` and `master_read_multi()` APIs
+ * - Provide pipelined, tagged `master_submit_*()` APIs with per-request
+ *   timeout and retry tracking
  * - Notify upper-layer task via `osThreadFlagsSet()` when data arrives
+ * - Queue outgoing frames for UART TX DMA so no sender blocks on the wire
+ * - Negotiate v2 framing (COBS + CRC16) with the slave via CMD_HELLO
+ * - Keep link health counters and a round-trip histogram (@ref LinkStats)
+ * - Step the UART up to a faster rate the slave confirms, falling back to
+ *   115200 when the link degrades (see baud_neg.h)
+ * - Time the slave's PD cycle markers and wake the exchange on each one
  *
  * @note Uses HAL UARTEx APIs with DMA idle-line detection.
  * @ingroup IPOS_Firmware
@@ -28,30 +38,131 @@
  */
 
 #include "master_link.h"
+#include "fmtlog.h"
 #include "ring_buffer.h"
+#include "dma_rx_ring.h"
+#include "tx_frame_queue.h"
+#include "link_stats.h"
+#include "baud_neg.h"
 #include "protocol.h"
+#include "telemetry.h"
 #include "cmsis_os2.h"
+#include <string.h>
+
+/**
+ * @brief RX mode selection.
+ *
+ * 1 = DMA runs in circular mode over @ref s_rx_dma_buf and the parser reads
+ *     straight from it using NDTR as the write index (no copy, no re-arm).
+ * 0 = legacy one-shot ReceiveToIdle DMA copied into a ring buffer.
+ */
+#ifndef UART_RX_CIRCULAR
+#define UART_RX_CIRCULAR 1
+#endif
 
 #ifndef UART_RX_DMA_CHUNK
+#if UART_RX_CIRCULAR
+#define UART_RX_DMA_CHUNK 2048  // ~10 ms at 2 Mbaud (~180 ms at 115200) between drains
+#else
 #define UART_RX_DMA_CHUNK 128
 #endif
+#endif
 #ifndef RB_SIZE
 #define RB_SIZE 256
 #endif
 
+/** Maximum number of tagged requests outstanding at once */
+#ifndef MASTER_WINDOW
+#define MASTER_WINDOW 4
+#endif
+/** Time (ms, 1 tick = 1 ms) before a tagged request is retransmitted */
+#ifndef MASTER_REQ_TIMEOUT_MS
+#define MASTER_REQ_TIMEOUT_MS 20
+#endif
+/** Retransmissions before a tagged request is reported via master_on_timeout() */
+#ifndef MASTER_REQ_RETRIES
+#define MASTER_REQ_RETRIES 2
+#endif
+
+/** Offer v2 framing (COBS + CRC16) to the slave; 0 keeps the link on v1 */
+#ifndef MASTER_LINK_V2
+#define MASTER_LINK_V2 1
+#endif
+/** Interval (ms) between HELLO offers until the slave has answered */
+#ifndef MASTER_HELLO_PERIOD_MS
+#define MASTER_HELLO_PERIOD_MS 1000
+#endif
+
+/** Highest index into baud_rates[] to negotiate; 0 keeps the link at 115200 */
+#ifndef MASTER_BAUD_MAX_IDX
+#define MASTER_BAUD_MAX_IDX 3
+#endif
+
+_Static_assert(PROTO_V2_MAX_WIRE <= TXQ_SLOT_SIZE, "v2 frame does not fit a TX queue slot");
+
 /** UART handle used for master link communication */
 static UART_HandleTypeDef *s_huart = NULL;
 /** DMA RX buffer */
 static uint8_t s_rx_dma_buf[UART_RX_DMA_CHUNK];
+#if UART_RX_CIRCULAR
+/** Reader over the circular DMA buffer */
+static DmaRxRing s_rx_dma;
+#else
 /** Static ring buffer storage */
 static uint8_t s_rb_storage[RB_SIZE];
 /** Ring buffer control structure */
 static RingBuffer s_rx_rb;
+#endif
 /** Protocol parser instance */
 static ProtoParser s_parser;
 /** Optional task handle for data notification */
 static osThreadId_t s_notify_task = NULL;
 
+/** One outstanding tagged request */
+typedef struct {
+    bool     used;
+    uint8_t  tag;                       ///< Transaction tag echoed by the slave
+    uint8_t  retries;                   ///< Retransmissions left
+    uint8_t  len;                       ///< Length of @ref frame
+    uint32_t sent_tick;                 ///< Tick of the last (re)transmission
+    uint32_t sent_cyc;                  ///< DWT cycle count at first transmission, for RTT
+    uint8_t  frame[PROTO_MAX_FRAME];    ///< Tagged frame, kept for retransmission
+} InflightReq;
+
+/** In-flight request table (matched by tag, not by arrival order) */
+static InflightReq s_inflight[MASTER_WINDOW];
+/** Next transaction tag to hand out */
+static uint8_t s_next_tag = 0;
+/** Serializes TX enqueueing and the in-flight table between submitters and the link task */
+static osMutexId_t s_link_mutex = NULL;
+
+/** Frames waiting for (or being sent by) UART TX DMA */
+static TxFrameQueue s_txq;
+/** True while the DMA is sending the front frame of @ref s_txq */
+static volatile bool s_tx_busy = false;
+/** Set by the UART error ISR; parser_drain() drops the stale bytes and partial frame */
+static volatile bool s_rx_error = false;
+
+/** Framing in use on the wire (PROTO_V1 until the slave accepts v2) */
+static uint8_t s_link_version = PROTO_V1;
+/** Tick of the last HELLO offer */
+static uint32_t s_hello_tick = 0;
+
+/** Link health counters and round-trip histogram */
+static LinkStats s_stats;
+
+/** Baud-rate negotiation state */
+static BaudNeg s_baud;
+/** Set when the negotiator asked for a rate change; carried out by master_link_poll() */
+static bool s_baud_switch = false;
+/** Rate index last reported over USB, 0xFF before the first report */
+static uint8_t s_baud_reported = 0xFF;
+
+/** Arrival jitter of the slave's PD cycle markers */
+static CycleStats s_cycle;
+/** DWT cycle count at the previous marker */
+static uint32_t s_cycle_cyc;
+
 /**
  * @brief Weak callback when an ACK frame is received.
  * @param var_id Variable identifier
@@ -64,21 +175,423 @@ __attribute__((weak)) void master_on_ack(uint8_t var_id, uint16_t value) { (void
  * @param value  Received data value
  */
 __attribute__((weak)) void master_on_data(uint8_t var_id, uint16_t value) { (void)var_id; (void)value; }
+/**
+ * @brief Weak callback when the slave pushes a changed value (CMD_NOTIFY).
+ * @param var_id Variable identifier
+ * @param value  New data value
+ */
+__attribute__((weak)) void master_on_notify(uint8_t var_id, uint16_t value) { (void)var_id; (void)value; }
+/**
+ * @brief Weak callback when the slave marks a new Profinet PD cycle (CMD_CYCLE).
+ *
+ * Schedule the write/read exchange from here so it runs in phase with the PLC.
+ *
+ * @param seq       Marker count, mod 256 (gaps mean lost markers)
+ * @param period_us Slave's PD cycle period in µs
+ */
+__attribute__((weak)) void master_on_cycle(uint8_t seq, uint16_t period_us) { (void)seq; (void)period_us; }
+/**
+ * @brief Weak callback when a tagged request exhausted its retries.
+ *
+ * Called once per variable carried by the request.
+ *
+ * @param cmd    Request command (CMD_WRITE, CMD_READ, CMD_WRITE_MULTI, ...)
+ * @param var_id Variable identifier
+ */
+__attribute__((weak)) void master_on_timeout(uint8_t cmd, uint8_t var_id) { (void)cmd; (void)var_id; }
+
+/**
+ * @brief Restarts DMA reception after the HAL stopped it (error or re-init).
+ *
+ * Only touches the HAL, so the error ISR may call it. The read index and
+ * parser belong to the link task and are resynced by rx_resync().
+ */
+static void rx_restart(void) {
+#if UART_RX_CIRCULAR
+    dma_rx_isr_restart(&s_rx_dma);
+#endif
+    HAL_UARTEx_ReceiveToIdle_DMA(s_huart, s_rx_dma_buf, sizeof(s_rx_dma_buf));
+#if !UART_RX_CIRCULAR
+    __HAL_DMA_DISABLE_IT(s_huart->hdmarx, DMA_IT_HT);
+#endif
+}
+/**
+ * @brief Drops the bytes received before a restart and the partial frame.
+ *
+ * Link task only. In circular mode the stream restarted at index 0, so the
+ * read index moves to the current DMA position.
+ */
+static void rx_resync(void) {
+#if UART_RX_CIRCULAR
+    dma_rx_flush(&s_rx_dma, (uint16_t)__HAL_DMA_GET_COUNTER(s_huart->hdmarx));
+#endif
+    proto_reset(&s_parser);
+}
+/**
+ * @brief Starts a DMA transfer for the front frame if the UART is idle.
+ *
+ * Called from task context after enqueueing and from the TX-complete ISR,
+ * so the idle check and the DMA start run with interrupts masked.
+ */
+static void tx_kick(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!s_tx_busy) {
+        uint16_t len;
+        uint8_t *frame = txq_front(&s_txq, &len);
+        if (frame && HAL_UART_Transmit_DMA(s_huart, frame, len) == HAL_OK) s_tx_busy = true;
+    }
+    __set_PRIMASK(primask);
+}
+/**
+ * @brief Queues a frame for DMA transmission. Caller holds the link mutex.
+ *
+ * Frames are always built in v1 form; once v2 framing is negotiated they are
+ * re-encoded here, so retransmissions follow the current link version too.
+ *
+ * @return HAL_OK when queued, HAL_BUSY if the TX queue is full.
+ */
+static HAL_StatusTypeDef tx_enqueue(const uint8_t *frame, size_t n) {
+    uint8_t wire[PROTO_V2_MAX_WIRE];
+    if (s_link_version == PROTO_V2) {
+        n = proto_encode_v2(frame, n, wire);
+        if (n == 0) return HAL_ERROR;
+        frame = wire;
+    }
+    if (!txq_push(&s_txq, frame, n)) {
+        s_stats.tx_dropped++;
+        return HAL_BUSY;
+    }
+    s_stats.frames_tx++;
+    tx_kick();
+    return HAL_OK;
+}
+/**
+ * @brief Queues a frame on the link UART and returns immediately.
+ *
+ * Holds the link mutex (once created) so frames from several tasks and
+ * retransmissions from the link task are queued one at a time.
+ */
+static HAL_StatusTypeDef link_tx(const uint8_t *frame, size_t n) {
+    if (s_link_mutex) osMutexAcquire(s_link_mutex, osWaitForever);
+    HAL_StatusTypeDef st = tx_enqueue(frame, n);
+    if (s_link_mutex) osMutexRelease(s_link_mutex);
+    return st;
+}
+/**
+ * @brief Returns true if @p tag belongs to an outstanding request. Caller holds the mutex.
+ */
+static bool tag_in_use(uint8_t tag) {
+    for (uint8_t i = 0; i < MASTER_WINDOW; i++)
+        if (s_inflight[i].used && s_inflight[i].tag == tag) return true;
+    return false;
+}
+/**
+ * @brief Tags a built request, records it in the in-flight table and sends it.
+ *
+ * @param frame Untagged frame (buffer must hold @ref PROTO_MAX_FRAME bytes)
+ * @param n     Frame length, 0 if the builder rejected the request
+ * @return HAL_OK, HAL_BUSY if the window or the TX queue is full, HAL_ERROR on
+ *         invalid input or before master_link_init()
+ */
+static HAL_StatusTypeDef inflight_submit(uint8_t *frame, size_t n) {
+    if (n == 0 || s_link_mutex == NULL) return HAL_ERROR;
+
+    osMutexAcquire(s_link_mutex, osWaitForever);
+
+    InflightReq *r = NULL;
+    for (uint8_t i = 0; i < MASTER_WINDOW && !r; i++)
+        if (!s_inflight[i].used) r = &s_inflight[i];
+    if (!r) {
+        osMutexRelease(s_link_mutex);
+        return HAL_BUSY;
+    }
+
+    while (tag_in_use(s_next_tag)) s_next_tag++;
+    r->tag       = s_next_tag++;
+    r->len       = (uint8_t)proto_tag(r->tag, frame, n);
+    r->retries   = MASTER_REQ_RETRIES;
+    r->sent_tick = osKernelGetTickCount();
+    r->sent_cyc  = DWT->CYCCNT;
+    memcpy(r->frame, frame, r->len);
+    r->used      = true;
+
+    HAL_StatusTypeDef st = tx_enqueue(r->frame, r->len);
+    if (st != HAL_OK) r->used = false;
+
+    osMutexRelease(s_link_mutex);
+    return st;
+}
+/**
+ * @brief Retires the request matching a reply tag.
+ *
+ * Requests answered without a retransmission add their round trip to the
+ * histogram; after a retry the reply could belong to either send.
+ *
+ * @return false if no request carries @p tag (late reply after a retry/timeout)
+ */
+static bool inflight_complete(uint8_t tag) {
+    bool found = false;
+    osMutexAcquire(s_link_mutex, osWaitForever);
+    for (uint8_t i = 0; i < MASTER_WINDOW; i++) {
+        if (s_inflight[i].used && s_inflight[i].tag == tag) {
+            if (s_inflight[i].retries == MASTER_REQ_RETRIES)
+                link_stats_rtt(&s_stats, (DWT->CYCCNT - s_inflight[i].sent_cyc) / (SystemCoreClock / 1000000u));
+            s_inflight[i].used = false;
+            found = true;
+            break;
+        }
+    }
+    osMutexRelease(s_link_mutex);
+    return found;
+}
+/**
+ * @brief Reports every variable of a failed request through master_on_timeout().
+ * @param frame Tagged request frame: STX CMD TAG body ETX
+ */
+static void report_timeout(const uint8_t *frame) {
+    uint8_t cmd = (uint8_t)(frame[1] & ~PROTO_TAG_FLAG);
+
+    if (cmd == CMD_WRITE_MULTI || cmd == CMD_READ_MULTI) {
+        uint8_t stride = (cmd == CMD_READ_MULTI) ? 1 : 3;
+        for (uint8_t i = 0; i < frame[3]; i++) master_on_timeout(cmd, frame[4 + i * stride]);
+    } else {
+        master_on_timeout(cmd, frame[3]);
+    }
+}
+/**
+ * @brief Retransmits or expires requests whose reply is overdue.
+ *
+ * Each slot is handled on its own, so one slow reply does not hold back the
+ * rest of the window.
+ */
+static void inflight_service(void) {
+    if (s_link_mutex == NULL) return;
+
+    for (uint8_t i = 0; i < MASTER_WINDOW; i++) {
+        uint8_t failed[PROTO_MAX_FRAME];
+        bool expired = false;
+
+        osMutexAcquire(s_link_mutex, osWaitForever);
+        InflightReq *r = &s_inflight[i];
+        uint32_t now = osKernelGetTickCount();
+        if (r->used && (now - r->sent_tick) >= MASTER_REQ_TIMEOUT_MS) {
+            if (r->retries > 0) {
+                r->retries--;
+                r->sent_tick = now;
+                s_stats.retries++;
+                tx_enqueue(r->frame, r->len);
+            } else {
+                memcpy(failed, r->frame, r->len);
+                r->used = false;
+                expired = true;
+                s_stats.timeouts++;
+            }
+        }
+        osMutexRelease(s_link_mutex);
+
+        if (expired) report_timeout(failed);
+    }
+}
 
+/**
+ * @brief Carries out a step requested by the baud negotiator.
+ *
+ * Rate changes are only flagged here: they are made by master_link_poll()
+ * once the parser has consumed everything received at the old rate.
+ */
+static void baud_apply(BaudAction a) {
+    uint8_t frame[8];
+    switch (a) {
+        case BAUD_ACT_REQUEST:
+            link_tx(frame, proto_build_baud(s_baud.target, frame));
+            break;
+        case BAUD_ACT_ECHO:
+            link_tx(frame, proto_build_echo(s_baud.echo_seq, baud_echo_pattern(s_baud.echo_seq), frame));
+            break;
+        case BAUD_ACT_SET_RATE:
+            s_baud_switch = true;
+            break;
+        default:
+            break;
+    }
+}
+/**
+ * @brief Re-initializes USART2 at a new baud rate.
+ *
+ * Queued frames are given a few ticks to leave at the old rate; whatever is
+ * still on the wire after that is dropped (tagged requests are retried).
+ * RX restarts from scratch, so a partial frame is lost with the old rate.
+ *
+ * @param rate Baud rate in bit/s
+ */
+static void link_set_baud(uint32_t rate) {
+    for (uint8_t i = 0; i < 10 && (s_tx_busy || txq_count(&s_txq) != 0); i++) osDelay(1);
+
+    osMutexAcquire(s_link_mutex, osWaitForever);
+    HAL_UART_Abort(s_huart);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_tx_busy) {
+        txq_pop(&s_txq);
+        s_tx_busy = false;
+    }
+    __set_PRIMASK(primask);
+
+    s_huart->Init.BaudRate = rate;
+    HAL_UART_Init(s_huart);
+    rx_restart();
+    rx_resync();
+    tx_kick();
+    osMutexRelease(s_link_mutex);
+}
+/**
+ * @brief Reports the rate the link settled on.
+ *
+ * While STREAM is on the report is an FLOG() entry, so it cannot break the
+ * binary stream. Otherwise it is plain text for a terminal, as at boot.
+ * The text is built by hand: vsnprintf() would not fit the 512-byte
+ * uart_master stack next to UsbPrintf()'s buffer.
+ */
+static void baud_report(uint32_t rate) {
+    static const char head[] = "[LINK] USART2 at ", tail[] = " baud\r\n";
+    char line[sizeof(head) - 1u + 10u + sizeof(tail) - 1u];
+    char digits[10];
+    uint16_t n, d = 0;
+
+    if (Telemetry_Active()) {
+        FLOG("[LINK] USART2 at %lu baud", rate);
+        return;
+    }
+    do {
+        digits[d++] = (char)('0' + rate % 10u);
+        rate /= 10u;
+    } while (rate != 0);
+    memcpy(line, head, sizeof(head) - 1u);
+    n = sizeof(head) - 1u;
+    while (d != 0) line[n++] = digits[--d];
+    memcpy(&line[n], tail, sizeof(tail) - 1u);
+    n += sizeof(tail) - 1u;
+    UsbTxWrite((const uint8_t *)line, n);
+}
+/**
+ * @brief Runs the baud negotiator and applies any rate change it asked for.
+ *
+ * Link errors (parser resyncs, UART errors and request timeouts) feed its
+ * fallback check. baud_report() reports each rate it settles on.
+ */
+static void baud_service(void) {
+    uint32_t errors = s_parser.resyncs + s_stats.uart_errors + s_stats.timeouts;
+    baud_apply(baud_neg_tick(&s_baud, osKernelGetTickCount(), errors));
+
+    if (s_baud_switch) {
+        s_baud_switch = false;
+        link_set_baud(baud_rates[s_baud.cur]);
+    }
+    if (s_baud.state == BAUD_RUN && s_baud.cur != s_baud_reported) {
+        s_baud_reported = s_baud.cur;
+        baud_report(baud_rates[s_baud.cur]);
+    }
+}
+
+/**
+ * @brief Offers v2 framing to the slave.
+ *
+ * HELLO is sent before the switch, so it always goes out as v1; the slave
+ * answers in v1 with the version it accepted.
+ */
+static void hello_send(void) {
+#if MASTER_LINK_V2
+    uint8_t frame[8];
+    s_hello_tick = osKernelGetTickCount();
+    link_tx(frame, proto_build_hello(PROTO_V2, frame));
+#endif
+}
+/**
+ * @brief Applies the slave's HELLO reply.
+ * @param version Framing version agreed by the slave
+ */
+static void hello_accept(uint8_t version) {
+    if (version != PROTO_V2 || s_link_version == PROTO_V2) return;
+
+    osMutexAcquire(s_link_mutex, osWaitForever);
+    uint32_t resyncs = s_parser.resyncs;
+    s_link_version = PROTO_V2;
+    proto_init_v2(&s_parser, ROLE_MASTER);
+    s_parser.resyncs = resyncs;
+    osMutexRelease(s_link_mutex);
+
+    baud_apply(baud_neg_start(&s_baud, osKernelGetTickCount()));
+}
+
+/**
+ * @brief Records a PD cycle marker and passes it on.
+ */
+static void cycle_rx(uint8_t seq, uint16_t period_us) {
+    uint32_t cyc = DWT->CYCCNT;
+    cycle_stats_sample(&s_cycle, seq, (cyc - s_cycle_cyc) / (SystemCoreClock / 1000000u));
+    s_cycle_cyc = cyc;
+    master_on_cycle(seq, period_us);
+}
+
+/**
+ * @brief Feeds one received byte into the protocol parser.
+ *
+ * Triggers callback functions on valid frame reception. Tagged replies
+ * first retire their entry in the in-flight table.
+ */
+static void parser_feed(uint8_t b) {
+    ProtoFrame f;
+    if (proto_push(&s_parser, b, &f)) {
+        s_stats.frames_rx++;
+
+        /* Tagged replies must match an outstanding request; duplicates from retries are dropped */
+        if (f.tagged && !inflight_complete(f.tag)) return;
+
+        if (f.cmd == CMD_ACK  && f.has_value) master_on_ack(f.var_id, f.value);
+        if (f.cmd == CMD_READ && f.has_value) master_on_data(f.var_id, f.value);
+        if (f.cmd == CMD_NOTIFY)              master_on_notify(f.var_id, f.value);
+        if (f.cmd == CMD_HELLO && f.has_value) hello_accept(f.var_id);
+        if (f.cmd == CMD_BAUD  && f.has_value) baud_apply(baud_neg_on_reply(&s_baud, f.var_id, osKernelGetTickCount()));
+        if (f.cmd == CMD_ECHO  && f.has_value) baud_apply(baud_neg_on_echo(&s_baud, f.var_id, f.value, osKernelGetTickCount()));
+        if (f.cmd == CMD_CYCLE && f.has_value) cycle_rx(f.var_id, f.value);
+
+        /* Batched replies are fanned out to the same per-variable callbacks */
+        if (f.cmd == CMD_ACK_MULTI && f.has_value)
+            for (uint8_t i = 0; i < f.count; i++) master_on_ack(f.pairs[i].var_id, f.pairs[i].value);
+        if (f.cmd == CMD_READ_MULTI && f.has_value)
+            for (uint8_t i = 0; i < f.count; i++) master_on_data(f.pairs[i].var_id, f.pairs[i].value);
+        if (f.cmd == CMD_NOTIFY_MULTI && f.has_value)
+            for (uint8_t i = 0; i < f.count; i++) master_on_notify(f.pairs[i].var_id, f.pairs[i].value);
+    }
+}
 /**
  * @brief Internal helper to drain and parse received bytes.
  *
- * Reads bytes from the ring buffer, feeds them into the protocol parser,
- * and triggers callback functions on valid frame reception.
+ * Reads bytes from the circular DMA buffer (or, in legacy mode, one
+ * contiguous ring buffer span at a time) and feeds them into the parser.
  */
 static void parser_drain(void) {
-    uint8_t b; ProtoFrame f;
-    while (rb_get(&s_rx_rb, &b)) {
-        if (proto_push(&s_parser, b, &f)) {
-            if (f.cmd == CMD_ACK  && f.has_value) master_on_ack(f.var_id, f.value);
-            if (f.cmd == CMD_READ && f.has_value) master_on_data(f.var_id, f.value);
-        }
+    if (s_rx_error) {
+        s_rx_error = false;
+        rx_resync();
+    }
+#if UART_RX_CIRCULAR
+    uint8_t b;
+    uint16_t ndtr = (uint16_t)__HAL_DMA_GET_COUNTER(s_huart->hdmarx);
+    if (dma_rx_lapped(&s_rx_dma, ndtr)) {
+        s_stats.overruns++;     // a whole buffer arrived since the last drain
+        proto_reset(&s_parser);
+    }
+    while (dma_rx_get(&s_rx_dma, ndtr, &b)) parser_feed(b);
+#else
+    const uint8_t *span; uint16_t n;
+    while ((n = rb_peek_contiguous(&s_rx_rb, &span)) != 0) {
+        for (uint16_t i = 0; i < n; i++) parser_feed(span[i]);
+        rb_commit(&s_rx_rb, n);
     }
+#endif
 }
 /**
  * @brief Initializes the master UART link.
@@ -86,24 +599,126 @@ static void parser_drain(void) {
  */
 void master_link_init(UART_HandleTypeDef *huart) {
     s_huart = huart;
+#if UART_RX_CIRCULAR
+    dma_rx_init(&s_rx_dma, s_rx_dma_buf, sizeof(s_rx_dma_buf));
+#else
     rb_init(&s_rx_rb, s_rb_storage, RB_SIZE);
+#endif
     proto_init(&s_parser, ROLE_MASTER);
+    s_link_version = PROTO_V1;
+    baud_neg_init(&s_baud, MASTER_BAUD_MAX_IDX);
+    s_baud_switch = false;
+    s_baud_reported = 0xFF;
+
+    memset(s_inflight, 0, sizeof(s_inflight));
+    txq_init(&s_txq);
+    s_tx_busy = false;
+    s_rx_error = false;
+    if (s_link_mutex == NULL) s_link_mutex = osMutexNew(NULL);
+
+    /* DWT cycle counter times round trips at sub-tick resolution */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    link_stats_clear(&s_stats);
+    cycle_stats_clear(&s_cycle);
 }
 /**
  * @brief Starts DMA-based UART reception with idle-line detection.
+ *
+ * In circular mode the RX stream is switched to DMA_CIRCULAR here, so the
+ * CubeMX-generated init can stay untouched. Reception then runs forever;
+ * IDLE/HT/TC events only wake the link task.
+ *
+ * With @ref MASTER_LINK_V2 the first HELLO offer is sent here and baud
+ * negotiation starts once the slave has accepted it; without v2 it starts here.
  */
 void master_link_start(void) {
+#if UART_RX_CIRCULAR
+    s_huart->hdmarx->Init.Mode = DMA_CIRCULAR;
+    HAL_DMA_Init(s_huart->hdmarx);
+    HAL_UARTEx_ReceiveToIdle_DMA(s_huart, s_rx_dma_buf, sizeof(s_rx_dma_buf));
+#else
     HAL_UARTEx_ReceiveToIdle_DMA(s_huart, s_rx_dma_buf, sizeof(s_rx_dma_buf));
     __HAL_DMA_DISABLE_IT(s_huart->hdmarx, DMA_IT_HT);
+#endif
+    hello_send();
+#if !MASTER_LINK_V2
+    baud_apply(baud_neg_start(&s_baud, osKernelGetTickCount()));
+#endif
 }
 /**
  * @brief Polls and processes received bytes.
  *
  * Should be called periodically (or from a dedicated task)
- * to parse received frames and invoke callbacks.
+ * to parse received frames, invoke callbacks and retransmit or expire
+ * overdue tagged requests. Repeats the HELLO offer until the slave has
+ * switched to v2 framing, and steps the baud negotiation.
  */
 void master_link_poll(void) {
     parser_drain();
+    baud_service();
+    inflight_service();
+#if MASTER_LINK_V2
+    if (s_link_version == PROTO_V1 && (osKernelGetTickCount() - s_hello_tick) >= MASTER_HELLO_PERIOD_MS)
+        hello_send();
+#endif
+}
+/**
+ * @brief Framing version currently used on the link (PROTO_V1 or PROTO_V2).
+ */
+uint8_t master_link_version(void) {
+    return s_link_version;
+}
+/**
+ * @brief Baud rate currently used on the link (bit/s).
+ * @param fallbacks Optional: times the link dropped back to 115200
+ */
+uint32_t master_link_baud(uint16_t *fallbacks) {
+    if (fallbacks) *fallbacks = s_baud.fallbacks;
+    return baud_rates[s_baud.cur];
+}
+/**
+ * @brief Number of tagged requests currently awaiting a reply.
+ */
+uint8_t master_inflight(void) {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < MASTER_WINDOW; i++) n += s_inflight[i].used ? 1u : 0u;
+    return n;
+}
+/**
+ * @brief Reports TX queue usage, for sizing @ref TXQ_DEPTH.
+ * @param queued     Frames currently queued (including the one on the wire)
+ * @param high_water Deepest occupancy since init
+ * @param dropped    Frames rejected because the queue was full
+ */
+void master_link_tx_stats(uint8_t *queued, uint8_t *high_water, uint16_t *dropped) {
+    if (queued)     *queued     = txq_count(&s_txq);
+    if (high_water) *high_water = s_txq.high_water;
+    if (dropped)    *dropped    = s_txq.dropped;
+}
+/**
+ * @brief Copies the link health counters.
+ * @param out Destination; `resyncs` is taken from the parser at call time
+ */
+void master_link_get_stats(LinkStats *out) {
+    *out = s_stats;
+    out->resyncs = s_parser.resyncs;
+}
+/**
+ * @brief Zeroes the link health counters and the round-trip histogram.
+ */
+void master_link_clear_stats(void) {
+    link_stats_clear(&s_stats);
+    s_parser.resyncs = 0;
+    s_baud.err_base = 0;   // keep the negotiator's error window consistent with the reset totals
+    cycle_stats_clear(&s_cycle);
+}
+/**
+ * @brief Copies the PD cycle marker statistics (arrival interval and jitter).
+ * @param out Destination
+ */
+void master_link_get_cycle_stats(CycleStats *out) {
+    *out = s_cycle;
 }
 /**
  * @brief Registers a FreeRTOS task to be notified on data reception.
@@ -113,38 +728,132 @@ void master_link_attach_task_handle(void *task_handle) {
     s_notify_task = (osThreadId_t)task_handle;
 }
 /**
- * @brief Sends a 16-bit WRITE command to the slave.
+ * @brief Queues a 16-bit WRITE command to the slave (non-blocking).
  * @param var_id Variable identifier.
  * @param value  16-bit value to write.
- * @return HAL status.
+ * @return HAL_OK when queued, HAL_BUSY if the TX queue is full.
  */
 HAL_StatusTypeDef master_write_u16(uint8_t var_id, uint16_t value) {
     uint8_t frame[8]; size_t n = proto_build_write(var_id, value, frame);
-    return HAL_UART_Transmit(s_huart, frame, (uint16_t)n, 20);
+    return link_tx(frame, n);
 }
 /**
- * @brief Sends a READ request for a 16-bit variable.
+ * @brief Queues a READ request for a 16-bit variable (non-blocking).
  * @param var_id Variable identifier.
- * @return HAL status.
+ * @return HAL_OK when queued, HAL_BUSY if the TX queue is full.
  */
 HAL_StatusTypeDef master_read_u16(uint8_t var_id) {
     uint8_t frame[8]; size_t n = proto_build_read(var_id, frame);
-    return HAL_UART_Transmit(s_huart, frame, (uint16_t)n, 20);
+    return link_tx(frame, n);
+}
+/**
+ * @brief Sends several 16-bit WRITEs to the slave in one WRITE_MULTI frame.
+ *
+ * The slave answers with a single ACK_MULTI frame; each acknowledged pair is
+ * delivered through master_on_ack().
+ *
+ * @param pairs Variables and values to write.
+ * @param n     Number of pairs (1..PROTO_MAX_PAIRS).
+ * @return HAL_OK when queued, HAL_BUSY if the TX queue is full, HAL_ERROR if @p n is out of range.
+ */
+HAL_StatusTypeDef master_write_multi(const ProtoPair *pairs, uint8_t n) {
+    uint8_t frame[PROTO_MAX_FRAME]; size_t len = proto_build_write_multi(pairs, n, frame);
+    if (len == 0) return HAL_ERROR;
+    return link_tx(frame, len);
+}
+/**
+ * @brief Sends one READ_MULTI request for several 16-bit variables.
+ *
+ * The slave answers with a single READ_MULTI reply; each returned value is
+ * delivered through master_on_data().
+ *
+ * @param var_ids Variable identifiers.
+ * @param n       Number of variables (1..PROTO_MAX_PAIRS).
+ * @return HAL_OK when queued, HAL_BUSY if the TX queue is full, HAL_ERROR if @p n is out of range.
+ */
+HAL_StatusTypeDef master_read_multi(const uint8_t *var_ids, uint8_t n) {
+    uint8_t frame[PROTO_MAX_FRAME]; size_t len = proto_build_read_multi(var_ids, n, frame);
+    if (len == 0) return HAL_ERROR;
+    return link_tx(frame, len);
+}
+/**
+ * @brief Queues a tagged WRITE without waiting for its ACK.
+ *
+ * Up to @ref MASTER_WINDOW tagged requests may be outstanding. The ACK is
+ * matched by tag and delivered through master_on_ack(); a request that is
+ * still unanswered after @ref MASTER_REQ_RETRIES retransmissions is reported
+ * through master_on_timeout().
+ *
+ * @param var_id Variable identifier.
+ * @param value  16-bit value to write.
+ * @return HAL_OK when sent, HAL_BUSY if the window is full.
+ */
+HAL_StatusTypeDef master_submit_write(uint8_t var_id, uint16_t value) {
+    uint8_t frame[PROTO_MAX_FRAME];
+    return inflight_submit(frame, proto_build_write(var_id, value, frame));
+}
+/**
+ * @brief Queues a tagged READ; the reply arrives through master_on_data().
+ * @param var_id Variable identifier.
+ * @return HAL_OK when sent, HAL_BUSY if the window is full.
+ */
+HAL_StatusTypeDef master_submit_read(uint8_t var_id) {
+    uint8_t frame[PROTO_MAX_FRAME];
+    return inflight_submit(frame, proto_build_read(var_id, frame));
+}
+/**
+ * @brief Queues a tagged WRITE_MULTI; acknowledged pairs arrive through master_on_ack().
+ * @param pairs Variables and values to write.
+ * @param n     Number of pairs (1..PROTO_MAX_PAIRS).
+ * @return HAL_OK when sent, HAL_BUSY if the window is full, HAL_ERROR if @p n is out of range.
+ */
+HAL_StatusTypeDef master_submit_write_multi(const ProtoPair *pairs, uint8_t n) {
+    uint8_t frame[PROTO_MAX_FRAME];
+    return inflight_submit(frame, proto_build_write_multi(pairs, n, frame));
+}
+/**
+ * @brief Queues a tagged READ_MULTI; returned values arrive through master_on_data().
+ * @param var_ids Variable identifiers.
+ * @param n       Number of variables (1..PROTO_MAX_PAIRS).
+ * @return HAL_OK when sent, HAL_BUSY if the window is full, HAL_ERROR if @p n is out of range.
+ */
+HAL_StatusTypeDef master_submit_read_multi(const uint8_t *var_ids, uint8_t n) {
+    uint8_t frame[PROTO_MAX_FRAME];
+    return inflight_submit(frame, proto_build_read_multi(var_ids, n, frame));
+}
+/**
+ * @brief HAL callback when a TX DMA transfer has completed.
+ *
+ * Releases the frame just sent and chains the next queued frame.
+ *
+ * @param huart UART handle
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart != s_huart) return;
+    txq_pop(&s_txq);
+    s_tx_busy = false;
+    tx_kick();
 }
 /**
  * @brief HAL callback on UART RX idle event.
  *
- * Transfers received DMA data into the ring buffer and restarts reception.
+ * In circular mode the DMA keeps running and the bytes are parsed in place,
+ * so this only signals the link task. In legacy mode it transfers received
+ * DMA data into the ring buffer and restarts reception.
  * Optionally signals a FreeRTOS task via `osThreadFlagsSet()`.
  *
  * @param huart UART handle
- * @param Size  Number of bytes received
+ * @param Size  Number of bytes received (circular mode: current buffer position)
  */
 void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
     if (huart != s_huart) return;
-    rb_write(&s_rx_rb, s_rx_dma_buf, Size);
+#if !UART_RX_CIRCULAR
+    s_stats.overruns += (uint32_t)(Size - rb_write(&s_rx_rb, s_rx_dma_buf, Size));
     HAL_UARTEx_ReceiveToIdle_DMA(s_huart, s_rx_dma_buf, sizeof(s_rx_dma_buf));
     __HAL_DMA_DISABLE_IT(s_huart->hdmarx, DMA_IT_HT);
+#else
+    dma_rx_isr(&s_rx_dma, Size);    // HT, TC or idle: keeps the byte count for lap detection
+#endif
 
     if (s_notify_task) {
         osThreadFlagsSet(s_notify_task, 1);
@@ -153,16 +862,27 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
 /**
  * @brief HAL callback for UART error recovery.
  *
- * Clears overflow errors and restarts DMA reception.
+ * Clears overflow errors and restarts DMA reception. The read index and
+ * parser are left to the link task: @ref s_rx_error makes its next
+ * parser_drain() flush them, and the task is woken to do so.
  * @param huart UART handle
  */
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
     if (huart != s_huart) return;
+    s_stats.uart_errors++;
+    if (huart->ErrorCode & HAL_UART_ERROR_ORE) s_stats.overruns++;
 #if defined(__HAL_UART_CLEAR_OREFLAG)
     __HAL_UART_CLEAR_OREFLAG(huart);
 #endif
-    HAL_UARTEx_ReceiveToIdle_DMA(s_huart, s_rx_dma_buf, sizeof(s_rx_dma_buf));
-    __HAL_DMA_DISABLE_IT(s_huart->hdmarx, DMA_IT_HT);
+    rx_restart();
+    s_rx_error = true;
+    if (s_notify_task) osThreadFlagsSet(s_notify_task, 1);
+    /* If the error also ended a TX transfer, drop that frame and move on */
+    if (s_tx_busy && huart->gState == HAL_UART_STATE_READY) {
+        txq_pop(&s_txq);
+        s_tx_busy = false;
+        tx_kick();
+    }
 }
 
 /** @} */ // end of master_link
@@ -2,9 +2,9 @@
 
 #include "max31855.h"
 #include "usbd_cdc_if.h"   // For UsbPrintf (optional)
-#include <math.h>
 #include <stdio.h>
 #include "inputs.h"
+#include "telemetry.h"
 
 /* ---------------- Globals ---------------- */
 MAX31855_Data g_ThermoData = {0};
@@ -84,15 +84,15 @@ MAX31855_Data MAX31855_Read(void)
     out.fault = raw & 0x7;          // OC/SCG/SCV bits
 
     if (!out.flag) {
-        // Thermocouple temperature [31:18] (14-bit signed, 0.25 °C/bit)
+        // Thermocouple temperature [31:18] (14-bit signed, 0.25 °C/bit), kept in those units
         int16_t tc = (raw >> 18) & 0x3FFF;
         if (tc & 0x2000) tc |= 0xC000; // sign-extend
-        out.tc_c = tc * 0.25f;
+        out.tc_q2 = tc;
 
         // Cold-junction temperature [15:4] (12-bit signed, 0.0625 °C/bit)
         int16_t cj = (raw >> 4) & 0x0FFF;
         if (cj & 0x0800) cj |= 0xF000;
-        out.cj_c = cj * 0.0625f;
+        out.cj_q4 = cj;
     }
 
     return out;
@@ -114,7 +114,8 @@ void MAX31855_UpdateTask(void *argument)
 
         // Only check range if valid reading
         if (!d.flag) {
-            if (d.tc_c < MAX31855_TEMP_MIN_C || d.tc_c > MAX31855_TEMP_MAX_C) {
+            if (d.tc_q2 < MAX31855_TC_FROM_C(MAX31855_TEMP_MIN_C) ||
+                d.tc_q2 > MAX31855_TC_FROM_C(MAX31855_TEMP_MAX_C)) {
                 d.rangeFault = 1;
             }
         }
@@ -126,6 +127,8 @@ void MAX31855_UpdateTask(void *argument)
             osMutexRelease(g_ThermoMutex);
         }
 
+        Telemetry_Thermo(&d);   // no-op unless STREAM is on
+
 //        // Optional debug output
 //        if(verboseLogging){
 //			if (d.flag) {
@@ -6,9 +6,12 @@
  * This module defines the binary packet protocol used between the STM32
  * master and the slave controller. It handles:
  * - Frame parsing with start (`STX`) and end (`ETX`) markers
- * - Building and decoding of WRITE, READ, and ACK messages
+ * - Building and decoding of WRITE, READ, ACK and NOTIFY messages
+ * - Batched WRITE_MULTI / READ_MULTI / ACK_MULTI messages carrying N pairs
+ * - Optional transaction tags for pipelined requests
+ * - v2 framing (COBS + CRC16) negotiated with a HELLO exchange
  * - Role-dependent packet length handling (Master/Slave)
- * - Safe USB printf wrapper for debug output
+ * - Non-blocking USB printf with a TX ring drained by the CDC interrupt
  *
  * The protocol operates on simple, fixed-length frames:
  *
@@ -20,11 +23,22 @@
  * | 3–4 | `value` | Optional 16-bit data value |
  * | N | `ETX` | End byte (0x55) |
  *
+ * Batched frames insert a pair count after `CMD` and repeat the
+ * `var_id` / `value` fields `count` times (READ_MULTI requests carry only
+ * the `var_id` bytes).
+ *
+ * Any command may be sent tagged: `CMD | PROTO_TAG_FLAG` followed by a
+ * `TAG` byte, with the rest of the frame unchanged. The slave echoes the
+ * tag in its reply.
+ *
  * @ingroup IPOS_Firmware
  * @{
  */
 
 #include "protocol.h"
+#include "ring_buffer.h"
+#include "telemetry.h"
+#include "stm32f4xx_hal.h"
 #include "usbd_cdc_if.h"
 #include "cmsis_os2.h"
 #include <stdarg.h>
@@ -61,13 +75,28 @@ static inline uint16_t u16_from_lsbf(uint8_t lsb, uint8_t msb) {
  * @param p Pointer to parser object
  * @param role Protocol role (ROLE_MASTER or ROLE_SLAVE)
  */
-void proto_init(ProtoParser *p, ProtoRole role) { p->idx = 0; p->expected = 0; p->role = role; }
+void proto_init(ProtoParser *p, ProtoRole role) { p->idx = 0; p->expected = 0; p->role = role; p->version = PROTO_V1; p->resyncs = 0; }
+/**
+ * @brief Initialize a parser for v2 (COBS + CRC16) framing.
+ * @param p Pointer to parser object
+ * @param role Protocol role (ROLE_MASTER or ROLE_SLAVE)
+ */
+void proto_init_v2(ProtoParser *p, ProtoRole role) { proto_init(p, role); p->version = PROTO_V2; }
 /**
  * @brief Reset the parser state.
  * @param p Pointer to parser object
  */
 void proto_reset(ProtoParser *p)                { p->idx = 0; p->expected = 0; }
 
+/**
+ * @brief Check whether a command carries a pair count after the CMD byte.
+ * @param cmd Command byte
+ * @return `true` for the batched (MULTI) commands
+ */
+static inline bool is_multi(uint8_t cmd) {
+    return cmd == CMD_WRITE_MULTI || cmd == CMD_READ_MULTI || cmd == CMD_ACK_MULTI || cmd == CMD_NOTIFY_MULTI;
+}
+
 /**
  * @brief Determine expected frame length for given command.
  * @param role Parser role
@@ -78,11 +107,179 @@ static uint8_t expected_len(ProtoRole role, uint8_t cmd) {
     switch (cmd) {
         case CMD_WRITE: return 6;
         case CMD_ACK:   return 6;
+        case CMD_NOTIFY:return 6;
         case CMD_READ:  return (role == ROLE_SLAVE) ? 4 : 6;
+        case CMD_HELLO: return (role == ROLE_SLAVE) ? 4 : 6;
+        case CMD_BAUD:  return (role == ROLE_SLAVE) ? 4 : 6;
+        case CMD_ECHO:  return 6;
+        case CMD_CYCLE: return 6;
         default:        return 0;
     }
 }
 
+/**
+ * @brief Determine expected length of a batched frame once the pair count is known.
+ *
+ * A READ_MULTI request (slave side) carries only var_ids, every other batched
+ * frame carries full (var_id, value) triplets.
+ *
+ * @param role  Parser role
+ * @param cmd   Command byte
+ * @param count Number of pairs announced in the frame
+ * @return Expected frame length, or 0 if the count is invalid
+ */
+static uint8_t expected_multi_len(ProtoRole role, uint8_t cmd, uint8_t count) {
+    if (count == 0 || count > PROTO_MAX_PAIRS) return 0;
+    if (cmd == CMD_READ_MULTI && role == ROLE_SLAVE) return (uint8_t)(4u + count);
+    return (uint8_t)(4u + 3u * count);
+}
+
+/**
+ * @brief Decode the payload of a batched frame into `out->pairs`.
+ * @param role Parser role
+ * @param cmd  Command byte with the tag flag stripped
+ * @param q    Pointer to the pair count byte
+ * @param out  Output structure for parsed frame
+ */
+static void decode_multi(ProtoRole role, uint8_t cmd, const uint8_t *q, ProtoFrame *out) {
+    uint8_t n = *q++;
+    bool ids_only = (cmd == CMD_READ_MULTI) && (role == ROLE_SLAVE);
+
+    out->count     = n;
+    out->has_value = !ids_only;
+    out->var_id    = 0;
+    out->value     = 0;
+
+    for (uint8_t i = 0; i < n; i++) {
+        out->pairs[i].var_id = *q++;
+        if (ids_only) {
+            out->pairs[i].value = 0;
+        } else {
+            out->pairs[i].value = u16_from_lsbf(q[0], q[1]);
+            q += 2;
+        }
+    }
+}
+
+/**
+ * @brief Decode a frame body shared by both framing versions.
+ *
+ * @p b holds `CMD [TAG] body` without STX/ETX (v1) or CRC (v2); the length
+ * must match what the command implies.
+ *
+ * @param role Parser role
+ * @param b    Frame body
+ * @param len  Body length in bytes
+ * @param out  Output structure for parsed frame
+ * @return `true` if the body is a valid frame
+ */
+static bool decode_body(ProtoRole role, const uint8_t *b, uint8_t len, ProtoFrame *out) {
+    if (len < 2) return false;
+
+    uint8_t cmd = (uint8_t)(b[0] & ~PROTO_TAG_FLAG);
+    uint8_t tag = (b[0] & PROTO_TAG_FLAG) ? 1u : 0u;
+    uint8_t hdr = (uint8_t)(1u + tag);     // index of var_id / pair count
+    uint8_t expect;
+
+    if (is_multi(cmd)) {
+        if (len <= hdr) return false;
+        expect = expected_multi_len(role, cmd, b[hdr]);
+    } else {
+        expect = expected_len(role, cmd);
+    }
+    if (expect == 0 || (uint8_t)(expect - 2u + tag) != len) return false;
+
+    out->cmd    = cmd;
+    out->tagged = (tag != 0);
+    out->tag    = tag ? b[1] : 0;
+
+    if (is_multi(cmd)) {
+        decode_multi(role, cmd, &b[hdr], out);
+    } else {
+        out->var_id = b[hdr];
+        out->count  = 0;
+
+        if (expect == 6) {
+            out->has_value = true;
+            out->value = u16_from_lsbf(b[hdr + 1], b[hdr + 2]);
+        } else {
+            out->has_value = false;
+            out->value = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief CRC-16/MODBUS (poly 0xA001 reflected, init 0xFFFF).
+ *
+ * Same checksum as the ABCC driver's `CRC_Crc16()`, computed with a 16-entry
+ * nibble table so it does not depend on the ABCC serial driver being built.
+ *
+ * @param d Data
+ * @param n Length in bytes
+ * @return CRC value
+ */
+static uint16_t crc16(const uint8_t *d, size_t n) {
+    static const uint16_t tbl[16] = {
+        0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+        0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+    };
+    uint16_t crc = 0xFFFF;
+    while (n--) {
+        crc ^= *d++;
+        crc = (uint16_t)((crc >> 4) ^ tbl[crc & 0x0F]);
+        crc = (uint16_t)((crc >> 4) ^ tbl[crc & 0x0F]);
+    }
+    return crc;
+}
+
+/**
+ * @brief Decode a COBS block in place.
+ * @param buf Encoded bytes (no delimiters); decoded data overwrites them
+ * @param n   Encoded length
+ * @return Decoded length, 0 if the block is malformed
+ */
+static uint8_t cobs_decode(uint8_t *buf, uint8_t n) {
+    uint8_t r = 0, w = 0;
+    while (r < n) {
+        uint8_t code = buf[r++];
+        if (code == 0) return 0;
+        for (uint8_t i = 1; i < code; i++) {
+            if (r >= n) return 0;
+            buf[w++] = buf[r++];
+        }
+        if (code != 0xFF && r < n) buf[w++] = 0;
+    }
+    return w;
+}
+
+/**
+ * @brief v2 receive path: collect bytes up to a delimiter, then decode.
+ *
+ * Every delimiter ends the current frame, so after noise or a CRC failure the
+ * parser is back in sync at the very next frame.
+ */
+static bool push_v2(ProtoParser *p, uint8_t b, ProtoFrame *out) {
+    if (b != PROTO_V2_DELIM) {
+        if (p->idx < sizeof(p->buf)) p->buf[p->idx++] = b;
+        else p->expected = 0xFF;            // overlong: discard up to the next delimiter
+        return false;
+    }
+
+    bool ok = false;
+    if (p->idx != 0) {
+        if (p->expected != 0xFF) {
+            uint8_t n = cobs_decode(p->buf, p->idx);
+            if (n >= 4 && crc16(p->buf, (size_t)(n - 2)) == u16_from_lsbf(p->buf[n - 2], p->buf[n - 1]))
+                ok = decode_body(p->role, p->buf, (uint8_t)(n - 2), out);
+        }
+        if (!ok) p->resyncs++;
+    }
+    proto_reset(p);
+    return ok;
+}
+
 /**
  * @brief Feed one byte into the protocol parser.
  *
@@ -90,12 +287,19 @@ static uint8_t expected_len(ProtoRole role, uint8_t cmd) {
  * valid frame is detected. When a frame is complete, it fills the `out`
  * structure with decoded values and returns `true`.
  *
+ * In v1 framing, batched (MULTI) frames carry a pair count after the CMD
+ * byte, so their length is only known once that byte has arrived. In v2
+ * framing the frame ends at the next delimiter and is accepted only if its
+ * CRC matches.
+ *
  * @param p   Parser context
  * @param b   Incoming byte
  * @param out Output structure for parsed frame
  * @return `true` if a complete valid frame is parsed, otherwise `false`
  */
 bool proto_push(ProtoParser *p, uint8_t b, ProtoFrame *out) {
+    if (p->version == PROTO_V2) return push_v2(p, b, out);
+
     if (p->idx == 0) {
         if (b != STX) return false;
         p->buf[p->idx++] = b;
@@ -104,33 +308,37 @@ bool proto_push(ProtoParser *p, uint8_t b, ProtoFrame *out) {
 
     p->buf[p->idx++] = b;
 
-    if (p->idx == 2) {
-        p->expected = expected_len(p->role, p->buf[1]);
-        if (p->expected == 0 || p->expected > sizeof(p->buf)) {
+    /* A tagged frame has one TAG byte between CMD and the body */
+    uint8_t cmd = (uint8_t)(p->buf[1] & ~PROTO_TAG_FLAG);
+    uint8_t tag = (p->buf[1] & PROTO_TAG_FLAG) ? 1u : 0u;
+    uint8_t hdr = (uint8_t)(2u + tag);
+
+    if (p->idx == 2 && !is_multi(cmd)) {
+        p->expected = expected_len(p->role, cmd);
+        if (p->expected == 0 || p->expected + tag > PROTO_MAX_FRAME) {
+            p->resyncs++;
             proto_reset(p);
             return false;
         }
+        p->expected += tag;
     }
 
-    if (p->idx == p->expected) {
-        if (p->buf[p->expected - 1] != ETX) {
+    if (p->idx == hdr + 1 && is_multi(cmd)) {
+        p->expected = expected_multi_len(p->role, cmd, p->buf[hdr]);
+        if (p->expected == 0 || p->expected + tag > PROTO_MAX_FRAME) {
+            p->resyncs++;
             proto_reset(p);
             return false;
         }
+        p->expected += tag;
+    }
 
-        out->cmd    = p->buf[1];
-        out->var_id = p->buf[2];
-
-        if (p->expected == 6) {
-            out->has_value = true;
-            out->value = u16_from_lsbf(p->buf[3], p->buf[4]);
-        } else {
-            out->has_value = false;
-            out->value = 0;
-        }
-
+    if (p->idx == p->expected) {
+        bool ok = (p->buf[p->expected - 1] == ETX) &&
+                  decode_body(p->role, &p->buf[1], (uint8_t)(p->expected - 2), out);
+        if (!ok) p->resyncs++;
         proto_reset(p);
-        return true;
+        return ok;
     }
 
     return false;
@@ -184,6 +392,251 @@ size_t proto_build_readr(uint8_t var_id, uint16_t value, uint8_t out[8]) {
     return 6;
 }
 
+/**
+ * @brief Build an unsolicited NOTIFY frame (slave reports a changed value).
+ * @param var_id Variable identifier
+ * @param value  New data value
+ * @param out Output buffer
+ * @return Length of frame
+ */
+size_t proto_build_notify(uint8_t var_id, uint16_t value, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_NOTIFY; out[2]=var_id; out[3]=(uint8_t)(value & 0xFF); out[4]=(uint8_t)(value >> 8); out[5]=ETX;
+    return 6;
+}
+
+/**
+ * @brief Build a HELLO request (master offers its highest framing version).
+ * @param version Highest version supported (PROTO_V1 / PROTO_V2)
+ * @param out Output buffer
+ * @return Length of frame
+ */
+size_t proto_build_hello(uint8_t version, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_HELLO; out[2]=version; out[3]=ETX;
+    return 4;
+}
+/**
+ * @brief Build a HELLO reply (slave states the framing version to use).
+ * @param version Agreed version
+ * @param out Output buffer
+ * @return Length of frame
+ */
+size_t proto_build_hello_reply(uint8_t version, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_HELLO; out[2]=version; out[3]=0; out[4]=0; out[5]=ETX;
+    return 6;
+}
+/**
+ * @brief Build a BAUD request (master asks the slave to switch rate).
+ * @param rate_idx Index into `baud_rates[]`
+ * @param out Output buffer
+ * @return Length of frame
+ */
+size_t proto_build_baud(uint8_t rate_idx, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_BAUD; out[2]=rate_idx; out[3]=ETX;
+    return 4;
+}
+/**
+ * @brief Build a BAUD reply (slave states the rate it switches to).
+ * @param rate_idx Index into `baud_rates[]`
+ * @param out Output buffer
+ * @return Length of frame
+ */
+size_t proto_build_baud_reply(uint8_t rate_idx, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_BAUD; out[2]=rate_idx; out[3]=0; out[4]=0; out[5]=ETX;
+    return 6;
+}
+/**
+ * @brief Build an ECHO frame (the slave sends it back unchanged).
+ * @param seq   Sequence number
+ * @param value Test pattern
+ * @param out   Output buffer
+ * @return Length of frame
+ */
+size_t proto_build_echo(uint8_t seq, uint16_t value, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_ECHO; out[2]=seq; out[3]=(uint8_t)(value & 0xFF); out[4]=(uint8_t)(value >> 8); out[5]=ETX;
+    return 6;
+}
+/**
+ * @brief Build a CYCLE marker (slave: new Profinet read PD).
+ * @param seq       Marker count, mod 256
+ * @param period_us Slave's PD cycle period in µs
+ * @param out       Output buffer
+ * @return Length of frame
+ */
+size_t proto_build_cycle(uint8_t seq, uint16_t period_us, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_CYCLE; out[2]=seq; out[3]=(uint8_t)(period_us & 0xFF); out[4]=(uint8_t)(period_us >> 8); out[5]=ETX;
+    return 6;
+}
+
+/**
+ * @brief Write a batched frame carrying full (var_id, value) pairs.
+ * @param cmd   Command byte (WRITE_MULTI / ACK_MULTI / READ_MULTI reply)
+ * @param pairs Pairs to encode
+ * @param n     Number of pairs (1..PROTO_MAX_PAIRS)
+ * @param out   Output byte buffer
+ * @return Length of frame in bytes, 0 if @p n is out of range
+ */
+static size_t build_pairs(uint8_t cmd, const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    if (n == 0 || n > PROTO_MAX_PAIRS) return 0;
+
+    size_t k = 0;
+    out[k++] = STX; out[k++] = cmd; out[k++] = n;
+    for (uint8_t i = 0; i < n; i++) {
+        out[k++] = pairs[i].var_id;
+        out[k++] = (uint8_t)(pairs[i].value & 0xFF);
+        out[k++] = (uint8_t)(pairs[i].value >> 8);
+    }
+    out[k++] = ETX;
+    return k;
+}
+/**
+ * @brief Build a WRITE_MULTI frame (several variables in one frame).
+ * @param pairs Variables and values to write
+ * @param n     Number of pairs (1..PROTO_MAX_PAIRS)
+ * @param out   Output byte buffer
+ * @return Length of frame in bytes, 0 if @p n is out of range
+ */
+size_t proto_build_write_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    return build_pairs(CMD_WRITE_MULTI, pairs, n, out);
+}
+/**
+ * @brief Build a READ_MULTI request frame.
+ * @param var_ids Variable identifiers to read
+ * @param n       Number of variables (1..PROTO_MAX_PAIRS)
+ * @param out     Output buffer
+ * @return Length of frame, 0 if @p n is out of range
+ */
+size_t proto_build_read_multi(const uint8_t *var_ids, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    if (n == 0 || n > PROTO_MAX_PAIRS) return 0;
+
+    size_t k = 0;
+    out[k++] = STX; out[k++] = CMD_READ_MULTI; out[k++] = n;
+    for (uint8_t i = 0; i < n; i++) out[k++] = var_ids[i];
+    out[k++] = ETX;
+    return k;
+}
+/**
+ * @brief Build an ACK_MULTI frame acknowledging a WRITE_MULTI.
+ * @param pairs Acknowledged variables and values
+ * @param n     Number of pairs
+ * @param out   Output buffer
+ * @return Length of frame, 0 if @p n is out of range
+ */
+size_t proto_build_ack_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    return build_pairs(CMD_ACK_MULTI, pairs, n, out);
+}
+/**
+ * @brief Build a READ_MULTI response frame with data values.
+ * @param pairs Variables and the values to return
+ * @param n     Number of pairs
+ * @param out   Output buffer
+ * @return Length of frame, 0 if @p n is out of range
+ */
+size_t proto_build_readr_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    return build_pairs(CMD_READ_MULTI, pairs, n, out);
+}
+/**
+ * @brief Build a NOTIFY_MULTI frame (slave pushes several changed registers).
+ * @param pairs Changed variables and their new values
+ * @param n     Number of pairs
+ * @param out   Output buffer
+ * @return Length of frame, 0 if @p n is out of range
+ */
+size_t proto_build_notify_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    return build_pairs(CMD_NOTIFY_MULTI, pairs, n, out);
+}
+
+/**
+ * @brief Convert a built frame into its tagged form.
+ *
+ * Sets @ref PROTO_TAG_FLAG in the CMD byte and inserts @p tag after it, so
+ * the reply can be matched to this request regardless of arrival order.
+ *
+ * @param tag   Transaction tag echoed by the slave
+ * @param frame Frame produced by one of the builders (room for @p n + 1 bytes)
+ * @param n     Current frame length
+ * @return New frame length, 0 if @p n is not a valid frame length
+ */
+size_t proto_tag(uint8_t tag, uint8_t *frame, size_t n) {
+    if (n < 4 || n >= PROTO_MAX_FRAME) return 0;
+    memmove(&frame[3], &frame[2], n - 2);
+    frame[1] |= PROTO_TAG_FLAG;
+    frame[2]  = tag;
+    return n + 1;
+}
+
+/**
+ * @brief Frame a payload as 0x00, COBS(payload CRC16), 0x00.
+ *
+ * Same framing as the v2 link, for any payload length: runs of 254
+ * non-zero bytes are split into 0xFF blocks.
+ *
+ * @param raw Payload
+ * @param len Payload length
+ * @param out Output buffer, at least PROTO_COBS_MAX(len) bytes
+ * @return Wire length
+ */
+size_t proto_frame_cobs(const uint8_t *raw, size_t len, uint8_t *out) {
+    uint16_t crc = crc16(raw, len);
+    const uint8_t tail[2] = { (uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8) };
+
+    size_t k = 0;
+    out[k++] = PROTO_V2_DELIM;
+    size_t code_at = k++;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len + 2; i++) {
+        uint8_t b = (i < len) ? raw[i] : tail[i - len];
+        if (b == 0) {
+            out[code_at] = code;
+            code_at = k++;
+            code = 1;
+        } else {
+            out[k++] = b;
+            if (++code == 0xFF) {           // full block: no implied zero
+                out[code_at] = code;
+                code_at = k++;
+                code = 1;
+            }
+        }
+    }
+    out[code_at] = code;
+    out[k++] = PROTO_V2_DELIM;
+    return k;
+}
+
+/**
+ * @brief Re-encode a v1 frame as a v2 (COBS + CRC16) wire frame.
+ *
+ * The body between STX and ETX gets a CRC16 appended, is COBS-encoded so it
+ * contains no 0x00, and is wrapped in 0x00 delimiters. A leading delimiter
+ * lets the receiver resync even if noise preceded the frame.
+ *
+ * @param frame v1 frame from one of the builders (optionally tagged)
+ * @param n     v1 frame length
+ * @param out   Output buffer
+ * @return Wire length, 0 if @p frame is not a valid v1 frame
+ */
+size_t proto_encode_v2(const uint8_t *frame, size_t n, uint8_t out[PROTO_V2_MAX_WIRE]) {
+    if (n < 4 || n > PROTO_MAX_FRAME || frame[0] != STX || frame[n - 1] != ETX) return 0;
+    return proto_frame_cobs(&frame[1], n - 2, out);
+}
+
+/**
+ * @brief Decide whether a v1 HELLO may renegotiate the framing (slave side).
+ *
+ * COBS output can contain STX..ETX look-alikes, and the slave runs both
+ * parsers on every byte, so a v2 payload may parse as a v1 HELLO. While
+ * v2 is in use a HELLO is therefore only taken once no v2 frame has arrived
+ * for @p quiet_ms, as after a master restart.
+ *
+ * @param link_version Framing currently in use (PROTO_V1 / PROTO_V2)
+ * @param v2_quiet_ms  Time since the last valid v2 frame
+ * @param quiet_ms     Required v2 silence
+ * @return `true` if the HELLO may be answered
+ */
+bool proto_hello_allowed(uint8_t link_version, uint32_t v2_quiet_ms, uint32_t quiet_ms) {
+    return link_version != PROTO_V2 || v2_quiet_ms >= quiet_ms;
+}
+
 /* -------------------------------------------------------------------------- */
 /*                             USB Debug Print                                */
 /* -------------------------------------------------------------------------- */
@@ -191,57 +644,167 @@ size_t proto_build_readr(uint8_t var_id, uint16_t value, uint8_t out[8]) {
 /** Global flag indicating that USB CDC is ready */
 extern volatile uint8_t usbReadyFlag;
 
+/** TX ring between UsbPrintf() callers and the CDC IN endpoint */
+static uint8_t usbTxStorage[USB_TX_RING_SIZE];
+static RingBuffer usbTxRing = { usbTxStorage, USB_TX_RING_SIZE, 0, 0 };
+/** Bytes handed to CDC_Transmit_FS(), released by UsbTxComplete(); 0 = idle */
+static volatile uint16_t usbTxInFlight;
+/** Messages discarded because the ring was full */
+static volatile uint32_t usbTxDropped;
+/** Deepest ring occupancy seen, for sizing USB_TX_RING_SIZE */
+static uint16_t usbTxHighWater;
+
+/**
+ * @brief Start the next IN transfer if the endpoint is idle.
+ *
+ * Sends up to one full packet straight from the ring, so short messages
+ * queued while a packet was on the wire go out together. Must run with
+ * interrupts masked or from the USB interrupt.
+ */
+static void usb_tx_kick(void)
+{
+    if (usbTxInFlight != 0)
+        return;
+
+    const uint8_t *span;
+    uint16_t n = rb_peek_contiguous(&usbTxRing, &span);
+    if (n == 0)
+        return;
+    if (n > USB_TX_PACKET)
+        n = USB_TX_PACKET;
+
+    // BUSY: another writer owns the endpoint; its completion kicks us again
+    if (CDC_Transmit_FS((uint8_t*)span, n) == USBD_OK)
+        usbTxInFlight = n;
+}
+
+/**
+ * @brief CDC IN transfer finished (called from CDC_TransmitCplt_FS()).
+ *
+ * Releases the bytes just sent and chains the next packet.
+ */
+void UsbTxComplete(void)
+{
+    rb_commit(&usbTxRing, usbTxInFlight);
+    usbTxInFlight = 0;
+    usb_tx_kick();
+}
+
+/**
+ * @brief Drop queued output and any transfer lost with the connection.
+ *
+ * A bus reset or cable pull ends the IN transfer without a completion
+ * callback, so the pipeline restarts from empty once the host reconnects.
+ * Called from CDC_Init_FS() / CDC_DeInit_FS() and by writers that find the
+ * device unconfigured.
+ */
+void UsbTxReset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    usbTxRing.tail = usbTxRing.head;
+    usbTxInFlight = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Queue raw bytes for USB CDC without waiting.
+ *
+ * The message is queued whole or not at all: if the ring lacks room it is
+ * dropped and counted in UsbTxDropped(). While the host is not connected,
+ * data is discarded and any unfinished transfer is forgotten.
+ *
+ * @param data Bytes to send
+ * @param len  Number of bytes
+ * @return len if queued, 0 if dropped
+ */
+uint16_t UsbTxWrite(const uint8_t *data, uint16_t len)
+{
+    if (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED)
+    {
+        UsbTxReset();
+        return 0;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (rb_space(&usbTxRing) < len)
+    {
+        usbTxDropped++;
+        len = 0;
+    }
+    else
+    {
+        rb_write_n(&usbTxRing, data, len);
+        if (rb_count(&usbTxRing) > usbTxHighWater)
+            usbTxHighWater = rb_count(&usbTxRing);
+        usb_tx_kick();
+    }
+
+    __set_PRIMASK(primask);
+    return len;
+}
+
+/**
+ * @brief Free bytes in the USB TX ring.
+ *
+ * For bulk writers (LOG DUMP) that wait for room instead of having their
+ * output dropped. Another task may take the room before the write, so a
+ * writer still has to check UsbTxWrite()'s result.
+ */
+uint16_t UsbTxSpace(void)
+{
+    return rb_space(&usbTxRing);
+}
+
+/**
+ * @brief Read the USB TX pipeline statistics.
+ * @param high_water Optional; deepest ring occupancy seen (bytes)
+ * @return Number of messages dropped because the ring was full
+ */
+uint32_t UsbTxDropped(uint16_t *high_water)
+{
+    if (high_water)
+        *high_water = usbTxHighWater;
+    return usbTxDropped;
+}
+
 /**
- * @brief Thread-safe USB printf using CDC_Transmit_FS().
+ * @brief Non-blocking USB printf.
  *
- * Formats and transmits text over USB CDC in safe 64-byte chunks.
- * It automatically waits for the USB interface to become ready and
- * uses a mutex to prevent interleaved transmissions from multiple threads.
+ * Formats into a local buffer and queues it with UsbTxWrite(); the USB
+ * interrupt sends it in 64-byte packets. Never waits for the host, so it
+ * is safe in fault paths. Interrupts are masked only for the copy into the
+ * ring, which also keeps messages from different tasks from interleaving.
  *
  * @param fmt printf-style format string
  * @param ... Variable argument list
  *
- * @note Non-blocking; uses short delays between packets to allow host ACK.
+ * @note Output is lost (and counted) if it arrives faster than the host reads.
  */
 void UsbPrintf(const char *fmt, ...)
 {
-    static osMutexId_t usbTxMutex = NULL;
-    if (usbTxMutex == NULL)
-        usbTxMutex = osMutexNew(NULL);
-
     if (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED)
+    {
+        UsbTxReset();
         return;
+    }
 
-    osMutexAcquire(usbTxMutex, osWaitForever);
-
-    char buf[256];
+    char buf[MAX_USB_BUFF];
     va_list args;
     va_start(args, fmt);
-    int len = vsnprintf(buf, sizeof(buf) - 1, fmt, args);
+    int len = vsnprintf(buf, sizeof(buf), fmt, args);
     va_end(args);
 
-    // clamp and terminate
+    // clamp to what was actually written
     if (len < 0) len = 0;
     if (len >= (int)sizeof(buf)) len = sizeof(buf) - 1;
-    buf[len] = '\0';
-
-    // break into safe 64-byte USB packets
-    const int CHUNK = 64;
-    int sent = 0;
-    while (sent < len) {
-        int chunkSize = len - sent;
-        if (chunkSize > CHUNK)
-            chunkSize = CHUNK;
-
-        // wait for driver ready
-        while (CDC_Transmit_FS((uint8_t*)&buf[sent], (uint16_t)chunkSize) == USBD_BUSY)
-            osDelay(1);
-
-        sent += chunkSize;
-        osDelay(2); // let host ACK
-    }
 
-    osMutexRelease(usbTxMutex);
+    if (Telemetry_Active())
+        Telemetry_Text(buf, (uint16_t)len);     // keep the binary stream decodable
+    else
+        UsbTxWrite((const uint8_t*)buf, (uint16_t)len);
 }
 
 //void UsbVPrintf(const char *fmt, va_list args)
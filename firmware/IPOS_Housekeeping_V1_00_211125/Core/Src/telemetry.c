@@ -0,0 +1,182 @@
+/**
+ * @file telemetry.c
+ * @defgroup telemetry Binary Telemetry Stream
+ * @brief Compact binary diagnostics over USB CDC.
+ *
+ * With `STREAM ON`, input snapshots, status words, thermocouple samples and
+ * log events are sent as small binary records instead of formatted text,
+ * and any UsbPrintf() output is wrapped in TEXT records so the stream stays
+ * decodable. A record costs a few dozen bytes of copying and no vsnprintf().
+ *
+ * Records are built, stamped and queued with interrupts masked, so records
+ * from different tasks reach the host in sequence order and the buffers can
+ * be static instead of on each caller's stack. Nothing waits for the host:
+ * a record that does not fit in the USB TX ring is dropped, which shows up
+ * as a gap in `seq`.
+ *
+ * @ingroup IPOS_Firmware
+ * @{
+ */
+
+#include "telemetry.h"
+#include "protocol.h"
+#include "stm32f4xx_hal.h"
+#include <string.h>
+
+/** 1 while STREAM mode is on */
+static volatile uint8_t tlmOn;
+/** Next record sequence number */
+static uint8_t tlmSeq;
+/** Microsecond clock extended from the DWT cycle counter */
+static uint32_t tlmUs, tlmCyc, tlmCycRem;
+
+/**
+ * @brief Advance the microsecond clock (interrupts masked).
+ *
+ * CYCCNT wraps every ~25 s at 168 MHz; the snapshot records keep the gap
+ * between calls far below that while streaming.
+ */
+static uint32_t tlm_now_us(void)
+{
+    uint32_t perUs = SystemCoreClock / 1000000u;
+    uint32_t now = DWT->CYCCNT;
+    uint32_t d = (now - tlmCyc) + tlmCycRem;
+    tlmCyc = now;
+    tlmUs += d / perUs;
+    tlmCycRem = d % perUs;
+    return tlmUs;
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+
+/** Record and wire buffers, shared by all tasks; only used with interrupts masked */
+static uint8_t tlmRec[TLM_HDR_SIZE + TLM_MAX_PAYLOAD];
+static uint8_t tlmWire[PROTO_COBS_MAX(TLM_HDR_SIZE + TLM_MAX_PAYLOAD)];
+
+/**
+ * @brief Stamp, frame and queue one record, streaming or not.
+ *
+ * Runs entirely with interrupts masked (a few microseconds for the largest
+ * record), which keeps callers' stacks small and the records in seq order.
+ *
+ * @param type    Record type
+ * @param payload Payload bytes
+ * @param len     Payload length (clamped to TLM_MAX_PAYLOAD)
+ * @return 1 if queued, 0 if the USB TX ring had no room
+ */
+static uint8_t tlm_queue(uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    if (len > TLM_MAX_PAYLOAD)
+        len = TLM_MAX_PAYLOAD;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    tlmRec[0] = type;
+    tlmRec[1] = tlmSeq++;
+    put_u32(&tlmRec[2], tlm_now_us());
+    memcpy(&tlmRec[TLM_HDR_SIZE], payload, len);
+    size_t n = proto_frame_cobs(tlmRec, TLM_HDR_SIZE + len, tlmWire);
+    uint8_t ok = UsbTxWrite(tlmWire, (uint16_t)n) != 0;
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+/** @brief tlm_queue() while STREAM mode is on; nothing otherwise. */
+static uint8_t tlm_emit(uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    return tlmOn ? tlm_queue(type, payload, len) : 0;
+}
+
+/**
+ * @brief Switch STREAM mode on or off.
+ *
+ * Starting restarts the sequence and the microsecond clock at 0.
+ */
+void Telemetry_Enable(uint8_t on)
+{
+    if (on && !tlmOn) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        tlmSeq = 0;
+        tlmUs = 0;
+        tlmCycRem = 0;
+        tlmCyc = DWT->CYCCNT;
+        __set_PRIMASK(primask);
+    }
+    tlmOn = on ? 1 : 0;
+}
+
+/** @brief 1 while STREAM mode is on. */
+uint8_t Telemetry_Active(void)
+{
+    return tlmOn;
+}
+
+/** @brief Input snapshot: bit i = debounced state of input i. */
+void Telemetry_Inputs(uint32_t bitmap)
+{
+    uint8_t p[4];
+    put_u32(p, bitmap);
+    tlm_emit(TLM_REC_INPUTS, p, sizeof(p));
+}
+
+/** @brief The three status words sent to the PLC. */
+void Telemetry_Status(uint16_t debug, uint16_t debug2, uint16_t active)
+{
+    uint8_t p[6];
+    put_u16(&p[0], debug);
+    put_u16(&p[2], debug2);
+    put_u16(&p[4], active);
+    tlm_emit(TLM_REC_STATUS, p, sizeof(p));
+}
+
+/** @brief Thermocouple sample as the raw MAX31855 word; the host converts it. */
+void Telemetry_Thermo(const MAX31855_Data *d)
+{
+    uint8_t p[5];
+    put_u32(p, d->raw);
+    p[4] = d->rangeFault;
+    tlm_emit(TLM_REC_THERMO, p, sizeof(p));
+}
+
+/** @brief Log event as queued for flash. */
+void Telemetry_Log(uint16_t code, uint8_t flags, const char *msg)
+{
+    uint8_t p[3 + 64];
+    size_t n = msg ? strnlen(msg, 64) : 0;
+    put_u16(&p[0], code);
+    p[2] = flags;
+    if (n > 0)
+        memcpy(&p[3], msg, n);      // msg may be NULL: memcpy(dst, NULL, 0) is undefined
+    tlm_emit(TLM_REC_LOG, p, (uint16_t)(3 + n));
+}
+
+/** @brief Text output while streaming (UsbPrintf(), LOG DUMP); 1 if queued. */
+uint8_t Telemetry_Text(const char *text, uint16_t len)
+{
+    return tlm_emit(TLM_REC_TEXT, (const uint8_t *)text, len);
+}
+
+/** @brief Deferred-format log entries (called by FmtLog_Drain()). */
+void Telemetry_Fmt(const uint32_t *words, uint16_t nwords)
+{
+    tlm_emit(TLM_REC_FMT, (const uint8_t *)words, (uint16_t)(nwords * 4u));   // little-endian words
+}
+
+/**
+ * @brief Stored flash log records for `LOG BIN` (called by Log_Dump()).
+ *
+ * Sent whether or not STREAM mode is on, since the command asked for them.
+ * An empty record ends the dump.
+ *
+ * @return 1 if queued, 0 if the USB TX ring had no room (retry later)
+ */
+uint8_t Telemetry_LogRecs(const void *recs, uint16_t len)
+{
+    return tlm_queue(TLM_REC_LOGDUMP, (const uint8_t *)recs, len);
+}
+
+/** @} */
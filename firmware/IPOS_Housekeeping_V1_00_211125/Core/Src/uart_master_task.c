@@ -10,17 +10,20 @@
  * - The @ref app_main high-level task logic.
  *
  * @details
- * The UART Master Task initializes message queues for:
- * - Acknowledgment frames (`gAckQueue`)
- * - Data (read) frames (`gDataQueue`)
+ * The UART Master Task keeps one latest-value mailbox per variable for:
+ * - Acknowledged writes (CMD_ACK)
+ * - Received values (CMD_READ replies and CMD_NOTIFY)
+ * - The slave's Profinet PD cycle marker (CMD_CYCLE)
  *
  * It spawns a FreeRTOS thread that continuously polls the
  * @ref master_link parser, processes incoming UART frames, and
- * dispatches parsed messages to other tasks via message queues.
+ * publishes each value into its mailbox. Readers take a snapshot whenever
+ * they like, or subscribe to thread flags to be woken on updates.
  *
  * **Responsibilities:**
  * - Initialize UART communication
- * - Forward ACK and DATA frames from parser to queues
+ * - Store ACK, DATA and NOTIFY values in per-variable mailboxes
+ * - Wake subscribed reader tasks via thread flags
  * - Handle ISR notifications via thread flags
  * - Poll and drain protocol frames using @ref master_link_poll
  *
@@ -35,21 +38,128 @@
 #include "FreeRTOS.h"
 
 /* -------------------------------------------------------------------------- */
-/*                             Global Queues                                  */
+/*                           Variable Mailboxes                               */
 /* -------------------------------------------------------------------------- */
 
 /**
- * @brief Queue for acknowledgment frames from slave (CMD_ACK).
+ * @brief One latest-value slot, published with a sequence counter.
  *
- * Used by higher-level tasks (e.g., @ref app_main) to verify write commands.
+ * The single writer (uart_master task) updates the slot and bumps `seq` in
+ * one short interrupt-masked section, so no reader can observe it half
+ * written. A reader that is itself preempted by the writer sees `seq` change
+ * and copies again. Older values are simply overwritten: readers always see
+ * the newest one.
  */
-osMessageQueueId_t gAckQueue;
+typedef struct {
+    volatile uint32_t seq;      ///< Update count, 0 = never written
+    volatile uint16_t value;
+    volatile uint32_t tick;
+} MboxSlot;
+
+/** Last acknowledged write per variable */
+static MboxSlot s_ack_mbox[MBOX_MAX_VARS];
+/** Last READ reply / NOTIFY per variable */
+static MboxSlot s_data_mbox[MBOX_MAX_VARS];
+/** Last PD cycle marker (value = slave cycle period in µs) */
+static MboxSlot s_cycle_mbox;
+
+/** Reader registered for update flags */
+typedef struct {
+    osThreadId_t      thread;
+    volatile uint32_t flags;    ///< MBOX_FLAG_* bits of interest, 0 = free slot
+} MboxReader;
+
+static MboxReader s_readers[MBOX_MAX_READERS];
+
+/**
+ * @brief Publishes a value and wakes readers subscribed to @p flag.
+ * @param slot  Mailbox slot
+ * @param value New value
+ * @param flag  MBOX_FLAG_DATA() / MBOX_FLAG_ACK() bit of this slot
+ */
+static void mbox_publish(MboxSlot *slot, uint16_t value, uint32_t flag) {
+    uint32_t tick = osKernelGetTickCount();
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    slot->value = value;
+    slot->tick  = tick;
+    slot->seq++;
+    __set_PRIMASK(primask);
+
+    for (uint32_t i = 0; i < MBOX_MAX_READERS; i++)
+        if (s_readers[i].flags & flag) osThreadFlagsSet(s_readers[i].thread, flag);
+}
+/**
+ * @brief Copies a mailbox slot without blocking the writer.
+ * @return false if @p var_id has no mailbox
+ */
+static bool mbox_snapshot(const MboxSlot *table, uint8_t var_id, VarMailbox *out) {
+    if (var_id >= MBOX_MAX_VARS) return false;
+    const MboxSlot *slot = &table[var_id];
+    uint32_t seq;
+    do {
+        seq = slot->seq;
+        out->value = slot->value;
+        out->tick  = slot->tick;
+    } while (slot->seq != seq);     // writer ran in between: copy again
+    out->seq = seq;
+    return true;
+}
+/**
+ * @brief Latest READ reply or NOTIFY value of a variable.
+ * @param var_id Variable identifier
+ * @param out    Snapshot (`seq` = 0 if nothing received yet)
+ * @return false if @p var_id has no mailbox
+ */
+bool mbox_read_data(uint8_t var_id, VarMailbox *out) {
+    return mbox_snapshot(s_data_mbox, var_id, out);
+}
+/**
+ * @brief Latest acknowledged write of a variable.
+ * @param var_id Variable identifier
+ * @param out    Snapshot (`seq` = 0 if nothing acknowledged yet)
+ * @return false if @p var_id has no mailbox
+ */
+bool mbox_read_ack(uint8_t var_id, VarMailbox *out) {
+    return mbox_snapshot(s_ack_mbox, var_id, out);
+}
 /**
- * @brief Queue for incoming data frames (CMD_READ).
+ * @brief Latest PD cycle marker from the slave.
+ * @param out Snapshot: `value` = slave cycle period in µs, `seq` = markers
+ *            received (0 if none yet), `tick` = arrival
+ */
+void mbox_read_cycle(VarMailbox *out) {
+    mbox_snapshot(&s_cycle_mbox, 0, out);
+}
+/**
+ * @brief Subscribes the calling thread to mailbox update flags.
  *
- * Used to deliver variable data updates to the main control logic.
+ * The thread is then woken through osThreadFlagsWait() with the
+ * MBOX_FLAG_DATA(var) / MBOX_FLAG_ACK(var) bit of each update it asked for;
+ * wait on MBOX_FLAGS_DATA_ANY / MBOX_FLAGS_ACK_ANY for "any variable".
+ * Calling it again replaces the thread's flags.
+ *
+ * @param flags MBOX_FLAG_* bits of interest
+ * @return false if all @ref MBOX_MAX_READERS slots are taken
  */
-osMessageQueueId_t gDataQueue;
+bool mbox_subscribe(uint32_t flags) {
+    osThreadId_t self = osThreadGetId();
+    MboxReader *free_slot = NULL;
+
+    for (uint32_t i = 0; i < MBOX_MAX_READERS; i++) {
+        if (s_readers[i].flags && s_readers[i].thread == self) {
+            s_readers[i].flags = flags;
+            return true;
+        }
+        if (!s_readers[i].flags && !free_slot) free_slot = &s_readers[i];
+    }
+    if (!free_slot) return false;
+
+    free_slot->thread = self;
+    __DMB();                        // thread id visible before the slot goes live
+    free_slot->flags = flags;
+    return true;
+}
 
 extern uint8_t usbTxBuf[128];
 /* -------------------------------------------------------------------------- */
@@ -61,22 +171,43 @@ extern uint8_t usbTxBuf[128];
  * @param var_id Variable ID acknowledged
  * @param value  16-bit value returned by slave
  *
- * Pushes an acknowledgment frame into @ref gAckQueue.
+ * Stores the value in the variable's ACK mailbox.
  */
 void master_on_ack(uint8_t var_id, uint16_t value) {
-    VarFrame f = {var_id, value};
-    if (gAckQueue) osMessageQueuePut(gAckQueue, &f, 0, 0);
+    if (var_id < MBOX_MAX_VARS) mbox_publish(&s_ack_mbox[var_id], value, MBOX_FLAG_ACK(var_id));
 }
 /**
  * @brief Called by @ref master_link when a READ response is received.
  * @param var_id Variable ID read
  * @param value  16-bit value returned by slave
  *
- * Pushes a data frame into @ref gDataQueue.
+ * Stores the value in the variable's DATA mailbox.
  */
 void master_on_data(uint8_t var_id, uint16_t value) {
-    VarFrame f = {var_id, value};
-    if (gDataQueue) osMessageQueuePut(gDataQueue, &f, 0, 0);
+    if (var_id < MBOX_MAX_VARS) mbox_publish(&s_data_mbox[var_id], value, MBOX_FLAG_DATA(var_id));
+}
+/**
+ * @brief Called by @ref master_link when the slave pushes a changed value.
+ * @param var_id Variable ID that changed
+ * @param value  New 16-bit value
+ *
+ * Notifications go to the same DATA mailbox as READ replies, so readers
+ * handle polled and pushed values the same way.
+ */
+void master_on_notify(uint8_t var_id, uint16_t value) {
+    master_on_data(var_id, value);
+}
+/**
+ * @brief Called by @ref master_link when the slave starts a new PD cycle.
+ * @param seq       Marker count, mod 256
+ * @param period_us Slave's PD cycle period in µs
+ *
+ * Wakes tasks subscribed to MBOX_FLAG_CYCLE, which then run their
+ * write/read exchange in phase with the PLC.
+ */
+void master_on_cycle(uint8_t seq, uint16_t period_us) {
+    (void)seq;
+    mbox_publish(&s_cycle_mbox, period_us, MBOX_FLAG_CYCLE);
 }
 /* -------------------------------------------------------------------------- */
 /*                              Master Task                                   */
@@ -88,7 +219,8 @@ void master_on_data(uint8_t var_id, uint16_t value) {
  * This thread:
  * - Initializes the UART link and parser
  * - Waits for UART DMA RX notifications
- * - Periodically polls the @ref master_link layer for new frames
+ * - Periodically polls the @ref master_link layer for new frames and
+ *   overdue pipelined requests
  *
  * @param argument Pointer to UART handle (`UART_HandleTypeDef*`)
  *
@@ -101,7 +233,8 @@ static void vTaskUartMaster(void *argument) {
     master_link_attach_task_handle(osThreadGetId());
 
     for (;;) {
-        osThreadFlagsWait(1, osFlagsWaitAny, 20);  // wait for ISR flag or timeout
+        /* Wake sooner while tagged requests are outstanding so retries stay on time */
+        osThreadFlagsWait(1, osFlagsWaitAny, master_inflight() ? 5 : 20);  // wait for ISR flag or timeout
         master_link_poll();
     }
 }
@@ -110,11 +243,11 @@ static void vTaskUartMaster(void *argument) {
 /* -------------------------------------------------------------------------- */
 
 /**
- * @brief Creates message queues and starts the UART Master task.
+ * @brief Starts the UART Master task.
  *
  * This function is called from @ref app_main during startup.
- * It creates the FreeRTOS message queues and starts the
- * UART Master Task with high priority to maintain link timing.
+ * It starts the UART Master Task with high priority to maintain link
+ * timing. The mailboxes are static and need no creation.
  *
  * @param uart_handle Pointer to initialized UART handle (e.g. &huart2)
  *
@@ -123,9 +256,6 @@ static void vTaskUartMaster(void *argument) {
  * `osPriorityAboveNormal`.
  */
 void UartMaster_StartTasks(void *uart_handle) {
-    gAckQueue  = osMessageQueueNew(8, sizeof(VarFrame), NULL);
-    gDataQueue = osMessageQueueNew(8, sizeof(VarFrame), NULL);
-
     osThreadNew(vTaskUartMaster, uart_handle, &(const osThreadAttr_t){
         .name = "uart_master",
         .priority = osPriorityAboveNormal,
@@ -16,6 +16,11 @@
  * translates them into system events or control actions. Commands are posted as
  * messages to the RTOS queue for asynchronous processing by the input/event system.
  *
+ * Received bytes are only queued in the USB interrupt. vTaskUsbLogger
+ * assembles them into lines, so a command may arrive split over several USB
+ * packets (or several commands in one), and looks each line up in a sorted
+ * command table. The same table generates the HELP text.
+ *
  * @note The module interacts primarily with the Input Handling and Flash Log subsystems.
  */
 
@@ -25,21 +30,18 @@
 
 #include "debug_flags.h"
 #include "protocol.h"   /**< Provides UsbPrintf() for command feedback. */
+#include "telemetry.h"  /**< STREAM ON / OFF. */
 #include "cmsis_os2.h"
 #include "inputs.h"
-#include <string.h>
-#include <stdlib.h>
-#include <stdio.h>
-
-#include <string.h>
-#include "cmsis_os2.h"
 #include "usbd_cdc_if.h"
-#include "inputs.h"
-
 #include "FreeRTOS.h"
 #include "task.h"
 #include "max31855.h"
 #include "log_flash.h"
+#include "ring_buffer.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
 
 /* -------------------------------------------------------------------------- */
 /* External Variables                                                         */
@@ -70,194 +72,337 @@ extern osEventFlagsId_t ForceLatchEvent;  // event flag for reset button press
 extern uint16_t App_BuildDebug2StatusWord(void);
 
 /* -------------------------------------------------------------------------- */
-/* Internal Helpers                                                           */
+/* Receive Side                                                               */
 /* -------------------------------------------------------------------------- */
 
+/** Stored in place of dropped packets; the line it falls in is discarded */
+#define CMD_RX_DROP     0x18u   // ASCII CAN
+
+/** Raw bytes from CDC_Receive_FS(), consumed by UsbCommand_Poll() */
+static uint8_t cmdRxStorage[USB_CMD_RX_SIZE];
+static RingBuffer cmdRx = { cmdRxStorage, USB_CMD_RX_SIZE, 0, 0 };
+/** 1 while an EVT_USB_RX event is queued and not yet handled */
+static volatile uint8_t cmdRxPending;
+/** ISR only: 1 once CMD_RX_DROP marks the packets being dropped */
+static uint8_t cmdRxDropping;
+
+/** Line being assembled (task side only) */
+static char     cmdLine[USB_CMD_LINE_MAX + 1];
+static uint16_t cmdLen;
+static uint8_t  cmdDiscard;     ///< 1 = skip to the end of an overlong or damaged line
+
 /**
- * @brief Removes leading and trailing spaces and newline characters from a command string.
+ * @brief Queue received USB bytes (called from CDC_Receive_FS(), ISR context).
  *
- * @param[in,out] cmd Pointer to the command buffer to be trimmed.
+ * Only copies the bytes and wakes vTaskUsbLogger with one EVT_USB_RX event;
+ * nothing is parsed here. A packet is queued whole or not at all. One byte
+ * of the ring is kept free so that the first dropped packet can always be
+ * replaced by a CMD_RX_DROP marker: the parser then discards exactly the
+ * line the missing bytes belonged to. If the event cannot be queued,
+ * UsbCommand_Retry() picks the bytes up.
+ */
+void UsbCommand_Receive(const uint8_t *buf, uint32_t len)
+{
+    if (len < rb_space(&cmdRx)) {
+        rb_write_n(&cmdRx, buf, (uint16_t)len);
+        cmdRxDropping = 0;
+    } else if (!cmdRxDropping) {
+        rb_put(&cmdRx, CMD_RX_DROP);
+        cmdRxDropping = 1;
+    }
+
+    if (!cmdRxPending && inputEventQueue) {
+        InputEvent_t evt = { .type = EVT_USB_RX, .msg = "USB RX" };
+        if (osMessageQueuePut(inputEventQueue, &evt, 0, 0) == osOK)
+            cmdRxPending = 1;
+    }
+}
+
+/**
+ * @brief Run bytes whose EVT_USB_RX event did not fit in the queue.
  *
- * @details
- * This prevents issues when processing commands received via USB where
- * extra whitespace or carriage returns may be included.
+ * Called by vTaskUsbLogger each time its queue wait times out
+ * (USB_CMD_RETRY_MS), so a command is not stuck until the next packet.
+ */
+void UsbCommand_Retry(void)
+{
+    if (!cmdRxPending && rb_count(&cmdRx) != 0)
+        UsbCommand_Poll();
+}
+
+/**
+ * @brief Assemble queued bytes into lines and run each complete line.
+ *
+ * Called by vTaskUsbLogger on EVT_USB_RX. A line ends at CR or LF (CRLF
+ * gives one line and one empty line, which is ignored). Lines longer than
+ * USB_CMD_LINE_MAX, and lines that lost bytes to a full ring, are rejected
+ * whole.
+ */
+void UsbCommand_Poll(void)
+{
+    cmdRxPending = 0;       // bytes arriving from now on queue a new event
+
+    uint8_t c;
+    while (rb_get(&cmdRx, &c)) {
+        if (c == CMD_RX_DROP) {
+            cmdLen = 0;
+            cmdDiscard = 1;
+            UsbPrintf("[CMD] Input overflow, line discarded\r\n");
+        } else if (c == '\r' || c == '\n') {
+            if (!cmdDiscard && cmdLen > 0) {
+                cmdLine[cmdLen] = '\0';
+                UsbCommand_Process(cmdLine);
+            }
+            cmdLen = 0;
+            cmdDiscard = 0;
+        } else if (cmdDiscard) {
+            continue;
+        } else if (cmdLen < USB_CMD_LINE_MAX) {
+            cmdLine[cmdLen++] = (char)c;
+        } else {
+            cmdDiscard = 1;
+            UsbPrintf("[CMD] Line too long (max %u)\r\n", (unsigned)USB_CMD_LINE_MAX);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Command Handlers                                                           */
+/* -------------------------------------------------------------------------- */
+
+/** @brief Queue an event for vTaskUsbLogger / the input system. */
+static void post_event(InputEventType_t type, uint8_t newState, const char *msg)
+{
+    InputEvent_t evt = {
+        .type     = type,
+        .input    = 0,
+        .newState = newState,
+        .msg      = msg
+    };
+    osMessageQueuePut(inputEventQueue, &evt, 0, 0);
+}
+
+static void cmd_bdo(uint8_t arg)      { (void)arg; post_event(EVT_TEMP_STATUS, 0, "BDO TEMP"); }
+static void cmd_help(uint8_t arg)     { (void)arg; post_event(EVT_HELP, 0, "HELP"); }
+static void cmd_trupulse(uint8_t arg) { (void)arg; post_event(EVT_TRUPULSE, 0, "TRUPULSE STATE"); }
+static void cmd_status(uint8_t arg)   { (void)arg; post_event(EVT_STATUS, 0, "STATUS"); }
+
+static void cmd_bypass_thermo(uint8_t arg)
+{
+    if (arg < 2)
+        debugBypassThermoCheck = (arg != 0);
+    UsbPrintf("Thermocouple check bypass %s\r\n",
+              debugBypassThermoCheck ? "ENABLED" : "DISABLED");
+}
+
+static void cmd_flash(uint8_t arg)
+{
+    static const InputEventType_t evts[] = { EVT_FLASH_TEST, EVT_FLASH_ID, EVT_FLASH_STATUS };
+    static const char *const msgs[] = { "FLASH TEST", "FLASH ID", "FLASH STATUS" };
+    post_event(evts[arg], 0, msgs[arg]);
+}
+
+static void cmd_force(uint8_t arg)
+{
+    (void)arg;
+    // Trigger a force latch event for debug only
+    osEventFlagsSet(ForceLatchEvent, 0x01);
+    UsbPrintf("Reset-bit detected -> triggered latch reset\r\n");
+}
+
+static void cmd_link(uint8_t arg)     { post_event(EVT_LINK_STATS, arg, "LINK STATS"); }
+
+static void cmd_log(uint8_t arg)
+{
+    if (arg == 0)
+        post_event(EVT_LOG_DUMP, 0, "LOG DUMP");
+    else if (arg == 1)
+        post_event(EVT_LOG_ERASE, 0, "LOG ERASE");
+    else
+        post_event(EVT_LOG_DUMP, 1, "LOG BIN");
+}
+
+static void cmd_reset(uint8_t arg)
+{
+    (void)arg;
+    UsbPrintf("Latch reset command received\r\n");
+    osEventFlagsSet(ResetLatchEvent, 0x01);
+}
+
+static void cmd_start(uint8_t arg)    { (void)arg; UsbPrintf("Start enabled\r\n"); }
+
+static void cmd_stream(uint8_t arg)
+{
+    if (arg == 0) {
+        UsbPrintf("Binary telemetry ON (decode with tools/telemetry_decode.py)\r\n");
+        Telemetry_Enable(1);
+    } else {
+        Telemetry_Enable(0);
+        UsbPrintf("Binary telemetry OFF\r\n");
+    }
+}
+
+static void cmd_verbose(uint8_t arg)
+{
+    verboseLogging = (arg == 0);
+    UsbPrintf("Verbose logging %s\r\n", verboseLogging ? "ENABLED" : "DISABLED");
+}
+
+/* -------------------------------------------------------------------------- */
+/* Command Table                                                              */
+/* -------------------------------------------------------------------------- */
+
+/** @brief Accepted argument words, NULL-terminated; the handler gets the index. */
+static const char *const argOnOff[]   = { "ON", "OFF", NULL };
+static const char *const argBypass[]  = { "0", "1", "?", NULL };
+static const char *const argFlash[]   = { "TEST", "ID", "STATUS", NULL };
+static const char *const argLatch[]   = { "LATCH", NULL };
+static const char *const argLink[]    = { "STATS", "CLEAR", NULL };
+static const char *const argLog[]     = { "DUMP", "ERASE", "BIN", NULL };
+static const char *const argDebug[]   = { "DEBUG", NULL };
+static const char *const argTemp[]    = { "TEMP", NULL };
+
+/**
+ * @brief One console command.
+ *
+ * The first word of a line selects the entry; `args` is its argument
+ * parser: NULL means the command takes no argument, otherwise the rest of
+ * the line must be one of the listed words (case-insensitive) and its index
+ * is passed to `run`.
  */
-static void trim_cmd(char *cmd)
+typedef struct {
+    const char *name;               ///< First word, upper case
+    const char *const *args;        ///< Accepted arguments, or NULL
+    void (*run)(uint8_t arg);       ///< Handler, arg = index into args (0 if none)
+    const char *help;               ///< One-line HELP text
+} UsbCmd;
+
+/** Sorted by name (strcasecmp order) for the binary search; keep it that way. */
+static const UsbCmd usbCmds[] = {
+    { "BDO",           argTemp,   cmd_bdo,           "Show current thermocouple temperature" },
+    { "BYPASS_THERMO", argBypass, cmd_bypass_thermo, "Disable(1)/enable(0) TC range/fault checks; '?' to query" },
+    { "FLASH",         argFlash,  cmd_flash,         "TEST: self-test (erases the log), ID: JEDEC id, STATUS: usage" },
+    { "FORCE",         argLatch,  cmd_force,         "Force a latch fault (debug)" },
+    { "HELP",          NULL,      cmd_help,          "Show this help menu" },
+    { "LINK",          argLink,   cmd_link,          "UART link counters and round-trip histogram; CLEAR zeroes them after printing" },
+    { "LOG",           argLog,    cmd_log,           "DUMP: whole flash log as text, BIN: as binary records, ERASE: erase it" },
+    { "RESET",         NULL,      cmd_reset,         "Reset latch faults (hardware faults stay latched)" },
+    { "START",         NULL,      cmd_start,         "Not enabled yet" },
+    { "STATUS",        argDebug,  cmd_status,        "Print input states" },
+    { "STREAM",        argOnOff,  cmd_stream,        "Binary telemetry records instead of text" },
+    { "TRUPULSE",      NULL,      cmd_trupulse,      "Display status of the TruPulse monitor pins" },
+    { "VERBOSE",       argOnOff,  cmd_verbose,       "Detailed input logging on/off" },
+};
+
+#define USB_CMD_COUNT   (sizeof(usbCmds) / sizeof(usbCmds[0]))
+
+/** @brief Binary search of usbCmds[] by first word; NULL if unknown. */
+static const UsbCmd *find_cmd(const char *name)
 {
-    // Remove leading spaces
-    while (*cmd == ' ' || *cmd == '\t') {
-        cmd++;
+    uint32_t lo = 0, hi = USB_CMD_COUNT;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2u;
+        int c = strcasecmp(name, usbCmds[mid].name);
+        if (c == 0)
+            return &usbCmds[mid];
+        if (c < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
     }
+    return NULL;
+}
 
-    // Remove trailing CR/LF/spaces
-    char *end = cmd + strlen(cmd) - 1;
-    while (end >= cmd && (*end == '\r' || *end == '\n' || *end == ' ' || *end == '\t')) {
-        *end = '\0';
-        end--;
+/** @brief Write "A|B|C" for an argument list ("" if none) into out. */
+static const char *join_args(const char *const *args, char *out, size_t size)
+{
+    size_t n = 0;
+    out[0] = '\0';
+    for (uint8_t i = 0; args && args[i] && n < size; i++)
+        n += (size_t)snprintf(out + n, size - n, i ? "|%s" : "%s", args[i]);
+    return out;
+}
+
+/**
+ * @brief Print the command list (EVT_HELP), generated from usbCmds[].
+ */
+void UsbCommand_PrintHelp(void)
+{
+    char a[32];
+    UsbPrintf("Available commands:\r\n");
+    for (uint32_t i = 0; i < USB_CMD_COUNT; i++) {
+        const UsbCmd *c = &usbCmds[i];
+        UsbPrintf("  %-13s %-14s - %s\r\n", c->name, join_args(c->args, a, sizeof(a)), c->help);
     }
+    UsbPrintf("-----------------------------\r\n");
 }
 
 /* -------------------------------------------------------------------------- */
 /* Command Processor                                                          */
 /* -------------------------------------------------------------------------- */
 
+static inline bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
 /**
- * @brief Processes incoming USB commands from the CDC interface.
+ * @brief Runs one command line.
  *
- * @param[in] cmd Null-terminated ASCII command string.
+ * @param[in] cmd Null-terminated ASCII command line (no line ending needed).
  *
  * @details
- * Recognized commands trigger specific actions such as:
- * - **HELP** — Lists all available commands.
- * - **VERBOSE ON/OFF** — Enables or disables detailed debug output.
- * - **STATUS DEBUG** — Requests current input status report.
- * - **TRUPULSE** — Displays Trupulse monitor pin states.
- * - **BDO TEMP** — Displays current thermocouple reading.
- * - **LOG DUMP / LOG ERASE** — Manages non-volatile event logs.
- * - **FLASH TEST / FLASH ID / FLASH STATUS** — Tests or queries SPI flash.
- * - **RESET** — Issues a software latch reset event.
+ * The line is split into a command word and at most one argument word,
+ * ignoring surrounding blanks. The command word is looked up in usbCmds[]
+ * (O(log n)) and the argument is checked against the entry's list. See
+ * UsbCommand_PrintHelp() or Docs/usb_commands.md for the commands.
  *
- * Unrecognized commands print an error message and a hint to use `HELP`.
+ * Unrecognized commands print an error message and a hint to use `HELP`;
+ * a wrong or missing argument prints the accepted ones.
  *
- * @note Commands are parsed case-insensitively.
+ * @note Commands are parsed case-insensitively. Called from vTaskUsbLogger.
  */
 void UsbCommand_Process(const char *cmd)
 {
-    // Trim whitespace (optional, prevents '\r' or '\n' issues)
-	trim_cmd(cmd);
-
-    if (strcasecmp(cmd, "HELP") == 0) {
-    	InputEvent_t evt = {
-				.type  = EVT_HELP,
-				.input = 0,
-				.newState = 0,
-				.msg = "HELP"   // marker string
-			};
-			osMessageQueuePut(inputEventQueue, &evt, 0, 0);
-    }
-    else if (strcasecmp(cmd, "VERBOSE ON") == 0) {
-        verboseLogging = 1;
-        UsbPrintf("Verbose logging ENABLED\r\n");
-    }
-    else if (strcasecmp(cmd, "VERBOSE OFF") == 0) {
-        verboseLogging = 0;
-        UsbPrintf("Verbose logging DISABLED\r\n");
-    }
-    else if (strcasecmp(cmd, "START") == 0) {
-
-		UsbPrintf("Start enabled\r\n");
-	}
-    else if (strcasecmp(cmd, "STATUS DEBUG") == 0) {
-		InputEvent_t evt = {
-			.type  = EVT_STATUS,
-			.input = 0,
-			.newState = 0,
-			.msg = "STATUS"   // marker string
-		};
-		osMessageQueuePut(inputEventQueue, &evt, 0, 0);
-    }
-    else if (strcasecmp(cmd, "TruPulse") == 0)
-    {
-        InputEvent_t evt = {
-            .type = EVT_TRUPULSE,
-            .input = 0,
-            .newState = 0,
-            .msg = "TRUPULSE STATE"
-        };
-        osMessageQueuePut(inputEventQueue, &evt, 0, 0);
-    }
-    else if (strcasecmp(cmd, "BDO TEMP") == 0)
-    {
-        InputEvent_t evt = {
-            .type = EVT_TEMP_STATUS,
-            .input = 0,
-            .newState = 0,
-            .msg = "BDO TEMP"
-        };
-        osMessageQueuePut(inputEventQueue, &evt, 0, 0);
-    }
-
-    else if (strcasecmp(cmd, "LOG DUMP") == 0)
-    {
-        InputEvent_t evt = {
-            .type = EVT_LOG_DUMP,
-            .input = 0,
-            .newState = 0,
-            .msg = "LOG DUMP"
-        };
-        osMessageQueuePut(inputEventQueue, &evt, 0, 0);
-    }
+    char word[16];
+    const char *p = cmd;
+    uint8_t n = 0;
 
-    else if (strcasecmp(cmd, "FLASH TEST") == 0)
-    {
-        InputEvent_t evt = {
-            .type = EVT_FLASH_TEST,
-            .input = 0,
-            .newState = 0,
-            .msg = "FLASH TEST"
-        };
-        osMessageQueuePut(inputEventQueue, &evt, 0, 0);
+    while (is_blank(*p)) p++;
+    while (*p && !is_blank(*p)) {
+        if (n < sizeof(word) - 1)
+            word[n] = *p;
+        n++;
+        p++;
     }
+    if (n == 0)
+        return;
+    word[n < sizeof(word) ? n : sizeof(word) - 1] = '\0';
 
-    else if (strcasecmp(cmd, "FLASH ID") == 0)
-    {
-        InputEvent_t evt = {
-            .type = EVT_FLASH_ID,
-            .input = 0,
-            .newState = 0,
-            .msg = "FLASH ID"
-        };
-        osMessageQueuePut(inputEventQueue, &evt, 0, 0);
-    }
+    const char *arg = p;
+    while (is_blank(*arg)) arg++;
+    const char *end = arg + strlen(arg);
+    while (end > arg && is_blank(end[-1])) end--;
 
-    else if (strcasecmp(cmd, "FLASH STATUS") == 0)
-    {
-        InputEvent_t evt = {
-            .type = EVT_FLASH_STATUS,
-            .input = 0,
-            .newState = 0,
-            .msg = "FLASH STATUS"
-        };
-        osMessageQueuePut(inputEventQueue, &evt, 0, 0);
+    const UsbCmd *c = (n < sizeof(word)) ? find_cmd(word) : NULL;
+    if (!c) {
+        UsbPrintf("Unknown command: %s\r\nType HELP for list.\r\n", cmd);
+        return;
     }
 
-    else if (strcasecmp(cmd, "LOG ERASE") == 0)
-    {
-        InputEvent_t evt = {
-            .type = EVT_LOG_ERASE,
-            .input = 0,
-            .newState = 0,
-            .msg = "LOG ERASE"
-        };
-        osMessageQueuePut(inputEventQueue, &evt, 0, 0);
-    }
-    else if (strncmp(cmd, "bypass_thermo", 13) == 0) {
-        int val = 0;
-        if (sscanf(cmd + 13, "%d", &val) == 1) {
-            debugBypassThermoCheck = (val != 0);
-            UsbPrintf("Thermocouple check bypass %s\r\n",
-                      debugBypassThermoCheck ? "ENABLED" : "DISABLED");
-        } else {
-            UsbPrintf("Usage: bypass_thermo <0|1>\r\n");
+    uint8_t idx = 0;
+    if (c->args) {
+        size_t alen = (size_t)(end - arg);
+        while (c->args[idx] &&
+               !(strlen(c->args[idx]) == alen && strncasecmp(arg, c->args[idx], alen) == 0))
+            idx++;
+        if (!c->args[idx]) {
+            char a[32];
+            UsbPrintf("Usage: %s %s\r\n", c->name, join_args(c->args, a, sizeof(a)));
+            return;
         }
+    } else if (end != arg) {
+        UsbPrintf("Usage: %s (no argument)\r\n", c->name);
+        return;
     }
 
-    else if (strcasecmp(cmd, "Force Latch") == 0){
-    		// Trigger a force latch event for debug only
-			osEventFlagsSet(ForceLatchEvent, 0x01);
-			UsbPrintf("Reset-bit detected -> triggered latch reset\r\n");
-    }
-
-    else if (strcasecmp(cmd, "RESET") == 0) {
-        UsbPrintf("Latch reset command received\r\n");
-        osEventFlagsSet(ResetLatchEvent, 0x01);
-    }
-    else {
-        char buf[256];
-        snprintf(buf, sizeof(buf),
-                 "Unknown command: %s\r\nType HELP for list.\r\n", cmd);
-        UsbPrintf("%s", buf);
-    }
+    c->run(idx);
 }
 /** @} */ // end of usb_commands
-
@@ -159,6 +159,7 @@ static int8_t CDC_Init_FS(void)
   /* Set Application Buffers */
   USBD_CDC_SetTxBuffer(&hUsbDeviceFS, UserTxBufferFS, 0);
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, UserRxBufferFS);
+  UsbTxReset();       // a transfer cut off by the last disconnect never completes
   return (USBD_OK);
   /* USER CODE END 3 */
 }
@@ -170,6 +171,7 @@ static int8_t CDC_Init_FS(void)
 static int8_t CDC_DeInit_FS(void)
 {
   /* USER CODE BEGIN 4 */
+  UsbTxReset();
   return (USBD_OK);
   /* USER CODE END 4 */
 }
@@ -273,9 +275,8 @@ static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 6 */
 
-  Buf[*Len] = '\0'; // Null-terminate so we can treat it as a string
-
-  UsbCommand_Process((char*)Buf);
+  // Queue only; vTaskUsbLogger assembles and runs the command lines
+  UsbCommand_Receive(Buf, *Len);
 
   // Re-arm USB receive
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
@@ -329,6 +330,7 @@ static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
   UNUSED(Buf);
   UNUSED(Len);
   UNUSED(epnum);
+  UsbTxComplete();    // release the sent bytes and start the next packet
   /* USER CODE END 13 */
   return result;
 }
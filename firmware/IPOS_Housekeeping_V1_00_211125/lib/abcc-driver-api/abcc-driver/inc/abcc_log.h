@@ -234,6 +234,11 @@ void ABCC_LogError( ABCC_LogSeverityType eSeverity,
    ABCC_ErrorCodeType eErrorCode,
    UINT32 lAdditionalInfo );
 
+/*
+** The log wrapper can be replaced from abcc_driver_config.h, e.g. to log
+** without formatting on the target.
+*/
+#ifndef ABCC_LogHandlerWrapper
 #if ABCC_CFG_LOG_FILE_LINE_ENABLED && ABCC_CFG_LOG_STRINGS_ENABLED
 #define ABCC_LogHandlerWrapper( bSeverity, eErrorCode, lAdditionalInfo, ... ) \
    ABCC_LogHandler( bSeverity, eErrorCode, lAdditionalInfo, ABCC_FILE_IDENTIFIER, __LINE__, __VA_ARGS__ )
@@ -247,6 +252,7 @@ void ABCC_LogError( ABCC_LogSeverityType eSeverity,
 #define ABCC_LogHandlerWrapper( bSeverity, eErrorCode, lAdditionalInfo, ... ) \
    ABCC_LogHandler( bSeverity, eErrorCode, lAdditionalInfo )
 #endif
+#endif
 
 #if ABCC_CFG_DEBUG_MESSAGING_ENABLED
 EXTFUNC void ABCC_LogMsg( ABP_MsgType* psMsg );
@@ -129,4 +129,38 @@
 #define ABCC_CFG_LOG_COLORS_ENABLED 0
 #define ABCC_CFG_DEBUG_HEXDUMP_SPI_ENABLED 1
 
+/*------------------------------------------------------------------------------
+** Deferred-format logging
+**
+** 1: ABCC_LOG_WARNING/INFO/DEBUG() store a format ID and the raw arguments
+**    with FLOG() (fmtlog.h) instead of formatting text in ABCC_LogHandler().
+**    Read them with STREAM ON and tools/telemetry_decode.py --elf.
+**    FATAL and ERROR stay formatted text through ABCC_LogHandler(), which
+**    also calls ABCC_LogError(): they must reach a plain terminal, and a
+**    fatal error may stop the board before anyone starts streaming.
+** 0: formatted text via ABCC_LogHandler() and ABCC_PORT_printf().
+**------------------------------------------------------------------------------
+*/
+#ifndef IPOS_ABCC_FLOG_ENABLED
+#define IPOS_ABCC_FLOG_ENABLED 1
+#endif
+
+#if IPOS_ABCC_FLOG_ENABLED && ABCC_CFG_LOG_STRINGS_ENABLED && ABCC_CFG_LOG_FILE_LINE_ENABLED
+#include "fmtlog.h"
+#define ABCC_LogHandlerWrapper( bSeverity, eErrorCode, lAdditionalInfo, ... )                  \
+do                                                                                          \
+{                                                                                           \
+   if( ( bSeverity ) <= ABCC_LOG_SEVERITY_ERROR )                                           \
+   {                                                                                        \
+      ABCC_LogHandler( bSeverity, eErrorCode, lAdditionalInfo,                              \
+                       ABCC_FILE_IDENTIFIER, __LINE__, __VA_ARGS__ );                       \
+   }                                                                                        \
+   else                                                                                     \
+   {                                                                                        \
+      FLOG_LEVEL( ( bSeverity ) + 1,                                                        \
+         "[ABCC] " ABCC_FILE_IDENTIFIER ":" FLOG_STR_( __LINE__ ) " " __VA_ARGS__ );        \
+   }                                                                                        \
+} while( 0 )
+#endif
+
 #endif  /* inclusion lock */
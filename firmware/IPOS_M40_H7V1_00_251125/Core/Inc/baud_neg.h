@@ -0,0 +1,270 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Link baud-rate negotiation. Nothing here touches the HAL: the caller feeds
+ * in ticks, replies and error counts and carries out the returned action, so
+ * master and slave can be run against each other on a host.
+ *
+ * Rates are indices into baud_rates[]; index 0 is the power-up rate that
+ * both sides fall back to.
+ *
+ * Master (BaudNeg), one step at a time:
+ *   1. send CMD_BAUD(target) at the current rate
+ *   2. the slave answers at the current rate, then switches once the answer
+ *      has left its UART; the master switches on receiving it
+ *   3. after BAUD_SETTLE_MS, BAUD_PROBES echo frames must come back intact
+ *   4. success -> keep the rate and try the next one
+ * Any lost reply or bad echo drops the master to index 0, lowers the
+ * ceiling below the failed rate and holds for BAUD_HOLD_MS before trying
+ * again. Above index 0 a keep-alive echo runs every BAUD_KEEPALIVE_MS, and
+ * BAUD_ERR_LIMIT link errors within BAUD_ERR_WINDOW_MS trigger the same
+ * fallback. An outage looks the same as a failing rate, so once the link
+ * has run BAUD_RECOVER_MS below the ceiling from baud_neg_init() without
+ * such an error burst, the ceiling is restored and the rates are tried again.
+ *
+ * Slave (BaudFollow): switches on request and returns to index 0 on its own
+ * after BAUD_SILENCE_MS without a valid frame. That is how it follows a
+ * master fallback it could not hear; BAUD_HOLD_MS > BAUD_SILENCE_MS so the
+ * master only retries once the slave is back at index 0.
+ */
+#define BAUD_RATE_COUNT 4u
+static const uint32_t baud_rates[BAUD_RATE_COUNT] = { 115200u, 460800u, 921600u, 2000000u };
+
+#ifndef BAUD_PROBES
+#define BAUD_PROBES          8u
+#endif
+#ifndef BAUD_REPLY_TIMEOUT_MS
+#define BAUD_REPLY_TIMEOUT_MS 50u
+#endif
+#ifndef BAUD_PROBE_ERR_LIMIT
+#define BAUD_PROBE_ERR_LIMIT 2u      // link errors tolerated while probing
+#endif
+#ifndef BAUD_SETTLE_MS
+#define BAUD_SETTLE_MS       5u
+#endif
+#ifndef BAUD_KEEPALIVE_MS
+#define BAUD_KEEPALIVE_MS    500u
+#endif
+#ifndef BAUD_ERR_LIMIT
+#define BAUD_ERR_LIMIT       8u
+#endif
+#ifndef BAUD_ERR_WINDOW_MS
+#define BAUD_ERR_WINDOW_MS   1000u
+#endif
+#ifndef BAUD_SILENCE_MS
+#define BAUD_SILENCE_MS      2000u
+#endif
+#ifndef BAUD_HOLD_MS
+#define BAUD_HOLD_MS         (BAUD_SILENCE_MS + 500u)
+#endif
+#ifndef BAUD_RECOVER_MS
+#define BAUD_RECOVER_MS      (5u * 60u * 1000u)     // clean running before a lowered ceiling is lifted
+#endif
+
+/* Echo payload for a sequence number: mixes 0x00, 0xFF and alternating bits */
+static inline uint16_t baud_echo_pattern(uint8_t seq) {
+    return (uint16_t)(0x55AAu ^ (uint16_t)(seq * 0x0101u));
+}
+
+/* ---------------------------------- Master --------------------------------- */
+
+typedef enum { BAUD_IDLE, BAUD_REQUEST, BAUD_SETTLE, BAUD_PROBE, BAUD_RUN, BAUD_HOLD } BaudState;
+
+typedef enum {
+    BAUD_ACT_NONE,
+    BAUD_ACT_REQUEST,       // send CMD_BAUD(target) at the current rate
+    BAUD_ACT_SET_RATE,      // switch the local UART to baud_rates[cur]
+    BAUD_ACT_ECHO           // send CMD_ECHO(echo_seq, baud_echo_pattern(echo_seq))
+} BaudAction;
+
+typedef struct {
+    BaudState state;
+    uint8_t  cur;           // rate index in use
+    uint8_t  target;        // rate index being tried
+    uint8_t  ceiling;       // highest index still worth trying
+    uint8_t  limit;         // ceiling from baud_neg_init(), restored by recovery
+    uint8_t  probes;        // echoes answered at the current step
+    uint8_t  echo_seq;      // echo awaiting its answer
+    bool     echo_wait;
+    uint8_t  echo_missed;   // keep-alive echoes lost in a row
+    uint32_t t0;            // start of the current wait
+    uint32_t err_base;      // error count at the start of the window
+    uint32_t err_t0;
+    uint32_t clean_t0;      // start of the current run without an error burst
+    uint16_t fallbacks;     // times the link dropped back to index 0
+    uint16_t recoveries;    // times the ceiling was restored
+} BaudNeg;
+
+static inline void baud_neg_init(BaudNeg *n, uint8_t ceiling) {
+    n->state = BAUD_IDLE;
+    n->cur = n->target = 0;
+    n->ceiling = (ceiling < BAUD_RATE_COUNT) ? ceiling : (uint8_t)(BAUD_RATE_COUNT - 1u);
+    n->limit = n->ceiling;
+    n->probes = n->echo_seq = n->echo_missed = 0;
+    n->echo_wait = false;
+    n->t0 = n->err_base = n->err_t0 = n->clean_t0 = 0;
+    n->fallbacks = n->recoveries = 0;
+}
+
+/* True once no step is in progress (RUN, HOLD or never started) */
+static inline bool baud_neg_settled(const BaudNeg *n) {
+    return n->state == BAUD_RUN || n->state == BAUD_HOLD || n->state == BAUD_IDLE;
+}
+
+/* Try the next rate up, or settle at the current one */
+static inline BaudAction baud_neg_start(BaudNeg *n, uint32_t now) {
+    n->t0 = now;
+    n->echo_wait = false;
+    n->echo_missed = 0;
+    if (n->cur < n->ceiling) {
+        n->target = (uint8_t)(n->cur + 1u);
+        n->state  = BAUD_REQUEST;
+        return BAUD_ACT_REQUEST;
+    }
+    n->state = BAUD_RUN;
+    n->clean_t0 = now;
+    return BAUD_ACT_NONE;
+}
+
+/* Drop to index 0; the failed rate and above wait for the ceiling to be restored */
+static inline BaudAction baud_neg_fail(BaudNeg *n, uint32_t now) {
+    uint8_t failed = (n->state == BAUD_RUN) ? n->cur : n->target;
+    n->ceiling = failed ? (uint8_t)(failed - 1u) : 0u;
+    n->cur     = 0;
+    n->state   = BAUD_HOLD;
+    n->t0      = now;
+    n->echo_wait = false;
+    n->fallbacks++;
+    return BAUD_ACT_SET_RATE;
+}
+
+static inline BaudAction baud_neg_echo(BaudNeg *n, uint32_t now) {
+    n->echo_seq++;
+    n->echo_wait = true;
+    n->t0 = now;
+    return BAUD_ACT_ECHO;
+}
+
+/* CMD_BAUD reply from the slave: idx is the rate it switched to */
+static inline BaudAction baud_neg_on_reply(BaudNeg *n, uint8_t idx, uint32_t now) {
+    if (n->state != BAUD_REQUEST) return BAUD_ACT_NONE;
+    if (idx != n->target) {             // refused: stay where we are
+        n->ceiling = n->cur;
+        n->state = BAUD_RUN;
+        n->t0 = n->clean_t0 = now;
+        return BAUD_ACT_NONE;
+    }
+    n->cur = n->target;
+    n->probes = 0;
+    n->state = BAUD_SETTLE;
+    n->t0 = now;
+    return BAUD_ACT_SET_RATE;
+}
+
+/* CMD_ECHO reply from the slave */
+static inline BaudAction baud_neg_on_echo(BaudNeg *n, uint8_t seq, uint16_t value, uint32_t now) {
+    if (!n->echo_wait || seq != n->echo_seq) return BAUD_ACT_NONE;   // stale or duplicate
+    if (value != baud_echo_pattern(seq)) return baud_neg_fail(n, now);
+    n->echo_wait = false;
+    n->echo_missed = 0;
+
+    if (n->state == BAUD_PROBE && ++n->probes >= BAUD_PROBES) return baud_neg_start(n, now);
+    if (n->state == BAUD_PROBE) return baud_neg_echo(n, now);
+    n->t0 = now;                        // keep-alive answered
+    return BAUD_ACT_NONE;
+}
+
+/* Periodic step; errors = running total of link errors (resyncs, UART errors, timeouts) */
+static inline BaudAction baud_neg_tick(BaudNeg *n, uint32_t now, uint32_t errors) {
+    uint32_t dt = now - n->t0;
+
+    switch (n->state) {
+        case BAUD_REQUEST:
+            return (dt >= BAUD_REPLY_TIMEOUT_MS) ? baud_neg_fail(n, now) : BAUD_ACT_NONE;
+
+        case BAUD_SETTLE:
+            if (dt < BAUD_SETTLE_MS) return BAUD_ACT_NONE;
+            n->state = BAUD_PROBE;
+            n->err_base = errors;
+            return baud_neg_echo(n, now);
+
+        case BAUD_PROBE:
+            if (errors - n->err_base >= BAUD_PROBE_ERR_LIMIT) return baud_neg_fail(n, now);
+            return (dt >= BAUD_REPLY_TIMEOUT_MS) ? baud_neg_fail(n, now) : BAUD_ACT_NONE;
+
+        case BAUD_RUN:
+            if (errors - n->err_base >= BAUD_ERR_LIMIT) {
+                if (n->cur != 0) return baud_neg_fail(n, now);
+                n->clean_t0 = now;              // at index 0 a burst only restarts recovery
+                n->err_base = errors;
+                n->err_t0 = now;
+            }
+            if (now - n->err_t0 >= BAUD_ERR_WINDOW_MS) { n->err_base = errors; n->err_t0 = now; }
+            if (n->ceiling < n->limit && now - n->clean_t0 >= BAUD_RECOVER_MS) {
+                n->ceiling = n->limit;
+                n->recoveries++;
+                return baud_neg_start(n, now);
+            }
+            if (n->cur == 0) return BAUD_ACT_NONE;
+            if (n->echo_wait) {
+                if (dt < BAUD_REPLY_TIMEOUT_MS) return BAUD_ACT_NONE;
+                n->echo_wait = false;
+                if (++n->echo_missed >= 2u) return baud_neg_fail(n, now);
+                return baud_neg_echo(n, now);
+            }
+            return (dt >= BAUD_KEEPALIVE_MS) ? baud_neg_echo(n, now) : BAUD_ACT_NONE;
+
+        case BAUD_HOLD:
+            return (dt >= BAUD_HOLD_MS) ? baud_neg_start(n, now) : BAUD_ACT_NONE;
+
+        default:
+            return BAUD_ACT_NONE;
+    }
+}
+
+/* ---------------------------------- Slave ---------------------------------- */
+
+#define BAUD_NONE 0xFFu
+
+typedef struct {
+    uint8_t  cur;           // rate index in use
+    uint8_t  pending;       // rate to switch to once the reply is out, BAUD_NONE if none
+    uint32_t last_rx;       // tick of the last valid frame
+} BaudFollow;
+
+static inline void baud_follow_init(BaudFollow *f, uint32_t now) {
+    f->cur = 0;
+    f->pending = BAUD_NONE;
+    f->last_rx = now;
+}
+
+/* Valid frame received at the current rate */
+static inline void baud_follow_on_frame(BaudFollow *f, uint32_t now) {
+    f->last_rx = now;
+}
+
+/* CMD_BAUD request; returns the index to answer with (the current one if refused) */
+static inline uint8_t baud_follow_request(BaudFollow *f, uint8_t idx) {
+    if (idx >= BAUD_RATE_COUNT) return f->cur;
+    f->pending = idx;
+    return idx;
+}
+
+/* Returns the rate index to switch the UART to now, or BAUD_NONE */
+static inline uint8_t baud_follow_tick(BaudFollow *f, uint32_t now, bool tx_idle) {
+    if (f->pending != BAUD_NONE) {
+        if (!tx_idle) return BAUD_NONE;     // the reply is still going out at the old rate
+        f->cur = f->pending;
+        f->pending = BAUD_NONE;
+        f->last_rx = now;
+        return f->cur;
+    }
+    if (f->cur != 0 && (now - f->last_rx) >= BAUD_SILENCE_MS) {
+        f->cur = 0;
+        f->last_rx = now;
+        return 0;
+    }
+    return BAUD_NONE;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Profinet PD cycle markers (CMD_CYCLE) and their jitter statistics.
+ *
+ * The M40 sends `STX CYCLE seq LSB MSB ETX` each time the ABCC driver hands
+ * it new read process data; seq counts markers (mod 256) and the value is
+ * the M40's own cycle period in µs (saturated to 0xFFFF). The F4 schedules
+ * its write/read exchange on the marker.
+ *
+ * Both sides feed each marker's interval into a CycleStats block: on the
+ * M40 that is the PD cycle as seen by the main loop, on the F4 the marker
+ * arrival as seen by the link task (PD cycle + UART + task latency).
+ * Jitter is the deviation of one interval from the smoothed period;
+ * intervals that span a lost marker only count towards `missed`, and
+ * intervals over CYCLE_PAUSE_FACTOR periods (cyclic exchange stopped, e.g.
+ * PLC in STOP) are skipped.
+ *
+ * The block is all uint32_t so it can be exported as a UINT32 array.
+ */
+#ifndef CYCLE_JITTER_BUCKET_US
+#define CYCLE_JITTER_BUCKET_US 50u
+#endif
+#ifndef CYCLE_PAUSE_FACTOR
+#define CYCLE_PAUSE_FACTOR     8u
+#endif
+#ifndef CYCLE_JITTER_BUCKETS
+#define CYCLE_JITTER_BUCKETS   16u     // 0 .. 750 µs, last bucket open-ended
+#endif
+
+typedef struct {
+    uint32_t cycles;                // markers seen
+    uint32_t missed;                // markers lost (sequence gaps)
+    uint32_t period_us;             // smoothed period (1/16 exponential average)
+    uint32_t jitter_max_us;         // largest |interval - period|
+    uint32_t jitter_hist[CYCLE_JITTER_BUCKETS];
+    uint32_t last_seq;
+} CycleStats;
+
+#define CYCLE_STATS_WORDS (sizeof(CycleStats) / sizeof(uint32_t))
+
+static inline void cycle_stats_clear(CycleStats *c) {
+    memset(c, 0, sizeof(*c));
+}
+
+/* Record one marker; dt_us = time since the previous one (ignored for the first) */
+static inline void cycle_stats_sample(CycleStats *c, uint8_t seq, uint32_t dt_us) {
+    uint8_t gap = (uint8_t)(seq - (uint8_t)c->last_seq - 1u);
+    uint32_t seen = c->cycles++;
+    c->last_seq = seq;
+
+    if (seen == 0) return;
+    if (gap != 0) {
+        c->missed += gap;
+        return;
+    }
+    if (c->period_us == 0) {
+        c->period_us = dt_us;
+        return;
+    }
+    if (dt_us > CYCLE_PAUSE_FACTOR * c->period_us) return;   // exchange was paused
+
+    uint32_t dev = (dt_us > c->period_us) ? dt_us - c->period_us : c->period_us - dt_us;
+    uint32_t i = dev / CYCLE_JITTER_BUCKET_US;
+    c->jitter_hist[(i < CYCLE_JITTER_BUCKETS) ? i : (CYCLE_JITTER_BUCKETS - 1u)]++;
+    if (dev > c->jitter_max_us) c->jitter_max_us = dev;
+    c->period_us = (uint32_t)((int32_t)c->period_us + ((int32_t)dt_us - (int32_t)c->period_us) / 16);
+}
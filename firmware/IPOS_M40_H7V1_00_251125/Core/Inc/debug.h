@@ -5,8 +5,16 @@
 
 #include "main.h"
 #include <stdio.h>
+#include "debug_log.h"
 
 void DEBUG_Init(UART_HandleTypeDef *huart);
 void DEBUG_Printf(const char *fmt, ...);
 
+/* Deferred event log (see debug_log.h): record now, format and send later */
+void DEBUG_Log(uint8_t id, uint8_t var_id, uint16_t value);
+void DEBUG_LogDrain(void);
+uint32_t DEBUG_LogDropped(void);
+
+void to_binary_str_grouped(uint16_t value, int bits, char *buf, size_t buf_size);
+
 #endif
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Deferred binary debug log.
+ *
+ * The frame path records a fixed-size event (timestamp, event id, var id,
+ * value) with a handful of stores instead of formatting text and waiting
+ * for UART3. A low-priority drain later pops one event at a time, formats
+ * it and hands it to the UART without blocking.
+ *
+ * When the ring is full the new event is dropped and counted; the drain
+ * prints the count once the ring has emptied, so lost lines are visible.
+ *
+ * Single producer, single consumer (both normally the main loop).
+ */
+#ifndef DBG_LOG_DEPTH
+#define DBG_LOG_DEPTH   64u     // MUST be a power of two
+#endif
+
+/* Event ids */
+enum {
+    DBG_EV_WRITE = 1,           // master wrote var = value
+    DBG_EV_READ  = 2,           // master read var, value = reply
+};
+
+typedef struct {
+    uint32_t t;                 // timestamp (DWT cycles)
+    uint8_t  id;                // DBG_EV_*
+    uint8_t  var;               // var_id
+    uint16_t value;
+} DbgEvent;
+
+typedef struct {
+    DbgEvent ev[DBG_LOG_DEPTH];
+    volatile uint16_t head;     // producer index
+    volatile uint16_t tail;     // consumer index
+    volatile uint32_t dropped;  // events lost because the ring was full
+} DbgLog;
+
+static inline void dbg_log_init(DbgLog *l) {
+    l->head = 0;
+    l->tail = 0;
+    l->dropped = 0;
+}
+
+static inline uint16_t dbg_log_count(const DbgLog *l) {
+    return (uint16_t)(l->head - l->tail);
+}
+
+/* Record one event; returns false (and counts a drop) if the ring is full */
+static inline bool dbg_log_push(DbgLog *l, uint32_t t, uint8_t id, uint8_t var, uint16_t value) {
+    uint16_t h = l->head;
+    if ((uint16_t)(h - l->tail) >= DBG_LOG_DEPTH) {
+        l->dropped++;
+        return false;
+    }
+    DbgEvent *e = &l->ev[h & (DBG_LOG_DEPTH - 1u)];
+    e->t = t;
+    e->id = id;
+    e->var = var;
+    e->value = value;
+    l->head = (uint16_t)(h + 1u);
+    return true;
+}
+
+/* Take the oldest event; returns false if the ring is empty */
+static inline bool dbg_log_pop(DbgLog *l, DbgEvent *out) {
+    uint16_t t = l->tail;
+    if (t == l->head) return false;
+    *out = l->ev[t & (DBG_LOG_DEPTH - 1u)];
+    l->tail = (uint16_t)(t + 1u);
+    return true;
+}
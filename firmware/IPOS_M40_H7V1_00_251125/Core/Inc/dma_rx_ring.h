@@ -0,0 +1,107 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Reader over a circular UART RX DMA buffer.
+ *
+ * The DMA stream is the producer: it runs in circular mode over `buf` and its
+ * NDTR register (bytes remaining until wrap) gives the write position. The
+ * consumer keeps only a read index, so no bytes are copied and the DMA never
+ * has to be re-armed.
+ *
+ * Nothing here touches the HAL: the caller samples NDTR
+ * (__HAL_DMA_GET_COUNTER) and passes it in, so the wraparound logic can be
+ * compiled and exercised on a host with a simulated counter.
+ *
+ * NDTR alone cannot show a DMA lap. The RX event ISR (half transfer,
+ * transfer complete, idle line; at least twice per lap) therefore reports
+ * each DMA position through dma_rx_isr(), which keeps a running byte
+ * count. dma_rx_lapped() compares it with what the reader consumed: if the
+ * DMA got a whole buffer ahead, the overwritten data is gone and
+ * the reader skips to the DMA position. This only fails if the ISR itself
+ * is held off for half a buffer.
+ */
+typedef struct {
+    const volatile uint8_t *buf;
+    uint16_t size;          // DMA transfer length (NDTR reload value)
+    uint16_t tail;          // read index, 0..size-1
+    uint32_t consumed;      // bytes read or skipped so far (reader)
+    volatile uint32_t produced; // bytes written up to isr_pos (ISR)
+    volatile uint16_t isr_pos;  // DMA write index at the last dma_rx_isr()
+} DmaRxRing;
+
+/* Initialize over the DMA target buffer */
+static inline void dma_rx_init(DmaRxRing *r, const volatile uint8_t *storage, uint16_t size) {
+    r->buf  = storage;
+    r->size = size;
+    r->tail = 0;
+    r->consumed = 0;
+    r->produced = 0;
+    r->isr_pos  = 0;
+}
+
+/* Convert a sampled NDTR value into the DMA write index */
+static inline uint16_t dma_rx_head(const DmaRxRing *r, uint16_t ndtr) {
+    /* NDTR counts down from size; 0 is only visible for an instant before the reload */
+    if (ndtr == 0 || ndtr > r->size) return 0;
+    return (uint16_t)(r->size - ndtr);
+}
+
+/* Number of unread bytes for a given NDTR sample */
+static inline uint16_t dma_rx_count(const DmaRxRing *r, uint16_t ndtr) {
+    uint16_t head = dma_rx_head(r, ndtr);
+    return (head >= r->tail) ? (uint16_t)(head - r->tail)
+                             : (uint16_t)(r->size - r->tail + head);
+}
+
+/* Pop one byte; returns false once the reader has caught up with the DMA */
+static inline bool dma_rx_get(DmaRxRing *r, uint16_t ndtr, uint8_t *out) {
+    if (r->tail == dma_rx_head(r, ndtr)) return false;
+    *out = r->buf[r->tail];
+    r->tail = (uint16_t)((r->tail + 1u == r->size) ? 0u : r->tail + 1u);
+    r->consumed++;
+    return true;
+}
+
+/* Bytes written by the DMA since init, as of the given NDTR sample */
+static inline uint32_t dma_rx_produced(const DmaRxRing *r, uint16_t ndtr) {
+    uint32_t produced;
+    uint16_t pos;
+    do {                    // the ISR may update both between the two reads
+        produced = r->produced;
+        pos      = r->isr_pos;
+    } while (produced != r->produced);
+    uint16_t head = dma_rx_head(r, ndtr);
+    return produced + ((head >= pos) ? (uint32_t)(head - pos) : (uint32_t)(r->size - pos + head));
+}
+
+/* Drop everything received so far (e.g. after a UART error) */
+static inline void dma_rx_flush(DmaRxRing *r, uint16_t ndtr) {
+    r->tail = dma_rx_head(r, ndtr);
+    r->consumed = dma_rx_produced(r, ndtr);
+}
+
+/* RX event ISR: `pos` is the DMA position the HAL reports (Size; == size at TC) */
+static inline void dma_rx_isr(DmaRxRing *r, uint16_t pos) {
+    if (pos >= r->size) pos = 0;
+    uint16_t last = r->isr_pos;
+    r->produced += (pos >= last) ? (uint32_t)(pos - last) : (uint32_t)(r->size - last + pos);
+    r->isr_pos = pos;
+}
+
+/* The HAL restarted the stream at index 0 (error recovery, re-init).
+ * Call before the restart or from the ISR; dma_rx_flush() then resyncs the reader. */
+static inline void dma_rx_isr_restart(DmaRxRing *r) {
+    r->isr_pos = 0;
+}
+
+/* Before a drain: if the DMA lapped the reader, skip to the DMA position.
+ * A full lap (ahead == size) also counts: head == tail then reads as empty.
+ * Returns true if data was lost. */
+static inline bool dma_rx_lapped(DmaRxRing *r, uint16_t ndtr) {
+    if (dma_rx_produced(r, ndtr) - r->consumed < r->size) return false;
+    dma_rx_flush(r, ndtr);
+    return true;
+}
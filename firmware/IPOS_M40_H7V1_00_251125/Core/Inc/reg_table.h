@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "protocol.h"
+
+/*
+ * Slave register map with change tracking.
+ *
+ * Every register has a value, a version counter (bumped on each change) and
+ * a bit in a 256-bit dirty bitmap. reg_table_set() marks a register dirty
+ * only when its value actually changes, so callers can store the current
+ * value every cycle instead of keeping their own last-value shadows.
+ *
+ * reg_table_collect() walks the bitmap a word at a time and jumps straight
+ * to each set bit with CTZ (RBIT + CLZ on the M7), so a sync costs one test
+ * per 32 clean registers plus one step per changed register.
+ *
+ * Single writer (main loop); not safe to call from interrupts.
+ */
+#define REG_COUNT       256u
+#define REG_DIRTY_WORDS (REG_COUNT / 32u)
+
+typedef struct {
+    uint16_t value[REG_COUNT];
+    uint16_t version[REG_COUNT];    // changes so far, wraps
+    uint32_t dirty[REG_DIRTY_WORDS];
+} RegTable;
+
+static inline void reg_table_init(RegTable *t) {
+    memset(t, 0, sizeof(*t));
+}
+
+static inline uint16_t reg_table_get(const RegTable *t, uint8_t id) {
+    return t->value[id];
+}
+
+static inline uint16_t reg_table_version(const RegTable *t, uint8_t id) {
+    return t->version[id];
+}
+
+static inline bool reg_table_is_dirty(const RegTable *t, uint8_t id) {
+    return (t->dirty[id >> 5] >> (id & 31u)) & 1u;
+}
+
+/* Queue a register for the next sync even if its value did not change */
+static inline void reg_table_touch(RegTable *t, uint8_t id) {
+    t->dirty[id >> 5] |= 1UL << (id & 31u);
+}
+
+/* Store a value that came from the peer: versioned, but not sent back */
+static inline void reg_table_load(RegTable *t, uint8_t id, uint16_t v) {
+    if (t->value[id] == v) return;
+    t->value[id] = v;
+    t->version[id]++;
+}
+
+/* Store a local value; returns true (and marks it dirty) if it changed */
+static inline bool reg_table_set(RegTable *t, uint8_t id, uint16_t v) {
+    if (t->value[id] == v) return false;
+    t->value[id] = v;
+    t->version[id]++;
+    reg_table_touch(t, id);
+    return true;
+}
+
+/* Move up to max dirty registers (lowest id first) into out[] and clear
+ * their bits; returns how many. Registers left over stay dirty. */
+static inline uint8_t reg_table_collect(RegTable *t, ProtoPair *out, uint8_t max) {
+    uint8_t n = 0;
+    for (uint32_t w = 0; w < REG_DIRTY_WORDS && n < max; w++) {
+        uint32_t bits = t->dirty[w];
+        while (bits != 0 && n < max) {
+            uint32_t b = (uint32_t)__builtin_ctz(bits);
+            uint8_t id = (uint8_t)(w * 32u + b);
+            out[n].var_id = id;
+            out[n].value  = t->value[id];
+            n++;
+            bits &= bits - 1u;                  // drop the lowest set bit
+            t->dirty[w] &= ~(1UL << b);
+        }
+    }
+    return n;
+}
@@ -2,6 +2,21 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
+
+/*
+ * Publish barrier between the payload copy and the index store.
+ *
+ * Producer and consumer share one core (ISR vs. task/main loop), so program
+ * order is already what the other side observes; the barrier stops the
+ * compiler from sinking the memcpy below the index store and, on Cortex-M7,
+ * drains the write buffer before the index becomes visible.
+ */
+#if defined(__arm__) || defined(__thumb__)
+#define RB_BARRIER() __asm volatile ("dmb" ::: "memory")
+#else
+#define RB_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
 
 /* Simple lockless ring buffer — single producer (ISR), single consumer (main loop) */
 typedef struct {
@@ -28,21 +43,97 @@ static inline bool rb_put(RingBuffer *rb, uint8_t b) {
     uint16_t next = rb->head + 1;
     if ((uint16_t)(next - rb->tail) > rb->size) return false; // full
     rb->buf[rb->head & (rb->size - 1)] = b;
+    RB_BARRIER();
     rb->head = next;
     return true;
 }
 
-/* Push an array of bytes; returns how many were written */
-static inline uint16_t rb_write(RingBuffer *rb, const uint8_t *src, uint16_t len) {
-    uint16_t w = 0;
-    while (w < len && rb_put(rb, src[w])) w++;
-    return w;
-}
-
 /* Pop one byte from the buffer; returns false if empty */
 static inline bool rb_get(RingBuffer *rb, uint8_t *out) {
     if (rb_count(rb) == 0) return false; // empty
+    RB_BARRIER();
     *out = rb->buf[rb->tail & (rb->size - 1)];
+    RB_BARRIER();
     rb->tail++;
     return true;
 }
+
+/* Free space in bytes */
+static inline uint16_t rb_space(const RingBuffer *rb) {
+    return (uint16_t)(rb->size - rb_count(rb));
+}
+
+/* Copy up to len bytes in (at most two memcpy); returns how many were written */
+static inline uint16_t rb_write_n(RingBuffer *rb, const uint8_t *src, uint16_t len) {
+    uint16_t head  = rb->head;
+    uint16_t space = (uint16_t)(rb->size - (uint16_t)(head - rb->tail));
+    if (len > space) len = space;
+    if (len == 0) return 0;
+
+    uint16_t idx   = head & (rb->size - 1);
+    uint16_t first = (uint16_t)(rb->size - idx);
+    if (first > len) first = len;
+    memcpy(&rb->buf[idx], src, first);
+    memcpy(rb->buf, src + first, (size_t)(len - first));
+
+    RB_BARRIER();
+    rb->head = (uint16_t)(head + len);
+    return len;
+}
+
+/* Push an array of bytes; returns how many were written */
+static inline uint16_t rb_write(RingBuffer *rb, const uint8_t *src, uint16_t len) {
+    return rb_write_n(rb, src, len);
+}
+
+/* Copy up to len bytes out (at most two memcpy); returns how many were read */
+static inline uint16_t rb_read_n(RingBuffer *rb, uint8_t *dst, uint16_t len) {
+    uint16_t tail  = rb->tail;
+    uint16_t avail = (uint16_t)(rb->head - tail);
+    if (len > avail) len = avail;
+    if (len == 0) return 0;
+    RB_BARRIER();
+
+    uint16_t idx   = tail & (rb->size - 1);
+    uint16_t first = (uint16_t)(rb->size - idx);
+    if (first > len) first = len;
+    memcpy(dst, &rb->buf[idx], first);
+    memcpy(dst + first, rb->buf, (size_t)(len - first));
+
+    RB_BARRIER();
+    rb->tail = (uint16_t)(tail + len);
+    return len;
+}
+
+/* Consumer span: longest readable run without wrap; release it with rb_commit() */
+static inline uint16_t rb_peek_contiguous(const RingBuffer *rb, const uint8_t **span) {
+    uint16_t tail  = rb->tail;
+    uint16_t avail = (uint16_t)(rb->head - tail);
+    uint16_t idx   = tail & (rb->size - 1);
+    uint16_t run   = (uint16_t)(rb->size - idx);
+    RB_BARRIER();
+    *span = &rb->buf[idx];
+    return (avail < run) ? avail : run;
+}
+
+/* Release n bytes obtained from rb_peek_contiguous() */
+static inline void rb_commit(RingBuffer *rb, uint16_t n) {
+    RB_BARRIER();
+    rb->tail = (uint16_t)(rb->tail + n);
+}
+
+/* Producer span: longest writable run without wrap; publish it with rb_produce() */
+static inline uint16_t rb_reserve_contiguous(const RingBuffer *rb, uint8_t **span) {
+    uint16_t head  = rb->head;
+    uint16_t space = (uint16_t)(rb->size - (uint16_t)(head - rb->tail));
+    uint16_t idx   = head & (rb->size - 1);
+    uint16_t run   = (uint16_t)(rb->size - idx);
+    *span = &rb->buf[idx];
+    return (space < run) ? space : run;
+}
+
+/* Publish n bytes filled in through rb_reserve_contiguous() */
+static inline void rb_produce(RingBuffer *rb, uint16_t n) {
+    RB_BARRIER();
+    rb->head = (uint16_t)(rb->head + n);
+}
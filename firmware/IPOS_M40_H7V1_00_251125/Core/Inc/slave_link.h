@@ -2,17 +2,32 @@
 
 #pragma once
 #include "stm32h7xx_hal.h"
+#include "link_stats.h"
+#include "cycle_sync.h"
 
 
 void slave_link_start(void);
 void slave_link_poll(void);
+void slave_link_tx_stats(uint8_t *queued, uint8_t *high_water, uint16_t *dropped);
+uint8_t slave_link_version(void);   // PROTO_V1 or PROTO_V2 (negotiated by the master)
+uint32_t slave_link_baud(void);     // USART2 bit/s (stepped up by the master, 115200 after silence)
+
+/* Link health counters (live; exported as the LINK_STATS ADI) */
+extern LinkStats link_stats;
+/* PD cycle period and jitter (exported as the CYCLE_STATS ADI) */
+extern CycleStats cycle_stats;
 
 /* Hooks for application logic */
 void slave_on_write(uint8_t var_id, uint16_t value);
 void slave_on_read(uint8_t var_id);
 
 uint16_t slave_get_reg(uint8_t var_id);
-void slave_set_reg(uint8_t var_id, uint16_t value);
+uint16_t slave_reg_version(uint8_t var_id);           // bumped on every change of the register
+void slave_set_reg(uint8_t var_id, uint16_t value);  // marks the register dirty if the value changed
+void slave_load_reg(uint8_t var_id, uint16_t value); // store without marking dirty (hooks: value the master has)
+void slave_sync(void);                                // push all dirty registers (NOTIFY / NOTIFY_MULTI)
+void slave_notify(uint8_t var_id, uint16_t value);   // set reg + sync now
+void slave_cycle_mark(void);                          // new read PD: send CMD_CYCLE to the master
 void to_binary_str(uint16_t value, int bits, char *buf, size_t buf_size);
 //static void send_bytes(const uint8_t *p, uint16_t n);
 
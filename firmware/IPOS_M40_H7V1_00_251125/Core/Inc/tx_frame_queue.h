@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Queue of complete link frames waiting for UART TX DMA.
+ *
+ * Single producer (link task / main loop) pushes copies of built frames;
+ * single consumer (TX-complete ISR) hands the front slot to the DMA and pops
+ * it when the transfer is done, so the DMA always reads a stable slot.
+ *
+ * Each slot is one 32-byte cache line (aligned), so on the H7 a frame can be
+ * cleaned from the D-cache without touching its neighbours.
+ *
+ * `high_water` records the deepest occupancy seen since init, for sizing
+ * TXQ_DEPTH; `dropped` counts frames rejected because the queue was full.
+ */
+#ifndef TXQ_DEPTH
+#define TXQ_DEPTH      8u       // MUST be a power of two
+#endif
+#define TXQ_SLOT_SIZE  32u      // one cache line; >= PROTO_MAX_FRAME
+
+#if defined(__arm__) || defined(__thumb__)
+#define TXQ_BARRIER() __asm volatile ("dmb" ::: "memory")
+#else
+#define TXQ_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+typedef struct {
+    uint8_t data[TXQ_DEPTH][TXQ_SLOT_SIZE] __attribute__((aligned(32)));
+    uint8_t len[TXQ_DEPTH];
+    volatile uint8_t head;      // producer index
+    volatile uint8_t tail;      // consumer index
+    uint8_t  high_water;        // max occupancy seen
+    uint16_t dropped;           // frames rejected while full
+} TxFrameQueue;
+
+/* Reset indices and statistics */
+static inline void txq_init(TxFrameQueue *q) {
+    q->head = q->tail = 0;
+    q->high_water = 0;
+    q->dropped = 0;
+}
+
+/* Frames queued, including the one the DMA is currently sending */
+static inline uint8_t txq_count(const TxFrameQueue *q) {
+    return (uint8_t)(q->head - q->tail);
+}
+
+/* Copy a frame in; returns false (and counts a drop) if full or too long */
+static inline bool txq_push(TxFrameQueue *q, const uint8_t *frame, size_t n) {
+    uint8_t head = q->head;
+    if (n == 0 || n > TXQ_SLOT_SIZE || (uint8_t)(head - q->tail) >= TXQ_DEPTH) {
+        q->dropped++;
+        return false;
+    }
+    uint8_t i = head & (TXQ_DEPTH - 1);
+    memcpy(q->data[i], frame, n);
+    q->len[i] = (uint8_t)n;
+    TXQ_BARRIER();
+    q->head = (uint8_t)(head + 1);
+
+    uint8_t used = (uint8_t)(q->head - q->tail);
+    if (used > q->high_water) q->high_water = used;
+    return true;
+}
+
+/* Oldest queued frame (stays queued until txq_pop), or NULL if empty */
+static inline uint8_t *txq_front(TxFrameQueue *q, uint16_t *len) {
+    uint8_t tail = q->tail;
+    if (q->head == tail) return NULL;
+    TXQ_BARRIER();
+    uint8_t i = tail & (TXQ_DEPTH - 1);
+    *len = q->len[i];
+    return q->data[i];
+}
+
+/* Release the front frame once its transfer has completed */
+static inline void txq_pop(TxFrameQueue *q) {
+    TXQ_BARRIER();
+    q->tail = (uint8_t)(q->tail + 1);
+}
@@ -1,12 +1,38 @@
 
 #include "debug.h"
+#include "protocol.h"
 #include <stdarg.h>
+#include <string.h>
 
 static UART_HandleTypeDef *dbg_huart = NULL;
 static char dbg_buf[128];
 
+/* Deferred log: ring filled by DEBUG_Log(), emptied by DEBUG_LogDrain() */
+static DbgLog dbg_log;
+static char dbg_line[96];           // line being sent by interrupt-driven TX
+static uint32_t dbg_dropped_shown;  // drop count already reported
+
+/* Per-variable text for the drained lines (index = var_id) */
+typedef struct {
+    const char *write;              // label for DBG_EV_WRITE, NULL = unknown
+    const char *read;               // label for DBG_EV_READ, NULL = unknown
+    uint8_t bits;                   // width of the binary dump
+} DbgVarText;
+
+static const DbgVarText dbg_vars[] = {
+    [VAR_PORTA]            = { "PortA",                             NULL,                    16 },
+    [VAR_PORTB]            = { NULL,                                "PortB",                 16 },
+    [VAR_PORTC]            = { NULL,                                "PortC",                  8 },
+    [VAR_STATUS_DEBUG]     = { "STATUS_DEBUG (from Master)",        "STATUS_DEBUG (to PLC)", 16 },
+    [VAR_STATUS_PLC]       = { "STATUS_OUT (from PLC)",             "STATUS_PLC (from PLC)", 16 },
+    [VAR_STATUS_ACTIVE]    = { "STATUS_ACTIVE (from Master)",       "STATUS_ACTIVE (to PLC)", 16 },
+    [VAR_STATUS_DEBUG_TRU] = { "STATUS_DEBUG_TRU (from Master)",    "STATUS_DEBUG_TRU (to PLC)", 16 },
+};
+
 void DEBUG_Init(UART_HandleTypeDef *huart) {
     dbg_huart = huart;
+    dbg_log_init(&dbg_log);
+    dbg_dropped_shown = 0;
 }
 
 void DEBUG_Printf(const char *fmt, ...) {
@@ -17,6 +43,85 @@ void DEBUG_Printf(const char *fmt, ...) {
     va_end(args);
 
     if (len > 0) {
+        if (len > (int)sizeof(dbg_buf) - 1) len = sizeof(dbg_buf) - 1;
+        while (dbg_huart->gState != HAL_UART_STATE_READY) {}   // let a drained line finish
         HAL_UART_Transmit(dbg_huart, (uint8_t*)dbg_buf, len, HAL_MAX_DELAY);
     }
 }
+
+void to_binary_str_grouped(uint16_t value, int bits, char *buf, size_t buf_size)
+{
+    // Each nibble adds a space, so need bits + bits/4 + 1 for null
+    if (buf_size < bits + bits / 4 + 1) return;
+
+    int len = 0;
+    for (int i = bits - 1; i >= 0; i--) {
+        buf[len++] = (value & (1 << i)) ? '1' : '0';
+        // Insert a space every 4 bits, except after the last group
+        if (i % 4 == 0 && i != 0)
+            buf[len++] = ' ';
+    }
+    buf[len] = '\0';
+}
+
+/* Hot path: a few stores, no formatting, never waits for the UART */
+void DEBUG_Log(uint8_t id, uint8_t var_id, uint16_t value) {
+    dbg_log_push(&dbg_log, DWT->CYCCNT, id, var_id, value);
+}
+
+uint32_t DEBUG_LogDropped(void) {
+    return dbg_log.dropped;
+}
+
+static int dbg_format(const DbgEvent *e, char *out, size_t size) {
+    uint32_t us = e->t / (SystemCoreClock / 1000000u);
+    const char *verb = (e->id == DBG_EV_WRITE) ? "WRITE" : "READ";
+    const char *label = NULL;
+    uint8_t bits = 16;
+
+    if (e->var < sizeof(dbg_vars) / sizeof(dbg_vars[0])) {
+        label = (e->id == DBG_EV_WRITE) ? dbg_vars[e->var].write : dbg_vars[e->var].read;
+        bits = dbg_vars[e->var].bits;
+    }
+    if (!label && e->id == DBG_EV_WRITE) {
+        return snprintf(out, size, "[%lu us] WRITE Unknown var=0x%02X val=%u\r\n",
+                        (unsigned long)us, e->var, e->value);
+    }
+    if (!label) {
+        return snprintf(out, size, "[%lu us] READ Unknown var=0x%02X\r\n",
+                        (unsigned long)us, e->var);
+    }
+
+    // Build grouped binary string (e.g., "0000 1111 0000 0000")
+    char bin_str[24];
+    to_binary_str_grouped(e->value, bits, bin_str, sizeof(bin_str));
+    return snprintf(out, size, "[%lu us] %s %s = %s (dec=%u)\r\n",
+                    (unsigned long)us, verb, label, bin_str, e->value);
+}
+
+/*
+ * Low-priority drain: call from the idle part of the main loop. Formats at
+ * most one line per call and starts it with interrupt-driven TX; returns at
+ * once while the previous line is still on the wire.
+ */
+void DEBUG_LogDrain(void) {
+    if (!dbg_huart || dbg_huart->gState != HAL_UART_STATE_READY) return;
+
+    int len;
+    uint32_t dropped = dbg_log.dropped;
+    DbgEvent e;
+    if (dbg_log_pop(&dbg_log, &e)) {
+        len = dbg_format(&e, dbg_line, sizeof(dbg_line));
+    } else if (dropped != dbg_dropped_shown) {
+        // ring empty again: the lost events came after everything printed so far
+        len = snprintf(dbg_line, sizeof(dbg_line), "[LOG] %lu events dropped\r\n",
+                       (unsigned long)(dropped - dbg_dropped_shown));
+        dbg_dropped_shown = dropped;
+    } else {
+        return;
+    }
+
+    if (len <= 0) return;
+    if (len > (int)sizeof(dbg_line) - 1) len = sizeof(dbg_line) - 1;
+    HAL_UART_Transmit_IT(dbg_huart, (uint8_t*)dbg_line, (uint16_t)len);
+}
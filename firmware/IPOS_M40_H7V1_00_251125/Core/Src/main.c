@@ -100,34 +100,15 @@ void SystemClock_Config(void);
 /* USER CODE BEGIN 0 */
 
 
-void to_binary_str_grouped(uint16_t value, int bits, char *buf, size_t buf_size)
-{
-    // Each nibble adds a space, so need bits + bits/4 + 1 for null
-    if (buf_size < bits + bits / 4 + 1) return;
-
-    int len = 0;
-    for (int i = bits - 1; i >= 0; i--) {
-        buf[len++] = (value & (1 << i)) ? '1' : '0';
-        // Insert a space every 4 bits, except after the last group
-        if (i % 4 == 0 && i != 0)
-            buf[len++] = ' ';
-    }
-    buf[len] = '\0';
-}
-
-void uart3_debug(const char *msg) {
-    HAL_UART_Transmit(&huart3, (uint8_t*)msg, strlen(msg), HAL_MAX_DELAY);
-}
-
 /*-----------------------------------------------------------------------------
 **  Called when the master (PLC or F4) writes a value to the slave.
 **  Handles PORTA and STATUS_OUT (from PLC → STM32F4).
+**  Runs in the frame path: debug output is only recorded here with
+**  DEBUG_Log() and printed later by DEBUG_LogDrain() in the main loop.
 **----------------------------------------------------------------------------*/
 void slave_on_write(uint8_t var_id, uint16_t value)
 {
-    char buf[128], bin_str[20];
-
-    // Remember last printed values (for debug throttling)
+    // Remember last logged values (for debug throttling)
     static uint16_t lastPortA  = 0xFFFF;
     static uint16_t lastStatusOut = 0xFFFF;
 
@@ -139,18 +120,12 @@ void slave_on_write(uint8_t var_id, uint16_t value)
     case VAR_PORTA:
     {
         uint16_t newVal = value & 0x03FF;    // mask to 10 bits (safety)
-        slave_set_reg(VAR_PORTA, newVal);
+        slave_load_reg(VAR_PORTA, newVal);
         appl_iPortA = newVal;
 
         if (newVal != lastPortA)
         {
-            //to_binary_str(newVal, 10, bin_str, sizeof(bin_str));
-            // Build grouped binary string (e.g., "0000 1111 0000 0000")
-			char bin_str[40];
-			to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-            snprintf(buf, sizeof(buf),
-                     "WRITE PortA = %s (dec=%u)\r\n", bin_str, newVal);
-            uart3_debug(buf);
+            DEBUG_Log(DBG_EV_WRITE, VAR_PORTA, newVal);
             lastPortA = newVal;
         }
         break;
@@ -163,18 +138,11 @@ void slave_on_write(uint8_t var_id, uint16_t value)
     {
         uint16_t newVal = value & 0x7FFFU;   // mask out any control bit (bit15 reserved)
         appl_iStatusPLC = newVal;
-        slave_set_reg(VAR_STATUS_PLC, newVal);
+        slave_load_reg(VAR_STATUS_PLC, newVal);
 
         if (newVal != lastStatusOut)
         {
-            //to_binary_str(newVal, 16, bin_str, sizeof(bin_str));
-            // Build grouped binary string (e.g., "0000 1111 0000 0000")
-			char bin_str[40];
-			to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-
-            snprintf(buf, sizeof(buf),
-                     "WRITE STATUS_OUT (from PLC) = %s (dec=%u)\r\n", bin_str, newVal);
-            uart3_debug(buf);
+            DEBUG_Log(DBG_EV_WRITE, VAR_STATUS_PLC, newVal);
             lastStatusOut = newVal;
         }
         break;
@@ -187,17 +155,8 @@ void slave_on_write(uint8_t var_id, uint16_t value)
     {
         uint16_t newVal = value & 0x7FFFU;
         appl_iStatusDebug = newVal;
-        slave_set_reg(VAR_STATUS_DEBUG, newVal);
-
-        // Build grouped binary string (e.g., "0000 1111 0000 0000")
-		char bin_str[40];
-		to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-
-        char buf[128];
-        snprintf(buf, sizeof(buf),
-                 "WRITE STATUS_DEBUG (from Master) = %s (dec=%u)\r\n",
-				 bin_str, newVal);
-        uart3_debug(buf);
+        slave_load_reg(VAR_STATUS_DEBUG, newVal);
+        DEBUG_Log(DBG_EV_WRITE, VAR_STATUS_DEBUG, newVal);
         break;
     }
     /*--------------------------------------------------
@@ -207,17 +166,8 @@ void slave_on_write(uint8_t var_id, uint16_t value)
 	{
 		uint16_t newVal = value & 0x7FFFU;
 		appl_iStatusDebugTru = newVal;
-		slave_set_reg(VAR_STATUS_DEBUG_TRU, newVal);
-
-		// Build grouped binary string (e.g., "0000 1111 0000 0000")
-		char bin_str[40];
-		to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-
-		char buf[128];
-		snprintf(buf, sizeof(buf),
-				 "WRITE STATUS_DEBUG_TRU (from Master) = %s (dec=%u)\r\n",
-				 bin_str, newVal);
-		uart3_debug(buf);
+		slave_load_reg(VAR_STATUS_DEBUG_TRU, newVal);
+		DEBUG_Log(DBG_EV_WRITE, VAR_STATUS_DEBUG_TRU, newVal);
 		break;
 	}
 
@@ -229,35 +179,21 @@ void slave_on_write(uint8_t var_id, uint16_t value)
     {
         uint16_t newVal = value & 0x7FFFU;   // mask bit 15 if reserved
         appl_iStatusActive = newVal;          // store for application logic
-        slave_set_reg(VAR_STATUS_ACTIVE, newVal); // make visible to PLC readback
-
-        // Convert to binary string (15 bits for example)
-        // Build grouped binary string (e.g., "0000 1111 0000 0000")
-		char bin_str[40];
-		to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-
-        char buf[128];
-        snprintf(buf, sizeof(buf),
-                 "WRITE STATUS_ACTIVE (from Master) = %s (dec=%u)\r\n",
-                 bin_str, newVal);
-        uart3_debug(buf);
-
+        slave_load_reg(VAR_STATUS_ACTIVE, newVal); // make visible to PLC readback
+        DEBUG_Log(DBG_EV_WRITE, VAR_STATUS_ACTIVE, newVal);
         break;
     }
     /*--------------------------------------------------
      * Default: unhandled variable
      *--------------------------------------------------*/
     default:
-        snprintf(buf, sizeof(buf),
-                 "WRITE Unknown var=0x%02X val=%u\r\n", var_id, value);
-        uart3_debug(buf);
+        DEBUG_Log(DBG_EV_WRITE, var_id, value);
         break;
     }
 }
 
 void slave_on_read(uint8_t var_id)
 {
-    char buf[64], bin_str[20];
     static uint16_t lastPortB = 0xFFFF;
     static uint8_t  lastPortC = 0xFF;
     static uint16_t lastStatusDebugIN  = 0xFFFF;
@@ -270,14 +206,10 @@ void slave_on_read(uint8_t var_id)
     case VAR_PORTB:
     {
         uint16_t newVal = PortB_val & 0x03FF;
-        slave_set_reg(VAR_PORTB, newVal);
+        slave_load_reg(VAR_PORTB, newVal);
 
         if (newVal != lastPortB) {
-        	// Build grouped binary string (e.g., "0000 1111 0000 0000")
-			char bin_str[40];
-			to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-            snprintf(buf, sizeof(buf), "READ PortB = %s (dec=%u)\r\n", bin_str, newVal);
-            uart3_debug(buf);
+            DEBUG_Log(DBG_EV_READ, VAR_PORTB, newVal);
             lastPortB = newVal;
         }
         break;
@@ -286,14 +218,10 @@ void slave_on_read(uint8_t var_id)
     case VAR_PORTC:
     {
         uint8_t newVal = PortC_val;
-        slave_set_reg(VAR_PORTC, newVal);
+        slave_load_reg(VAR_PORTC, newVal);
 
         if (newVal != lastPortC) {
-        	// Build grouped binary string (e.g., "0000 1111")
-			char bin_str[40];
-			to_binary_str_grouped(newVal, 8, bin_str, sizeof(bin_str));
-            snprintf(buf, sizeof(buf), "READ PortC = %s (dec=%u)\r\n", bin_str, newVal);
-            uart3_debug(buf);
+            DEBUG_Log(DBG_EV_READ, VAR_PORTC, newVal);
             lastPortC = newVal;
         }
         break;
@@ -302,14 +230,10 @@ void slave_on_read(uint8_t var_id)
     case VAR_STATUS_DEBUG:   // PLC reads this (feedback from Master)
     {
         uint16_t newVal = StatusDebug_val;
-        slave_set_reg(VAR_STATUS_DEBUG, newVal);
+        slave_load_reg(VAR_STATUS_DEBUG, newVal);
 
         if (newVal != lastStatusDebugIN) {
-        	// Build grouped binary string (e.g., "0000 1111 0000 0000")
-			char bin_str[40];
-			to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-            snprintf(buf, sizeof(buf), "READ STATUS_DEBUG (to PLC) = %s (dec=%u)\r\n", bin_str, newVal);
-            uart3_debug(buf);
+            DEBUG_Log(DBG_EV_READ, VAR_STATUS_DEBUG, newVal);
             lastStatusDebugIN = newVal;
         }
         break;
@@ -318,14 +242,10 @@ void slave_on_read(uint8_t var_id)
     case VAR_STATUS_ACTIVE:   // PLC reads this (feedback from Master)
     {
         uint16_t newVal = StatusActive_val;
-        slave_set_reg(VAR_STATUS_DEBUG, newVal);
+        slave_load_reg(VAR_STATUS_ACTIVE, newVal);
 
         if (newVal != lastStatusActiveIN) {
-        	// Build grouped binary string (e.g., "0000 1111 0000 0000")
-			char bin_str[40];
-			to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-            snprintf(buf, sizeof(buf), "READ STATUS_ACTIVE (to PLC) = %s (dec=%u)\r\n", bin_str, newVal);
-            uart3_debug(buf);
+            DEBUG_Log(DBG_EV_READ, VAR_STATUS_ACTIVE, newVal);
             lastStatusActiveIN = newVal;
         }
         break;
@@ -333,14 +253,10 @@ void slave_on_read(uint8_t var_id)
     case VAR_STATUS_DEBUG_TRU:   // PLC reads this (feedback from Master)
 	{
 		uint16_t newVal = StatusDebugTru_val;
-		slave_set_reg(VAR_STATUS_DEBUG_TRU, newVal);
+		slave_load_reg(VAR_STATUS_DEBUG_TRU, newVal);
 
 		if (newVal != lastStatusDebugIN_Tru) {
-			// Build grouped binary string (e.g., "0000 1111 0000 0000")
-			char bin_str[40];
-			to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-			snprintf(buf, sizeof(buf), "READ STATUS_ACTIVE (to PLC) = %s (dec=%u)\r\n", bin_str, newVal);
-			uart3_debug(buf);
+			DEBUG_Log(DBG_EV_READ, VAR_STATUS_DEBUG_TRU, newVal);
 			lastStatusDebugIN_Tru = newVal;
 		}
 		break;
@@ -348,22 +264,17 @@ void slave_on_read(uint8_t var_id)
     case VAR_STATUS_PLC:  // MasterF4 reads this (value PLC last wrote)
     {
         uint16_t newVal = StatusPLC_val;
-        slave_set_reg(VAR_STATUS_PLC, newVal);
+        slave_load_reg(VAR_STATUS_PLC, newVal);
 
         if (newVal != lastStatusOUT) {
-        	// Build grouped binary string (e.g., "0000 1111 0000 0000")
-			char bin_str[40];
-			to_binary_str_grouped(newVal, 16, bin_str, sizeof(bin_str));
-            snprintf(buf, sizeof(buf), "READ STATUS_PLC (from PLC) = %s (dec=%u)\r\n", bin_str, newVal);
-            uart3_debug(buf);
+            DEBUG_Log(DBG_EV_READ, VAR_STATUS_PLC, newVal);
             lastStatusOUT = newVal;
         }
         break;
     }
 
     default:
-        snprintf(buf, sizeof(buf), "READ Unknown var=0x%02X\r\n", var_id);
-        uart3_debug(buf);
+        DEBUG_Log(DBG_EV_READ, var_id, 0);
         break;
     }
 }
@@ -463,6 +374,7 @@ int main(void)
   MX_USART3_UART_Init();
   /* USER CODE BEGIN 2 */
 
+	  DEBUG_Init(&huart3);
 	  slave_link_start();
 
 	  /*
@@ -547,6 +459,11 @@ int main(void)
          }
       }
 
+      /*
+      ** Print at most one deferred debug line (non-blocking).
+      */
+      DEBUG_LogDrain();
+
       /*
       ** Restart the ABCC when the S1/RESTART is pushed down. Debouncing is not
       ** needed since the button is wired via a voltage WD chip (U4).
@@ -649,6 +566,7 @@ uint32_t HAL_GetTick(void)
 
 int _write(int file, char *ptr, int len)
 {
+    while (huart3.gState != HAL_UART_STATE_READY) {}   // let a drained log line finish
     HAL_UART_Transmit(&huart3, (uint8_t*)ptr, len, HAL_MAX_DELAY);
     return len;
 }
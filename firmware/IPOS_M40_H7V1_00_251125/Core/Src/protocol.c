@@ -1,5 +1,6 @@
 
 #include "protocol.h"
+#include <string.h>
 
 static inline uint16_t u16_from_lsbf(uint8_t lsb, uint8_t msb) {
     return (uint16_t)((uint16_t)lsb | ((uint16_t)msb << 8));
@@ -9,6 +10,13 @@ void proto_init(ProtoParser *p, ProtoRole role) {
     p->idx = 0;
     p->expected = 0;
     p->role = role;
+    p->version = PROTO_V1;
+    p->resyncs = 0;
+}
+
+void proto_init_v2(ProtoParser *p, ProtoRole role) {
+    proto_init(p, role);
+    p->version = PROTO_V2;
 }
 
 void proto_reset(ProtoParser *p) {
@@ -16,18 +24,149 @@ void proto_reset(ProtoParser *p) {
     p->expected = 0;
 }
 
+/* MULTI commands carry a pair count after the CMD byte */
+static inline bool is_multi(uint8_t cmd) {
+    return cmd == CMD_WRITE_MULTI || cmd == CMD_READ_MULTI || cmd == CMD_ACK_MULTI || cmd == CMD_NOTIFY_MULTI;
+}
+
 /* Decide expected frame length based on role and command */
 static uint8_t expected_len(ProtoRole role, uint8_t cmd) {
     switch (cmd) {
         case CMD_WRITE: return 6; // STX CMD VAR LSB MSB ETX
         case CMD_ACK:   return 6;
+        case CMD_NOTIFY:return 6; // STX CMD VAR LSB MSB ETX
         case CMD_READ:  return (role == ROLE_SLAVE) ? 4 : 6;
+        case CMD_HELLO: return (role == ROLE_SLAVE) ? 4 : 6;
+        case CMD_BAUD:  return (role == ROLE_SLAVE) ? 4 : 6;
+        case CMD_ECHO:  return 6;
+        case CMD_CYCLE: return 6;
         default:        return 0;
     }
 }
 
+/* Expected length of a MULTI frame once the pair count is known */
+static uint8_t expected_multi_len(ProtoRole role, uint8_t cmd, uint8_t count) {
+    if (count == 0 || count > PROTO_MAX_PAIRS) return 0;
+    if (cmd == CMD_READ_MULTI && role == ROLE_SLAVE) return (uint8_t)(4u + count); // STX CMD N VAR*N ETX
+    return (uint8_t)(4u + 3u * count);                                             // STX CMD N [VAR LSB MSB]*N ETX
+}
+
+/* Unpack the pairs of a MULTI frame; q points at the pair count */
+static void decode_multi(ProtoRole role, uint8_t cmd, const uint8_t *q, ProtoFrame *out) {
+    uint8_t n = *q++;
+    bool ids_only = (cmd == CMD_READ_MULTI) && (role == ROLE_SLAVE);
+
+    out->count     = n;
+    out->has_value = !ids_only;
+    out->var_id    = 0;
+    out->value     = 0;
+
+    for (uint8_t i = 0; i < n; i++) {
+        out->pairs[i].var_id = *q++;
+        if (ids_only) {
+            out->pairs[i].value = 0;
+        } else {
+            out->pairs[i].value = u16_from_lsbf(q[0], q[1]);
+            q += 2;
+        }
+    }
+}
+
+/* Decode "CMD [TAG] body" (no STX/ETX, no CRC); length must match the command */
+static bool decode_body(ProtoRole role, const uint8_t *b, uint8_t len, ProtoFrame *out) {
+    if (len < 2) return false;
+
+    uint8_t cmd = (uint8_t)(b[0] & ~PROTO_TAG_FLAG);
+    uint8_t tag = (b[0] & PROTO_TAG_FLAG) ? 1u : 0u;
+    uint8_t hdr = (uint8_t)(1u + tag);     // index of var_id / pair count
+    uint8_t expect;
+
+    if (is_multi(cmd)) {
+        if (len <= hdr) return false;
+        expect = expected_multi_len(role, cmd, b[hdr]);
+    } else {
+        expect = expected_len(role, cmd);
+    }
+    if (expect == 0 || (uint8_t)(expect - 2u + tag) != len) return false;
+
+    out->cmd    = cmd;
+    out->tagged = (tag != 0);
+    out->tag    = tag ? b[1] : 0;
+
+    if (is_multi(cmd)) {
+        decode_multi(role, cmd, &b[hdr], out);
+    } else {
+        out->var_id = b[hdr];
+        out->count  = 0;
+
+        if (expect == 6) {
+            out->has_value = true;
+            out->value = u16_from_lsbf(b[hdr + 1], b[hdr + 2]);
+        } else {
+            out->has_value = false;
+            out->value = 0;
+        }
+    }
+    return true;
+}
+
+/* CRC-16/MODBUS, same as the ABCC driver's CRC_Crc16() (only built with the
+ * ABCC serial driver, which this board does not use) */
+static uint16_t crc16(const uint8_t *d, size_t n) {
+    static const uint16_t tbl[16] = {
+        0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+        0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+    };
+    uint16_t crc = 0xFFFF;
+    while (n--) {
+        crc ^= *d++;
+        crc = (uint16_t)((crc >> 4) ^ tbl[crc & 0x0F]);
+        crc = (uint16_t)((crc >> 4) ^ tbl[crc & 0x0F]);
+    }
+    return crc;
+}
+
+/* Decode a COBS block in place; returns decoded length, 0 if malformed */
+static uint8_t cobs_decode(uint8_t *buf, uint8_t n) {
+    uint8_t r = 0, w = 0;
+    while (r < n) {
+        uint8_t code = buf[r++];
+        if (code == 0) return 0;
+        for (uint8_t i = 1; i < code; i++) {
+            if (r >= n) return 0;
+            buf[w++] = buf[r++];
+        }
+        if (code != 0xFF && r < n) buf[w++] = 0;
+    }
+    return w;
+}
+
+/* v2: collect up to a delimiter, then COBS-decode and check CRC.
+ * Every delimiter ends the frame, so resync after an error is immediate. */
+static bool push_v2(ProtoParser *p, uint8_t b, ProtoFrame *out) {
+    if (b != PROTO_V2_DELIM) {
+        if (p->idx < sizeof(p->buf)) p->buf[p->idx++] = b;
+        else p->expected = 0xFF;            // overlong: discard up to the next delimiter
+        return false;
+    }
+
+    bool ok = false;
+    if (p->idx != 0) {
+        if (p->expected != 0xFF) {
+            uint8_t n = cobs_decode(p->buf, p->idx);
+            if (n >= 4 && crc16(p->buf, (size_t)(n - 2)) == u16_from_lsbf(p->buf[n - 2], p->buf[n - 1]))
+                ok = decode_body(p->role, p->buf, (uint8_t)(n - 2), out);
+        }
+        if (!ok) p->resyncs++;
+    }
+    proto_reset(p);
+    return ok;
+}
+
 /* Feed bytes into parser; return true if frame complete */
 bool proto_push(ProtoParser *p, uint8_t b, ProtoFrame *out) {
+    if (p->version == PROTO_V2) return push_v2(p, b, out);
+
     if (p->idx == 0) {
         if (b != STX) return false;   // wait for STX
         p->buf[p->idx++] = b;
@@ -36,35 +175,40 @@ bool proto_push(ProtoParser *p, uint8_t b, ProtoFrame *out) {
 
     p->buf[p->idx++] = b;
 
-    /* After CMD byte, set expected length */
-    if (p->idx == 2) {
-        p->expected = expected_len(p->role, p->buf[1]);
-        if (p->expected == 0 || p->expected > sizeof(p->buf)) {
+    /* A tagged frame has one TAG byte between CMD and the body */
+    uint8_t cmd = (uint8_t)(p->buf[1] & ~PROTO_TAG_FLAG);
+    uint8_t tag = (p->buf[1] & PROTO_TAG_FLAG) ? 1u : 0u;
+    uint8_t hdr = (uint8_t)(2u + tag);
+
+    /* After CMD byte, set expected length (MULTI frames wait for the count byte) */
+    if (p->idx == 2 && !is_multi(cmd)) {
+        p->expected = expected_len(p->role, cmd);
+        if (p->expected == 0 || p->expected + tag > PROTO_MAX_FRAME) {
+            p->resyncs++;
             proto_reset(p);
             return false;
         }
+        p->expected += tag;
     }
 
-    /* Check if frame complete */
-    if (p->idx == p->expected) {
-        if (p->buf[p->expected - 1] != ETX) {
-            proto_reset(p);  // bad frame
+    /* After COUNT byte of a MULTI frame */
+    if (p->idx == hdr + 1 && is_multi(cmd)) {
+        p->expected = expected_multi_len(p->role, cmd, p->buf[hdr]);
+        if (p->expected == 0 || p->expected + tag > PROTO_MAX_FRAME) {
+            p->resyncs++;
+            proto_reset(p);
             return false;
         }
+        p->expected += tag;
+    }
 
-        out->cmd    = p->buf[1];
-        out->var_id = p->buf[2];
-
-        if (p->expected == 6) {
-            out->has_value = true;
-            out->value = u16_from_lsbf(p->buf[3], p->buf[4]);
-        } else {
-            out->has_value = false;
-            out->value = 0;
-        }
-
+    /* Check if frame complete (STX/ETX stripped before decoding) */
+    if (p->idx == p->expected) {
+        bool ok = (p->buf[p->expected - 1] == ETX) &&
+                  decode_body(p->role, &p->buf[1], (uint8_t)(p->expected - 2), out);
+        if (!ok) p->resyncs++;
         proto_reset(p);
-        return true;
+        return ok;
     }
 
     return false;
@@ -99,3 +243,132 @@ size_t proto_build_readr(uint8_t var_id, uint16_t value, uint8_t out[8]) {
     out[5]=ETX;
     return 6;
 }
+
+size_t proto_build_notify(uint8_t var_id, uint16_t value, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_NOTIFY; out[2]=var_id;
+    out[3]=(uint8_t)(value & 0xFF);
+    out[4]=(uint8_t)(value >> 8);
+    out[5]=ETX;
+    return 6;
+}
+
+size_t proto_build_hello(uint8_t version, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_HELLO; out[2]=version; out[3]=ETX;
+    return 4;
+}
+
+size_t proto_build_hello_reply(uint8_t version, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_HELLO; out[2]=version; out[3]=0; out[4]=0; out[5]=ETX;
+    return 6;
+}
+
+size_t proto_build_baud(uint8_t rate_idx, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_BAUD; out[2]=rate_idx; out[3]=ETX;
+    return 4;
+}
+
+size_t proto_build_baud_reply(uint8_t rate_idx, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_BAUD; out[2]=rate_idx; out[3]=0; out[4]=0; out[5]=ETX;
+    return 6;
+}
+
+size_t proto_build_echo(uint8_t seq, uint16_t value, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_ECHO; out[2]=seq;
+    out[3]=(uint8_t)(value & 0xFF);
+    out[4]=(uint8_t)(value >> 8);
+    out[5]=ETX;
+    return 6;
+}
+
+size_t proto_build_cycle(uint8_t seq, uint16_t period_us, uint8_t out[8]) {
+    out[0]=STX; out[1]=CMD_CYCLE; out[2]=seq;
+    out[3]=(uint8_t)(period_us & 0xFF);
+    out[4]=(uint8_t)(period_us >> 8);
+    out[5]=ETX;
+    return 6;
+}
+
+/* --- Batched Frame Builders --- */
+static size_t build_pairs(uint8_t cmd, const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    if (n == 0 || n > PROTO_MAX_PAIRS) return 0;
+
+    size_t k = 0;
+    out[k++] = STX; out[k++] = cmd; out[k++] = n;
+    for (uint8_t i = 0; i < n; i++) {
+        out[k++] = pairs[i].var_id;
+        out[k++] = (uint8_t)(pairs[i].value & 0xFF);
+        out[k++] = (uint8_t)(pairs[i].value >> 8);
+    }
+    out[k++] = ETX;
+    return k;
+}
+
+size_t proto_build_write_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    return build_pairs(CMD_WRITE_MULTI, pairs, n, out);
+}
+
+size_t proto_build_read_multi(const uint8_t *var_ids, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    if (n == 0 || n > PROTO_MAX_PAIRS) return 0;
+
+    size_t k = 0;
+    out[k++] = STX; out[k++] = CMD_READ_MULTI; out[k++] = n;
+    for (uint8_t i = 0; i < n; i++) out[k++] = var_ids[i];
+    out[k++] = ETX;
+    return k;
+}
+
+size_t proto_build_ack_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    return build_pairs(CMD_ACK_MULTI, pairs, n, out);
+}
+
+size_t proto_build_readr_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    return build_pairs(CMD_READ_MULTI, pairs, n, out);
+}
+
+size_t proto_build_notify_multi(const ProtoPair *pairs, uint8_t n, uint8_t out[PROTO_MAX_FRAME]) {
+    return build_pairs(CMD_NOTIFY_MULTI, pairs, n, out);
+}
+
+/* --- Transaction tag --- */
+size_t proto_tag(uint8_t tag, uint8_t *frame, size_t n) {
+    if (n < 4 || n >= PROTO_MAX_FRAME) return 0;
+    memmove(&frame[3], &frame[2], n - 2);   // STX CMD ... -> STX CMD|TAG_FLAG TAG ...
+    frame[1] |= PROTO_TAG_FLAG;
+    frame[2]  = tag;
+    return n + 1;
+}
+
+/* --- v2 framing: 00 COBS(CMD [TAG] body CRC16) 00 --- */
+size_t proto_encode_v2(const uint8_t *frame, size_t n, uint8_t out[PROTO_V2_MAX_WIRE]) {
+    if (n < 4 || n > PROTO_MAX_FRAME || frame[0] != STX || frame[n - 1] != ETX) return 0;
+
+    uint8_t raw[PROTO_MAX_FRAME];
+    size_t len = n - 2;
+    memcpy(raw, &frame[1], len);
+    uint16_t crc = crc16(raw, len);
+    raw[len++] = (uint8_t)(crc & 0xFF);
+    raw[len++] = (uint8_t)(crc >> 8);
+
+    size_t k = 0;
+    out[k++] = PROTO_V2_DELIM;              // leading delimiter: resync even after noise
+    size_t code_at = k++;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {      // len < 254: no 0xFF blocks needed
+        if (raw[i] == 0) {
+            out[code_at] = code;
+            code_at = k++;
+            code = 1;
+        } else {
+            out[k++] = raw[i];
+            code++;
+        }
+    }
+    out[code_at] = code;
+    out[k++] = PROTO_V2_DELIM;
+    return k;
+}
+
+/* A look-alike HELLO must not switch a live v2 link; a restarted master is quiet on v2 */
+bool proto_hello_allowed(uint8_t link_version, uint32_t v2_quiet_ms, uint32_t quiet_ms) {
+    return link_version != PROTO_V2 || v2_quiet_ms >= quiet_ms;
+}
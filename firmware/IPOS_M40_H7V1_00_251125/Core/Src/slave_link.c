@@ -2,102 +2,455 @@
 
 #include "slave_link.h"
 #include "ringbuffer.h"
+#include "dma_rx_ring.h"
+#include "tx_frame_queue.h"
+#include "link_stats.h"
+#include "baud_neg.h"
+#include "cycle_sync.h"
+#include "reg_table.h"
 #include "protocol.h"
+#include "debug.h"
 #include <string.h>
 #include "main.h"
 
 /* === User config === */
 extern UART_HandleTypeDef huart2;   // adjust to match CubeMX config
+/* 1 = circular DMA parsed in place (NDTR = write index), 0 = one-shot DMA + ring copy */
+#ifndef UART_RX_CIRCULAR
+#define UART_RX_CIRCULAR 1
+#endif
+#if UART_RX_CIRCULAR
+#define UART_RX_DMA_CHUNK 2048  /* multiple of 32: whole cache lines only; ~10 ms at 2 Mbaud */
+#else
 #define UART_RX_DMA_CHUNK 128
+#endif
 #define RB_SIZE           256
+/* 1 = accept v2 framing (COBS + CRC16) when the master offers it or sends it */
+#ifndef SLAVE_LINK_V2
+#define SLAVE_LINK_V2 1
+#endif
+
+/* Send a CMD_CYCLE marker on every Nth Profinet PD cycle (1 = every cycle) */
+#ifndef SLAVE_CYCLE_DIV
+#define SLAVE_CYCLE_DIV 1
+#endif
+
+_Static_assert(PROTO_V2_MAX_WIRE <= TXQ_SLOT_SIZE, "v2 frame does not fit a TX queue slot");
 
 
 /* DMA buffer (32B aligned for H7 cache) */
 __attribute__((aligned(32))) static uint8_t rx_dma_buf[UART_RX_DMA_CHUNK];
 
-/* Ring buffer and parser */
+#if UART_RX_CIRCULAR
+/* Reader over the circular DMA buffer */
+static DmaRxRing rx_dma;
+#else
+/* Ring buffer */
 static uint8_t rb_storage[RB_SIZE];
 static RingBuffer rx_rb;
-static ProtoParser parser;
+#endif
+static ProtoParser parser;      // v1: STX..ETX
+static ProtoParser parser_v2;   // v2: COBS + CRC16, run side by side so either is recognised
+static uint8_t link_version = PROTO_V1;
+static uint32_t v2_rx_tick;     // last valid v2 frame
+static bool hello_open;         // line reset since the last v2 frame: HELLO taken at once
+static volatile bool rx_error;  // set by the error ISR, handled by rx_drain()
 
-/* Register map */
-static uint16_t regmap[256];
+/* TX frame queue drained by USART2 TX DMA (slots are 32B aligned for H7 cache) */
+static TxFrameQueue txq;
+static volatile bool tx_busy = false;
+
+/* Link health counters, also exported as the LINK_STATS ADI */
+LinkStats link_stats;
+static uint32_t poll_prev_cyc;  // DWT count at the previous poll, for reply latency
+
+/* Baud rate requested by the master; falls back to 115200 on silence */
+static BaudFollow baud;
+
+/* PD cycle jitter, also exported as the CYCLE_STATS ADI */
+CycleStats cycle_stats;
+static uint32_t cycle_prev_cyc; // DWT count at the previous PD cycle
+static uint8_t cycle_seq;       // PD cycles, mod 256
+static uint8_t marker_seq;      // markers sent, mod 256
+static uint8_t cycle_div;
+
+/* Register map with dirty bitmap; slave_sync() pushes the changes */
+static RegTable regs;
 
 /* --- Helpers --- */
+/* Start DMA on the front frame if the UART is idle (main loop and TX ISR) */
+static void tx_kick(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!tx_busy) {
+        uint16_t len;
+        uint8_t *frame = txq_front(&txq, &len);
+        if (frame) {
+            /* Push the slot out of the D-cache before the DMA reads it */
+            SCB_CleanDCache_by_Addr((uint32_t*)frame, TXQ_SLOT_SIZE);
+            if (HAL_UART_Transmit_DMA(&huart2, frame, len) == HAL_OK) tx_busy = true;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/* Queue a frame and return at once; a full queue drops it (master retries) */
+static void send_raw(const uint8_t *p, uint16_t n) {
+    if (!txq_push(&txq, p, n)) {
+        link_stats.tx_dropped++;
+        return;
+    }
+    link_stats.frames_tx++;
+    tx_kick();
+}
+
+/* Send a built v1 frame in the framing currently used on the link */
 static void send_bytes(const uint8_t *p, uint16_t n) {
-    HAL_UART_Transmit(&huart2, (uint8_t*)p, n, HAL_MAX_DELAY);
+    uint8_t wire[PROTO_V2_MAX_WIRE];
+    if (link_version == PROTO_V2) {
+        n = (uint16_t)proto_encode_v2(p, n, wire);
+        if (n == 0) return;
+        p = wire;
+    }
+    send_raw(p, n);
+}
+
+/* Reply to a request, echoing its transaction tag if it carried one */
+static void send_reply(const ProtoFrame *req, uint8_t *frame, size_t n) {
+    if (n == 0) return;
+    if (req->tagged) n = proto_tag(req->tag, frame, n);
+    send_bytes(frame, (uint16_t)n);
+    link_stats_rtt(&link_stats, (DWT->CYCCNT - poll_prev_cyc) / (SystemCoreClock / 1000000u));
 }
 
 static void handle_frame(const ProtoFrame *f) {
-    uint8_t frame[8]; size_t n = 0;
+    uint8_t frame[PROTO_MAX_FRAME]; size_t n = 0;
+    ProtoPair reply[PROTO_MAX_PAIRS];
 
     switch (f->cmd) {
         case CMD_WRITE:
             if (!f->has_value) break;
-            regmap[f->var_id] = f->value;
+            reg_table_load(&regs, f->var_id, f->value);
             slave_on_write(f->var_id, f->value);
             n = proto_build_ack(f->var_id, f->value, frame);
-            send_bytes(frame, n);
+            send_reply(f, frame, n);
             break;
 
         case CMD_READ: {
-            uint16_t v = regmap[f->var_id];
-            slave_on_read(f->var_id);
+            slave_on_read(f->var_id);       // refreshes the register, as for READ_MULTI
+            uint16_t v = reg_table_get(&regs, f->var_id);
             n = proto_build_readr(f->var_id, v, frame);
-            send_bytes(frame, n);
+            send_reply(f, frame, n);
             break;
         }
+
+        /* Batched WRITE: apply every pair, answer with one ACK_MULTI */
+        case CMD_WRITE_MULTI:
+            if (!f->has_value) break;
+            for (uint8_t i = 0; i < f->count; i++) {
+                reg_table_load(&regs, f->pairs[i].var_id, f->pairs[i].value);
+                slave_on_write(f->pairs[i].var_id, f->pairs[i].value);
+                reply[i] = f->pairs[i];
+            }
+            n = proto_build_ack_multi(reply, f->count, frame);
+            send_reply(f, frame, n);
+            break;
+
+        /* Batched READ: refresh every register, answer with one READ_MULTI reply */
+        case CMD_READ_MULTI:
+            for (uint8_t i = 0; i < f->count; i++) {
+                uint8_t id = f->pairs[i].var_id;
+                slave_on_read(id);
+                reply[i].var_id = id;
+                reply[i].value  = reg_table_get(&regs, id);
+            }
+            n = proto_build_readr_multi(reply, f->count, frame);
+            send_reply(f, frame, n);
+            break;
+
         default: break;
     }
 }
 
+/* Restart RX after the HAL stopped it. Touches only the HAL, so the error
+ * ISR may call it; the reader and parsers are resynced by rx_resync(). */
+static void rx_restart(void) {
+#if UART_RX_CIRCULAR
+    dma_rx_isr_restart(&rx_dma);
+#endif
+    HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rx_dma_buf, sizeof(rx_dma_buf));
+#if !UART_RX_CIRCULAR
+    __HAL_DMA_DISABLE_IT(huart2.hdmarx, DMA_IT_HT);
+#endif
+}
+
+/* Drop what was received before a restart and the partial frame (poller only) */
+static void rx_resync(void) {
+#if UART_RX_CIRCULAR
+    dma_rx_flush(&rx_dma, (uint16_t)__HAL_DMA_GET_COUNTER(huart2.hdmarx));
+#endif
+    proto_reset(&parser);
+    proto_reset(&parser_v2);
+}
+
+/* Re-init USART2 at a new rate. Only called with the TX queue empty. */
+static void set_baud(uint32_t rate) {
+    HAL_UART_Abort(&huart2);
+    tx_busy = false;
+    huart2.Init.BaudRate = rate;
+    HAL_UART_Init(&huart2);
+    rx_restart();
+    rx_resync();
+    DEBUG_Printf("[LINK] USART2 at %lu baud\r\n", rate);
+}
+
+/* Gate a decoded frame on the link version, then handle it.
+ * HELLO (always v1) picks the version; any valid v2 frame also switches to v2,
+ * so a restarted slave follows a master that is already on v2. On v2 a HELLO
+ * may be a look-alike inside a COBS payload, so it is only taken after a line
+ * reset or once v2 has been quiet for BAUD_SILENCE_MS (master restarted). */
+static void rx_frame(const ProtoFrame *f, uint8_t ver) {
+    if (f->cmd == CMD_HELLO) {
+        uint8_t frame[8];
+        if (ver != PROTO_V1) return;
+        if (!hello_open && !proto_hello_allowed(link_version, HAL_GetTick() - v2_rx_tick, BAUD_SILENCE_MS))
+            return;
+        link_version = (SLAVE_LINK_V2 && f->var_id >= PROTO_V2) ? PROTO_V2 : PROTO_V1;
+        send_raw(frame, (uint16_t)proto_build_hello_reply(link_version, frame));
+        return;
+    }
+    if (ver == PROTO_V2) {
+        link_version = PROTO_V2;
+        v2_rx_tick = HAL_GetTick();
+        hello_open = false;
+    } else if (link_version != PROTO_V1) {
+        return;                             // STX/ETX look-alikes inside v2 traffic
+    }
+    link_stats.frames_rx++;
+    baud_follow_on_frame(&baud, HAL_GetTick());
+
+    /* Rate step: answer at the current rate, switch once the answer is out */
+    if (f->cmd == CMD_BAUD) {
+        uint8_t frame[8];
+        send_bytes(frame, (uint16_t)proto_build_baud_reply(baud_follow_request(&baud, f->var_id), frame));
+        return;
+    }
+    if (f->cmd == CMD_ECHO) {
+        uint8_t frame[PROTO_MAX_FRAME];
+        if (f->has_value) send_reply(f, frame, proto_build_echo(f->var_id, f->value, frame));
+        return;
+    }
+    handle_frame(f);
+}
+
+static void rx_byte(uint8_t b) {
+    ProtoFrame f;
+    /* Only the parser for the framing in use counts towards resyncs:
+     * the other one sees the traffic as noise */
+    ProtoParser *active = (link_version == PROTO_V2) ? &parser_v2 : &parser;
+    uint32_t resyncs = active->resyncs;
+
+    if (proto_push(&parser, b, &f)) rx_frame(&f, PROTO_V1);
+#if SLAVE_LINK_V2
+    if (proto_push(&parser_v2, b, &f)) rx_frame(&f, PROTO_V2);
+#endif
+    link_stats.resyncs += active->resyncs - resyncs;
+}
+
 /* --- Poller --- */
-void slave_link_poll(void) {
-    uint8_t b; ProtoFrame f;
-    while (rb_get(&rx_rb, &b)) {
-        if (proto_push(&parser, b, &f)) handle_frame(&f);
+static void rx_drain(void) {
+    if (rx_error) {
+        rx_error = false;
+        rx_resync();
+    }
+#if UART_RX_CIRCULAR
+    uint8_t b;
+    uint16_t ndtr = (uint16_t)__HAL_DMA_GET_COUNTER(huart2.hdmarx);
+    if (dma_rx_lapped(&rx_dma, ndtr)) {
+        link_stats.overruns++;  // a whole buffer arrived since the last poll
+        proto_reset(&parser);
+        proto_reset(&parser_v2);
+    }
+    if (dma_rx_count(&rx_dma, ndtr) == 0) return;
+    /* CPU never writes the buffer, so dropping the whole range is safe */
+    SCB_InvalidateDCache_by_Addr((uint32_t*)rx_dma_buf, sizeof(rx_dma_buf));
+    while (dma_rx_get(&rx_dma, ndtr, &b)) rx_byte(b);
+#else
+    const uint8_t *span; uint16_t n;
+    while ((n = rb_peek_contiguous(&rx_rb, &span)) != 0) {
+        for (uint16_t i = 0; i < n; i++) rx_byte(span[i]);
+        rb_commit(&rx_rb, n);
     }
+#endif
+}
+
+void slave_link_poll(void) {
+    uint32_t now = DWT->CYCCNT;
+    rx_drain();                 // replies are timed from poll_prev_cyc
+    poll_prev_cyc = now;
+
+    uint8_t idx = baud_follow_tick(&baud, HAL_GetTick(), !tx_busy && txq_count(&txq) == 0);
+    if (idx == 0) hello_open = true;    // silence fallback: the line starts over
+    if (idx != BAUD_NONE) set_baud(baud_rates[idx]);
 }
 
 /* --- Init --- */
 void slave_link_start(void) {
-    memset(regmap, 0, sizeof(regmap));
-    rb_init(&rx_rb, rb_storage, RB_SIZE);
+    reg_table_init(&regs);
     proto_init(&parser, ROLE_SLAVE);
+    proto_init_v2(&parser_v2, ROLE_SLAVE);
+    link_version = PROTO_V1;
+    v2_rx_tick = HAL_GetTick();
+    hello_open = true;
+    txq_init(&txq);
+    link_stats_clear(&link_stats);
+    cycle_stats_clear(&cycle_stats);
+    baud_follow_init(&baud, HAL_GetTick());
 
+    /* DWT cycle counter times replies at sub-ms resolution (M7 needs the unlock) */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    poll_prev_cyc = DWT->CYCCNT;
+    tx_busy = false;
+    rx_error = false;
+
+#if UART_RX_CIRCULAR
+    dma_rx_init(&rx_dma, rx_dma_buf, sizeof(rx_dma_buf));
+    /* Switch the CubeMX stream to circular here so regeneration can't undo it */
+    huart2.hdmarx->Init.Mode = DMA_CIRCULAR;
+    HAL_DMA_Init(huart2.hdmarx);
+    HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rx_dma_buf, sizeof(rx_dma_buf));
+#else
+    rb_init(&rx_rb, rb_storage, RB_SIZE);
     HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rx_dma_buf, sizeof(rx_dma_buf));
     __HAL_DMA_DISABLE_IT(huart2.hdmarx, DMA_IT_HT);
+#endif
 }
 
 /* --- ISR Callbacks --- */
-void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
     if (huart != &huart2) return;
+    txq_pop(&txq);          // frame sent, chain the next one
+    tx_busy = false;
+    tx_kick();
+}
 
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+    if (huart != &huart2) return;
+#if UART_RX_CIRCULAR
+    /* DMA keeps running; slave_link_poll() reads the bytes in place.
+     * HT, TC or idle: keep the byte count for lap detection. */
+    dma_rx_isr(&rx_dma, Size);
+#else
     /* Invalidate cache for DMA region */
     SCB_InvalidateDCache_by_Addr((uint32_t*)rx_dma_buf, ((Size+31)/32)*32);
 
-    rb_write(&rx_rb, rx_dma_buf, Size);
+    link_stats.overruns += (uint32_t)(Size - rb_write(&rx_rb, rx_dma_buf, Size));
     HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rx_dma_buf, sizeof(rx_dma_buf));
     __HAL_DMA_DISABLE_IT(huart2.hdmarx, DMA_IT_HT);
+#endif
 }
 
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
     if (huart != &huart2) return;
+    link_stats.uart_errors++;
+    if (huart->ErrorCode & HAL_UART_ERROR_ORE) link_stats.overruns++;
 #if defined(__HAL_UART_CLEAR_FLAG) && defined(UART_CLEAR_OREF)
     __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_OREF);
 #endif
-    HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rx_dma_buf, sizeof(rx_dma_buf));
-    __HAL_DMA_DISABLE_IT(huart2.hdmarx, DMA_IT_HT);
+    rx_restart();
+    rx_error = true;        // slave_link_poll() drops the stale bytes and partial frame
+    /* If the error also ended a TX transfer, drop that frame and move on */
+    if (tx_busy && huart->gState == HAL_UART_STATE_READY) {
+        txq_pop(&txq);
+        tx_busy = false;
+        tx_kick();
+    }
+}
+
+/* TX queue usage, for sizing TXQ_DEPTH */
+void slave_link_tx_stats(uint8_t *queued, uint8_t *high_water, uint16_t *dropped)
+{
+    if (queued)     *queued     = txq_count(&txq);
+    if (high_water) *high_water = txq.high_water;
+    if (dropped)    *dropped    = txq.dropped;
 }
 
+/* Framing in use: PROTO_V1 or PROTO_V2 */
+uint8_t slave_link_version(void)
+{
+    return link_version;
+}
+
+/* Current USART2 rate in bit/s, as last requested by the master */
+uint32_t slave_link_baud(void)
+{
+    return baud_rates[baud.cur];
+}
+
+/* Store a local value; a change is pushed by the next slave_sync() */
 void slave_set_reg(uint8_t var_id, uint16_t value)
 {
-    regmap[var_id] = value;
+    reg_table_set(&regs, var_id, value);
+}
+
+/* Store a value without queueing a NOTIFY. For the slave_on_write() and
+ * slave_on_read() hooks: the master already has the value from its own
+ * WRITE or from the reply it is about to get. */
+void slave_load_reg(uint8_t var_id, uint16_t value)
+{
+    reg_table_load(&regs, var_id, value);
+}
+
+/* Push every register changed since the last sync, up to PROTO_MAX_PAIRS per
+ * NOTIFY_MULTI frame. What does not fit in the TX queue stays dirty. */
+void slave_sync(void)
+{
+    ProtoPair pairs[PROTO_MAX_PAIRS];
+    uint8_t frame[PROTO_MAX_FRAME];
+    uint8_t n;
+
+    while (txq_count(&txq) < TXQ_DEPTH && (n = reg_table_collect(&regs, pairs, PROTO_MAX_PAIRS)) != 0) {
+        size_t len = (n == 1) ? proto_build_notify(pairs[0].var_id, pairs[0].value, frame)
+                              : proto_build_notify_multi(pairs, n, frame);
+        send_bytes(frame, (uint16_t)len);
+    }
+}
+
+/* New read PD: time the cycle and send the marker the master schedules on.
+ * Call after the cycle's notifies so the master sees them first. */
+void slave_cycle_mark(void)
+{
+    uint8_t frame[8];
+    uint32_t cyc = DWT->CYCCNT;
+    cycle_stats_sample(&cycle_stats, cycle_seq++, (cyc - cycle_prev_cyc) / (SystemCoreClock / 1000000u));
+    cycle_prev_cyc = cyc;
+
+    if (++cycle_div < SLAVE_CYCLE_DIV) return;
+    cycle_div = 0;
+    uint32_t period = cycle_stats.period_us;
+    size_t n = proto_build_cycle(marker_seq++, (uint16_t)((period > 0xFFFFu) ? 0xFFFFu : period), frame);
+    send_bytes(frame, (uint16_t)n);
+}
+
+/* Store a value and push it (with any other pending changes) right away */
+void slave_notify(uint8_t var_id, uint16_t value)
+{
+    reg_table_set(&regs, var_id, value);
+    reg_table_touch(&regs, var_id);
+    slave_sync();
 }
 
 uint16_t slave_get_reg(uint8_t var_id)
 {
-    return regmap[var_id];
+    return reg_table_get(&regs, var_id);
+}
+
+/* Changes to a register so far (wraps); lets callers skip values already seen */
+uint16_t slave_reg_version(uint8_t var_id)
+{
+    return reg_table_version(&regs, var_id);
 }
 
 
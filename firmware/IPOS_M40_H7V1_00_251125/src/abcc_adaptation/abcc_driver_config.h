@@ -102,6 +102,14 @@
    ABCC_APPLICATION_OBJ_FW_AVAILABLE_GET_CBFUNC, \
    ABCC_APPLICATION_OBJ_FW_AVAILABLE_SET_CBFUNC,
 
+/*------------------------------------------------------------------------------
+** ADI set callbacks: the set callback of PORTA, the first ADI in the read PD
+** map, marks each new read PD so that ABCC_API_CbfCyclicalProcessing() can
+** send a CMD_CYCLE frame to the master (abcc_network_data_parameters.c).
+**------------------------------------------------------------------------------
+*/
+#define ABCC_CFG_ADI_GET_SET_CALLBACK_ENABLED      1
+
 /*------------------------------------------------------------------------------
 ** Debug and error macro configuration
 **------------------------------------------------------------------------------
@@ -20,8 +20,8 @@
 #include "protocol.h"
 
 
-#if (  ABCC_CFG_STRUCT_DATA_TYPE_ENABLED || ABCC_CFG_ADI_GET_SET_CALLBACK_ENABLED )
-   #error ABCC_CFG_ADI_GET_SET_CALLBACK_ENABLED must be set to 0 and ABCC_CFG_STRUCT_DATA_TYPE_ENABLED set to 0 in order to run this example
+#if (  ABCC_CFG_STRUCT_DATA_TYPE_ENABLED || !ABCC_CFG_ADI_GET_SET_CALLBACK_ENABLED )
+   #error ABCC_CFG_ADI_GET_SET_CALLBACK_ENABLED must be set to 1 (cycle marker) and ABCC_CFG_STRUCT_DATA_TYPE_ENABLED set to 0 in order to run this example
 #endif
 
 /*==============================================================================
@@ -46,7 +46,7 @@ uint16_t pd_StatusPLC;   // process data buffer from PLC
 uint16_t pd_StatusDebug;    // process data buffer to PLC
 uint16_t pd_StatusActive;    // process data buffer to PLC
 
-/* Local shadow copies used for change detection and queueing. */
+/* Local copies of the mirrored ADIs (change detection is done by the slave register table). */
 uint16_t PortA_val;
 uint16_t PortB_val;
 uint8_t PortC_val;
@@ -55,18 +55,16 @@ uint16_t StatusDebug_val;
 uint16_t StatusDebugTru_val;
 uint16_t StatusActive_val;
 
-static uint8_t last_PortB_val = 0xFF; // initialize to an impossible value or known startup state
-static uint8_t last_PortA_val = 0xFF; // initialize to an impossible value or known startup state
-static uint8_t last_PortC_val = 0xFF; // initialize to an impossible value or known startup state
-static uint8_t last_StatusDebug_val = 0xFF; // initialize to an impossible value or known startup state
-static uint8_t last_StatusPlc_val = 0xFF; // initialize to an impossible value or known startup state
-static uint8_t last_StatusActive_val = 0xFF; // initialize to an impossible value or known startup state
-static uint8_t last_StatusDebugTru_val = 0xFF; // initialize to an impossible value or known startup state
+/* Set by the driver when new read PD reached the ADIs (PORTA set callback) */
+static volatile BOOL8 fNewReadPd = FALSE;
+
+static void IPOS_NewReadPdNotify( const struct AD_AdiEntry* psAdiEntry, UINT8 bNumElements, UINT8 bStartIndex );
 
 /*------------------------------------------------------------------------------
  *  ADI Type Properties
  *----------------------------------------------------------------------------*/
 static AD_UINT16Type appl_sUint16Prop = { { 0, 0xFFFF, 0 } };
+static AD_UINT32Type appl_sUint32Prop = { { 0, 0xFFFFFFFF, 0 } };
 
 /*==============================================================================
  *  ADI Table Definition
@@ -88,23 +86,30 @@ static AD_UINT16Type appl_sUint16Prop = { { 0, 0xFFFF, 0 } };
 const AD_AdiEntryType ABCC_API_asAdiEntryList[] =
 {
     /* PLC → STM32 (write from PLC) */
-    { 0x1, "PORTA",      ABP_UINT16,  1, AD_ADI_DESC___W_G, { { &appl_iPortA,     &appl_sUint16Prop } } },
+    /* First ADI of the read PD map: its set callback marks each new read PD */
+    { 0x1, "PORTA",      ABP_UINT16,  1, AD_ADI_DESC___W_G, { { &appl_iPortA,     &appl_sUint16Prop } }, NULL, IPOS_NewReadPdNotify },
 
     /* STM32 → PLC (read by PLC) */
-    { 0x2, "PORTB",      ABP_UINT16,  1, AD_ADI_DESC__R_S_, { { &appl_iPortB,     &appl_sUint16Prop } } },
-    { 0x3, "PORTC",      ABP_UINT8,   1, AD_ADI_DESC__R_S_, { { &appl_iPortC,     &appl_sUint16Prop } } },
+    { 0x2, "PORTB",      ABP_UINT16,  1, AD_ADI_DESC__R_S_, { { &appl_iPortB,     &appl_sUint16Prop } }, NULL, NULL },
+    { 0x3, "PORTC",      ABP_UINT8,   1, AD_ADI_DESC__R_S_, { { &appl_iPortC,     &appl_sUint16Prop } }, NULL, NULL },
 
     /* STM32F4 → PLC  (feedback/status from the F4 master) */
-    { 0x4, "STATUS_DEBUG",  ABP_UINT16,  1, AD_ADI_DESC___W_G,  { { &appl_iStatusDebug,  &appl_sUint16Prop } } },
+    { 0x4, "STATUS_DEBUG",  ABP_UINT16,  1, AD_ADI_DESC___W_G,  { { &appl_iStatusDebug,  &appl_sUint16Prop } }, NULL, NULL },
 
     /* PLC → STM32F4  (commands or mode bits from PLC) */
-    { 0x5, "STATUS_PLC", ABP_UINT16,  1, AD_ADI_DESC__R_S_, { { &appl_iStatusPLC, &appl_sUint16Prop } } },
+    { 0x5, "STATUS_PLC", ABP_UINT16,  1, AD_ADI_DESC__R_S_, { { &appl_iStatusPLC, &appl_sUint16Prop } }, NULL, NULL },
 
     /* STM32F4 → PLC  (feedback/status from the master) */
-    { 0x6, "STATUS_Active",  ABP_UINT16,  1, AD_ADI_DESC___W_G,  { { &appl_iStatusActive,  &appl_sUint16Prop } } },
+    { 0x6, "STATUS_Active",  ABP_UINT16,  1, AD_ADI_DESC___W_G,  { { &appl_iStatusActive,  &appl_sUint16Prop } }, NULL, NULL },
 
     /* STM32F4 → PLC  (feedback/status from the master) */
-    { 0x7, "STATUS_DEBUG_TRU",  ABP_UINT16,  1, AD_ADI_DESC___W_G,  { { &appl_iStatusDebugTru,  &appl_sUint16Prop } } }
+    { 0x7, "STATUS_DEBUG_TRU",  ABP_UINT16,  1, AD_ADI_DESC___W_G,  { { &appl_iStatusDebugTru,  &appl_sUint16Prop } }, NULL, NULL },
+
+    /* M40 → PLC  (UART link health, acyclic read only; layout = LinkStats in link_stats.h) */
+    { 0x8, "LINK_STATS",  ABP_UINT32,  LINK_STATS_WORDS, AD_ADI_DESC_____G,  { { &link_stats,  &appl_sUint32Prop } }, NULL, NULL },
+
+    /* M40 → PLC  (PD cycle period and jitter, acyclic read only; layout = CycleStats in cycle_sync.h) */
+    { 0x9, "CYCLE_STATS", ABP_UINT32,  CYCLE_STATS_WORDS, AD_ADI_DESC_____G, { { &cycle_stats, &appl_sUint32Prop } }, NULL, NULL }
 
 };
 
@@ -150,6 +155,27 @@ UINT16 ABCC_API_CbfGetNumAdi( void )
 **------------------------------------------------------------------------------
 */
 
+/*==============================================================================
+ *  IPOS_NewReadPdNotify
+ *============================================================================*/
+/**
+ * @brief PORTA set callback: new read process data has been copied to the ADIs.
+ *
+ * AD_UpdatePdReadData() calls the set callback of every ADI in the read PD
+ * map, so the first mapped ADI sees each new read PD once. An acyclic set of
+ * PORTA also lands here and costs one extra marker.
+ *
+ * Only flags the event; the marker is sent from
+ * ABCC_API_CbfCyclicalProcessing() after the changed values.
+ */
+static void IPOS_NewReadPdNotify( const struct AD_AdiEntry* psAdiEntry, UINT8 bNumElements, UINT8 bStartIndex )
+{
+    (void)psAdiEntry;
+    (void)bNumElements;
+    (void)bStartIndex;
+    fNewReadPd = TRUE;
+}
+
 /*==============================================================================
  *  ABCC_API_CbfCyclicalProcessing
  *============================================================================*/
@@ -159,9 +185,12 @@ UINT16 ABCC_API_CbfGetNumAdi( void )
  * Synchronises mapped ADIs with the STM32 master board and the
  * Anybus process data buffers.
  *
- * - Detects variable changes (PORTA/B/C, STATUS_xx)
- * - Calls `slave_set_reg()` for each updated value, which pushes data
- *   to the STM32 via UART3.
+ * - Stores every mapped ADI (PORTA/B/C, STATUS_xx) with `slave_set_reg()`;
+ *   the slave register table marks only the values that changed.
+ * - `slave_sync()` then pushes all changed registers to the master in one
+ *   NOTIFY_MULTI frame, so the master sees them without polling.
+ * - On new read PD, sends a CMD_CYCLE marker after that batch, so the
+ *   master can run its exchange in phase with the PLC.
  *
  * Called automatically by the Anybus stack when the network state is
  * `ABP_ANB_STATE_PROCESS_ACTIVE`.
@@ -180,65 +209,38 @@ void ABCC_API_CbfCyclicalProcessing(void)
         //pd_StatusF4 = appl_iStatusF4;
 
         /*------------------------------------------------------
-        | 2. Normal port I/O mirroring logic                   |
+        | 2. Mirror every ADI into the register table; it      |
+        |    flags only the values that actually changed       |
         -------------------------------------------------------*/
-        if (appl_iPortA != last_PortA_val)
-        {
-            PortA_val = appl_iPortA;
-            last_PortA_val = PortA_val;
-            slave_set_reg(VAR_PORTA, PortA_val);
-        }
-
-        if (appl_iPortB != last_PortB_val)
-        {
-            PortB_val = appl_iPortB;
-            last_PortB_val = PortB_val;
-            slave_set_reg(VAR_PORTB, PortB_val);
-        }
-
-        if (appl_iPortC != last_PortC_val)
-        {
-            PortC_val = appl_iPortC;
-            last_PortC_val = PortC_val;
-            slave_set_reg(VAR_PORTC, PortC_val);
-        }
+        PortA_val          = appl_iPortA;
+        PortB_val          = appl_iPortB;
+        PortC_val          = appl_iPortC;
+        StatusDebug_val    = appl_iStatusDebug;
+        StatusDebugTru_val = appl_iStatusDebugTru;
+        StatusActive_val   = appl_iStatusActive;
+        StatusPLC_val      = appl_iStatusPLC;
+
+        slave_set_reg(VAR_PORTA,            PortA_val);
+        slave_set_reg(VAR_PORTB,            PortB_val & 0x03FF);
+        slave_set_reg(VAR_PORTC,            PortC_val);
+        slave_set_reg(VAR_STATUS_DEBUG,     StatusDebug_val);
+        slave_set_reg(VAR_STATUS_DEBUG_TRU, StatusDebugTru_val);
+        slave_set_reg(VAR_STATUS_ACTIVE,    StatusActive_val);
+        slave_set_reg(VAR_STATUS_PLC,       StatusPLC_val);
 
         /*------------------------------------------------------
-        | 3. Track STATUS DEBUG values             |
+        | 3. Push the changed registers to the master in one   |
+        |    NOTIFY_MULTI batch                                |
         -------------------------------------------------------*/
-        if (appl_iStatusDebug != last_StatusDebug_val)
-        {
-        	StatusDebug_val = appl_iStatusDebug;
-        	slave_set_reg(VAR_STATUS_DEBUG, appl_iStatusDebug);
-            last_StatusDebug_val = appl_iStatusDebug;
-        }
-
-        /*------------------------------------------------------
-		| 3a. Track STATUS DEBUG TruPulse values             |
-		-------------------------------------------------------*/
-		if (appl_iStatusDebugTru != last_StatusDebugTru_val)
-		{
-			StatusDebugTru_val = appl_iStatusDebugTru;
-			slave_set_reg(VAR_STATUS_DEBUG_TRU, appl_iStatusDebugTru);
-			last_StatusDebugTru_val = appl_iStatusDebugTru;
-		}
+        slave_sync();
 
         /*------------------------------------------------------
-		| 3. Track STATUS ACTIVE values             |
-		-------------------------------------------------------*/
-
-        if (appl_iStatusActive != last_StatusActive_val)
-		{
-			StatusActive_val = appl_iStatusActive;
-			slave_set_reg(VAR_STATUS_ACTIVE, appl_iStatusActive);
-			last_StatusActive_val = appl_iStatusActive;
-		}
-
-        if (appl_iStatusPLC != last_StatusPlc_val)
+        | 4. Mark the PD cycle for the master                  |
+        -------------------------------------------------------*/
+        if (fNewReadPd)
         {
-            // Optionally act on new PLC command here
-        	StatusPLC_val = appl_iStatusPLC;
-            last_StatusPlc_val = appl_iStatusPLC;
+            fNewReadPd = FALSE;
+            slave_cycle_mark();
         }
     }
 }
@@ -0,0 +1,92 @@
+/*
+ * Cost of one debounce scan of the F4's 23 inputs: the per-input
+ * changeCount[] loop vTaskInputs used to run against vdeb_update()
+ * (debounce.h), in ns and, on x86, TSC ticks per scan. The samples are
+ * precomputed noise so both see the same input and only the scan is timed.
+ */
+#include "debounce.h"
+#include "test.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define NUM_INPUTS      23
+#define DEBOUNCE_LIMIT  3u
+#define SAMPLES         4096u           // power of two
+#define SCANS           20000000u
+
+static uint32_t samples[SAMPLES];
+static volatile uint32_t sink;
+
+static uint8_t stableState[NUM_INPUTS], changeCount[NUM_INPUTS];
+
+/* The old vTaskInputs loop, event post replaced by a changed mask */
+static uint32_t loop_scan(uint32_t sample) {
+    uint32_t changed = 0;
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        uint8_t raw = (sample >> i) & 1u;
+        if (raw != stableState[i]) {
+            changeCount[i]++;
+            if (changeCount[i] >= DEBOUNCE_LIMIT) {
+                stableState[i] = raw;
+                changeCount[i] = 0;
+                changed |= 1u << i;
+            }
+        } else {
+            changeCount[i] = 0;
+        }
+    }
+    return changed;
+}
+
+static uint64_t ticks(void) {
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void report(const char *name, double t0, uint64_t c0) {
+    double ns = (test_now() - t0) * 1e9 / SCANS;
+    printf("%-16s %8.2f %10.2f\n", name, ns, (double)(ticks() - c0) / SCANS);
+}
+
+static void run_loop(void) {
+    uint32_t sum = 0;
+    for (int i = 0; i < NUM_INPUTS; i++) stableState[i] = changeCount[i] = 0;
+    double t0 = test_now();
+    uint64_t c0 = ticks();
+    for (uint32_t n = 0; n < SCANS; n++) sum += loop_scan(samples[n & (SAMPLES - 1u)]);
+    report("changeCount[]", t0, c0);
+    sink = sum;
+}
+
+static void run_vdeb(void) {
+    VDebounce d;
+    uint32_t sum = 0;
+    vdeb_init(&d, 0);
+    double t0 = test_now();
+    uint64_t c0 = ticks();
+    for (uint32_t n = 0; n < SCANS; n++) sum += vdeb_update(&d, samples[n & (SAMPLES - 1u)]);
+    report("vdeb_update()", t0, c0);
+    sink = sum;
+}
+
+int main(void) {
+    static const uint32_t noise_pct[] = { 0, 5, 50 };
+    printf("%d inputs, per scan (lower is better)\n", NUM_INPUTS);
+    for (unsigned k = 0; k < sizeof(noise_pct) / sizeof(noise_pct[0]); k++) {
+        uint32_t seed = 1, level = 0;
+        for (uint32_t n = 0; n < SAMPLES; n++) {
+            for (int i = 0; i < NUM_INPUTS; i++)
+                if (test_rand(&seed) % 100u < noise_pct[k]) level ^= 1u << i;
+            samples[n] = level;
+        }
+        printf("\n%u %% of inputs toggle per sample\n%-16s %8s %10s\n", noise_pct[k], "", "ns", "TSC ticks");
+        run_loop();
+        run_vdeb();
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Cost of one log call, ns: snprintf() into a line buffer (what UsbPrintf()
+ * does before the copy into the USB ring) against FLOG() through the real
+ * fmtlog.c. The FLOG figure includes FmtLog_Drain() moving the entries into
+ * TLM_REC_FMT records; the record itself goes nowhere.
+ */
+#include "fmtlog.h"
+#include "telemetry.h"
+#include "test.h"
+#include <string.h>
+
+#define CALLS   4000000u
+
+static volatile uint32_t sink;
+
+/* fmtlog.c's consumer: STREAM on, records dropped after a checksum */
+uint8_t Telemetry_Active(void) { return 1; }
+void Telemetry_Fmt(const uint32_t *words, uint16_t nwords) { sink += words[0] + nwords; }
+
+static const char *const names[] = { "PORTA", "STATUS_PLC", "STATUS_ACTIVE" };
+
+enum { FMT_STR_INT, FMT_FLOAT };
+
+static double run_snprintf(int kind) {
+    char line[128];
+    uint32_t sum = 0;
+    double t0 = test_now();
+    for (uint32_t i = 0; i < CALLS; i++) {
+        int n = (kind == FMT_STR_INT)
+              ? snprintf(line, sizeof(line), "%s (%d)", names[i % 3u], (int)i)
+              : snprintf(line, sizeof(line), "%.2f", (double)i * 0.01);
+        sum += (uint32_t)n + (uint8_t)line[0];
+    }
+    sink = sum;
+    return (test_now() - t0) * 1e9 / CALLS;
+}
+
+static double run_flog(int kind) {
+    double t0 = test_now();
+    for (uint32_t i = 0; i < CALLS; i++) {
+        if (kind == FMT_STR_INT)
+            FLOG("%s (%d)", names[i % 3u], (int)i);
+        else
+            FLOG("%.2f", (float)i * 0.01f);
+        if ((i & 63u) == 63u)
+            FmtLog_Drain();             // vTaskInputs drains every 10 ms
+    }
+    FmtLog_Drain();
+    return (test_now() - t0) * 1e9 / CALLS;
+}
+
+int main(void) {
+    printf("ns per log call (lower is better)\n\n");
+    printf("%-12s %10s %10s\n", "format", "snprintf", "FLOG");
+    printf("%-12s %10.1f %10.1f\n", "\"%s (%d)\"", run_snprintf(FMT_STR_INT), run_flog(FMT_STR_INT));
+    printf("%-12s %10.1f %10.1f\n", "\"%.2f\"", run_snprintf(FMT_FLOAT), run_flog(FMT_FLOAT));
+    printf("\nentries dropped (ring full): %lu\n", (unsigned long)FmtLog_Dropped());
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Wire cost and cycle latency of one full housekeeping sync at 115200 baud:
+ * write PortA, STATUS_DEBUG, STATUS_ACTIVE, STATUS_DEBUG_TRU and read PortB,
+ * PortC, STATUS_PLC, once per variable and batched.
+ *
+ * Frame sizes come from the real builders. Latency is a full-duplex wire
+ * model: a request is on the wire for 10 bits per byte, the slave starts its
+ * reply `turnaround` after the request's last byte, and the master either
+ * waits for each reply (stop-and-wait) or sends every request back to back
+ * (tagged, pipelined). The host CPU time to build and parse one cycle is
+ * measured on the real code.
+ */
+#include "protocol.h"
+#include "test.h"
+#include <string.h>
+
+#define BAUD        115200.0
+#define BYTE_US     (10.0 * 1e6 / BAUD)
+
+typedef struct { size_t req, rep; } Exchange;
+
+static const ProtoPair out_pairs[] = {
+    { VAR_PORTA, 0x0155 }, { VAR_STATUS_DEBUG, 0x1234 },
+    { VAR_STATUS_ACTIVE, 0x0001 }, { VAR_STATUS_DEBUG_TRU, 0x00F0 },
+};
+static const uint8_t in_ids[] = { VAR_PORTB, VAR_PORTC, VAR_STATUS_PLC };
+
+static size_t wire(const uint8_t *frame, size_t n, int v2, int tagged, uint8_t *buf) {
+    uint8_t tmp[PROTO_MAX_FRAME];
+    memcpy(tmp, frame, n);
+    if (tagged) n = proto_tag(0x21, tmp, n);
+    if (!v2) { memcpy(buf, tmp, n); return n; }
+    return proto_encode_v2(tmp, n, buf);
+}
+
+/* Exchanges of one cycle; returns how many */
+static int build_cycle(int batched, int v2, int tagged, Exchange *ex) {
+    uint8_t f[PROTO_MAX_FRAME], w[PROTO_V2_MAX_WIRE];
+    ProtoPair rp[3];
+    int k = 0;
+
+    if (batched) {
+        ex[k].req = wire(f, proto_build_write_multi(out_pairs, 4, f), v2, tagged, w);
+        ex[k].rep = wire(f, proto_build_ack_multi(out_pairs, 4, f), v2, tagged, w);
+        k++;
+        for (int i = 0; i < 3; i++) { rp[i].var_id = in_ids[i]; rp[i].value = 0x0A0A; }
+        ex[k].req = wire(f, proto_build_read_multi(in_ids, 3, f), v2, tagged, w);
+        ex[k].rep = wire(f, proto_build_readr_multi(rp, 3, f), v2, tagged, w);
+        k++;
+    } else {
+        for (int i = 0; i < 4; i++, k++) {
+            ex[k].req = wire(f, proto_build_write(out_pairs[i].var_id, out_pairs[i].value, f), v2, tagged, w);
+            ex[k].rep = wire(f, proto_build_ack(out_pairs[i].var_id, out_pairs[i].value, f), v2, tagged, w);
+        }
+        for (int i = 0; i < 3; i++, k++) {
+            ex[k].req = wire(f, proto_build_read(in_ids[i], f), v2, tagged, w);
+            ex[k].rep = wire(f, proto_build_readr(in_ids[i], 0x0A0A, f), v2, tagged, w);
+        }
+    }
+    return k;
+}
+
+/* Cycle time in µs under the full-duplex wire model */
+static double cycle_us(const Exchange *ex, int n, int pipelined, double turnaround_us) {
+    double tx_free = 0, rx_free = 0, done = 0;
+    for (int i = 0; i < n; i++) {
+        double start = pipelined ? tx_free : done;          // stop-and-wait: after the previous reply
+        double req_end = start + (double)ex[i].req * BYTE_US;
+        tx_free = req_end;
+        double rep_start = req_end + turnaround_us;
+        if (rep_start < rx_free) rep_start = rx_free;       // slave TX is busy with an earlier reply
+        rx_free = rep_start + (double)ex[i].rep * BYTE_US;
+        done = rx_free;
+    }
+    return done;
+}
+
+static void report(const char *name, int batched, int v2, int tagged, int pipelined) {
+    Exchange ex[8];
+    int n = build_cycle(batched, v2, tagged, ex);
+    size_t bytes = 0;
+    for (int i = 0; i < n; i++) bytes += ex[i].req + ex[i].rep;
+    printf("%-30s %7d %7zu %10.2f %10.2f\n", name, 2 * n, bytes,
+           cycle_us(ex, n, pipelined, 100.0) / 1000.0,
+           cycle_us(ex, n, pipelined, 1000.0) / 1000.0);
+}
+
+/* Host CPU time for the master side of one cycle: build requests, parse replies */
+static double cpu_ns_per_cycle(int batched) {
+    uint8_t f[PROTO_MAX_FRAME], rep[8][PROTO_MAX_FRAME];
+    size_t rep_len[8];
+    ProtoParser master;
+    ProtoFrame fr;
+    ProtoPair rp[3];
+    int nrep = 0;
+    volatile uint32_t sink = 0;
+
+    if (batched) {
+        rep_len[nrep] = proto_build_ack_multi(out_pairs, 4, rep[nrep]); nrep++;
+        for (int i = 0; i < 3; i++) { rp[i].var_id = in_ids[i]; rp[i].value = 0x0A0A; }
+        rep_len[nrep] = proto_build_readr_multi(rp, 3, rep[nrep]); nrep++;
+    } else {
+        for (int i = 0; i < 4; i++, nrep++) rep_len[nrep] = proto_build_ack(out_pairs[i].var_id, 1, rep[nrep]);
+        for (int i = 0; i < 3; i++, nrep++) rep_len[nrep] = proto_build_readr(in_ids[i], 1, rep[nrep]);
+    }
+
+    proto_init(&master, ROLE_MASTER);
+    const int iters = 200000;
+    double t0 = test_now();
+    for (int it = 0; it < iters; it++) {
+        if (batched) {
+            sink += (uint32_t)proto_build_write_multi(out_pairs, 4, f);
+            sink += (uint32_t)proto_build_read_multi(in_ids, 3, f);
+        } else {
+            for (int i = 0; i < 4; i++) sink += (uint32_t)proto_build_write(out_pairs[i].var_id, out_pairs[i].value, f);
+            for (int i = 0; i < 3; i++) sink += (uint32_t)proto_build_read(in_ids[i], f);
+        }
+        for (int r = 0; r < nrep; r++)
+            for (size_t b = 0; b < rep_len[r]; b++)
+                if (proto_push(&master, rep[r][b], &fr)) sink += fr.count;
+    }
+    (void)sink;
+    return (test_now() - t0) * 1e9 / iters;
+}
+
+int main(void) {
+    printf("Full sync cycle (4 writes + 3 reads) at %.0f baud\n\n", BAUD);
+    printf("%-30s %7s %7s %10s %10s\n", "mode", "frames", "bytes", "ms@0.1ms", "ms@1ms");
+    printf("%-30s %7s %7s %10s %10s\n", "", "", "", "turnaround", "turnaround");
+    report("v1 single, stop-and-wait",    0, 0, 0, 0);
+    report("v1 batched, stop-and-wait",   1, 0, 0, 0);
+    report("v1 single, tagged pipelined", 0, 0, 1, 1);
+    report("v1 batched, tagged pipelined",1, 0, 1, 1);
+    report("v2 batched, tagged pipelined",1, 1, 1, 1);
+    printf("\nhost CPU, master side per cycle: single %.0f ns, batched %.0f ns\n",
+           cpu_ns_per_cycle(0), cpu_ns_per_cycle(1));
+    return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * Parser throughput, v1 (STX..ETX) against v2 (COBS + CRC16), for the
+ * smallest and the largest frame: wire bytes, ns per frame and MB/s of
+ * wire data through proto_push(), plus the cost of proto_encode_v2().
+ */
+#include "protocol.h"
+#include "test.h"
+#include <string.h>
+
+#define STREAM  4096u
+#define PASSES  400
+
+static volatile uint32_t sink;
+
+/* Parse a stream of back-to-back copies of one frame; returns ns per frame */
+static double parse_ns(const uint8_t *frame, size_t n, int v2, double *mbps) {
+    static uint8_t stream[STREAM];
+    size_t copies = sizeof(stream) / n, len = copies * n;
+    for (size_t c = 0; c < copies; c++) memcpy(stream + c * n, frame, n);
+
+    ProtoParser p;
+    ProtoFrame f;
+    uint32_t got = 0;
+    if (v2) proto_init_v2(&p, ROLE_SLAVE); else proto_init(&p, ROLE_SLAVE);
+    double t0 = test_now();
+    for (int pass = 0; pass < PASSES; pass++)
+        for (size_t i = 0; i < len; i++)
+            if (proto_push(&p, stream[i], &f)) got += f.count + 1u;
+    double dt = test_now() - t0;
+    sink = got;
+    *mbps = (double)len * PASSES / dt / 1e6;
+    return dt * 1e9 / ((double)copies * PASSES);
+}
+
+static double encode_ns(const uint8_t *frame, size_t n) {
+    uint8_t wire[PROTO_V2_MAX_WIRE];
+    const int iters = 2000000;
+    size_t total = 0;
+    double t0 = test_now();
+    for (int i = 0; i < iters; i++) total += proto_encode_v2(frame, n, wire);
+    sink = (uint32_t)total;
+    return (test_now() - t0) * 1e9 / iters;
+}
+
+static void report(const char *name, const uint8_t *v1, size_t n1) {
+    uint8_t wire[PROTO_V2_MAX_WIRE];
+    size_t nw = proto_encode_v2(v1, n1, wire);
+    double mb1, mb2;
+    double ns1 = parse_ns(v1, n1, 0, &mb1);
+    double ns2 = parse_ns(wire, nw, 1, &mb2);
+    printf("%-22s %4zu %4zu %9.1f %9.1f %8.0f %8.0f %9.1f\n",
+           name, n1, nw, ns1, ns2, mb1, mb2, encode_ns(v1, n1));
+}
+
+int main(void) {
+    uint8_t f[PROTO_MAX_FRAME];
+    ProtoPair pairs[PROTO_MAX_PAIRS];
+    for (unsigned i = 0; i < PROTO_MAX_PAIRS; i++) {
+        pairs[i].var_id = (uint8_t)i;
+        pairs[i].value  = (uint16_t)(0x0100u * i + 0x20u);
+    }
+
+    printf("%-22s %4s %4s %9s %9s %8s %8s %9s\n", "", "v1", "v2", "v1", "v2", "v1", "v2", "encode");
+    printf("%-22s %4s %4s %9s %9s %8s %8s %9s\n", "frame", "B", "B", "ns/frame", "ns/frame", "MB/s", "MB/s", "v2 ns");
+    report("WRITE", f, proto_build_write(VAR_PORTA, 0x1234, f));
+    report("WRITE, value 0x0000", f, proto_build_write(VAR_PORTA, 0x0000, f));
+    size_t n = proto_build_write_multi(pairs, PROTO_MAX_PAIRS, f);
+    report("WRITE_MULTI x8 tagged", f, proto_tag(0x42, f, n));
+    return 0;
+}
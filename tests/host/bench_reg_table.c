@@ -0,0 +1,78 @@
+/*
+ * Cost of one M40 register sync, ns: store the mapped registers, then
+ * collect the changed ones for NOTIFY / NOTIFY_MULTI. reg_table_collect()
+ * (bitmap + CTZ) against a byte-per-register dirty array scanned linearly,
+ * for 0 to 32 registers changed per sync out of 256.
+ */
+#include "reg_table.h"
+#include "test.h"
+
+#define ROUNDS 2000000u
+
+/* ---- linear scan: one dirty byte per register ---- */
+typedef struct {
+    uint16_t value[REG_COUNT];
+    uint8_t  dirty[REG_COUNT];
+} ScanTable;
+
+static inline void scan_set(ScanTable *t, uint8_t id, uint16_t v) {
+    if (t->value[id] == v) return;
+    t->value[id] = v;
+    t->dirty[id] = 1;
+}
+
+static inline uint8_t scan_collect(ScanTable *t, ProtoPair *out, uint8_t max) {
+    uint8_t n = 0;
+    for (uint32_t id = 0; id < REG_COUNT && n < max; id++) {
+        if (!t->dirty[id]) continue;
+        t->dirty[id] = 0;
+        out[n].var_id = (uint8_t)id;
+        out[n].value  = t->value[id];
+        n++;
+    }
+    return n;
+}
+
+static volatile uint32_t sink;
+
+/* Registers 1..changed change every round, spread over the table */
+static uint8_t reg_id(uint32_t i) { return (uint8_t)(1u + i * 7u); }
+
+static double run_bitmap(uint32_t changed) {
+    static RegTable t;
+    ProtoPair out[PROTO_MAX_PAIRS];
+    uint32_t sum = 0;
+    reg_table_init(&t);
+    double t0 = test_now();
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        for (uint32_t i = 0; i < changed; i++) reg_table_set(&t, reg_id(i), (uint16_t)r);
+        uint8_t n;
+        while ((n = reg_table_collect(&t, out, PROTO_MAX_PAIRS)) != 0) sum += n + out[0].value;
+    }
+    sink = sum;
+    return (test_now() - t0) * 1e9 / ROUNDS;
+}
+
+static double run_scan(uint32_t changed) {
+    static ScanTable t;
+    ProtoPair out[PROTO_MAX_PAIRS];
+    uint32_t sum = 0;
+    memset(&t, 0, sizeof(t));
+    double t0 = test_now();
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        for (uint32_t i = 0; i < changed; i++) scan_set(&t, reg_id(i), (uint16_t)r);
+        uint8_t n;
+        while ((n = scan_collect(&t, out, PROTO_MAX_PAIRS)) != 0) sum += n + out[0].value;
+    }
+    sink = sum;
+    return (test_now() - t0) * 1e9 / ROUNDS;
+}
+
+int main(void) {
+    static const uint32_t changed[] = { 0, 1, 2, 7, 32 };
+    printf("%u registers, ns per sync (lower is better)\n\n", REG_COUNT);
+    printf("%-8s %14s %14s\n", "changed", "bitmap + CTZ", "linear scan");
+    for (unsigned i = 0; i < sizeof(changed) / sizeof(changed[0]); i++)
+        printf("%-8u %14.1f %14.1f\n", changed[i], run_bitmap(changed[i]), run_scan(changed[i]));
+    return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Ring buffer throughput, MB/s: the per-byte implementation the boards had
+ * before the bulk API (copied below as old_*) against rb_write_n/rb_read_n
+ * and the span calls. A 256-byte ring (RB_SIZE) is filled in chunks the
+ * size of a UART DMA burst and drained by the consumer, on one thread.
+ */
+#include "ring_buffer.h"
+#include "test.h"
+
+/* ---- previous ring_buffer.h: rb_write loops over rb_put ---- */
+static inline bool old_put(RingBuffer *rb, uint8_t b) {
+    uint16_t next = rb->head + 1;
+    if ((uint16_t)(next - rb->tail) > rb->size) return false;
+    rb->buf[rb->head & (rb->size - 1)] = b;
+    rb->head = next;
+    return true;
+}
+static inline uint16_t old_write(RingBuffer *rb, const uint8_t *src, uint16_t len) {
+    uint16_t w = 0;
+    while (w < len && old_put(rb, src[w])) w++;
+    return w;
+}
+static inline bool old_get(RingBuffer *rb, uint8_t *out) {
+    if (rb_count(rb) == 0) return false;
+    *out = rb->buf[rb->tail & (rb->size - 1)];
+    rb->tail++;
+    return true;
+}
+
+#define TOTAL   (256u * 1024u * 1024u)
+#define RB_SIZE 256u
+
+static uint8_t storage[RB_SIZE];
+static uint8_t src[RB_SIZE], dst[RB_SIZE];
+static volatile uint32_t sink;
+
+enum { OLD_BYTES, NEW_BULK, NEW_SPAN };
+
+static double run(int mode, uint16_t chunk) {
+    RingBuffer rb;
+    uint32_t moved = 0, sum = 0;
+    rb_init(&rb, storage, RB_SIZE);
+    double t0 = test_now();
+    while (moved < TOTAL) {
+        if (mode == OLD_BYTES) {
+            old_write(&rb, src, chunk);
+            uint8_t b;
+            uint16_t n = 0;
+            while (old_get(&rb, &b)) { dst[n++] = b; }
+            sum += dst[0];
+            moved += n;
+        } else if (mode == NEW_BULK) {
+            rb_write_n(&rb, src, chunk);
+            uint16_t n = rb_read_n(&rb, dst, RB_SIZE);
+            sum += dst[0];
+            moved += n;
+        } else {
+            rb_write_n(&rb, src, chunk);
+            const uint8_t *span;
+            uint16_t n;
+            while ((n = rb_peek_contiguous(&rb, &span)) != 0) {
+                sum += span[0];                  // parser consumes in place, no copy out
+                rb_commit(&rb, n);
+                moved += n;
+            }
+        }
+    }
+    sink = sum;
+    return (double)moved / (test_now() - t0) / 1e6;
+}
+
+int main(void) {
+    static const uint16_t chunks[] = { 8, 29, 64, 200 };
+    for (unsigned i = 0; i < sizeof(src); i++) src[i] = (uint8_t)i;
+
+    printf("ring %u B, single thread, MB/s (higher is better)\n\n", RB_SIZE);
+    printf("%-8s %14s %14s %14s\n", "chunk", "rb_put/rb_get", "write_n/read_n", "write_n/peek");
+    for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+        printf("%-8u %14.0f %14.0f %14.0f\n", chunks[c],
+               run(OLD_BYTES, chunks[c]), run(NEW_BULK, chunks[c]), run(NEW_SPAN, chunks[c]));
+    return 0;
+}
@@ -0,0 +1,361 @@
+/*
+ * Link simulator: the F4 master (sim_master) and the M40 slave (sim_slave)
+ * talk over two pseudo-terminals, with this process as the cable between
+ * them. Each direction is relayed byte by byte with seeded faults:
+ *
+ *   -l ppm      byte loss
+ *   -f ppm      single bit flips
+ *   -d us       extra delay per burst, uniform 0..us (order is kept)
+ *   -o s:ms     outage every s seconds for ms milliseconds (cable pulled)
+ *   -e ppm      framing errors raised by the UART shim on each side
+ *
+ * The relay reads each side's tty speed; while the two differ (one side
+ * has switched rate and the other not yet) bytes arrive as garbage, more
+ * or fewer of them, as on a real line.
+ *
+ *   linksim [-t seconds] [-s seed] [-l ppm] [-f ppm] [-d us] [-o s:ms] [-e ppm]
+ *
+ * Prints the configuration, relay counters, the recovery time after each
+ * outage (end of outage -> first good master exchange) and both sides'
+ * reports. The same seed replays the same fault pattern; timings vary
+ * with the host's scheduling.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define QUEUE_SIZE  (1u << 16)
+#define MAX_OUTAGES 1024u
+
+typedef struct {
+    double   seconds;
+    uint32_t seed;
+    uint32_t loss_ppm, flip_ppm, delay_us;
+    double   outage_every;
+    uint32_t outage_ms;
+    uint32_t uart_err_ppm;
+} Config;
+
+static Config cfg = { 60.0, 1, 20, 20, 200, 15.0, 800, 5 };
+static double t_start;
+
+typedef struct {
+    const char *name;
+    int in, out;
+    uint32_t seed;
+    /* bytes waiting for their release time */
+    uint8_t  q[QUEUE_SIZE];
+    double   q_at[QUEUE_SIZE];
+    uint32_t q_head, q_tail;
+    double   last_at;
+    double   mismatch_frac;
+    /* counters */
+    uint64_t bytes, lost, flipped, outage_dropped, garbled, overflow;
+} Relay;
+
+static double mono(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rnd(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return *s = x;
+}
+
+static bool in_outage(double t) {
+    double rel = t - t_start;
+    if (cfg.outage_every <= 0 || cfg.outage_ms == 0 || rel < cfg.outage_every) return false;
+    double phase = rel - cfg.outage_every * (double)(uint64_t)(rel / cfg.outage_every);
+    return phase < cfg.outage_ms / 1000.0;
+}
+
+/* Line rate set by the process on the other end of a pty (shared termios) */
+static uint32_t tty_rate(int fd) {
+    static const struct { speed_t sp; uint32_t rate; } map[] = {
+        { B9600, 9600 }, { B19200, 19200 }, { B38400, 38400 }, { B57600, 57600 },
+        { B115200, 115200 }, { B230400, 230400 }, { B460800, 460800 }, { B921600, 921600 },
+        { B1000000, 1000000 }, { B2000000, 2000000 }, { B3000000, 3000000 },
+    };
+    struct termios t;
+    if (tcgetattr(fd, &t) != 0) return 0;
+    speed_t sp = cfgetospeed(&t);
+    for (size_t i = 0; i < sizeof(map) / sizeof(map[0]); i++)
+        if (map[i].sp == sp) return map[i].rate;
+    return 0;
+}
+
+static void enqueue(Relay *r, uint8_t b, double at) {
+    if (r->q_head - r->q_tail == QUEUE_SIZE) {
+        r->overflow++;
+        return;
+    }
+    if (at < r->last_at) at = r->last_at;       // a delayed burst holds back the ones after it
+    r->last_at = at;
+    r->q[r->q_head % QUEUE_SIZE] = b;
+    r->q_at[r->q_head % QUEUE_SIZE] = at;
+    r->q_head++;
+}
+
+/* One byte through the cable */
+static void relay_byte(Relay *r, uint8_t b, double at, uint32_t rate_in, uint32_t rate_out) {
+    r->bytes++;
+    if (in_outage(at)) {
+        r->outage_dropped++;
+        return;
+    }
+    if (rnd(&r->seed) % 1000000u < cfg.loss_ppm) {
+        r->lost++;
+        return;
+    }
+    if (rnd(&r->seed) % 1000000u < cfg.flip_ppm) {
+        b ^= (uint8_t)(1u << (rnd(&r->seed) % 8u));
+        r->flipped++;
+    }
+    if (rate_in && rate_out && rate_in != rate_out) {
+        /* Sampled at the wrong rate: rate_out/rate_in characters of garbage per byte */
+        r->garbled++;
+        r->mismatch_frac += (double)rate_out / (double)rate_in;
+        while (r->mismatch_frac >= 1.0) {
+            r->mismatch_frac -= 1.0;
+            enqueue(r, (uint8_t)rnd(&r->seed), at);
+        }
+        return;
+    }
+    enqueue(r, b, at);
+}
+
+static volatile bool running = true;
+
+static void *relay_thread(void *arg) {
+    Relay *r = arg;
+    uint8_t buf[512];
+    while (running) {
+        double now = mono();
+        int timeout = 5;
+        if (r->q_head != r->q_tail) {
+            double wait = r->q_at[r->q_tail % QUEUE_SIZE] - now;
+            timeout = (wait <= 0) ? 0 : (int)(wait * 1000.0) + 1;
+            if (timeout > 5) timeout = 5;
+        }
+        struct pollfd p = { .fd = r->in, .events = POLLIN };
+        if (poll(&p, 1, timeout) > 0 && (p.revents & POLLIN)) {
+            ssize_t n = read(r->in, buf, sizeof(buf));
+            if (n > 0) {
+                now = mono();
+                double at = now + (cfg.delay_us ? (rnd(&r->seed) % (cfg.delay_us + 1u)) * 1e-6 : 0.0);
+                uint32_t rate_in = tty_rate(r->in), rate_out = tty_rate(r->out);
+                for (ssize_t i = 0; i < n; i++) relay_byte(r, buf[i], at, rate_in, rate_out);
+            }
+        }
+        /* Release what is due, in order */
+        now = mono();
+        while (r->q_head != r->q_tail && r->q_at[r->q_tail % QUEUE_SIZE] <= now) {
+            uint32_t i = r->q_tail % QUEUE_SIZE, k = 0;
+            uint8_t out[512];
+            while (r->q_head != r->q_tail + k && k < sizeof(out) && r->q_at[(r->q_tail + k) % QUEUE_SIZE] <= now) {
+                out[k] = r->q[(i + k) % QUEUE_SIZE];
+                k++;
+            }
+            ssize_t w = write(r->out, out, k);
+            if (w <= 0) break;                  // receiver's tty buffer full: retry later
+            r->q_tail += (uint32_t)w;
+        }
+    }
+    return NULL;
+}
+
+/* ---- child processes ---- */
+
+typedef struct {
+    const char *name;
+    pid_t pid;
+    int fd;                 // read end of its stdout
+    char *out;              // everything it printed
+    size_t len;
+} Child;
+
+static void child_start(Child *c, const char *exe, const char *tty, uint32_t seed) {
+    char secs[32], sd[32], err[32];
+    int p[2];
+    snprintf(secs, sizeof(secs), "%.3f", cfg.seconds);
+    snprintf(sd, sizeof(sd), "%lu", (unsigned long)seed);
+    snprintf(err, sizeof(err), "%lu", (unsigned long)cfg.uart_err_ppm);
+    if (pipe(p) != 0) { perror("pipe"); exit(1); }
+    c->pid = fork();
+    if (c->pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        dup2(p[1], STDOUT_FILENO);
+        close(p[0]);
+        close(p[1]);
+        execl(exe, exe, tty, secs, sd, err, (char *)NULL);
+        perror(exe);
+        _exit(127);
+    }
+    close(p[1]);
+    c->fd = p[0];
+}
+
+static void *child_reader(void *arg) {
+    Child *c = arg;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(c->fd, buf, sizeof(buf))) > 0) {
+        c->out = realloc(c->out, c->len + (size_t)n + 1);
+        memcpy(c->out + c->len, buf, (size_t)n);
+        c->len += (size_t)n;
+        c->out[c->len] = 0;
+    }
+    return NULL;
+}
+
+static void open_pty(int *master, int *slave, char *name) {
+    struct termios t;
+    if (openpty(master, slave, name, NULL, NULL) != 0) { perror("openpty"); exit(1); }
+    /* Raw from the start: no echo or line editing before the firmware opens its side */
+    tcgetattr(*slave, &t);
+    cfmakeraw(&t);
+    cfsetspeed(&t, B115200);
+    tcsetattr(*slave, TCSANOW, &t);
+    fcntl(*master, F_SETFL, fcntl(*master, F_GETFL) | O_NONBLOCK);
+    fcntl(*master, F_SETFD, FD_CLOEXEC);
+    fcntl(*slave, F_SETFD, FD_CLOEXEC);
+}
+
+static void print_counters(const Relay *r) {
+    printf("relay %s: %llu B in, lost %llu, bit flips %llu, dropped in outages %llu, "
+           "garbled by rate mismatch %llu, queue overflow %llu\n", r->name,
+           (unsigned long long)r->bytes, (unsigned long long)r->lost, (unsigned long long)r->flipped,
+           (unsigned long long)r->outage_dropped, (unsigned long long)r->garbled,
+           (unsigned long long)r->overflow);
+}
+
+/* End of each outage -> first "recover" line the master printed after it */
+static void print_recovery(const Child *master) {
+    double rec[MAX_OUTAGES], worst = 0, sum = 0;
+    unsigned n = 0, missed = 0;
+    if (cfg.outage_every <= 0 || cfg.outage_ms == 0) return;
+    for (double t = cfg.outage_every; t + cfg.outage_ms / 1000.0 < cfg.seconds && n + missed < MAX_OUTAGES; t += cfg.outage_every) {
+        double end = t_start + t + cfg.outage_ms / 1000.0, found = 0;
+        for (const char *p = master->out; p && (p = strstr(p, "recover ")) != NULL; p++) {
+            double at = strtod(p + 8, NULL);
+            if (at >= end) { found = at; break; }
+        }
+        if (found == 0 || found > t_start + t + cfg.outage_every) { missed++; continue; }
+        rec[n] = found - end;
+        sum += rec[n];
+        if (rec[n] > worst) worst = rec[n];
+        n++;
+    }
+    printf("recovery after %u outages of %lu ms: ", n + missed, (unsigned long)cfg.outage_ms);
+    if (n) printf("mean %.0f ms, max %.0f ms", sum / n * 1000.0, worst * 1000.0);
+    printf("%s%u not recovered before the next outage\n", n ? ", " : "", missed);
+    printf("  each (ms):");
+    for (unsigned i = 0; i < n; i++) printf(" %.0f", rec[i] * 1000.0);
+    printf("\n");
+}
+
+/* Child output without the "recover" lines, which only feed print_recovery() */
+static void print_child(const Child *c) {
+    for (const char *p = c->out; p && *p;) {
+        const char *e = strchr(p, '\n');
+        size_t len = e ? (size_t)(e - p) + 1 : strlen(p);
+        if (strncmp(p, "recover ", 8) != 0) fwrite(p, 1, len, stdout);
+        p += len;
+    }
+}
+
+static void usage(const char *exe) {
+    fprintf(stderr, "usage: %s [-t seconds] [-s seed] [-l loss_ppm] [-f flip_ppm] [-d delay_us] "
+                    "[-o every_s:ms] [-e uart_err_ppm]\n", exe);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "t:s:l:f:d:o:e:")) != -1) {
+        switch (opt) {
+            case 't': cfg.seconds = strtod(optarg, NULL); break;
+            case 's': cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'l': cfg.loss_ppm = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'f': cfg.flip_ppm = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'd': cfg.delay_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'o':
+                if (sscanf(optarg, "%lf:%u", &cfg.outage_every, &cfg.outage_ms) != 2) usage(argv[0]);
+                break;
+            case 'e': cfg.uart_err_ppm = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (cfg.seed == 0) cfg.seed = 1;
+
+    /* The simulator binaries sit next to this one */
+    char dir[4096], master_exe[4200], slave_exe[4200];
+    snprintf(dir, sizeof(dir), "%s", argv[0]);
+    char *slash = strrchr(dir, '/');
+    if (slash) *slash = 0; else snprintf(dir, sizeof(dir), ".");
+    snprintf(master_exe, sizeof(master_exe), "%s/sim_master", dir);
+    snprintf(slave_exe, sizeof(slave_exe), "%s/sim_slave", dir);
+
+    int ma, sa, mb, sb;
+    char tty_a[256], tty_b[256];
+    open_pty(&ma, &sa, tty_a);
+    open_pty(&mb, &sb, tty_b);
+
+    static Relay to_slave, to_master;
+    to_slave  = (Relay){ .name = "master->slave", .in = ma, .out = mb, .seed = cfg.seed * 2654435761u | 1u };
+    to_master = (Relay){ .name = "slave->master", .in = mb, .out = ma, .seed = cfg.seed * 40503u | 1u };
+
+    printf("linksim: %.0f s, seed %lu, loss %lu ppm, bit flips %lu ppm, delay 0..%lu us, "
+           "outage %lu ms every %.0f s, uart framing errors %lu ppm\n",
+           cfg.seconds, (unsigned long)cfg.seed, (unsigned long)cfg.loss_ppm, (unsigned long)cfg.flip_ppm,
+           (unsigned long)cfg.delay_us, (unsigned long)cfg.outage_ms, cfg.outage_every,
+           (unsigned long)cfg.uart_err_ppm);
+    fflush(stdout);
+
+    t_start = mono();
+    Child master = { .name = "master" }, slave = { .name = "slave" };
+    child_start(&slave, slave_exe, tty_b, cfg.seed);
+    child_start(&master, master_exe, tty_a, cfg.seed);
+
+    pthread_t rt[2], ct[2];
+    pthread_create(&rt[0], NULL, relay_thread, &to_slave);
+    pthread_create(&rt[1], NULL, relay_thread, &to_master);
+    pthread_create(&ct[0], NULL, child_reader, &master);
+    pthread_create(&ct[1], NULL, child_reader, &slave);
+
+    int status, failed = 0;
+    if (waitpid(master.pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = 1;
+    if (waitpid(slave.pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = 1;
+    running = false;
+    pthread_join(rt[0], NULL);
+    pthread_join(rt[1], NULL);
+    pthread_join(ct[0], NULL);
+    pthread_join(ct[1], NULL);
+
+    print_counters(&to_slave);
+    print_counters(&to_master);
+    print_recovery(&master);
+    printf("\n");
+    print_child(&master);
+    printf("\n");
+    print_child(&slave);
+    if (failed) fprintf(stderr, "linksim: a simulator process failed\n");
+    return failed;
+}
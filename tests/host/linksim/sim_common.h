@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "link_stats.h"
+
+/* Shared by sim_master.c and sim_slave.c */
+
+#define SIM_PD_CYCLE_MS 10u     // simulated Profinet PD cycle on the slave
+#define SIM_POLL_US     200u    // slave main loop period
+
+/* CLOCK_MONOTONIC is system-wide, so linksim can line these up with its own events */
+static inline double sim_mono(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static inline double sim_elapsed(void) {
+    static double t0;
+    if (t0 == 0) t0 = sim_mono();
+    return sim_mono() - t0;
+}
+
+static inline void sim_sleep_us(uint32_t us) {
+    struct timespec ts = { (time_t)(us / 1000000u), (long)(us % 1000000u) * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+/* Upper edge (µs) of the bucket holding the p-th fraction of n samples */
+static inline uint32_t sim_hist_pct(const uint32_t *hist, uint32_t buckets, uint32_t bucket_us, double p) {
+    uint64_t n = 0, seen = 0;
+    for (uint32_t i = 0; i < buckets; i++) n += hist[i];
+    if (n == 0) return 0;
+    for (uint32_t i = 0; i < buckets; i++) {
+        seen += hist[i];
+        if ((double)seen >= p * (double)n) return (i + 1u) * bucket_us;
+    }
+    return buckets * bucket_us;
+}
+
+static inline void sim_print_link_stats(const char *side, const LinkStats *s) {
+    printf("%s: frames rx %lu tx %lu, resyncs %lu, overruns %lu, uart errors %lu, tx dropped %lu, retries %lu, timeouts %lu\n",
+           side, (unsigned long)s->frames_rx, (unsigned long)s->frames_tx, (unsigned long)s->resyncs,
+           (unsigned long)s->overruns, (unsigned long)s->uart_errors, (unsigned long)s->tx_dropped,
+           (unsigned long)s->retries, (unsigned long)s->timeouts);
+    printf("%s: LinkStats RTT p50 <%lu us, p90 <%lu us, p99 <%lu us, p99.9 <%lu us, max %lu us\n", side,
+           (unsigned long)sim_hist_pct(s->rtt_hist, LINK_RTT_BUCKETS, LINK_RTT_BUCKET_US, 0.50),
+           (unsigned long)sim_hist_pct(s->rtt_hist, LINK_RTT_BUCKETS, LINK_RTT_BUCKET_US, 0.90),
+           (unsigned long)sim_hist_pct(s->rtt_hist, LINK_RTT_BUCKETS, LINK_RTT_BUCKET_US, 0.99),
+           (unsigned long)sim_hist_pct(s->rtt_hist, LINK_RTT_BUCKETS, LINK_RTT_BUCKET_US, 0.999),
+           (unsigned long)s->rtt_max_us);
+}
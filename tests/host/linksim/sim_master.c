@@ -0,0 +1,175 @@
+/*
+ * Master side of the link simulator: the F4's master_link.c,
+ * uart_master_task.c and protocol.c on a tty. The uart_master task runs as
+ * on the board. The main thread plays the housekeeping exchange of
+ * app_main.c back to back: a tagged WRITE_MULTI of SIM_VARS registers, then
+ * a tagged READ_MULTI of the same registers, each checked against the
+ * values written.
+ *
+ *   sim_master <tty> <seconds> <seed> <uart_err_ppm>
+ *
+ * Prints "recover <t>" (CLOCK_MONOTONIC seconds) on the first good exchange
+ * after a failed one, which linksim lines up with its outages, and a
+ * report on exit. Started by linksim.
+ */
+#include "master_link.h"
+#include "uart_master_task.h"
+#include "uart_pty.h"
+#include "sim_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SIM_VARS                8u      // registers 1 .. SIM_VARS
+#define SIM_EXCHANGE_TIMEOUT_MS 250u    // > MASTER_REQ_TIMEOUT_MS * (MASTER_REQ_RETRIES + 1)
+#define EX_BUCKET_US            50u
+#define EX_BUCKETS              (SIM_EXCHANGE_TIMEOUT_MS * 1000u / EX_BUCKET_US)
+
+UART_HandleTypeDef huart2;
+static DMA_HandleTypeDef hdma_usart2_rx;
+
+static uint32_t ex_hist[EX_BUCKETS];
+static volatile uint32_t timeouts_reported;
+
+/* FLOG() entries are not decoded here (the baud report is one while streaming); main() prints rate changes */
+void FmtLog_Write(uint32_t hdr, ...) { (void)hdr; }
+
+void master_on_timeout(uint8_t cmd, uint8_t var_id) {
+    (void)cmd; (void)var_id;
+    __atomic_fetch_add(&timeouts_reported, 1u, __ATOMIC_RELAXED);
+}
+
+/* Values carry the exchange number (12 bits) and the register */
+static uint16_t sim_value(uint32_t exchange, uint8_t var) { return (uint16_t)((exchange << 4) | var); }
+
+/* A value this run never wrote: wrong register or not one of the last 256 exchanges */
+static int sim_corrupt(uint16_t v, uint32_t exchange, uint8_t var) {
+    return (v & 0xFu) != var || ((exchange - (v >> 4)) & 0xFFFu) > 256u;
+}
+
+typedef enum { EX_OK, EX_STALE, EX_FAILED } ExResult;
+
+static uint32_t corrupt;
+
+static HAL_StatusTypeDef submit(int write, const ProtoPair *pairs, const uint8_t *ids, uint32_t deadline) {
+    HAL_StatusTypeDef st;
+    while ((st = write ? master_submit_write_multi(pairs, SIM_VARS) : master_submit_read_multi(ids, SIM_VARS)) == HAL_BUSY &&
+           (int32_t)(osKernelGetTickCount() - deadline) < 0)
+        osDelay(1);                     // window full: wait for replies or expiry
+    return st;
+}
+
+static ExResult exchange(uint32_t n, double *us) {
+    ProtoPair pairs[SIM_VARS];
+    uint8_t ids[SIM_VARS];
+    VarMailbox ack0, dat0, m;
+    for (uint8_t i = 0; i < SIM_VARS; i++) {
+        ids[i] = (uint8_t)(i + 1u);
+        pairs[i].var_id = ids[i];
+        pairs[i].value = sim_value(n, ids[i]);
+    }
+    mbox_read_ack(SIM_VARS, &ack0);
+    mbox_read_data(SIM_VARS, &dat0);
+    osThreadFlagsClear(MBOX_FLAG_ACK(SIM_VARS) | MBOX_FLAG_DATA(SIM_VARS));
+
+    double t0 = sim_mono();
+    uint32_t deadline = osKernelGetTickCount() + SIM_EXCHANGE_TIMEOUT_MS;
+    if (submit(1, pairs, ids, deadline) != HAL_OK || submit(0, pairs, ids, deadline) != HAL_OK) return EX_FAILED;
+
+    /* The last register's ACK and READ reply: ACK_MULTI / READ_MULTI fan out in order */
+    bool acked = false, read = false;
+    for (;;) {
+        int32_t left = (int32_t)(deadline - osKernelGetTickCount());
+        if (left <= 0) return EX_FAILED;
+        osThreadFlagsWait(MBOX_FLAG_ACK(SIM_VARS) | MBOX_FLAG_DATA(SIM_VARS), osFlagsWaitAny, (uint32_t)left);
+        mbox_read_ack(SIM_VARS, &m);
+        if (m.seq != ack0.seq && m.value == pairs[SIM_VARS - 1].value) acked = true;
+        mbox_read_data(SIM_VARS, &m);
+        if (m.seq != dat0.seq) read = true;
+        if (acked && read) break;
+    }
+    *us = (sim_mono() - t0) * 1e6;
+
+    ExResult r = EX_OK;
+    for (uint8_t i = 0; i < SIM_VARS; i++) {
+        mbox_read_data(ids[i], &m);
+        if (m.value == pairs[i].value) continue;
+        if (sim_corrupt(m.value, n, ids[i])) corrupt++;
+        r = EX_STALE;                   // write retried after the read was answered
+    }
+    return r;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s <tty> <seconds> <seed> <uart_err_ppm>\n", argv[0]);
+        return 2;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    SystemCoreClock = 168000000u;
+    shim_uart_seed = (uint32_t)strtoul(argv[3], NULL, 0) * 2u;
+    shim_uart_error_ppm = (uint32_t)strtoul(argv[4], NULL, 0);
+    huart2.Init.BaudRate = 115200u;
+    if (shim_uart_open(&huart2, &hdma_usart2_rx, argv[1]) != 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    double seconds = strtod(argv[2], NULL), end = sim_elapsed() + seconds;
+
+    UartMaster_StartTasks(&huart2);
+    mbox_subscribe(MBOX_FLAG_ACK(SIM_VARS) | MBOX_FLAG_DATA(SIM_VARS));
+
+    uint32_t n = 0, ok = 0, stale = 0, failed = 0, rate = 0;
+    uint8_t version = 0;
+    bool down = false;
+    while (sim_elapsed() < end) {
+        double us = 0;
+        ExResult r = exchange(++n, &us);
+        if (r == EX_FAILED) {
+            failed++;
+            down = true;
+        } else {
+            uint32_t b = (uint32_t)us / EX_BUCKET_US;
+            ex_hist[(b < EX_BUCKETS) ? b : EX_BUCKETS - 1u]++;
+            if (r == EX_OK) ok++; else stale++;
+            if (down) printf("recover %.6f\n", sim_mono());
+            down = false;
+        }
+
+        uint16_t fallbacks;
+        uint32_t now_rate = master_link_baud(&fallbacks);
+        if (now_rate != rate || master_link_version() != version) {
+            rate = now_rate;
+            version = master_link_version();
+            printf("master %8.3f s  framing v%u, %lu baud, %u fallbacks\n", sim_elapsed(), version,
+                   (unsigned long)rate, fallbacks);
+        }
+    }
+
+    LinkStats s;
+    CycleStats c;
+    VarMailbox notify;
+    uint8_t queued, high;
+    uint16_t dropped, fallbacks;
+    master_link_get_stats(&s);
+    master_link_get_cycle_stats(&c);
+    master_link_tx_stats(&queued, &high, &dropped);
+    mbox_read_data(10, &notify);
+    rate = master_link_baud(&fallbacks);
+    printf("master: framing v%u, %lu baud, %u fallbacks\n", master_link_version(), (unsigned long)rate, fallbacks);
+    printf("master: exchanges %lu: ok %lu, stale read %lu, failed %lu; corrupt values %lu\n",
+           (unsigned long)n, (unsigned long)ok, (unsigned long)stale, (unsigned long)failed, (unsigned long)corrupt);
+    printf("master: throughput %.1f exchanges/s, %.0f registers/s; uart rx %lu B, tx %lu B, framing errors %lu\n",
+           (ok + stale) / seconds, (ok + stale) * 2.0 * SIM_VARS / seconds, (unsigned long)shim_uart.rx_bytes,
+           (unsigned long)shim_uart.tx_bytes, (unsigned long)shim_uart.errors);
+    printf("master: exchange time p50 <%lu us, p90 <%lu us, p99 <%lu us, p99.9 <%lu us\n",
+           (unsigned long)sim_hist_pct(ex_hist, EX_BUCKETS, EX_BUCKET_US, 0.50),
+           (unsigned long)sim_hist_pct(ex_hist, EX_BUCKETS, EX_BUCKET_US, 0.90),
+           (unsigned long)sim_hist_pct(ex_hist, EX_BUCKETS, EX_BUCKET_US, 0.99),
+           (unsigned long)sim_hist_pct(ex_hist, EX_BUCKETS, EX_BUCKET_US, 0.999));
+    sim_print_link_stats("master", &s);
+    printf("master: master_on_timeout() %lu calls; tx queue high water %u, dropped %u\n",
+           (unsigned long)timeouts_reported, high, dropped);
+    printf("master: PD markers %lu, missed %lu, period %lu us; NOTIFY updates of register 10: %lu\n",
+           (unsigned long)c.cycles, (unsigned long)c.missed, (unsigned long)c.period_us, (unsigned long)notify.seq);
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Slave side of the link simulator: the M40's slave_link.c and protocol.c
+ * on a tty, driven the way main() drives them on the H7. The main loop
+ * polls the link; every SIM_PD_CYCLE_MS a simulated Profinet PD cycle
+ * changes the NOTIFY registers, syncs them and sends the cycle marker.
+ *
+ *   sim_slave <tty> <seconds> <seed> <uart_err_ppm>
+ *
+ * Prints the slave's link counters on exit. Started by linksim.
+ */
+#include "slave_link.h"
+#include "protocol.h"
+#include "uart_pty.h"
+#include "sim_common.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+UART_HandleTypeDef huart2;
+static DMA_HandleTypeDef hdma_usart2_rx;
+
+/* Registers the PD cycle pushes to the master (CMD_NOTIFY) */
+#define SIM_NOTIFY_FIRST 10u
+#define SIM_NOTIFY_COUNT 3u
+
+/* main.c keeps the application hooks; the stored value is all the link needs */
+void slave_on_write(uint8_t var_id, uint16_t value) { (void)var_id; (void)value; }
+void slave_on_read(uint8_t var_id) { (void)var_id; }
+
+void DEBUG_Printf(const char *fmt, ...) {
+    char line[160];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    line[strcspn(line, "\r\n")] = 0;
+    printf("slave  %8.3f s  %s\n", sim_elapsed(), line);
+}
+
+static void pd_cycle(uint32_t n) {
+    /* One register every cycle, all of them every 8th: NOTIFY and NOTIFY_MULTI */
+    slave_set_reg(SIM_NOTIFY_FIRST, (uint16_t)n);
+    if (n % 8u == 0)
+        for (uint8_t i = 1; i < SIM_NOTIFY_COUNT; i++) slave_set_reg((uint8_t)(SIM_NOTIFY_FIRST + i), (uint16_t)(n + i));
+    slave_sync();
+    slave_cycle_mark();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s <tty> <seconds> <seed> <uart_err_ppm>\n", argv[0]);
+        return 2;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    SystemCoreClock = 64000000u;            // HSI, as the H7 board runs
+    shim_uart_seed = (uint32_t)strtoul(argv[3], NULL, 0) * 2u + 1u;
+    shim_uart_error_ppm = (uint32_t)strtoul(argv[4], NULL, 0);
+    huart2.Init.BaudRate = 115200u;
+    if (shim_uart_open(&huart2, &hdma_usart2_rx, argv[1]) != 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    double end = sim_elapsed() + strtod(argv[2], NULL);
+
+    slave_link_start();
+    uint32_t next_pd = HAL_GetTick() + SIM_PD_CYCLE_MS, cycles = 0;
+    while (sim_elapsed() < end) {
+        slave_link_poll();
+        if ((int32_t)(HAL_GetTick() - next_pd) >= 0) {
+            next_pd += SIM_PD_CYCLE_MS;
+            pd_cycle(++cycles);
+        }
+        sim_sleep_us(SIM_POLL_US);      // the H7 main loop spins; leave the CPU to the master
+    }
+
+    uint8_t queued, high;
+    uint16_t dropped;
+    slave_link_tx_stats(&queued, &high, &dropped);
+    printf("slave: framing v%u, %lu baud, %lu PD cycles\n", slave_link_version(),
+           (unsigned long)slave_link_baud(), (unsigned long)cycles);
+    sim_print_link_stats("slave", &link_stats);
+    printf("slave: tx queue high water %u, dropped %u; uart rx %lu B, lost while stopped %lu B, tx %lu B, framing errors %lu\n",
+           high, dropped, (unsigned long)shim_uart.rx_bytes, (unsigned long)shim_uart.rx_lost,
+           (unsigned long)shim_uart.tx_bytes, (unsigned long)shim_uart.errors);
+    return 0;
+}
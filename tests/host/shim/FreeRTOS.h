@@ -0,0 +1,2 @@
+#pragma once
+/* Included by the firmware for configASSERT and friends; nothing is needed on a host */
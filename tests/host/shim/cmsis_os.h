@@ -0,0 +1,2 @@
+#pragma once
+#include "cmsis_os2.h"
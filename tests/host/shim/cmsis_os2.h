@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * The CMSIS-RTOS2 calls the firmware modules make, with the real
+ * signatures. Two implementations exist:
+ *  - rtos_stub.c:  single thread, simulated clock that the test advances
+ *  - rtos_posix.c: one pthread per osThreadNew(), wall-clock ticks
+ */
+
+typedef void *osThreadId_t;
+typedef void *osMutexId_t;
+typedef void *osMessageQueueId_t;
+typedef void *osEventFlagsId_t;
+typedef void *osTimerId_t;
+typedef void (*osThreadFunc_t)(void *argument);
+
+typedef enum {
+    osOK = 0,
+    osError = -1,
+    osErrorTimeout = -2,
+    osErrorResource = -3,
+    osErrorParameter = -4,
+} osStatus_t;
+
+typedef enum {
+    osPriorityIdle = 1,
+    osPriorityLow = 8,
+    osPriorityBelowNormal = 16,
+    osPriorityNormal = 24,
+    osPriorityAboveNormal = 32,
+    osPriorityHigh = 40,
+    osPriorityRealtime = 48,
+} osPriority_t;
+
+typedef struct {
+    const char  *name;
+    uint32_t     attr_bits;
+    void        *cb_mem;
+    uint32_t     cb_size;
+    void        *stack_mem;
+    uint32_t     stack_size;
+    osPriority_t priority;
+} osThreadAttr_t;
+
+#define osWaitForever       0xFFFFFFFFu
+#define osFlagsWaitAny      0x00000000u
+#define osFlagsWaitAll      0x00000001u
+#define osFlagsNoClear      0x00000002u
+#define osFlagsError        0x80000000u
+#define osFlagsErrorTimeout 0xFFFFFFFEu
+
+uint32_t osKernelGetTickCount(void);
+uint32_t osKernelGetTickFreq(void);
+osStatus_t osDelay(uint32_t ticks);
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr);
+osThreadId_t osThreadGetId(void);
+void osThreadExit(void);
+uint32_t osThreadFlagsSet(osThreadId_t thread, uint32_t flags);
+uint32_t osThreadFlagsClear(uint32_t flags);
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout);
+
+osMutexId_t osMutexNew(const void *attr);
+osStatus_t osMutexAcquire(osMutexId_t m, uint32_t timeout);
+osStatus_t osMutexRelease(osMutexId_t m);
+
+osMessageQueueId_t osMessageQueueNew(uint32_t count, uint32_t size, const void *attr);
+osStatus_t osMessageQueuePut(osMessageQueueId_t q, const void *msg, uint8_t prio, uint32_t timeout);
+osStatus_t osMessageQueueGet(osMessageQueueId_t q, void *msg, uint8_t *prio, uint32_t timeout);
+uint32_t osMessageQueueGetCount(osMessageQueueId_t q);
+
+osEventFlagsId_t osEventFlagsNew(const void *attr);
+uint32_t osEventFlagsSet(osEventFlagsId_t ef, uint32_t flags);
+uint32_t osEventFlagsWait(osEventFlagsId_t ef, uint32_t flags, uint32_t options, uint32_t timeout);
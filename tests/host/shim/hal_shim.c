@@ -0,0 +1,23 @@
+/*
+ * Register blocks and GPIO calls of hal_shim.h. Ticks live with the RTOS
+ * implementation (rtos_stub.c / rtos_posix.c) so HAL and kernel agree.
+ */
+#include "hal_shim.h"
+
+uint32_t SystemCoreClock = 168000000u;
+DWT_Type shimDWT;
+CoreDebug_Type shimCoreDebug;
+GPIO_TypeDef shimGPIO[11];
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin) {
+    return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState s) {
+    if (s) port->ODR |= pin;
+    else   port->ODR &= ~(uint32_t)pin;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin) {
+    port->ODR ^= pin;
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Host stand-in for the parts of the STM32 HAL and CMSIS-Core that the
+ * firmware modules under test use. stm32f4xx_hal.h and stm32h7xx_hal.h
+ * both resolve here, so a module compiles unchanged for either board.
+ *
+ * Register blocks are plain structs in RAM; a test sets IDR, NDTR or
+ * CYCCNT directly to play the hardware. Everything that has behaviour
+ * (UART, DMA, ticks) is implemented in hal_shim.c.
+ */
+
+typedef enum { HAL_OK = 0, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+#define HAL_MAX_DELAY   0xFFFFFFFFu
+
+/* ---- Core ---- */
+extern uint32_t SystemCoreClock;
+
+#ifdef SHIM_POSIX
+/* rtos_posix.c: interrupt masking is one process-wide lock that the
+ * simulated ISRs (shim/uart_pty.c) also take, so a critical section
+ * excludes them as on the target */
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t m);
+void __disable_irq(void);
+void __enable_irq(void);
+#else
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t m) { (void)m; }
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+#endif
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __NOP(void) {}
+
+typedef struct { volatile uint32_t CTRL, CYCCNT, LAR; } DWT_Type;
+typedef struct { volatile uint32_t DEMCR; } CoreDebug_Type;
+extern DWT_Type shimDWT;
+extern CoreDebug_Type shimCoreDebug;
+#ifdef SHIM_POSIX
+/* CYCCNT runs from the monotonic clock at SystemCoreClock */
+DWT_Type *shim_dwt(void);
+#define DWT         (shim_dwt())
+#else
+#define DWT         (&shimDWT)
+#endif
+#define CoreDebug   (&shimCoreDebug)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk      1UL
+
+/* H7 D-cache maintenance: nothing to do on a host */
+static inline void SCB_CleanDCache_by_Addr(void *a, int32_t n) { (void)a; (void)n; }
+static inline void SCB_InvalidateDCache_by_Addr(void *a, int32_t n) { (void)a; (void)n; }
+
+uint32_t HAL_GetTick(void);
+void     HAL_Delay(uint32_t ms);
+
+/* ---- GPIO ---- */
+typedef struct {
+    volatile uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+extern GPIO_TypeDef shimGPIO[11];
+#define GPIOA (&shimGPIO[0])
+#define GPIOB (&shimGPIO[1])
+#define GPIOC (&shimGPIO[2])
+#define GPIOD (&shimGPIO[3])
+#define GPIOE (&shimGPIO[4])
+#define GPIOF (&shimGPIO[5])
+#define GPIOG (&shimGPIO[6])
+#define GPIOH (&shimGPIO[7])
+#define GPIOI (&shimGPIO[8])
+#define GPIOJ (&shimGPIO[9])
+#define GPIOK (&shimGPIO[10])
+
+#define GPIO_PIN_0  0x0001u
+#define GPIO_PIN_1  0x0002u
+#define GPIO_PIN_2  0x0004u
+#define GPIO_PIN_3  0x0008u
+#define GPIO_PIN_4  0x0010u
+#define GPIO_PIN_5  0x0020u
+#define GPIO_PIN_6  0x0040u
+#define GPIO_PIN_7  0x0080u
+#define GPIO_PIN_8  0x0100u
+#define GPIO_PIN_9  0x0200u
+#define GPIO_PIN_10 0x0400u
+#define GPIO_PIN_11 0x0800u
+#define GPIO_PIN_12 0x1000u
+#define GPIO_PIN_13 0x2000u
+#define GPIO_PIN_14 0x4000u
+#define GPIO_PIN_15 0x8000u
+
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState s);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin);
+
+/* ---- UART + DMA ----
+ * Only the fields and calls master_link.c / slave_link.c use. shim/uart_pty.c
+ * backs a handle with a pseudo-terminal: HAL_UARTEx_ReceiveToIdle_DMA() fills
+ * the buffer from the tty and raises HT / TC / idle events, transmit paces
+ * the bytes at Init.BaudRate and then calls HAL_UART_TxCpltCallback(). */
+#define DMA_NORMAL              0x00000000u
+#define DMA_CIRCULAR            0x00000100u
+#define DMA_IT_TC               0x00000010u
+#define DMA_IT_HT               0x00000008u
+
+typedef struct { uint32_t Mode; } DMA_InitTypeDef;
+
+typedef struct {
+    DMA_InitTypeDef   Init;
+    volatile uint32_t NDTR;         // items left, as the stream's counter register
+    volatile uint32_t ITDisabled;   // DMA_IT_* masked by __HAL_DMA_DISABLE_IT()
+} DMA_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER(h)        ((h)->NDTR)
+#define __HAL_DMA_DISABLE_IT(h, it)     ((h)->ITDisabled |= (it))
+#define __HAL_DMA_ENABLE_IT(h, it)      ((h)->ITDisabled &= ~(uint32_t)(it))
+
+#define HAL_UART_ERROR_NONE     0x00u
+#define HAL_UART_ERROR_PE       0x01u
+#define HAL_UART_ERROR_NE       0x02u
+#define HAL_UART_ERROR_FE       0x04u
+#define HAL_UART_ERROR_ORE      0x08u
+
+typedef enum {
+    HAL_UART_STATE_RESET   = 0x00u,
+    HAL_UART_STATE_READY   = 0x20u,
+    HAL_UART_STATE_BUSY_TX = 0x21u,
+    HAL_UART_STATE_BUSY_RX = 0x22u,
+} HAL_UART_StateTypeDef;
+
+typedef struct { uint32_t BaudRate; } UART_InitTypeDef;
+
+typedef struct {
+    UART_InitTypeDef      Init;
+    DMA_HandleTypeDef    *hdmarx;
+    DMA_HandleTypeDef    *hdmatx;
+    volatile uint32_t     gState;   // TX side
+    volatile uint32_t     RxState;
+    volatile uint32_t     ErrorCode;
+    void                 *shim;     // uart_pty.c port state
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *buf, uint16_t size);
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+
+/* Implemented by the firmware module under test */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
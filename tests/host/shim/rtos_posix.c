@@ -0,0 +1,325 @@
+/*
+ * CMSIS-RTOS2 on pthreads, for the link simulator (linksim/).
+ *
+ * Every osThreadNew() is a real thread and ticks are wall-clock
+ * milliseconds since start-up, so the firmware's timeouts, retries and
+ * baud-rate holds run in real time. Interrupt masking (__disable_irq and
+ * the PRIMASK calls) is one process-wide lock with a per-thread nesting
+ * state; the simulated ISRs in uart_pty.c take the same lock, so a
+ * critical section keeps them out exactly as on the target.
+ *
+ * Build with -DSHIM_POSIX so hal_shim.h routes PRIMASK and DWT here.
+ */
+#include "cmsis_os2.h"
+#include "hal_shim.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+/* ---- clock ---- */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t t_start;
+
+__attribute__((constructor)) static void clock_init(void) { t_start = now_ns(); }
+
+uint32_t osKernelGetTickCount(void) { return (uint32_t)((now_ns() - t_start) / 1000000u); }
+uint32_t osKernelGetTickFreq(void)  { return 1000u; }
+uint32_t HAL_GetTick(void)          { return osKernelGetTickCount(); }
+
+static void sleep_ns(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000u), (long)(ns % 1000000000u) };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+void HAL_Delay(uint32_t ms) { sleep_ns((uint64_t)ms * 1000000u); }
+
+osStatus_t osDelay(uint32_t ticks) {
+    sleep_ns((uint64_t)ticks * 1000000u);
+    return osOK;
+}
+
+DWT_Type *shim_dwt(void) {
+    /* Whole seconds apart: ns * SystemCoreClock overflows 64 bits after ~100 s */
+    uint64_t ns = now_ns() - t_start;
+    shimDWT.CYCCNT = (uint32_t)(ns / 1000000000u * SystemCoreClock + ns % 1000000000u * SystemCoreClock / 1000000000u);
+    return &shimDWT;
+}
+
+/* Absolute CLOCK_MONOTONIC deadline for a timeout in ticks */
+static struct timespec deadline(uint32_t ticks) {
+    uint64_t t = now_ns() + (uint64_t)ticks * 1000000u;
+    struct timespec ts = { (time_t)(t / 1000000000u), (long)(t % 1000000000u) };
+    return ts;
+}
+
+static void cond_init(pthread_cond_t *c) {
+    pthread_condattr_t a;
+    pthread_condattr_init(&a);
+    pthread_condattr_setclock(&a, CLOCK_MONOTONIC);
+    pthread_cond_init(c, &a);
+    pthread_condattr_destroy(&a);
+}
+
+/* Wait on c until woken or the deadline passes; false on timeout */
+static bool cond_wait(pthread_cond_t *c, pthread_mutex_t *m, uint32_t timeout, const struct timespec *dl) {
+    if (timeout == osWaitForever) return pthread_cond_wait(c, m) == 0;
+    return pthread_cond_timedwait(c, m, dl) != ETIMEDOUT;
+}
+
+/* ---- interrupt masking ---- */
+
+static pthread_mutex_t irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread uint32_t primask;
+
+uint32_t __get_PRIMASK(void) { return primask; }
+
+void __disable_irq(void) {
+    if (primask) return;
+    pthread_mutex_lock(&irq_lock);
+    primask = 1;
+}
+
+void __enable_irq(void) {
+    if (!primask) return;
+    primask = 0;
+    pthread_mutex_unlock(&irq_lock);
+}
+
+void __set_PRIMASK(uint32_t m) {
+    if (m) __disable_irq();
+    else   __enable_irq();
+}
+
+/* ---- threads and thread flags ---- */
+
+typedef struct {
+    pthread_t       tid;
+    const char     *name;
+    osThreadFunc_t  func;
+    void           *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        flags;
+} PosixThread;
+
+static __thread PosixThread *self;
+
+static PosixThread *thread_alloc(const char *name) {
+    PosixThread *t = calloc(1, sizeof(*t));
+    t->name = name;
+    pthread_mutex_init(&t->lock, NULL);
+    cond_init(&t->cond);
+    return t;
+}
+
+static void *thread_entry(void *p) {
+    self = p;
+    self->func(self->arg);
+    return NULL;
+}
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr) {
+    PosixThread *t = thread_alloc(attr ? attr->name : NULL);
+    t->func = func;
+    t->arg  = argument;
+    if (pthread_create(&t->tid, NULL, thread_entry, t) != 0) {
+        free(t);
+        return NULL;
+    }
+    pthread_detach(t->tid);
+    return t;
+}
+
+osThreadId_t osThreadGetId(void) {
+    if (self == NULL) self = thread_alloc("main");   // a thread the kernel did not start
+    return self;
+}
+
+void osThreadExit(void) { pthread_exit(NULL); }
+
+uint32_t osThreadFlagsSet(osThreadId_t thread, uint32_t flags) {
+    PosixThread *t = thread;
+    if (t == NULL) return osFlagsError;
+    pthread_mutex_lock(&t->lock);
+    uint32_t now = (t->flags |= flags);
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return now;
+}
+
+uint32_t osThreadFlagsClear(uint32_t flags) {
+    PosixThread *t = osThreadGetId();
+    pthread_mutex_lock(&t->lock);
+    uint32_t old = t->flags;
+    t->flags &= ~flags;
+    pthread_mutex_unlock(&t->lock);
+    return old;
+}
+
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout) {
+    PosixThread *t = osThreadGetId();
+    struct timespec dl = deadline(timeout);
+    uint32_t got;
+    pthread_mutex_lock(&t->lock);
+    for (;;) {
+        got = t->flags & flags;
+        if ((options & osFlagsWaitAll) ? (got == flags) : (got != 0)) break;
+        if (timeout == 0 || !cond_wait(&t->cond, &t->lock, timeout, &dl)) {
+            pthread_mutex_unlock(&t->lock);
+            return osFlagsErrorTimeout;
+        }
+    }
+    if (!(options & osFlagsNoClear)) t->flags &= ~got;
+    pthread_mutex_unlock(&t->lock);
+    return got;
+}
+
+/* ---- mutexes ---- */
+
+osMutexId_t osMutexNew(const void *attr) {
+    pthread_mutexattr_t a;
+    pthread_mutex_t *m = malloc(sizeof(*m));
+    (void)attr;
+    pthread_mutexattr_init(&a);
+    pthread_mutexattr_settype(&a, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(m, &a);
+    pthread_mutexattr_destroy(&a);
+    return m;
+}
+
+osStatus_t osMutexAcquire(osMutexId_t m, uint32_t timeout) {
+    if (m == NULL) return osErrorParameter;
+    if (timeout == osWaitForever) return pthread_mutex_lock(m) ? osError : osOK;
+    if (timeout == 0) return pthread_mutex_trylock(m) ? osErrorResource : osOK;
+    struct timespec dl;
+    clock_gettime(CLOCK_REALTIME, &dl);     // pthread_mutex_timedlock() runs on CLOCK_REALTIME
+    uint64_t t = (uint64_t)dl.tv_nsec + (uint64_t)timeout * 1000000u;
+    dl.tv_sec += (time_t)(t / 1000000000u);
+    dl.tv_nsec = (long)(t % 1000000000u);
+    return pthread_mutex_timedlock(m, &dl) ? osErrorTimeout : osOK;
+}
+
+osStatus_t osMutexRelease(osMutexId_t m) {
+    if (m == NULL) return osErrorParameter;
+    return pthread_mutex_unlock(m) ? osErrorResource : osOK;
+}
+
+/* ---- message queues ---- */
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        count, size, head, n;
+    uint8_t        *buf;
+} PosixQueue;
+
+osMessageQueueId_t osMessageQueueNew(uint32_t count, uint32_t size, const void *attr) {
+    PosixQueue *q = calloc(1, sizeof(*q));
+    (void)attr;
+    pthread_mutex_init(&q->lock, NULL);
+    cond_init(&q->cond);
+    q->count = count;
+    q->size  = size;
+    q->buf   = calloc(count, size);
+    return q;
+}
+
+osStatus_t osMessageQueuePut(osMessageQueueId_t id, const void *msg, uint8_t prio, uint32_t timeout) {
+    PosixQueue *q = id;
+    struct timespec dl = deadline(timeout);
+    (void)prio;
+    if (q == NULL) return osErrorParameter;
+    pthread_mutex_lock(&q->lock);
+    while (q->n == q->count) {
+        if (timeout == 0 || !cond_wait(&q->cond, &q->lock, timeout, &dl)) {
+            pthread_mutex_unlock(&q->lock);
+            return timeout ? osErrorTimeout : osErrorResource;
+        }
+    }
+    memcpy(q->buf + ((q->head + q->n) % q->count) * q->size, msg, q->size);
+    q->n++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    return osOK;
+}
+
+osStatus_t osMessageQueueGet(osMessageQueueId_t id, void *msg, uint8_t *prio, uint32_t timeout) {
+    PosixQueue *q = id;
+    struct timespec dl = deadline(timeout);
+    if (q == NULL) return osErrorParameter;
+    pthread_mutex_lock(&q->lock);
+    while (q->n == 0) {
+        if (timeout == 0 || !cond_wait(&q->cond, &q->lock, timeout, &dl)) {
+            pthread_mutex_unlock(&q->lock);
+            return timeout ? osErrorTimeout : osErrorResource;
+        }
+    }
+    memcpy(msg, q->buf + q->head * q->size, q->size);
+    q->head = (q->head + 1) % q->count;
+    q->n--;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    if (prio) *prio = 0;
+    return osOK;
+}
+
+uint32_t osMessageQueueGetCount(osMessageQueueId_t id) {
+    PosixQueue *q = id;
+    if (q == NULL) return 0;
+    pthread_mutex_lock(&q->lock);
+    uint32_t n = q->n;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+/* ---- event flags ---- */
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        flags;
+} PosixEvents;
+
+osEventFlagsId_t osEventFlagsNew(const void *attr) {
+    PosixEvents *e = calloc(1, sizeof(*e));
+    (void)attr;
+    pthread_mutex_init(&e->lock, NULL);
+    cond_init(&e->cond);
+    return e;
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t ef, uint32_t flags) {
+    PosixEvents *e = ef;
+    pthread_mutex_lock(&e->lock);
+    uint32_t now = (e->flags |= flags);
+    pthread_cond_broadcast(&e->cond);
+    pthread_mutex_unlock(&e->lock);
+    return now;
+}
+
+uint32_t osEventFlagsWait(osEventFlagsId_t ef, uint32_t flags, uint32_t options, uint32_t timeout) {
+    PosixEvents *e = ef;
+    struct timespec dl = deadline(timeout);
+    uint32_t got;
+    pthread_mutex_lock(&e->lock);
+    for (;;) {
+        got = e->flags & flags;
+        if ((options & osFlagsWaitAll) ? (got == flags) : (got != 0)) break;
+        if (timeout == 0 || !cond_wait(&e->cond, &e->lock, timeout, &dl)) {
+            pthread_mutex_unlock(&e->lock);
+            return osFlagsErrorTimeout;
+        }
+    }
+    if (!(options & osFlagsNoClear)) e->flags &= ~got;
+    pthread_mutex_unlock(&e->lock);
+    return got;
+}
@@ -0,0 +1,142 @@
+/*
+ * Single-threaded CMSIS-RTOS2 stand-in for unit tests.
+ *
+ * Time only moves when the test (or a blocking call) moves it: shim_tick is
+ * the kernel tick in ms and HAL_GetTick() returns the same value. A wait
+ * that cannot be satisfied advances the clock by its timeout and fails, so
+ * code under test never hangs. Thread flags are kept per osThreadId_t; the
+ * caller is always the "current" thread unless the test switches it.
+ */
+#include "cmsis_os2.h"
+#include "rtos_stub.h"
+#include <stdlib.h>
+#include <string.h>
+
+uint32_t shim_tick;
+int shim_queue_fail;
+
+static ShimThread main_thread = { .name = "main" };
+ShimThread *shim_current = &main_thread;
+
+uint32_t osKernelGetTickCount(void) { return shim_tick; }
+uint32_t HAL_GetTick(void)          { return shim_tick; }
+void     HAL_Delay(uint32_t ms)     { shim_tick += ms; }
+uint32_t osKernelGetTickFreq(void)  { return 1000u; }
+
+osStatus_t osDelay(uint32_t ticks) {
+    shim_tick += ticks;
+    return osOK;
+}
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr) {
+    (void)func; (void)argument;
+    ShimThread *t = calloc(1, sizeof(*t));
+    t->name = attr ? attr->name : NULL;
+    return t;       // never runs: tests call the task body's pieces directly
+}
+
+osThreadId_t osThreadGetId(void) { return shim_current; }
+void osThreadExit(void) { abort(); }
+
+uint32_t osThreadFlagsSet(osThreadId_t thread, uint32_t flags) {
+    ShimThread *t = thread;
+    if (t == NULL) return osFlagsError;
+    t->flags |= flags;
+    t->sets++;
+    return t->flags;
+}
+
+uint32_t osThreadFlagsClear(uint32_t flags) {
+    uint32_t old = shim_current->flags;
+    shim_current->flags &= ~flags;
+    return old;
+}
+
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout) {
+    uint32_t got = shim_current->flags & flags;
+    bool ok = (options & osFlagsWaitAll) ? (got == flags) : (got != 0);
+    if (!ok) {
+        if (timeout != osWaitForever) shim_tick += timeout;
+        return osFlagsErrorTimeout;
+    }
+    if (!(options & osFlagsNoClear)) shim_current->flags &= ~got;
+    return got;
+}
+
+/* Mutexes: one thread, nothing to exclude; count holds to catch imbalance */
+osMutexId_t osMutexNew(const void *attr) {
+    (void)attr;
+    return calloc(1, sizeof(int));
+}
+osStatus_t osMutexAcquire(osMutexId_t m, uint32_t timeout) {
+    (void)timeout;
+    ++*(int *)m;
+    return osOK;
+}
+osStatus_t osMutexRelease(osMutexId_t m) {
+    return (--*(int *)m < 0) ? osErrorResource : osOK;
+}
+
+typedef struct {
+    uint32_t count, size, head, n;
+    uint8_t *buf;
+} StubQueue;
+
+osMessageQueueId_t osMessageQueueNew(uint32_t count, uint32_t size, const void *attr) {
+    (void)attr;
+    StubQueue *q = calloc(1, sizeof(*q));
+    q->count = count;
+    q->size  = size;
+    q->buf   = calloc(count, size);
+    return q;
+}
+
+osStatus_t osMessageQueuePut(osMessageQueueId_t id, const void *msg, uint8_t prio, uint32_t timeout) {
+    StubQueue *q = id;
+    (void)prio;
+    if (q == NULL) return osErrorParameter;
+    if (shim_queue_fail > 0) { shim_queue_fail--; return osErrorResource; }
+    if (q->n == q->count) {
+        if (timeout != 0 && timeout != osWaitForever) shim_tick += timeout;
+        return timeout ? osErrorTimeout : osErrorResource;
+    }
+    memcpy(q->buf + ((q->head + q->n) % q->count) * q->size, msg, q->size);
+    q->n++;
+    return osOK;
+}
+
+osStatus_t osMessageQueueGet(osMessageQueueId_t id, void *msg, uint8_t *prio, uint32_t timeout) {
+    StubQueue *q = id;
+    if (q == NULL) return osErrorParameter;
+    if (q->n == 0) {
+        if (timeout != 0 && timeout != osWaitForever) shim_tick += timeout;
+        return timeout ? osErrorTimeout : osErrorResource;
+    }
+    memcpy(msg, q->buf + q->head * q->size, q->size);
+    q->head = (q->head + 1) % q->count;
+    q->n--;
+    if (prio) *prio = 0;
+    return osOK;
+}
+
+uint32_t osMessageQueueGetCount(osMessageQueueId_t id) {
+    return id ? ((StubQueue *)id)->n : 0;
+}
+
+osEventFlagsId_t osEventFlagsNew(const void *attr) {
+    (void)attr;
+    return calloc(1, sizeof(uint32_t));
+}
+uint32_t osEventFlagsSet(osEventFlagsId_t ef, uint32_t flags) {
+    return *(uint32_t *)ef |= flags;
+}
+uint32_t osEventFlagsWait(osEventFlagsId_t ef, uint32_t flags, uint32_t options, uint32_t timeout) {
+    uint32_t *f = ef, got = *f & flags;
+    (void)options;
+    if (!got) {
+        if (timeout != osWaitForever) shim_tick += timeout;
+        return osFlagsErrorTimeout;
+    }
+    *f &= ~got;
+    return got;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Test-side view of rtos_stub.c */
+typedef struct {
+    const char *name;
+    uint32_t    flags;      // pending thread flags
+    uint32_t    sets;       // osThreadFlagsSet() calls on this thread
+} ShimThread;
+
+extern uint32_t    shim_tick;         // kernel tick (ms); tests advance it
+extern ShimThread *shim_current;      // thread osThreadGetId() returns
+extern int         shim_queue_fail;   // make the next N osMessageQueuePut() fail
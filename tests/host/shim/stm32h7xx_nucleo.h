@@ -0,0 +1,2 @@
+#pragma once
+/* Nucleo BSP: nothing the modules under test use */
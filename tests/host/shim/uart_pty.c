@@ -0,0 +1,295 @@
+/*
+ * UART + RX DMA on a tty, for the link simulator. Needs rtos_posix.c.
+ *
+ * RX thread: reads the tty and plays the DMA stream and the USART. Bytes go
+ * into the buffer given to HAL_UARTEx_ReceiveToIdle_DMA() while NDTR counts
+ * down; HAL_UARTEx_RxEventCallback() runs at half and full buffer and when
+ * the line has been quiet for UART_IDLE_MS. In DMA_CIRCULAR mode the stream
+ * wraps, otherwise it stops at the end like a normal-mode transfer.
+ * An injected framing error ends reception the way the HAL does for DMA
+ * transfers (RxState back to READY), then calls HAL_UART_ErrorCallback().
+ *
+ * TX thread: HAL_UART_Transmit_DMA() hands the frame over; the thread waits
+ * the frame's time on the wire at Init.BaudRate (10 bits per byte), writes
+ * it and calls HAL_UART_TxCpltCallback(). HAL_UART_Abort() cancels it.
+ *
+ * HAL_UART_Init() sets the tty speed, so the relay on the other end of a
+ * pseudo-terminal sees the rate and can garble bytes across a mismatch.
+ *
+ * Callbacks run with interrupts masked (rtos_posix.c), as ISRs.
+ */
+#include "uart_pty.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define UART_IDLE_MS  1         // quiet time that raises the idle event
+#define UART_TX_MAX   256u
+
+uint32_t shim_uart_error_ppm;
+uint32_t shim_uart_seed = 1;
+ShimUartCounters shim_uart;
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    int fd;
+    uint32_t seed;
+
+    /* RX DMA stream: interrupts masked */
+    uint8_t *rx_buf;
+    uint16_t rx_size;
+    uint16_t rx_pos;
+    uint16_t rx_since_event;    // bytes since the last RX event, for the idle event
+    bool     rx_armed;
+    bool     rx_circular;
+
+    /* TX: job handed to the TX thread under tx_lock; tx_gen under masked interrupts */
+    pthread_mutex_t tx_lock;
+    pthread_cond_t  tx_cond;
+    uint8_t  tx_buf[UART_TX_MAX];
+    uint16_t tx_len;
+    bool     tx_job;
+    uint32_t tx_job_gen;
+    uint32_t tx_gen;            // bumped by HAL_UART_Abort(): a transfer in flight is dropped
+} PtyUart;
+
+static uint32_t rand_next(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return *s = x;
+}
+
+static speed_t tty_speed(uint32_t rate) {
+    switch (rate) {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        case 3000000: return B3000000;
+        default:      return B0;
+    }
+}
+
+/* ---- RX ---- */
+
+static void rx_event(PtyUart *u, uint16_t size) {
+    u->rx_since_event = 0;
+    HAL_UARTEx_RxEventCallback(u->huart, size);
+}
+
+/* DMA stores one byte; interrupts masked */
+static void rx_byte(PtyUart *u, uint8_t b) {
+    UART_HandleTypeDef *h = u->huart;
+    if (!u->rx_armed) {
+        shim_uart.rx_lost++;
+        return;
+    }
+    if (shim_uart_error_ppm && rand_next(&u->seed) % 1000000u < shim_uart_error_ppm) {
+        shim_uart.errors++;
+        u->rx_armed = false;                    // HAL ends a DMA reception on FE/NE/ORE
+        h->RxState = HAL_UART_STATE_READY;
+        h->ErrorCode = HAL_UART_ERROR_FE;
+        HAL_UART_ErrorCallback(h);
+        return;
+    }
+    u->rx_buf[u->rx_pos++] = b;
+    u->rx_since_event++;
+    shim_uart.rx_bytes++;
+    h->hdmarx->NDTR = (uint32_t)(u->rx_size - u->rx_pos);
+
+    if (u->rx_pos == u->rx_size / 2u && !(h->hdmarx->ITDisabled & DMA_IT_HT)) {
+        rx_event(u, u->rx_pos);
+    } else if (u->rx_pos == u->rx_size) {
+        if (u->rx_circular) {
+            u->rx_pos = 0;
+            h->hdmarx->NDTR = u->rx_size;       // reloaded before TC is serviced
+        } else {
+            u->rx_armed = false;
+            h->RxState = HAL_UART_STATE_READY;
+        }
+        rx_event(u, u->rx_size);
+    }
+}
+
+static void *rx_thread(void *arg) {
+    PtyUart *u = arg;
+    uint8_t in[256];
+    for (;;) {
+        struct pollfd p = { .fd = u->fd, .events = POLLIN };
+        ssize_t n = 0;
+        if (poll(&p, 1, UART_IDLE_MS) > 0) {
+            n = read(u->fd, in, sizeof(in));
+            if (n <= 0) {                       // other end not open (yet): line idle
+                struct timespec ts = { 0, UART_IDLE_MS * 1000000L };
+                nanosleep(&ts, NULL);
+                continue;
+            }
+        }
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        for (ssize_t i = 0; i < n; i++) rx_byte(u, in[i]);
+        if (n == 0 && u->rx_armed && u->rx_since_event && u->rx_pos != 0) rx_event(u, u->rx_pos);
+        __set_PRIMASK(primask);
+    }
+    return NULL;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *buf, uint16_t size) {
+    PtyUart *u = huart->shim;
+    HAL_StatusTypeDef st = HAL_OK;
+    if (u == NULL || buf == NULL || size == 0) return HAL_ERROR;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (huart->RxState != HAL_UART_STATE_READY) {
+        st = HAL_BUSY;
+    } else {
+        u->rx_buf = buf;
+        u->rx_size = size;
+        u->rx_pos = 0;
+        u->rx_since_event = 0;
+        u->rx_circular = (huart->hdmarx->Init.Mode == DMA_CIRCULAR);
+        u->rx_armed = true;
+        huart->hdmarx->NDTR = size;
+        huart->hdmarx->ITDisabled = 0;          // HAL_DMA_Start_IT() enables HT and TC
+        huart->RxState = HAL_UART_STATE_BUSY_RX;
+        huart->ErrorCode = HAL_UART_ERROR_NONE;
+    }
+    __set_PRIMASK(primask);
+    return st;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) {
+    (void)hdma;
+    return HAL_OK;
+}
+
+/* ---- TX ---- */
+
+static void *tx_thread(void *arg) {
+    PtyUart *u = arg;
+    uint8_t buf[UART_TX_MAX];
+    for (;;) {
+        pthread_mutex_lock(&u->tx_lock);
+        while (!u->tx_job) pthread_cond_wait(&u->tx_cond, &u->tx_lock);
+        uint16_t len = u->tx_len;
+        uint32_t gen = u->tx_job_gen;
+        memcpy(buf, u->tx_buf, len);
+        u->tx_job = false;
+        pthread_mutex_unlock(&u->tx_lock);
+
+        /* Time on the wire: start bit, 8 data bits, stop bit */
+        uint32_t rate = u->huart->Init.BaudRate ? u->huart->Init.BaudRate : 115200u;
+        uint64_t ns = (uint64_t)len * 10u * 1000000000u / rate;
+        struct timespec ts = { (time_t)(ns / 1000000000u), (long)(ns % 1000000000u) };
+        nanosleep(&ts, NULL);
+
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (gen == u->tx_gen && u->huart->gState == HAL_UART_STATE_BUSY_TX) {
+            for (uint16_t off = 0; off < len;) {
+                ssize_t w = write(u->fd, buf + off, len - off);
+                if (w <= 0) break;              // no reader: the bytes are lost on the line
+                off = (uint16_t)(off + w);
+            }
+            shim_uart.tx_bytes += len;
+            u->huart->gState = HAL_UART_STATE_READY;
+            HAL_UART_TxCpltCallback(u->huart);
+        }
+        __set_PRIMASK(primask);
+    }
+    return NULL;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+    PtyUart *u = huart->shim;
+    HAL_StatusTypeDef st = HAL_OK;
+    if (u == NULL || data == NULL || size == 0 || size > UART_TX_MAX) return HAL_ERROR;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (huart->gState != HAL_UART_STATE_READY) {
+        st = HAL_BUSY;
+    } else {
+        huart->gState = HAL_UART_STATE_BUSY_TX;
+        pthread_mutex_lock(&u->tx_lock);
+        memcpy(u->tx_buf, data, size);
+        u->tx_len = size;
+        u->tx_job = true;
+        u->tx_job_gen = u->tx_gen;
+        pthread_cond_signal(&u->tx_cond);
+        pthread_mutex_unlock(&u->tx_lock);
+    }
+    __set_PRIMASK(primask);
+    return st;
+}
+
+/* ---- control ---- */
+
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart) {
+    PtyUart *u = huart->shim;
+    if (u == NULL) return HAL_ERROR;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    u->rx_armed = false;
+    u->tx_gen++;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    __set_PRIMASK(primask);
+    return HAL_OK;
+}
+
+static int tty_configure(int fd, uint32_t rate) {
+    struct termios t;
+    speed_t sp = tty_speed(rate);
+    if (sp == B0 || tcgetattr(fd, &t) != 0) return -1;
+    cfmakeraw(&t);
+    cfsetispeed(&t, sp);
+    cfsetospeed(&t, sp);
+    return tcsetattr(fd, TCSANOW, &t);
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+    PtyUart *u = huart->shim;
+    if (u == NULL || tty_configure(u->fd, huart->Init.BaudRate) != 0) return HAL_ERROR;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+int shim_uart_open(UART_HandleTypeDef *huart, DMA_HandleTypeDef *hdmarx, const char *path) {
+    static PtyUart port;        // one link per process
+    PtyUart *u = &port;
+    pthread_t t;
+
+    u->fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (u->fd < 0) return -1;
+    u->huart = huart;
+    u->seed = shim_uart_seed ? shim_uart_seed : 1u;
+    pthread_mutex_init(&u->tx_lock, NULL);
+    pthread_cond_init(&u->tx_cond, NULL);
+
+    huart->hdmarx = hdmarx;
+    huart->shim = u;
+    if (huart->Init.BaudRate == 0) huart->Init.BaudRate = 115200u;
+    if (HAL_UART_Init(huart) != HAL_OK) return -1;
+
+    if (pthread_create(&t, NULL, rx_thread, u) != 0) return -1;
+    pthread_detach(t);
+    if (pthread_create(&t, NULL, tx_thread, u) != 0) return -1;
+    pthread_detach(t);
+    return 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "hal_shim.h"
+
+/* Test-side view of uart_pty.c: a UART handle backed by a tty */
+extern uint32_t shim_uart_error_ppm;    // chance per received byte of a framing error, in 1e-6
+extern uint32_t shim_uart_seed;         // seeds the error draw; set before shim_uart_open()
+
+typedef struct {
+    uint32_t rx_bytes;                  // bytes the DMA stored
+    uint32_t rx_lost;                   // bytes that arrived while reception was stopped
+    uint32_t tx_bytes;
+    uint32_t errors;                    // injected framing errors
+} ShimUartCounters;
+extern ShimUartCounters shim_uart;
+
+/* Open the tty at path in raw mode and attach it to huart / hdmarx.
+ * Starts the RX and TX threads; returns 0 or -1 with errno set. */
+int shim_uart_open(UART_HandleTypeDef *huart, DMA_HandleTypeDef *hdmarx, const char *path);
@@ -0,0 +1,34 @@
+/*
+ * USB CDC device for host tests: CDC_Transmit_FS() appends to shim_usb_out
+ * and reports USBD_OK, or USBD_BUSY while shim_usb_busy is set. The
+ * completion callback is left to the test (UsbTxComplete()), so it can
+ * play a slow host.
+ */
+#include "usbd_cdc_if.h"
+#include "usb_shim.h"
+#include <string.h>
+
+USBD_HandleTypeDef hUsbDeviceFS = { USBD_STATE_CONFIGURED };
+
+uint8_t  shim_usb_out[1u << 16];
+uint32_t shim_usb_len;
+uint32_t shim_usb_packets;
+int      shim_usb_busy;
+
+uint8_t CDC_Transmit_FS(uint8_t *buf, uint16_t len) {
+    if (shim_usb_busy) return USBD_BUSY;
+    if (shim_usb_len + len <= sizeof(shim_usb_out)) {
+        memcpy(shim_usb_out + shim_usb_len, buf, len);
+        shim_usb_len += len;
+    }
+    shim_usb_packets++;
+    return USBD_OK;
+}
+
+/* protocol.c hands text to the telemetry stream while it is on; tests that
+ * link telemetry.c get the real ones */
+__attribute__((weak)) uint8_t Telemetry_Active(void) { return 0; }
+__attribute__((weak)) uint8_t Telemetry_Text(const char *text, uint16_t len) {
+    (void)text; (void)len;
+    return 0;
+}
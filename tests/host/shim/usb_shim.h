@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+
+extern uint8_t  shim_usb_out[1u << 16];   // bytes passed to CDC_Transmit_FS()
+extern uint32_t shim_usb_len;
+extern uint32_t shim_usb_packets;
+extern int      shim_usb_busy;            // non-zero: CDC_Transmit_FS() returns USBD_BUSY
@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+
+/* USB device stack: just what the CDC users call. usb_shim.c captures
+ * everything handed to CDC_Transmit_FS() in shim_usb_out. */
+#define USBD_OK                 0u
+#define USBD_BUSY               1u
+#define USBD_FAIL               3u
+#define USBD_STATE_CONFIGURED   3u
+
+typedef struct { uint8_t dev_state; } USBD_HandleTypeDef;
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+uint8_t CDC_Transmit_FS(uint8_t *buf, uint16_t len);
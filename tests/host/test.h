@@ -0,0 +1,45 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Minimal check macros for the host tests. A failed CHECK prints where and
+ * what, and the test carries on; TEST_END() sets the exit status.
+ */
+static int test_checks __attribute__((unused)), test_failures __attribute__((unused));
+
+#define CHECK(cond) do {                                                    \
+        test_checks++;                                                      \
+        if (!(cond)) {                                                      \
+            test_failures++;                                                \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_EQ(a, b) do {                                                 \
+        long long _a = (long long)(a), _b = (long long)(b);                 \
+        test_checks++;                                                      \
+        if (_a != _b) {                                                     \
+            test_failures++;                                                \
+            fprintf(stderr, "%s:%d: %s == %lld, expected %s == %lld\n",     \
+                    __FILE__, __LINE__, #a, _a, #b, _b);                    \
+        }                                                                   \
+    } while (0)
+
+#define TEST_END() (printf("%s: %d checks, %d failed\n", __FILE__, test_checks, test_failures), \
+                    test_failures ? 1 : 0)
+
+/* Deterministic PRNG (xorshift32) so fuzz runs and traces repeat exactly */
+static inline uint32_t test_rand(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return *s = x;
+}
+
+/* Wall-clock seconds for the benchmarks */
+static inline double test_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
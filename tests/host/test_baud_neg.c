@@ -0,0 +1,260 @@
+/*
+ * Master baud negotiation (baud_neg.h) driven step by step through
+ * baud_neg_tick() / _on_reply() / _on_echo(): the climb to the ceiling,
+ * probe failures, a refused step, keep-alive loss and error bursts in RUN,
+ * the hold before a retry, and recovery of a lowered ceiling after
+ * BAUD_RECOVER_MS of clean running. The slave side is played by the test.
+ */
+#include "baud_neg.h"
+#include "test.h"
+
+#define TOP     (BAUD_RATE_COUNT - 1u)
+
+static uint32_t now;
+
+static void advance(BaudNeg *n, uint32_t ms, uint32_t errors) {
+    for (uint32_t i = 0; i < ms; i++) {
+        now++;
+        CHECK_EQ(baud_neg_tick(n, now, errors), BAUD_ACT_NONE);
+    }
+}
+
+/* Answer every echo of a probe; returns the action after the last one */
+static BaudAction probe_ok(BaudNeg *n, uint32_t errors) {
+    now += BAUD_SETTLE_MS;
+    CHECK_EQ(baud_neg_tick(n, now, errors), BAUD_ACT_ECHO);
+    CHECK_EQ(n->state, BAUD_PROBE);
+    BaudAction a = BAUD_ACT_ECHO;
+    for (uint32_t i = 0; i < BAUD_PROBES && a == BAUD_ACT_ECHO; i++) {
+        now++;
+        a = baud_neg_on_echo(n, n->echo_seq, baud_echo_pattern(n->echo_seq), now);
+    }
+    return a;
+}
+
+/* From a REQUEST, accept every step up to the ceiling */
+static void climb(BaudNeg *n, BaudAction a, uint32_t errors) {
+    for (uint32_t step = 0; a == BAUD_ACT_REQUEST && step < BAUD_RATE_COUNT; step++) {
+        uint8_t target = n->target;
+        now++;
+        CHECK_EQ(baud_neg_on_reply(n, target, now), BAUD_ACT_SET_RATE);
+        CHECK_EQ(n->cur, target);
+        CHECK_EQ(n->state, BAUD_SETTLE);
+        a = probe_ok(n, errors);
+    }
+    CHECK_EQ(a, BAUD_ACT_NONE);
+    CHECK_EQ(n->state, BAUD_RUN);
+    CHECK_EQ(n->cur, n->ceiling);
+}
+
+/* Keep-alive echoes answered at once for ms milliseconds */
+static void run_clean(BaudNeg *n, uint32_t ms, uint32_t errors) {
+    for (uint32_t end = now + ms; now != end;) {
+        now++;
+        BaudAction a = baud_neg_tick(n, now, errors);
+        if (a == BAUD_ACT_ECHO) a = baud_neg_on_echo(n, n->echo_seq, baud_echo_pattern(n->echo_seq), now);
+        if (a != BAUD_ACT_NONE) { CHECK_EQ(a, BAUD_ACT_NONE); return; }
+    }
+}
+
+static void test_climb(void) {
+    BaudNeg n;
+    now = 1000;
+    baud_neg_init(&n, 99);
+    CHECK_EQ(n.ceiling, TOP);                       // clamped to the table
+    CHECK(baud_neg_settled(&n));
+    BaudAction a = baud_neg_start(&n, now);
+    CHECK_EQ(a, BAUD_ACT_REQUEST);
+    CHECK_EQ(n.target, 1);
+    CHECK(!baud_neg_settled(&n));
+    climb(&n, a, 0);
+    CHECK_EQ(n.cur, TOP);
+    CHECK_EQ(n.fallbacks, 0);
+
+    /* Stale and duplicate echoes are ignored */
+    run_clean(&n, BAUD_KEEPALIVE_MS, 0);
+    CHECK_EQ(baud_neg_on_echo(&n, (uint8_t)(n.echo_seq - 1u), 0, now), BAUD_ACT_NONE);
+    CHECK_EQ(n.state, BAUD_RUN);
+
+    /* A ceiling of 0 never leaves the power-up rate */
+    baud_neg_init(&n, 0);
+    CHECK_EQ(baud_neg_start(&n, now), BAUD_ACT_NONE);
+    CHECK_EQ(n.state, BAUD_RUN);
+    run_clean(&n, BAUD_RECOVER_MS + 1000u, 0);
+    CHECK_EQ(n.cur, 0);
+    CHECK_EQ(n.recoveries, 0);
+}
+
+static void test_probe_failures(void) {
+    BaudNeg n;
+
+    /* Corrupted echo at the second step: back to 0, ceiling below the failed rate */
+    now = 0;
+    baud_neg_init(&n, TOP);
+    BaudAction a = baud_neg_start(&n, now);
+    CHECK_EQ(baud_neg_on_reply(&n, 1, ++now), BAUD_ACT_SET_RATE);
+    CHECK_EQ(probe_ok(&n, 0), BAUD_ACT_REQUEST);
+    CHECK_EQ(n.target, 2);
+    CHECK_EQ(baud_neg_on_reply(&n, 2, ++now), BAUD_ACT_SET_RATE);
+    now += BAUD_SETTLE_MS;
+    CHECK_EQ(baud_neg_tick(&n, now, 0), BAUD_ACT_ECHO);
+    a = baud_neg_on_echo(&n, n.echo_seq, (uint16_t)(baud_echo_pattern(n.echo_seq) ^ 0x0100u), ++now);
+    CHECK_EQ(a, BAUD_ACT_SET_RATE);
+    CHECK_EQ(n.cur, 0);
+    CHECK_EQ(n.ceiling, 1);
+    CHECK_EQ(n.state, BAUD_HOLD);
+    CHECK_EQ(n.fallbacks, 1);
+
+    /* Hold, then climb again only to the new ceiling */
+    advance(&n, BAUD_HOLD_MS - 1u, 0);
+    a = baud_neg_tick(&n, ++now, 0);
+    CHECK_EQ(a, BAUD_ACT_REQUEST);
+    climb(&n, a, 0);
+    CHECK_EQ(n.cur, 1);
+
+    /* Lost echo during a probe */
+    baud_neg_init(&n, TOP);
+    baud_neg_start(&n, now);
+    baud_neg_on_reply(&n, 1, ++now);
+    now += BAUD_SETTLE_MS;
+    CHECK_EQ(baud_neg_tick(&n, now, 0), BAUD_ACT_ECHO);
+    advance(&n, BAUD_REPLY_TIMEOUT_MS - 1u, 0);
+    CHECK_EQ(baud_neg_tick(&n, ++now, 0), BAUD_ACT_SET_RATE);
+    CHECK_EQ(n.ceiling, 0);
+
+    /* Link errors during a probe */
+    baud_neg_init(&n, TOP);
+    baud_neg_start(&n, now);
+    baud_neg_on_reply(&n, 1, ++now);
+    now += BAUD_SETTLE_MS;
+    CHECK_EQ(baud_neg_tick(&n, now, 100), BAUD_ACT_ECHO);
+    CHECK_EQ(baud_neg_tick(&n, ++now, 100 + BAUD_PROBE_ERR_LIMIT - 1u), BAUD_ACT_NONE);
+    CHECK_EQ(baud_neg_tick(&n, ++now, 100 + BAUD_PROBE_ERR_LIMIT), BAUD_ACT_SET_RATE);
+
+    /* No answer to the request */
+    baud_neg_init(&n, TOP);
+    baud_neg_start(&n, now);
+    advance(&n, BAUD_REPLY_TIMEOUT_MS - 1u, 0);
+    CHECK_EQ(baud_neg_tick(&n, ++now, 0), BAUD_ACT_SET_RATE);
+    CHECK_EQ(n.ceiling, 0);
+    CHECK_EQ(n.state, BAUD_HOLD);
+}
+
+/* The slave answers with another rate: stay, and retry only after BAUD_RECOVER_MS */
+static void test_refusal(void) {
+    BaudNeg n;
+    now = 0;
+    baud_neg_init(&n, TOP);
+    BaudAction a = baud_neg_start(&n, now);
+    CHECK_EQ(baud_neg_on_reply(&n, 1, ++now), BAUD_ACT_SET_RATE);
+    CHECK_EQ(probe_ok(&n, 0), BAUD_ACT_REQUEST);
+    CHECK_EQ(baud_neg_on_reply(&n, 1, ++now), BAUD_ACT_NONE);      // refused 2
+    CHECK_EQ(n.state, BAUD_RUN);
+    CHECK_EQ(n.cur, 1);
+    CHECK_EQ(n.ceiling, 1);
+    CHECK_EQ(n.fallbacks, 0);
+    CHECK_EQ(baud_neg_on_reply(&n, 2, ++now), BAUD_ACT_NONE);      // late answer: not requesting
+
+    run_clean(&n, BAUD_RECOVER_MS - 2u, 0);
+    CHECK_EQ(n.state, BAUD_RUN);
+    a = BAUD_ACT_NONE;
+    for (int i = 0; i < 4 && a == BAUD_ACT_NONE; i++) {
+        a = baud_neg_tick(&n, ++now, 0);
+        if (a == BAUD_ACT_ECHO) a = baud_neg_on_echo(&n, n.echo_seq, baud_echo_pattern(n.echo_seq), now);
+    }
+    CHECK_EQ(a, BAUD_ACT_REQUEST);
+    CHECK_EQ(n.target, 2);
+    CHECK_EQ(n.recoveries, 1);
+    climb(&n, a, 0);
+    CHECK_EQ(n.cur, TOP);
+}
+
+/* Outages in RUN cost the rate, and BAUD_RECOVER_MS of clean running wins it back */
+static void test_fallback_and_recovery(void) {
+    BaudNeg n;
+    uint32_t errors = 0;
+    now = 0;
+    baud_neg_init(&n, TOP);
+    climb(&n, baud_neg_start(&n, now), errors);
+
+    /* Two keep-alive echoes lost: fallback, ceiling below the top rate */
+    run_clean(&n, 100, errors);
+    BaudAction a = BAUD_ACT_NONE;
+    for (uint32_t t = 0; (a == BAUD_ACT_NONE || a == BAUD_ACT_ECHO) && t < 2u * BAUD_KEEPALIVE_MS; t++)
+        a = baud_neg_tick(&n, ++now, errors);
+    CHECK_EQ(a, BAUD_ACT_SET_RATE);
+    CHECK_EQ(n.ceiling, TOP - 1u);
+    advance(&n, BAUD_HOLD_MS - 1u, errors);
+    climb(&n, baud_neg_tick(&n, ++now, errors), errors);
+    CHECK_EQ(n.cur, TOP - 1u);
+
+    /* An error burst: fallback again */
+    run_clean(&n, BAUD_ERR_WINDOW_MS, errors);
+    errors += BAUD_ERR_LIMIT;
+    CHECK_EQ(baud_neg_tick(&n, ++now, errors), BAUD_ACT_SET_RATE);
+    CHECK_EQ(n.ceiling, TOP - 2u);
+    CHECK_EQ(n.fallbacks, 2);
+    advance(&n, BAUD_HOLD_MS - 1u, errors);
+    climb(&n, baud_neg_tick(&n, ++now, errors), errors);
+
+    /* Isolated errors below the limit do not hold recovery back */
+    uint32_t t_run = now;
+    for (uint32_t t = 0; t < BAUD_RECOVER_MS / BAUD_ERR_WINDOW_MS - 1u; t++) {
+        errors += BAUD_ERR_LIMIT - 1u;
+        run_clean(&n, BAUD_ERR_WINDOW_MS, errors);
+        CHECK_EQ(n.state, BAUD_RUN);
+        CHECK_EQ(n.ceiling, TOP - 2u);
+    }
+    a = BAUD_ACT_NONE;
+    for (uint32_t t = 0; a == BAUD_ACT_NONE && t < 2u * BAUD_ERR_WINDOW_MS; t++) {
+        a = baud_neg_tick(&n, ++now, errors);
+        if (a == BAUD_ACT_ECHO) a = baud_neg_on_echo(&n, n.echo_seq, baud_echo_pattern(n.echo_seq), now);
+    }
+    CHECK_EQ(a, BAUD_ACT_REQUEST);
+    CHECK_EQ(now - t_run, BAUD_RECOVER_MS);
+    CHECK_EQ(n.ceiling, TOP);
+    CHECK_EQ(n.recoveries, 1);
+    climb(&n, a, errors);
+    CHECK_EQ(n.cur, TOP);
+    CHECK_EQ(n.fallbacks, 2);
+
+    /* Nothing further to recover at the top */
+    run_clean(&n, BAUD_RECOVER_MS + 1000u, errors);
+    CHECK_EQ(n.recoveries, 1);
+}
+
+/* Stuck at index 0 (first step failed): bursts there restart the recovery wait */
+static void test_recovery_from_zero(void) {
+    BaudNeg n;
+    uint32_t errors = 0;
+    now = 0xFFFF0000u;                              // across the tick wrap
+    baud_neg_init(&n, TOP);
+    baud_neg_start(&n, now);
+    advance(&n, BAUD_REPLY_TIMEOUT_MS - 1u, errors);
+    CHECK_EQ(baud_neg_tick(&n, ++now, errors), BAUD_ACT_SET_RATE);
+    CHECK_EQ(n.ceiling, 0);
+    advance(&n, BAUD_HOLD_MS - 1u, errors);
+    CHECK_EQ(baud_neg_tick(&n, ++now, errors), BAUD_ACT_NONE);    // nothing to try: RUN at 0
+    CHECK_EQ(n.state, BAUD_RUN);
+    CHECK_EQ(n.cur, 0);
+
+    advance(&n, BAUD_RECOVER_MS / 2u, errors);
+    errors += BAUD_ERR_LIMIT;                       // an outage at 115200
+    uint32_t t_burst = now + 1u;
+    advance(&n, BAUD_RECOVER_MS, errors);
+    CHECK_EQ(n.fallbacks, 1);                       // a burst at 0 is no fallback
+    CHECK_EQ(baud_neg_tick(&n, ++now, errors), BAUD_ACT_REQUEST);
+    CHECK_EQ(now - t_burst, BAUD_RECOVER_MS);
+    CHECK_EQ(n.target, 1);
+    climb(&n, BAUD_ACT_REQUEST, errors);
+    CHECK_EQ(n.cur, TOP);
+}
+
+int main(void) {
+    test_climb();
+    test_probe_failures();
+    test_refusal();
+    test_fallback_and_recovery();
+    test_recovery_from_zero();
+    return TEST_END();
+}
@@ -0,0 +1,136 @@
+/*
+ * F4 input debouncer (debounce.h) against the per-input loop it replaced in
+ * vTaskInputs: changeCount[i] counts samples that differ from
+ * stableState[i], a matching sample clears it, and at debounceLimit = 3 the
+ * input flips and the count restarts. vdeb_update() must give the same
+ * changed mask and stable word on every sample, for all 32 bit positions.
+ */
+#include "debounce.h"
+#include "test.h"
+#include <stdbool.h>
+
+#define DEBOUNCE_LIMIT  3u
+
+/* The old loop, one byte per input */
+typedef struct {
+    uint8_t stable[32];
+    uint8_t count[32];
+} LoopDebounce;
+
+static void loop_init(LoopDebounce *m, uint32_t sample) {
+    for (int i = 0; i < 32; i++) {
+        m->stable[i] = (sample >> i) & 1u;
+        m->count[i] = 0;
+    }
+}
+
+static uint32_t loop_update(LoopDebounce *m, uint32_t sample) {
+    uint32_t changed = 0;
+    for (int i = 0; i < 32; i++) {
+        uint8_t raw = (sample >> i) & 1u;
+        if (raw != m->stable[i]) {
+            if (++m->count[i] >= DEBOUNCE_LIMIT) {
+                m->stable[i] = raw;
+                m->count[i] = 0;
+                changed |= 1u << i;
+            }
+        } else {
+            m->count[i] = 0;
+        }
+    }
+    return changed;
+}
+
+static uint32_t loop_stable(const LoopDebounce *m) {
+    uint32_t bits = 0;
+    for (int i = 0; i < 32; i++) bits |= (uint32_t)m->stable[i] << i;
+    return bits;
+}
+
+/* Every 1-input sequence of up to 12 samples from either start level */
+static void test_all_short_sequences(void) {
+    unsigned mismatches = 0;
+    for (uint32_t start = 0; start <= 1; start++) {
+        for (uint32_t len = 1; len <= 12; len++) {
+            for (uint32_t seq = 0; seq < (1u << len); seq++) {
+                VDebounce d;
+                LoopDebounce m;
+                vdeb_init(&d, start);
+                loop_init(&m, start);
+                for (uint32_t k = 0; k < len; k++) {
+                    uint32_t s = (seq >> k) & 1u;
+                    if (vdeb_update(&d, s) != loop_update(&m, s) || d.stable != loop_stable(&m))
+                        mismatches++;
+                }
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+static void test_three_in_a_row(void) {
+    VDebounce d;
+    vdeb_init(&d, 0);
+    CHECK_EQ(vdeb_update(&d, 1), 0);
+    CHECK_EQ(vdeb_update(&d, 1), 0);
+    CHECK_EQ(vdeb_update(&d, 1), 1);        // third differing sample
+    CHECK_EQ(d.stable, 1);
+    CHECK_EQ(vdeb_update(&d, 1), 0);
+
+    /* A matching sample restarts the count */
+    CHECK_EQ(vdeb_update(&d, 0), 0);
+    CHECK_EQ(vdeb_update(&d, 0), 0);
+    CHECK_EQ(vdeb_update(&d, 1), 0);
+    CHECK_EQ(vdeb_update(&d, 0), 0);
+    CHECK_EQ(vdeb_update(&d, 0), 0);
+    CHECK_EQ(d.stable, 1);
+    CHECK_EQ(vdeb_update(&d, 0), 1);
+    CHECK_EQ(d.stable, 0);
+    CHECK_EQ(VDEB_SAMPLES, DEBOUNCE_LIMIT);
+}
+
+/*
+ * Random 32-bit inputs, each bit flipping with its own probability per
+ * sample from quiet to pure noise, and an occasional vdeb_accept() (the
+ * EXTI / DMA front ends), which in the loop is "set stable, clear count".
+ */
+static void test_random_noise(void) {
+    uint32_t seed = 0xC0FFEEu;
+    unsigned mismatches = 0;
+    for (int run = 0; run < 400; run++) {
+        uint32_t noise = (uint32_t)run * 0x1000000u / 400u;     // flip chance per bit, /2^24
+        uint32_t level = test_rand(&seed);
+        VDebounce d;
+        LoopDebounce m;
+        vdeb_init(&d, level);
+        loop_init(&m, level);
+
+        for (int tick = 0; tick < 2000; tick++) {
+            uint32_t flips = 0;
+            for (int i = 0; i < 32; i++)
+                if ((test_rand(&seed) & 0xFFFFFFu) < noise) flips |= 1u << i;
+            level ^= flips;
+
+            uint32_t r = test_rand(&seed);
+            if ((r & 63u) == 0) {
+                uint32_t mask = test_rand(&seed);
+                vdeb_accept(&d, mask, level);
+                for (int i = 0; i < 32; i++) {
+                    if (!((mask >> i) & 1u)) continue;
+                    m.stable[i] = (level >> i) & 1u;
+                    m.count[i] = 0;
+                }
+            }
+            if (vdeb_update(&d, level) != loop_update(&m, level) || d.stable != loop_stable(&m))
+                mismatches++;
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+int main(void) {
+    test_all_short_sequences();
+    test_three_in_a_row();
+    test_random_noise();
+    return TEST_END();
+}
@@ -0,0 +1,195 @@
+/*
+ * F4 safety rules (error_rules.c evaluated by sr_eval()) replayed against
+ * the input traces in traces/. The replay does what CheckErrorRules()
+ * does every 10 ms: build the rule vector (inputs, swLatchForceError, the
+ * temperature fault), run sr_eval() and feed SR_ACT_FORCE_LATCH back into
+ * the vector for a second pass. RESET clears swLatchForceError as
+ * vTaskResetLatches() does.
+ *
+ * Trace lines, in time order (ms, multiples of 10):
+ *   <t> inputs <hex>        whole input vector, bit i = InputName i
+ *   <t> set|clear <name>... inputs by InputName without the INPUT_ prefix
+ *   <t> temp 0|1            tempFaultActive
+ *   <t> reset               latch RESET
+ *   <t> expect <rule>...|-  active rules after the pass at t
+ *
+ * The temperature rule is also checked against the condition it replaced:
+ * Cond_TemperatureSafe() returns 1 while the temperature is safe, and the
+ * old rule table used that return value as "fault active".
+ */
+#include "error_rules.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef TRACE_DIR
+#define TRACE_DIR "traces"
+#endif
+#define TICK_MS     10u
+
+static const char *const traceInputs[NUM_INPUTS] = {
+    [INPUT_DOOR] = "DOOR",                   [INPUT_DOOR_LATCH_ERR] = "DOOR_LATCH_ERR",
+    [INPUT_ESTOP] = "ESTOP",                 [INPUT_ESTOP_LATCH_ERR] = "ESTOP_LATCH_ERR",
+    [INPUT_KEY] = "KEY",                     [INPUT_KEY_LATCH_ERR] = "KEY_LATCH_ERR",
+    [INPUT_BDO] = "BDO",                     [INPUT_BDO_LATCH_ERR] = "BDO_LATCH_ERR",
+    [INPUT_RELAY1_ON] = "RELAY1_ON",         [INPUT_RELAY2_ON] = "RELAY2_ON",
+    [INPUT_RELAY_LATCH_ERR] = "RELAY_LATCH_ERR",
+    [INPUT_NO1] = "NO1",                     [INPUT_NC1] = "NC1",
+    [INPUT_12V_PWR_GOOD] = "12V_PWR_GOOD",   [INPUT_24V_PWR_GOOD] = "24V_PWR_GOOD",
+    [INPUT_12V_FUSE_GOOD] = "12V_FUSE_GOOD",
+    [INPUT_TRU_LAS_DEACTIVATED] = "TRU_LAS_DEACTIVATED", [INPUT_TRU_SYS_FAULT] = "TRU_SYS_FAULT",
+    [INPUT_TRU_BEAM_DELIVERY] = "TRU_BEAM_DELIVERY",     [INPUT_TRU_EMISS_WARN] = "TRU_EMISS_WARN",
+    [INPUT_TRU_ALARM] = "TRU_ALARM",         [INPUT_TRU_MONITOR] = "TRU_MONITOR",
+    [INPUT_TRU_TEMPERATURE] = "TRU_TEMPERATURE",
+};
+
+static const char *const traceRules[NUM_ERROR_RULES] = {
+    [RULE_DOOR_RELAYS] = "DOOR_RELAYS", [RULE_RELAY_CONTACTS] = "RELAY_CONTACTS",
+    [RULE_LATCH] = "LATCH",             [RULE_POWER] = "POWER",
+    [RULE_TEMPERATURE] = "TEMPERATURE",
+};
+
+static int lookup(const char *const *names, int n, const char *name) {
+    for (int i = 0; i < n; i++)
+        if (names[i] && strcmp(names[i], name) == 0) return i;
+    return -1;
+}
+
+/* Board state the rules see and act on */
+typedef struct {
+    uint32_t inputs;
+    uint8_t  swLatchForceError;
+    uint8_t  tempFaultActive;
+    SafetyRuleState rules;
+} Board;
+
+static uint32_t rule_vector(const Board *b) {
+    uint32_t v = b->inputs;
+    if (b->swLatchForceError) v |= INPUT_BIT(RULE_IN_SW_LATCH);
+    if (b->tempFaultActive)   v |= INPUT_BIT(RULE_IN_TEMP_FAULT);
+    return v;
+}
+
+/* CheckErrorRules() without the messages and outputs */
+static void check_rules(Board *b, uint32_t now) {
+    uint32_t v = rule_vector(b);
+    for (int pass = 0; pass < 2; pass++) {
+        sr_eval(errorRules, NUM_ERROR_RULES, &b->rules, v, now);
+        for (uint32_t m = b->rules.active; m; m &= m - 1u)
+            if (errorRules[__builtin_ctz(m)].actions & SR_ACT_FORCE_LATCH)
+                b->swLatchForceError = 1;
+        uint32_t after = rule_vector(b);
+        if (after == v) break;
+        v = after;
+    }
+}
+
+static void format_rules(char *out, size_t size, uint32_t mask) {
+    size_t n = 0;
+    out[0] = '\0';
+    for (int r = 0; r < (int)NUM_ERROR_RULES; r++)
+        if (mask & (1u << r))
+            n += (size_t)snprintf(out + n, size - n, "%s%s", n ? " " : "", traceRules[r]);
+    if (n == 0) snprintf(out, size, "-");
+}
+
+static unsigned passes, baselineAgrees;
+
+/* One 10 ms pass; the temperature rule is checked against both polarities */
+static void tick(Board *b, uint32_t now) {
+    check_rules(b, now);
+    uint32_t active = (b->rules.active >> RULE_TEMPERATURE) & 1u;
+    uint8_t safe = !b->tempFaultActive;             // Cond_TemperatureSafe()
+    passes++;
+    if (active == safe) baselineAgrees++;           // old table: the return value was the fault
+    CHECK_EQ(active, b->tempFaultActive);
+}
+
+static void replay(const char *file) {
+    char path[256], line[256];
+    snprintf(path, sizeof(path), "%s/%s", TRACE_DIR, file);
+    FILE *f = fopen(path, "r");
+    CHECK(f != NULL);
+    if (!f) { perror(path); return; }
+
+    Board b = { 0 };
+    sr_init(&b.rules);
+    uint32_t now = 0;                   // time of the next pass
+    bool ran = false;                   // the pass at `now` has run
+    int lineNo = 0, expects = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *tok = strtok(line, " \t\r\n");
+        if (!tok) continue;
+        uint32_t t = (uint32_t)strtoul(tok, NULL, 10);
+        char *cmd = strtok(NULL, " \t\r\n");
+        CHECK(cmd != NULL && t % TICK_MS == 0 && t >= now);
+        if (!cmd) continue;
+
+        /* Every pass up to t; the one at t runs after t's input changes */
+        if (t > now) {
+            if (!ran) tick(&b, now);
+            for (now += TICK_MS; now < t; now += TICK_MS) tick(&b, now);
+            now = t;
+            ran = false;
+        }
+
+        if (strcmp(cmd, "expect") == 0) {
+            if (!ran) { tick(&b, now); ran = true; }
+            uint32_t want = 0;
+            for (char *r; (r = strtok(NULL, " \t\r\n")) != NULL;) {
+                if (strcmp(r, "-") == 0) continue;
+                int i = lookup(traceRules, NUM_ERROR_RULES, r);
+                CHECK(i >= 0);
+                if (i >= 0) want |= 1u << i;
+            }
+            expects++;
+            if (b.rules.active != want) {
+                char got[128], exp[128];
+                format_rules(got, sizeof(got), b.rules.active);
+                format_rules(exp, sizeof(exp), want);
+                fprintf(stderr, "%s:%d: at %lu ms active rules %s, expected %s\n", path, lineNo,
+                        (unsigned long)now, got, exp);
+            }
+            CHECK_EQ(b.rules.active, want);
+            continue;
+        }
+
+        if (ran) fprintf(stderr, "%s:%d: input change after an expect of the same time\n", path, lineNo);
+        CHECK(!ran);
+        char *arg = strtok(NULL, " \t\r\n");
+        if (strcmp(cmd, "inputs") == 0 && arg) {
+            b.inputs = (uint32_t)strtoul(arg, NULL, 16);
+        } else if (strcmp(cmd, "set") == 0 || strcmp(cmd, "clear") == 0) {
+            for (char *n = arg; n != NULL; n = strtok(NULL, " \t\r\n")) {
+                int i = lookup(traceInputs, NUM_INPUTS, n);
+                CHECK(i >= 0);
+                if (i < 0) continue;
+                if (cmd[0] == 's') b.inputs |= INPUT_BIT(i);
+                else               b.inputs &= ~INPUT_BIT(i);
+            }
+        } else if (strcmp(cmd, "temp") == 0 && arg) {
+            b.tempFaultActive = (uint8_t)atoi(arg);
+        } else if (strcmp(cmd, "reset") == 0) {
+            b.swLatchForceError = 0;
+        } else {
+            fprintf(stderr, "%s:%d: bad line\n", path, lineNo);
+            CHECK(0);
+        }
+    }
+    fclose(f);
+    CHECK(expects > 0);
+}
+
+int main(void) {
+    static const char *const traces[] = {
+        "door_relays.trace", "relay_contacts.trace", "power.trace", "temperature.trace",
+    };
+    for (unsigned i = 0; i < sizeof(traces) / sizeof(traces[0]); i++) replay(traces[i]);
+    CHECK(passes > 1000);
+    CHECK_EQ(baselineAgrees, 0);        // the old polarity was wrong on every pass
+    return TEST_END();
+}
@@ -0,0 +1,126 @@
+/*
+ * Fixed-point temperatures (fixed_point.h) against the float decode they
+ * replaced in max31855.c (tc * 0.25f, cj * 0.0625f), for every 14-bit
+ * thermocouple and 12-bit cold-junction code:
+ *   - fx_format() gives the same text as printf("%.*f") of the float,
+ *     ties to even included;
+ *   - fx_round() gives lroundf() of the float;
+ *   - whole-degree limits scaled with MAX31855_TC_FROM_C() compare the same
+ *     way as the float against the plain number.
+ */
+#include "max31855.h"
+#include "test.h"
+#include <math.h>
+#include <string.h>
+
+#define TC_CODES    (1u << 14)
+#define CJ_CODES    (1u << 12)
+
+/* The field decode of MAX31855_Read(), sign extension included */
+static int16_t decode_tc(uint32_t raw) {
+    int16_t tc = (raw >> 18) & 0x3FFF;
+    if (tc & 0x2000) tc |= 0xC000;
+    return tc;
+}
+
+static int16_t decode_cj(uint32_t raw) {
+    int16_t cj = (raw >> 4) & 0x0FFF;
+    if (cj & 0x0800) cj |= 0xF000;
+    return cj;
+}
+
+static unsigned format_mismatches;
+
+static void check_format(int32_t v, uint8_t frac, float f, uint8_t decimals) {
+    char fx[FX_STR_MAX], ref[32];
+    snprintf(ref, sizeof(ref), "%.*f", (int)decimals, (double)f);
+    fx_format(fx, sizeof(fx), v, frac, decimals);
+    CHECK(strlen(ref) < FX_STR_MAX);
+    if (strcmp(fx, ref) != 0 && format_mismatches++ < 10)
+        fprintf(stderr, "fx_format(%ld, Q.%u, %u) = \"%s\", printf gives \"%s\"\n",
+                (long)v, frac, decimals, fx, ref);
+}
+
+static void test_tc_codes(void) {
+    unsigned round_mismatches = 0, limit_mismatches = 0;
+    for (uint32_t code = 0; code < TC_CODES; code++) {
+        int16_t q2 = decode_tc(code << 18);
+        float c = q2 * 0.25f;
+
+        for (uint8_t d = 0; d <= 2; d++) check_format(q2, MAX31855_TC_FRAC, c, d);
+        if (fx_round(q2, MAX31855_TC_FRAC) != lroundf(c)) round_mismatches++;
+
+        /* Every whole-degree limit the sensor can reach, -270 .. 1372 °C */
+        for (int limit = -270; limit <= 1372; limit++) {
+            int32_t q = MAX31855_TC_FROM_C(limit);
+            if ((q2 > q) != (c > limit) || (q2 < q) != (c < limit)) limit_mismatches++;
+        }
+    }
+    CHECK_EQ(format_mismatches, 0);
+    CHECK_EQ(round_mismatches, 0);
+    CHECK_EQ(limit_mismatches, 0);
+
+    /* Both ends of the 14-bit range */
+    CHECK_EQ(decode_tc(0x1FFFu << 18), 8191);
+    CHECK_EQ(decode_tc(0x2000u << 18), -8192);
+}
+
+static void test_cj_codes(void) {
+    format_mismatches = 0;
+    for (uint32_t code = 0; code < CJ_CODES; code++) {
+        int16_t q4 = decode_cj(code << 4);
+        float c = q4 * 0.0625f;
+        for (uint8_t d = 0; d <= 4; d++) check_format(q4, MAX31855_CJ_FRAC, c, d);
+    }
+    CHECK_EQ(format_mismatches, 0);
+}
+
+/* Exact ties: printf rounds them to even, fx_round() away from zero */
+static void test_ties(void) {
+    static const struct {
+        int32_t v;
+        uint8_t frac, decimals;
+        const char *text;
+    } ties[] = {
+        {  1, 2, 1, "0.2"   },      //  0.25
+        {  3, 2, 1, "0.8"   },      //  0.75
+        { -1, 2, 1, "-0.2"  },      // -0.25
+        { -3, 2, 1, "-0.8"  },      // -0.75
+        {  2, 2, 0, "0"     },      //  0.5
+        {  6, 2, 0, "2"     },      //  1.5
+        { 10, 2, 0, "2"     },      //  2.5
+        { -2, 2, 0, "-0"    },      // -0.5: printf keeps the sign
+        { -1, 2, 0, "-0"    },      // -0.25
+        {  1, 4, 3, "0.062" },      //  0.0625
+        {  3, 4, 3, "0.188" },      //  0.1875
+        {  1, 4, 2, "0.06"  },      //  0.0625, not a tie
+        {  2, 4, 1, "0.1"   },      //  0.125
+        { 24, 4, 0, "2"     },      //  1.5
+        { 40, 4, 0, "2"     },      //  2.5
+    };
+    char t[FX_STR_MAX];
+    for (unsigned i = 0; i < sizeof(ties) / sizeof(ties[0]); i++) {
+        fx_format(t, sizeof(t), ties[i].v, ties[i].frac, ties[i].decimals);
+        if (strcmp(t, ties[i].text) != 0)
+            fprintf(stderr, "fx_format(%ld, Q.%u, %u) = \"%s\", expected \"%s\"\n", (long)ties[i].v,
+                    ties[i].frac, ties[i].decimals, t, ties[i].text);
+        CHECK(strcmp(t, ties[i].text) == 0);
+    }
+
+    CHECK_EQ(fx_round(2, 2), 1);        //  0.5
+    CHECK_EQ(fx_round(10, 2), 3);       //  2.5
+    CHECK_EQ(fx_round(-2, 2), -1);      // -0.5
+    CHECK_EQ(fx_round(-10, 2), -3);     // -2.5
+    CHECK_EQ(fx_round(-1, 2), 0);       // -0.25
+    CHECK_EQ(fx_round(7, 0), 7);
+
+    CHECK_EQ(FX_FROM_INT(60, 2), 240);
+    CHECK_EQ(FX_FROM_INT(-5, 4), -80);
+}
+
+int main(void) {
+    test_tc_codes();
+    test_cj_codes();
+    test_ties();
+    return TEST_END();
+}
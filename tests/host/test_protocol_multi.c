@@ -0,0 +1,194 @@
+/*
+ * Batched WRITE_MULTI / READ_MULTI / ACK_MULTI / NOTIFY_MULTI frames.
+ * Built once against each board's protocol.c (see Makefile).
+ */
+#include "protocol.h"
+#include "test.h"
+#include <string.h>
+
+/* Feed a frame to a parser; returns how many frames came out (last in *out) */
+static int feed(ProtoParser *p, const uint8_t *b, size_t n, ProtoFrame *out) {
+    int frames = 0;
+    for (size_t i = 0; i < n; i++)
+        if (proto_push(p, b[i], out)) frames++;
+    return frames;
+}
+
+static const ProtoPair sync_out[] = {
+    { VAR_PORTA, 0x0203 }, { VAR_STATUS_DEBUG, 0x0302 },
+    { VAR_STATUS_ACTIVE, 0xFFFF }, { VAR_STATUS_DEBUG_TRU, 0x0000 },
+};
+static const uint8_t sync_in[] = { VAR_PORTB, VAR_PORTC, VAR_STATUS_PLC };
+
+static void test_write_multi_roundtrip(void) {
+    uint8_t frame[PROTO_MAX_FRAME];
+    ProtoParser slave, master;
+    ProtoFrame f;
+
+    size_t n = proto_build_write_multi(sync_out, 4, frame);
+    CHECK_EQ(n, 4 + 3 * 4);
+    CHECK_EQ(frame[0], STX);
+    CHECK_EQ(frame[1], CMD_WRITE_MULTI);
+    CHECK_EQ(frame[2], 4);
+    CHECK_EQ(frame[n - 1], ETX);
+
+    /* Values deliberately contain STX/ETX bytes: v1 relies on the count, not on scanning */
+    proto_init(&slave, ROLE_SLAVE);
+    CHECK_EQ(feed(&slave, frame, n, &f), 1);
+    CHECK_EQ(f.cmd, CMD_WRITE_MULTI);
+    CHECK(f.has_value);
+    CHECK(!f.tagged);
+    CHECK_EQ(f.count, 4);
+    for (int i = 0; i < 4; i++) {
+        CHECK_EQ(f.pairs[i].var_id, sync_out[i].var_id);
+        CHECK_EQ(f.pairs[i].value, sync_out[i].value);
+    }
+
+    /* The slave answers with the same pairs in one ACK_MULTI */
+    n = proto_build_ack_multi(f.pairs, f.count, frame);
+    proto_init(&master, ROLE_MASTER);
+    CHECK_EQ(feed(&master, frame, n, &f), 1);
+    CHECK_EQ(f.cmd, CMD_ACK_MULTI);
+    CHECK_EQ(f.count, 4);
+    CHECK_EQ(f.pairs[2].value, 0xFFFF);
+}
+
+static void test_read_multi_roundtrip(void) {
+    uint8_t frame[PROTO_MAX_FRAME];
+    ProtoParser slave, master;
+    ProtoFrame f;
+    ProtoPair reply[3];
+
+    /* Request carries ids only */
+    size_t n = proto_build_read_multi(sync_in, 3, frame);
+    CHECK_EQ(n, 4 + 3);
+    proto_init(&slave, ROLE_SLAVE);
+    CHECK_EQ(feed(&slave, frame, n, &f), 1);
+    CHECK_EQ(f.cmd, CMD_READ_MULTI);
+    CHECK(!f.has_value);
+    CHECK_EQ(f.count, 3);
+    for (int i = 0; i < 3; i++) {
+        CHECK_EQ(f.pairs[i].var_id, sync_in[i]);
+        reply[i].var_id = f.pairs[i].var_id;
+        reply[i].value  = (uint16_t)(0x1100 * (i + 1) + 3);
+    }
+
+    /* Reply carries full triplets; the master parser expects those */
+    n = proto_build_readr_multi(reply, 3, frame);
+    CHECK_EQ(n, 4 + 3 * 3);
+    proto_init(&master, ROLE_MASTER);
+    CHECK_EQ(feed(&master, frame, n, &f), 1);
+    CHECK_EQ(f.cmd, CMD_READ_MULTI);
+    CHECK(f.has_value);
+    CHECK_EQ(f.count, 3);
+    CHECK_EQ(f.pairs[1].var_id, VAR_PORTC);
+    CHECK_EQ(f.pairs[1].value, 0x2203);
+
+    /* NOTIFY_MULTI is slave -> master only */
+    n = proto_build_notify_multi(reply, 2, frame);
+    CHECK_EQ(feed(&master, frame, n, &f), 1);
+    CHECK_EQ(f.cmd, CMD_NOTIFY_MULTI);
+    CHECK_EQ(f.count, 2);
+}
+
+static void test_count_limits(void) {
+    uint8_t frame[PROTO_MAX_FRAME];
+    ProtoPair pairs[PROTO_MAX_PAIRS + 1];
+    uint8_t ids[PROTO_MAX_PAIRS + 1];
+    ProtoParser slave;
+    ProtoFrame f;
+
+    for (unsigned i = 0; i <= PROTO_MAX_PAIRS; i++) {
+        pairs[i].var_id = (uint8_t)i;
+        pairs[i].value  = (uint16_t)(i * 257u);
+        ids[i] = (uint8_t)i;
+    }
+    CHECK_EQ(proto_build_write_multi(pairs, 0, frame), 0);
+    CHECK_EQ(proto_build_write_multi(pairs, PROTO_MAX_PAIRS + 1, frame), 0);
+    CHECK_EQ(proto_build_read_multi(ids, 0, frame), 0);
+    CHECK_EQ(proto_build_read_multi(ids, PROTO_MAX_PAIRS + 1, frame), 0);
+
+    /* The largest frame fits PROTO_MAX_FRAME even with a tag */
+    size_t n = proto_build_write_multi(pairs, PROTO_MAX_PAIRS, frame);
+    n = proto_tag(0x5A, frame, n);
+    CHECK_EQ(n, PROTO_MAX_FRAME);
+    proto_init(&slave, ROLE_SLAVE);
+    CHECK_EQ(feed(&slave, frame, n, &f), 1);
+    CHECK_EQ(f.count, PROTO_MAX_PAIRS);
+    CHECK(f.tagged);
+    CHECK_EQ(f.tag, 0x5A);
+    CHECK_EQ(f.pairs[PROTO_MAX_PAIRS - 1].value, (PROTO_MAX_PAIRS - 1) * 257u);
+
+    /* A count of 0 or above the maximum on the wire is rejected and resynced */
+    const uint8_t bad0[] = { STX, CMD_WRITE_MULTI, 0, ETX };
+    const uint8_t bad9[] = { STX, CMD_READ_MULTI, PROTO_MAX_PAIRS + 1, 1, 2, 3, 4, 5, 6, 7, 8, 9, ETX };
+    uint32_t resyncs = slave.resyncs;
+    CHECK_EQ(feed(&slave, bad0, sizeof(bad0), &f), 0);
+    CHECK_EQ(feed(&slave, bad9, sizeof(bad9), &f), 0);
+    CHECK(slave.resyncs > resyncs);
+
+    /* ... and the parser still takes the next good frame */
+    n = proto_build_read_multi(ids, 2, frame);
+    CHECK_EQ(feed(&slave, frame, n, &f), 1);
+    CHECK_EQ(f.count, 2);
+}
+
+static void test_tagged_reply_and_v2(void) {
+    uint8_t frame[PROTO_MAX_FRAME], wire[PROTO_V2_MAX_WIRE];
+    ProtoParser master;
+    ProtoFrame f;
+
+    size_t n = proto_build_ack_multi(sync_out, 4, frame);
+    n = proto_tag(0x03, frame, n);      // tag equal to ETX
+    proto_init(&master, ROLE_MASTER);
+    CHECK_EQ(feed(&master, frame, n, &f), 1);
+    CHECK(f.tagged);
+    CHECK_EQ(f.tag, 0x03);
+    CHECK_EQ(f.count, 4);
+
+    /* Same frame in v2 framing */
+    size_t w = proto_encode_v2(frame, n, wire);
+    CHECK(w > 0 && w <= PROTO_V2_MAX_WIRE);
+    proto_init_v2(&master, ROLE_MASTER);
+    CHECK_EQ(feed(&master, wire, w, &f), 1);
+    CHECK_EQ(f.cmd, CMD_ACK_MULTI);
+    CHECK_EQ(f.tag, 0x03);
+    CHECK_EQ(f.pairs[3].var_id, VAR_STATUS_DEBUG_TRU);
+}
+
+/* Back-to-back frames with noise in between, as the M40 sees a busy link */
+static void test_stream(void) {
+    uint8_t stream[1024], frame[PROTO_MAX_FRAME];
+    size_t len = 0;
+    ProtoParser slave;
+    ProtoFrame f;
+    uint32_t seed = 1;
+    int sent = 0, got = 0;
+
+    while (len + PROTO_MAX_FRAME + 4 < sizeof(stream)) {
+        ProtoPair p[PROTO_MAX_PAIRS];
+        uint8_t cnt = (uint8_t)(1 + test_rand(&seed) % PROTO_MAX_PAIRS);
+        for (uint8_t i = 0; i < cnt; i++) {
+            p[i].var_id = (uint8_t)test_rand(&seed);
+            p[i].value  = (uint16_t)test_rand(&seed);
+        }
+        size_t n = proto_build_write_multi(p, cnt, frame);
+        memcpy(stream + len, frame, n);
+        len += n;
+        sent++;
+        if (test_rand(&seed) % 4 == 0) stream[len++] = 0xEE;   // line noise between frames
+    }
+    proto_init(&slave, ROLE_SLAVE);
+    for (size_t i = 0; i < len; i++)
+        if (proto_push(&slave, stream[i], &f)) got++;
+    CHECK_EQ(got, sent);
+}
+
+int main(void) {
+    test_write_multi_roundtrip();
+    test_read_multi_roundtrip();
+    test_count_limits();
+    test_tagged_reply_and_v2();
+    test_stream();
+    return TEST_END();
+}
@@ -0,0 +1,274 @@
+/*
+ * v2 framing (COBS + CRC16): round trips against the v1 parser, and fuzzing
+ * with bit flips, dropped bytes, truncation and garbage bursts. After any
+ * damage the next intact frame must parse: resync costs one delimiter. A v1
+ * HELLO look-alike inside a v2 payload must not switch the slave back to v1.
+ * Built once against each board's protocol.c, with ASan/UBSan (see Makefile).
+ */
+#include "protocol.h"
+#include "baud_neg.h"
+#include "test.h"
+#include <string.h>
+
+#define ROUNDS 20000
+
+typedef struct {
+    uint8_t   v1[PROTO_MAX_FRAME];
+    size_t    n1;
+    uint8_t   wire[PROTO_V2_MAX_WIRE];
+    size_t    nw;
+    ProtoRole rx;       // role of the receiving side
+} TestFrame;
+
+/* Any frame either side can send, random command, payload and tag */
+static void random_frame(uint32_t *seed, TestFrame *t) {
+    ProtoPair p[PROTO_MAX_PAIRS];
+    uint8_t ids[PROTO_MAX_PAIRS];
+    uint8_t cnt = (uint8_t)(1 + test_rand(seed) % PROTO_MAX_PAIRS);
+    uint8_t id  = (uint8_t)test_rand(seed);
+    uint16_t v  = (uint16_t)test_rand(seed);
+    for (uint8_t i = 0; i < cnt; i++) {
+        p[i].var_id = ids[i] = (uint8_t)test_rand(seed);
+        p[i].value  = (uint16_t)test_rand(seed);
+    }
+    /* Bias values towards the bytes that matter to the framing */
+    if (test_rand(seed) % 4 == 0) v = (uint16_t)((test_rand(seed) % 2) ? 0x0000 : 0x0203);
+
+    t->rx = ROLE_SLAVE;
+    switch (test_rand(seed) % 16) {
+    case 0:  t->n1 = proto_build_write(id, v, t->v1); break;
+    case 1:  t->n1 = proto_build_read(id, t->v1); break;
+    case 2:  t->n1 = proto_build_write_multi(p, cnt, t->v1); break;
+    case 3:  t->n1 = proto_build_read_multi(ids, cnt, t->v1); break;
+    case 4:  t->n1 = proto_build_baud((uint8_t)(id & 3), t->v1); break;
+    case 5:  t->n1 = proto_build_echo(id, v, t->v1); break;
+    case 6:  t->n1 = proto_build_hello(PROTO_V2, t->v1); break;
+    default:
+        t->rx = ROLE_MASTER;
+        switch (test_rand(seed) % 9) {
+        case 0:  t->n1 = proto_build_ack(id, v, t->v1); break;
+        case 1:  t->n1 = proto_build_readr(id, v, t->v1); break;
+        case 2:  t->n1 = proto_build_notify(id, v, t->v1); break;
+        case 3:  t->n1 = proto_build_ack_multi(p, cnt, t->v1); break;
+        case 4:  t->n1 = proto_build_readr_multi(p, cnt, t->v1); break;
+        case 5:  t->n1 = proto_build_notify_multi(p, cnt, t->v1); break;
+        case 6:  t->n1 = proto_build_cycle(id, v, t->v1); break;
+        case 7:  t->n1 = proto_build_echo(id, v, t->v1); break;
+        default: t->n1 = proto_build_hello_reply(PROTO_V2, t->v1); break;
+        }
+    }
+    if (t->v1[1] != CMD_HELLO && test_rand(seed) % 2) t->n1 = proto_tag((uint8_t)test_rand(seed), t->v1, t->n1);
+    t->nw = proto_encode_v2(t->v1, t->n1, t->wire);
+}
+
+static bool same_frame(const ProtoFrame *a, const ProtoFrame *b) {
+    if (a->cmd != b->cmd || a->var_id != b->var_id || a->has_value != b->has_value ||
+        a->count != b->count || a->tagged != b->tagged)
+        return false;
+    if (a->has_value && a->value != b->value) return false;
+    if (a->tagged && a->tag != b->tag) return false;
+    for (uint8_t i = 0; i < a->count; i++) {
+        if (a->pairs[i].var_id != b->pairs[i].var_id) return false;
+        if (a->has_value && a->pairs[i].value != b->pairs[i].value) return false;
+    }
+    return true;
+}
+
+/* Feed bytes; returns the number of frames accepted, the last one in *out */
+static int feed(ProtoParser *p, const uint8_t *b, size_t n, ProtoFrame *out) {
+    int frames = 0;
+    for (size_t i = 0; i < n; i++)
+        if (proto_push(p, b[i], out)) frames++;
+    return frames;
+}
+
+/* Every frame decodes to the same thing in both framings, and nothing else is accepted */
+static void test_roundtrip(void) {
+    uint32_t seed = 1;
+    int mismatches = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        TestFrame t;
+        ProtoParser p1, p2;
+        ProtoFrame f1, f2;
+        random_frame(&seed, &t);
+        CHECK(t.nw > 0 && t.nw <= PROTO_V2_MAX_WIRE);
+        CHECK(memchr(t.wire + 1, PROTO_V2_DELIM, t.nw - 2) == NULL);  // COBS: no delimiter inside
+
+        proto_init(&p1, t.rx);
+        proto_init_v2(&p2, t.rx);
+        if (feed(&p1, t.v1, t.n1, &f1) != 1 || feed(&p2, t.wire, t.nw, &f2) != 1 || !same_frame(&f1, &f2))
+            mismatches++;
+        CHECK_EQ(p2.resyncs, 0);
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+/* One flipped bit is never accepted (CRC16 catches every single-bit error),
+ * and the frame after it always parses */
+static void test_bit_flips(void) {
+    uint32_t seed = 2;
+    int false_accepts = 0, lost_next = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        TestFrame bad, good;
+        ProtoParser p;
+        ProtoFrame f;
+        random_frame(&seed, &bad);
+        do random_frame(&seed, &good); while (good.rx != bad.rx);
+
+        size_t at = test_rand(&seed) % bad.nw;
+        bad.wire[at] ^= (uint8_t)(1u << (test_rand(&seed) % 8));
+
+        proto_init_v2(&p, bad.rx);
+        false_accepts += feed(&p, bad.wire, bad.nw, &f);
+        if (feed(&p, good.wire, good.nw, &f) != 1) lost_next++;
+    }
+    CHECK_EQ(false_accepts, 0);
+    CHECK_EQ(lost_next, 0);
+}
+
+/* Dropped or truncated bytes: the damaged frame is discarded, the next one parses */
+static void test_drops_and_truncation(void) {
+    uint32_t seed = 3;
+    int false_accepts = 0, lost_next = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        TestFrame bad, good;
+        ProtoParser p;
+        ProtoFrame f;
+        random_frame(&seed, &bad);
+        do random_frame(&seed, &good); while (good.rx != bad.rx);
+
+        size_t n = bad.nw;
+        if (r & 1) {                                        // drop one byte inside the frame
+            size_t at = 1 + test_rand(&seed) % (n - 2);
+            memmove(&bad.wire[at], &bad.wire[at + 1], n - at - 1);
+            n--;
+        } else {                                            // line cut off mid-frame
+            n = 1 + test_rand(&seed) % (n - 2);             // (losing only the final 00 is no damage:
+        }                                                   //  the next frame's leading 00 ends it)
+        proto_init_v2(&p, bad.rx);
+        false_accepts += feed(&p, bad.wire, n, &f);
+        if (feed(&p, good.wire, good.nw, &f) != 1) lost_next++;
+    }
+    CHECK_EQ(false_accepts, 0);
+    CHECK_EQ(lost_next, 0);
+}
+
+/* Random garbage, including overlong runs without a delimiter, never hides the next frame */
+static void test_garbage(void) {
+    uint32_t seed = 4;
+    int lost_next = 0, accepted = 0;
+    uint8_t junk[300];
+    for (int r = 0; r < ROUNDS; r++) {
+        TestFrame good;
+        ProtoParser p;
+        ProtoFrame f;
+        size_t n = test_rand(&seed) % sizeof(junk);
+        for (size_t i = 0; i < n; i++) {
+            junk[i] = (uint8_t)test_rand(&seed);
+            if (r & 1 && junk[i] == 0) junk[i] = 0x5A;     // odd rounds: no delimiter at all
+        }
+        random_frame(&seed, &good);
+        proto_init_v2(&p, good.rx);
+        accepted += feed(&p, junk, n, &f);
+        if (feed(&p, good.wire, good.nw, &f) != 1) lost_next++;
+    }
+    CHECK_EQ(lost_next, 0);
+    CHECK(accepted <= 2);       // a random block passes CRC16 with p = 2^-16
+}
+
+/* The v1 parser takes a value corrupted in flight; v2 does not */
+static void test_v1_weakness(void) {
+    uint8_t frame[8], wire[PROTO_V2_MAX_WIRE];
+    ProtoParser p;
+    ProtoFrame f;
+    size_t n = proto_build_write(VAR_PORTA, 0x0100, frame);
+    size_t w = proto_encode_v2(frame, n, wire);
+
+    frame[3] ^= 0x01;                                       // value LSB
+    proto_init(&p, ROLE_SLAVE);
+    CHECK_EQ(feed(&p, frame, n, &f), 1);
+    CHECK_EQ(f.value, 0x0101);
+
+    wire[4] ^= 0x01;
+    proto_init_v2(&p, ROLE_SLAVE);
+    CHECK_EQ(feed(&p, wire, w, &f), 0);
+    CHECK_EQ(p.resyncs, 1);
+}
+
+/* The slave runs both parsers on the same bytes: each ignores the other framing */
+static void test_mixed_framing(void) {
+    uint32_t seed = 5;
+    int v2_from_v1 = 0, v1_from_v2 = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        TestFrame t;
+        ProtoParser p1, p2;
+        ProtoFrame f;
+        random_frame(&seed, &t);
+        proto_init(&p1, t.rx);
+        proto_init_v2(&p2, t.rx);
+        v2_from_v1 += feed(&p2, t.v1, t.n1, &f);
+        v1_from_v2 += feed(&p1, t.wire, t.nw, &f);
+    }
+    CHECK_EQ(v2_from_v1, 0);
+    /* COBS output can contain STX..ETX look-alikes; slave_link.c ignores v1
+     * frames once on v2 (HELLO too, see test_hello_lookalike), so only count them here */
+    printf("v1 parser accepted %d of %d v2 wire frames as v1\n", v1_from_v2, ROUNDS);
+}
+
+/*
+ * A v1 HELLO look-alike inside a v2 payload: WRITE_MULTI 12 03 | 02 09 01 | 03 ...
+ * reads as STX HELLO(1) ETX from the first pair on. The slave's v1 parser takes
+ * it; proto_hello_allowed() keeps it from dropping a live v2 link back to v1,
+ * and still lets a restarted master's real HELLO through once v2 is quiet.
+ */
+static void test_hello_lookalike(void) {
+    const ProtoPair pairs[3] = {
+        { STX, (uint16_t)(CMD_HELLO | (PROTO_V1 << 8)) }, { ETX, 0x0101 }, { 0x04, 0x0101 },
+    };
+    uint8_t frame[PROTO_MAX_FRAME], wire[PROTO_V2_MAX_WIRE], hello[8];
+    size_t w = proto_encode_v2(frame, proto_build_write_multi(pairs, 3, frame), wire);
+    size_t h = proto_build_hello(PROTO_V2, hello);
+    ProtoParser p1, p2;
+    ProtoFrame f;
+    proto_init(&p1, ROLE_SLAVE);
+    proto_init_v2(&p2, ROLE_SLAVE);
+
+    /* The slave's rx_frame() version gate, fed one look-alike every 10 ms */
+    uint8_t link_version = PROTO_V2;
+    uint32_t now = 0, v2_rx = 0;
+    int lookalikes = 0, v2_frames = 0;
+    for (int r = 0; r < 500; r++, now += 10) {
+        for (size_t i = 0; i < w; i++) {
+            if (proto_push(&p1, wire[i], &f) && f.cmd == CMD_HELLO) {
+                lookalikes++;
+                if (proto_hello_allowed(link_version, now - v2_rx, BAUD_SILENCE_MS))
+                    link_version = (f.var_id >= PROTO_V2) ? PROTO_V2 : PROTO_V1;
+            }
+            if (proto_push(&p2, wire[i], &f) && f.cmd == CMD_WRITE_MULTI) {
+                v2_frames++;
+                v2_rx = now;
+            }
+        }
+    }
+    CHECK_EQ(lookalikes, 500);
+    CHECK_EQ(v2_frames, 500);
+    CHECK_EQ(link_version, PROTO_V2);
+
+    /* Master restarted: v2 goes quiet, its v1 HELLO is taken after BAUD_SILENCE_MS */
+    CHECK(!proto_hello_allowed(PROTO_V2, BAUD_SILENCE_MS - 1u, BAUD_SILENCE_MS));
+    CHECK(proto_hello_allowed(PROTO_V2, BAUD_SILENCE_MS, BAUD_SILENCE_MS));
+    CHECK(proto_hello_allowed(PROTO_V1, 0, BAUD_SILENCE_MS));
+    CHECK_EQ(feed(&p1, hello, h, &f), 1);
+    CHECK(f.cmd == CMD_HELLO && f.var_id == PROTO_V2);
+}
+
+int main(void) {
+    test_roundtrip();
+    test_bit_flips();
+    test_drops_and_truncation();
+    test_garbage();
+    test_v1_weakness();
+    test_mixed_framing();
+    test_hello_lookalike();
+    return TEST_END();
+}
@@ -0,0 +1,115 @@
+/*
+ * M40 register table (reg_table.h): change tracking against a plain model.
+ * reg_table_set() marks only real changes, reg_table_load() never marks,
+ * and reg_table_collect() returns every dirty register exactly once, lowest
+ * id first, across calls with a small max.
+ */
+#include "reg_table.h"
+#include "test.h"
+
+static void test_set_and_load(void) {
+    RegTable t;
+    reg_table_init(&t);
+
+    CHECK(!reg_table_set(&t, 5, 0));                // same as the initial value
+    CHECK(!reg_table_is_dirty(&t, 5));
+    CHECK(reg_table_set(&t, 5, 7));
+    CHECK(reg_table_is_dirty(&t, 5));
+    CHECK_EQ(reg_table_version(&t, 5), 1);
+    CHECK(!reg_table_set(&t, 5, 7));
+    CHECK_EQ(reg_table_version(&t, 5), 1);
+
+    /* A value from the peer is versioned but not sent back */
+    reg_table_load(&t, 6, 9);
+    CHECK_EQ(reg_table_get(&t, 6), 9);
+    CHECK_EQ(reg_table_version(&t, 6), 1);
+    CHECK(!reg_table_is_dirty(&t, 6));
+    reg_table_load(&t, 6, 9);
+    CHECK_EQ(reg_table_version(&t, 6), 1);
+
+    /* A later local store of the loaded value is no change either */
+    CHECK(!reg_table_set(&t, 6, 9));
+    CHECK(!reg_table_is_dirty(&t, 6));
+
+    reg_table_touch(&t, 6);
+    CHECK(reg_table_is_dirty(&t, 6));
+}
+
+static void test_collect_order_and_limit(void) {
+    static const uint8_t ids[] = { 0, 1, 31, 32, 33, 63, 64, 128, 200, 255 };
+    RegTable t;
+    ProtoPair out[4];
+    reg_table_init(&t);
+    for (unsigned i = 0; i < sizeof(ids); i++) reg_table_set(&t, ids[i], (uint16_t)(1000u + ids[i]));
+
+    unsigned seen = 0;
+    uint8_t n;
+    while ((n = reg_table_collect(&t, out, 4)) != 0) {
+        CHECK(n <= 4);
+        for (uint8_t i = 0; i < n; i++, seen++) {
+            CHECK_EQ(out[i].var_id, ids[seen]);
+            CHECK_EQ(out[i].value, 1000u + ids[seen]);
+        }
+    }
+    CHECK_EQ(seen, sizeof(ids));
+    for (unsigned i = 0; i < sizeof(ids); i++) CHECK(!reg_table_is_dirty(&t, ids[i]));
+    CHECK_EQ(reg_table_collect(&t, out, 4), 0);
+}
+
+/* Random sets, loads and partial collects against a dirty/value model */
+static void test_random_model(void) {
+    RegTable t;
+    uint16_t value[REG_COUNT] = { 0 }, version[REG_COUNT] = { 0 };
+    bool dirty[REG_COUNT] = { false };
+    uint32_t seed = 0x1234567u;
+    ProtoPair out[PROTO_MAX_PAIRS];
+    reg_table_init(&t);
+
+    for (int round = 0; round < 20000; round++) {
+        uint32_t r = test_rand(&seed);
+        uint8_t id = (uint8_t)r;
+        uint16_t v = (uint16_t)((r >> 8) & 3u);     // few values: many no-change stores
+
+        switch ((r >> 16) % 4u) {
+        case 0:
+        case 1: {
+            bool changed = reg_table_set(&t, id, v);
+            CHECK_EQ(changed, value[id] != v);
+            if (changed) { value[id] = v; version[id]++; dirty[id] = true; }
+            break;
+        }
+        case 2:
+            reg_table_load(&t, id, v);
+            if (value[id] != v) { value[id] = v; version[id]++; }
+            break;
+        default: {
+            uint8_t max = (uint8_t)(1u + (r >> 24) % PROTO_MAX_PAIRS);
+            uint8_t n = reg_table_collect(&t, out, max);
+            int prev = -1;
+            for (uint8_t i = 0; i < n; i++) {
+                CHECK(out[i].var_id > prev);
+                CHECK(dirty[out[i].var_id]);
+                CHECK_EQ(out[i].value, value[out[i].var_id]);
+                dirty[out[i].var_id] = false;
+                prev = out[i].var_id;
+            }
+            /* Nothing dirty was skipped below the last id returned */
+            for (int k = 0; k < prev; k++) CHECK(!dirty[k]);
+            if (n < max) for (int k = 0; k < (int)REG_COUNT; k++) CHECK(!dirty[k]);
+            break;
+        }
+        }
+    }
+    for (int k = 0; k < (int)REG_COUNT; k++) {
+        CHECK_EQ(reg_table_get(&t, (uint8_t)k), value[k]);
+        CHECK_EQ(reg_table_version(&t, (uint8_t)k), version[k]);
+        CHECK_EQ(reg_table_is_dirty(&t, (uint8_t)k), dirty[k]);
+    }
+}
+
+int main(void) {
+    test_set_and_load();
+    test_collect_order_and_limit();
+    test_random_model();
+    return TEST_END();
+}
@@ -0,0 +1,180 @@
+/*
+ * SPSC ring buffer: bulk and span calls against a byte-at-a-time model,
+ * 16-bit index wraparound, and a two-thread producer/consumer run.
+ * Built once against each board's header (RB_HEADER, see Makefile).
+ */
+#include RB_HEADER
+#include "test.h"
+#include <pthread.h>
+
+#define SIZE 64u
+
+static void test_basic(void) {
+    uint8_t storage[SIZE] = { 0 }, b = 0;
+    RingBuffer rb;
+    rb_init(&rb, storage, SIZE);
+
+    CHECK_EQ(rb_count(&rb), 0);
+    CHECK_EQ(rb_space(&rb), SIZE);
+    CHECK(!rb_get(&rb, &b));
+    for (unsigned i = 0; i < SIZE; i++) CHECK(rb_put(&rb, (uint8_t)i));
+    CHECK(!rb_put(&rb, 0xAA));                  // full: all SIZE slots usable
+    CHECK_EQ(rb_space(&rb), 0);
+    CHECK(rb_get(&rb, &b));
+    CHECK_EQ(b, 0);
+    CHECK_EQ(rb_count(&rb), SIZE - 1);
+}
+
+static void test_bulk_wrap(void) {
+    uint8_t storage[SIZE], src[SIZE], dst[SIZE];
+    RingBuffer rb;
+    rb_init(&rb, storage, SIZE);
+    for (unsigned i = 0; i < SIZE; i++) src[i] = (uint8_t)(0x80 + i);
+
+    /* Move the indices near the end so the next write splits in two */
+    CHECK_EQ(rb_write_n(&rb, src, 50), 50);
+    CHECK_EQ(rb_read_n(&rb, dst, 50), 50);
+    CHECK_EQ(rb_write_n(&rb, src, 40), 40);     // 14 at the end, 26 at the start
+    CHECK_EQ(rb_write_n(&rb, src, 40), SIZE - 40);  // clipped to the free space
+    CHECK_EQ(rb_read_n(&rb, dst, SIZE), SIZE);
+    CHECK(memcmp(dst, src, 40) == 0);
+    CHECK(memcmp(dst + 40, src, SIZE - 40) == 0);
+    CHECK_EQ(rb_read_n(&rb, dst, 1), 0);
+    CHECK_EQ(rb_write_n(&rb, src, 0), 0);
+
+    /* Consumer span stops at the physical end; the rest follows after commit */
+    const uint8_t *span;
+    CHECK_EQ(rb_write_n(&rb, src, 30), 30);     // tail 114 (idx 50), head 144 (idx 16)
+    CHECK_EQ(rb_peek_contiguous(&rb, &span), 14);
+    CHECK(span == &storage[50]);
+    CHECK(memcmp(span, src, 14) == 0);
+    rb_commit(&rb, 10);
+    CHECK_EQ(rb_count(&rb), 20);
+
+    /* Producer span */
+    uint8_t *w;
+    uint16_t run = rb_reserve_contiguous(&rb, &w);
+    CHECK_EQ(run, SIZE - 20);                   // limited by free space, not by the end
+    CHECK(w == &storage[16]);
+    w[0] = 0x55;
+    rb_produce(&rb, 1);
+    CHECK_EQ(rb_count(&rb), 21);
+}
+
+/* Random mix of every call against a plain FIFO model; the 16-bit indices wrap many times */
+static void test_model(uint16_t size) {
+    static uint8_t storage[1024];
+    uint8_t model[1024], tmp[1024];
+    unsigned mhead = 0, mtail = 0;             // model indices, unbounded
+    uint8_t next_in = 0;
+    uint32_t seed = 12345u + size;
+    RingBuffer rb;
+    rb_init(&rb, storage, size);
+
+    for (int step = 0; step < 200000; step++) {
+        uint16_t want = (uint16_t)(test_rand(&seed) % (size + 8u));
+        uint16_t n;
+        switch (test_rand(&seed) % 6) {
+        case 0: {                                // rb_put
+            bool ok = rb_put(&rb, next_in);
+            CHECK_EQ(ok, mhead - mtail < size);
+            if (ok) model[mhead++ % 1024] = next_in++;
+            break;
+        }
+        case 1: {                                // rb_get
+            uint8_t b;
+            bool ok = rb_get(&rb, &b);
+            CHECK_EQ(ok, mhead != mtail);
+            if (ok) CHECK_EQ(b, model[mtail++ % 1024]);
+            break;
+        }
+        case 2:                                  // rb_write_n
+            for (uint16_t i = 0; i < want; i++) tmp[i] = (uint8_t)(next_in + i);
+            n = rb_write_n(&rb, tmp, want);
+            CHECK_EQ(n, want < size - (mhead - mtail) ? want : size - (mhead - mtail));
+            for (uint16_t i = 0; i < n; i++) model[mhead++ % 1024] = next_in++;
+            break;
+        case 3:                                  // rb_read_n
+            n = rb_read_n(&rb, tmp, want);
+            CHECK_EQ(n, want < mhead - mtail ? want : mhead - mtail);
+            for (uint16_t i = 0; i < n; i++) CHECK_EQ(tmp[i], model[mtail++ % 1024]);
+            break;
+        case 4: {                                // peek + partial commit
+            const uint8_t *span;
+            n = rb_peek_contiguous(&rb, &span);
+            CHECK(n <= mhead - mtail);
+            if (n) n = (uint16_t)(1 + test_rand(&seed) % n);
+            for (uint16_t i = 0; i < n; i++) CHECK_EQ(span[i], model[(mtail + i) % 1024]);
+            rb_commit(&rb, n);
+            mtail += n;
+            break;
+        }
+        default: {                               // reserve + partial produce
+            uint8_t *span;
+            n = rb_reserve_contiguous(&rb, &span);
+            CHECK(n <= size - (mhead - mtail));
+            if (n) n = (uint16_t)(1 + test_rand(&seed) % n);
+            for (uint16_t i = 0; i < n; i++) { span[i] = next_in; model[mhead++ % 1024] = next_in++; }
+            rb_produce(&rb, n);
+            break;
+        }
+        }
+        CHECK_EQ(rb_count(&rb), mhead - mtail);
+        if (test_failures) return;              // one divergence is enough output
+    }
+    CHECK(mhead > 70000u);                      // indices went through 16-bit wrap
+}
+
+/* Producer and consumer on separate threads, as ISR and task on the target */
+#define STREAM_BYTES (1024u * 1024u)
+static RingBuffer s_rb;
+
+/* Let the other side run, also on a single-CPU host */
+static void pause_thread(void) {
+    struct timespec ts = { 0, 1000 };
+    nanosleep(&ts, NULL);
+}
+static uint8_t s_storage[256];
+
+static void *producer(void *arg) {
+    uint8_t chunk[48];
+    uint32_t seq = 0, seed = 7;
+    (void)arg;
+    while (seq < STREAM_BYTES) {
+        uint16_t want = (uint16_t)(1 + test_rand(&seed) % sizeof(chunk));
+        if (want > STREAM_BYTES - seq) want = (uint16_t)(STREAM_BYTES - seq);
+        for (uint16_t i = 0; i < want; i++) chunk[i] = (uint8_t)((seq + i) * 31u);
+        uint16_t n = rb_write_n(&s_rb, chunk, want);
+        if (n == 0) pause_thread();             // full
+        seq += n;
+    }
+    return NULL;
+}
+
+static void test_threads(void) {
+    pthread_t t;
+    uint32_t seq = 0, bad = 0;
+    rb_init(&s_rb, s_storage, sizeof(s_storage));
+    pthread_create(&t, NULL, producer, NULL);
+    while (seq < STREAM_BYTES) {
+        const uint8_t *span;
+        uint16_t n = rb_peek_contiguous(&s_rb, &span);
+        if (n == 0) pause_thread();             // empty
+        for (uint16_t i = 0; i < n; i++)
+            if (span[i] != (uint8_t)((seq + i) * 31u)) bad++;
+        rb_commit(&s_rb, n);
+        seq += n;
+    }
+    pthread_join(t, NULL);
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(rb_count(&s_rb), 0);
+}
+
+int main(void) {
+    test_basic();
+    test_bulk_wrap();
+    test_model(64);
+    test_model(256);
+    test_threads();
+    return TEST_END();
+}
@@ -0,0 +1,145 @@
+/*
+ * Sample numbering of the F4 input oversampling (sample_ring.h): the
+ * number of samples each circular DMA stream has written, from its NDTR
+ * and the TIM5 update count; the minimum across streams; and the reader's
+ * lap recovery. A simulated TIM8 starts one sample per tick and every
+ * stream finishes it with its own lag; the reader drains after random
+ * gaps, some longer than a buffer, and checks every sample it reads.
+ */
+#include "sample_ring.h"
+#include "test.h"
+
+#define DEPTH       64u
+#define STREAMS     5u
+#define MARGIN      4u
+
+typedef struct {
+    uint32_t ticks;                     // TIM5: samples started
+    uint32_t written[STREAMS];          // samples each stream has finished
+    uint32_t buf[STREAMS][DEPTH];       // sample number stored at each index
+} SimDma;
+
+/* NDTR as the stream shows it: DEPTH after a reload, 0 for an instant before */
+static uint32_t sim_ndtr(const SimDma *s, uint32_t p, uint32_t *seed) {
+    uint32_t head = s->written[p] % DEPTH;
+    if (head == 0 && (test_rand(seed) & 1u)) return 0;
+    return DEPTH - head;
+}
+
+/* TIM8 update: sample `ticks` starts; streams finish it now or one tick later */
+static void sim_tick(SimDma *s, uint32_t *seed) {
+    for (uint32_t p = 0; p < STREAMS; p++)
+        if (s->written[p] != s->ticks && (test_rand(seed) & 3u)) {  // finish the previous one
+            s->buf[p][s->written[p] % DEPTH] = s->written[p];
+            s->written[p]++;
+        }
+    for (uint32_t p = 0; p < STREAMS; p++)
+        if (s->written[p] != s->ticks) {       // at most one sample behind the update
+            s->buf[p][s->written[p] % DEPTH] = s->written[p];
+            s->written[p]++;
+        }
+    s->ticks++;
+    for (uint32_t p = 0; p < STREAMS; p++)
+        if (test_rand(seed) & 1u) {            // this stream's request is serviced at once
+            s->buf[p][s->written[p] % DEPTH] = s->written[p];
+            s->written[p]++;
+        }
+}
+
+static uint32_t sim_min_written(const SimDma *s) {
+    uint32_t m = s->written[0];
+    for (uint32_t p = 1; p < STREAMS; p++)
+        if ((int32_t)(s->written[p] - m) < 0) m = s->written[p];
+    return m;
+}
+
+static void sim_init(SimDma *s, uint32_t start) {
+    s->ticks = start;
+    for (uint32_t p = 0; p < STREAMS; p++) s->written[p] = start;
+}
+
+/* Every stream one sample behind, level with, or one ahead of TIM5 */
+static void test_stream_count(void) {
+    unsigned mismatches = 0;
+    static const uint32_t starts[] = { 0, 1000, 0xFFFFFFF0u };
+    for (unsigned k = 0; k < sizeof(starts) / sizeof(starts[0]); k++) {
+        for (uint32_t t = starts[k]; t != starts[k] + 4u * DEPTH; t++) {
+            for (int32_t lag = -1; lag <= 1; lag++) {
+                uint32_t w = t + (uint32_t)lag;
+                uint32_t ndtr = DEPTH - w % DEPTH;
+                if (sring_stream_written(t, ndtr, DEPTH) != w) mismatches++;
+                if (w % DEPTH == 0 && sring_stream_written(t, 0, DEPTH) != w) mismatches++;
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+
+    /* The slowest stream bounds what is complete, across the 32-bit wrap */
+    uint32_t ndtr[3] = { DEPTH - 1u, DEPTH, DEPTH - 1u };      // written 1, 0 (= 2^32), 1
+    CHECK_EQ(sring_written(0u, ndtr, 3, DEPTH), 0u);
+    CHECK_EQ(sring_written(0u, ndtr, 1, DEPTH), 1u);
+    ndtr[1] = 1;                                                // written 2^32 - 1
+    CHECK_EQ(sring_written(0u, ndtr, 3, DEPTH), 0xFFFFFFFFu);
+    ndtr[0] = ndtr[2] = DEPTH;                                  // written 2^32, one ahead of TIM5
+    CHECK_EQ(sring_written(0xFFFFFFFFu, ndtr, 3, DEPTH), 0xFFFFFFFFu);
+}
+
+static void test_lap_limits(void) {
+    CHECK(!sring_lapped(100, 100, DEPTH, MARGIN));                      // nothing new
+    CHECK(!sring_lapped(100 + DEPTH - MARGIN, 100, DEPTH, MARGIN));
+    CHECK(sring_lapped(101 + DEPTH - MARGIN, 100, DEPTH, MARGIN));
+    CHECK(sring_lapped(100 + DEPTH, 100, DEPTH, MARGIN));               // exact lap: head == tail
+    CHECK(sring_lapped(99, 100, DEPTH, MARGIN));                        // count went backwards
+    CHECK(!sring_lapped(5, 0xFFFFFFFEu, DEPTH, MARGIN));                // across the wrap
+    CHECK_EQ(sring_index(0xFFFFFFFFu, DEPTH), DEPTH - 1u);
+    CHECK_EQ(sring_index(3u * DEPTH, DEPTH), 0u);
+}
+
+/*
+ * The reader of input_dma.c: read all NDTRs, then TIM5, take the slowest
+ * stream's count, resync on a lap, else read every sample up to it. Each
+ * sample read must carry its own number in every stream.
+ */
+static void test_reader(uint32_t start) {
+    static SimDma s;
+    uint32_t seed = 0x5A17u ^ start;
+    uint32_t next = start, laps = 0, read = 0;
+    unsigned count_errors = 0, data_errors = 0, missed_laps = 0;
+    sim_init(&s, start);
+
+    for (int round = 0; round < 20000; round++) {
+        uint32_t r = test_rand(&seed);
+        uint32_t gap = (r & 15u) == 0 ? (r >> 8) % (3u * DEPTH) : (r >> 8) % 24u;
+        for (uint32_t i = 0; i < gap; i++) sim_tick(&s, &seed);
+
+        uint32_t ndtr[STREAMS];
+        for (uint32_t p = 0; p < STREAMS; p++) ndtr[p] = sim_ndtr(&s, p, &seed);
+        uint32_t written = sring_written(s.ticks, ndtr, STREAMS, DEPTH);
+        if (written != sim_min_written(&s)) count_errors++;
+
+        if (sring_lapped(written, next, DEPTH, MARGIN)) {
+            laps++;
+            next = written - 1u;
+        } else if (written - next > DEPTH) {
+            missed_laps++;
+        }
+        /* A few more samples may land while the block is read */
+        for (uint32_t i = 0; i < (r >> 28) % MARGIN; i++) sim_tick(&s, &seed);
+        for (; next != written; next++, read++)
+            for (uint32_t p = 0; p < STREAMS; p++)
+                if (s.buf[p][sring_index(next, DEPTH)] != next) data_errors++;
+    }
+    CHECK_EQ(count_errors, 0);
+    CHECK_EQ(data_errors, 0);
+    CHECK_EQ(missed_laps, 0);
+    CHECK(laps > 100);                  // the long gaps did lap the reader
+    CHECK(read > 100000);
+}
+
+int main(void) {
+    test_stream_count();
+    test_lap_limits();
+    test_reader(0);
+    test_reader(0xFFFF0000u);           // TIM5 and the sample numbers wrap
+    return TEST_END();
+}
@@ -0,0 +1,279 @@
+#!/usr/bin/env python3
+"""Decode the housekeeping board's binary telemetry stream (USB command STREAM ON).
+
+Records are framed as 0x00 COBS(type seq t_us payload CRC16) 0x00, see
+firmware/IPOS_Housekeeping_V1_00_211125/Core/Inc/telemetry.h.
+
+    telemetry_decode.py capture.bin            text, one line per record
+    telemetry_decode.py --csv capture.bin      CSV: t_us,seq,type,field,value
+    telemetry_decode.py COM7 | /dev/ttyACM0     read a serial port (pyserial)
+    telemetry_decode.py --elf IPOS.elf ...      also format FLOG() entries
+
+The same framing carries the flash log sent by `LOG BIN` (LOGREC records,
+one line per stored record), with or without STREAM ON.
+
+FLOG() entries (fmtlog.h) carry only a format ID and raw argument words; the
+format strings live in the ELF's non-loaded .ipos_fmt section, so pass the
+ELF of the running firmware to turn them back into text.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+# InputName order (inputs.h)
+INPUT_NAMES = [
+    "DOOR", "DOOR_LATCH_ERR", "ESTOP", "ESTOP_LATCH_ERR", "KEY", "KEY_LATCH_ERR",
+    "BDO", "BDO_LATCH_ERR", "RELAY1_ON", "RELAY2_ON", "RELAY_LATCH_ERR", "NO1", "NC1",
+    "12V_PWR_GOOD", "24V_PWR_GOOD", "12V_FUSE_GOOD", "TRU_LAS_DEACTIVATED",
+    "TRU_SYS_FAULT", "TRU_BEAM_DELIVERY", "TRU_EMISS_WARN", "TRU_ALARM",
+    "TRU_MONITOR", "TRU_TEMPERATURE",
+]
+
+REC_INPUTS, REC_STATUS, REC_THERMO, REC_LOG, REC_TEXT, REC_FMT, REC_LOGDUMP = 1, 2, 3, 4, 5, 6, 7
+TYPE_NAMES = {REC_INPUTS: "INPUTS", REC_STATUS: "STATUS", REC_THERMO: "THERMO",
+              REC_LOG: "LOG", REC_TEXT: "TEXT", REC_FMT: "FLOG", REC_LOGDUMP: "LOGREC"}
+
+# LogRec (log_flash.h): seq, ms, code, flags, msg[20], commit
+LOGREC = struct.Struct("<IIHH20sB")
+
+# FMTLOG_LVL_* (fmtlog.h)
+LEVEL_NAMES = ["", "FATAL", "ERROR", "WARNING", "INFO", "DEBUG"]
+
+
+class Elf:
+    """Just enough of an ELF reader for FLOG(): .ipos_fmt and loaded strings."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        is64 = data[4] == 2
+        end = "<" if data[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(end + "Q", data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", data, 0x3A)
+            shdr = end + "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(end + "I", data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", data, 0x2E)
+            shdr = end + "IIIIIIIIII"
+        secs = [struct.unpack_from(shdr, data, shoff + i * shentsize) for i in range(shnum)]
+        names = secs[shstrndx]
+        self.fmt = b""
+        self.loaded = []        # (addr, bytes) of allocated PROGBITS sections
+        for name, stype, flags, addr, off, size in (s[:6] for s in secs):
+            n = data[names[4] + name:data.index(b"\0", names[4] + name)].decode()
+            if n == ".ipos_fmt":
+                self.fmt = data[off:off + size]
+            elif stype == 1 and flags & 2:      # SHT_PROGBITS, SHF_ALLOC
+                self.loaded.append((addr, data[off:off + size]))
+
+    def cstr(self, blob, off):
+        end = blob.find(b"\0", off)
+        return blob[off:end if end >= 0 else len(blob)].decode("ascii", "replace")
+
+    def format(self, fid):
+        return self.cstr(self.fmt, fid) if fid < len(self.fmt) else None
+
+    def string(self, addr):
+        for base, blob in self.loaded:
+            if base <= addr < base + len(blob):
+                return self.cstr(blob, addr - base)
+        return "<0x%08X>" % addr
+
+
+ELF = None
+CONV = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t)?([diouxXeEfFgGcsp%])")
+
+
+def flog_text(fmt, words):
+    """printf-style formatting of 32-bit argument words, as the target would."""
+    args = iter(words)
+
+    def conv(m):
+        flags, c = m.group(1), m.group(2)
+        if c == "%":
+            return "%"
+        w = next(args, 0)
+        if c in "di":
+            return ("%" + flags + "d") % (w - (1 << 32) if w & 0x80000000 else w)
+        if c in "eEfFgG":
+            return ("%" + flags + c) % struct.unpack("<f", struct.pack("<I", w))[0]
+        if c == "s":
+            return ("%" + flags + "s") % ELF.string(w)
+        if c == "p":
+            return "0x%08X" % w
+        if c == "c":
+            return chr(w & 0xFF)
+        return ("%" + flags + c.replace("u", "d")) % w
+
+    return CONV.sub(conv, fmt)
+
+
+def flog_entries(p):
+    """FMT record payload -> list of (tick_ms, text)."""
+    out = []
+    words = struct.unpack_from("<%uI" % (len(p) // 4), p)
+    i = 0
+    while i + 2 <= len(words):
+        hdr, tick = words[i], words[i + 1]
+        fid, n, lvl = hdr & 0xFFFFF, (hdr >> 20) & 0xF, (hdr >> 24) & 0xF
+        argv = words[i + 2:i + 2 + n]
+        i += 2 + n
+        fmt = ELF.format(fid) if ELF else None
+        if fmt is None:
+            text = "fmt#%u %s" % (fid, " ".join("0x%08X" % a for a in argv))
+        else:
+            text = flog_text(fmt, argv).rstrip("\r\n")
+        if 0 < lvl < len(LEVEL_NAMES):
+            text = "%s %s" % (LEVEL_NAMES[lvl], text)
+        out.append((tick, text))
+    return out
+
+
+def crc16(data):
+    """CRC-16/MODBUS, as crc16() in protocol.c."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def cobs_decode(block):
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        if code == 0 or i + code > len(block):
+            return None
+        out += block[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+def frames(stream):
+    """Yield decoded, CRC-checked records; count anything else as bad."""
+    buf = bytearray()
+    frames.bad = 0
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        for b in chunk:
+            if b != 0:
+                buf.append(b)
+                continue
+            if buf:
+                raw = cobs_decode(bytes(buf))
+                if raw and len(raw) >= 8 and crc16(raw[:-2]) == struct.unpack_from("<H", raw, len(raw) - 2)[0]:
+                    yield raw[:-2]
+                else:
+                    frames.bad += 1
+                buf.clear()
+
+
+def thermo_c(raw):
+    """MAX31855 word -> (fault flag, fault bits, thermocouple degC, cold junction degC)."""
+    tc = (raw >> 18) & 0x3FFF
+    if tc & 0x2000:
+        tc -= 0x4000
+    cj = (raw >> 4) & 0x0FFF
+    if cj & 0x0800:
+        cj -= 0x1000
+    return (raw >> 16) & 1, raw & 7, tc * 0.25, cj * 0.0625
+
+
+def fields(rtype, p):
+    """Payload -> list of (field, value)."""
+    if rtype == REC_INPUTS:
+        bits, = struct.unpack_from("<I", p)
+        return [(name, (bits >> i) & 1) for i, name in enumerate(INPUT_NAMES)]
+    if rtype == REC_STATUS:
+        dbg, dbg2, act = struct.unpack_from("<HHH", p)
+        return [("debug", "0x%04X" % dbg), ("debug2", "0x%04X" % dbg2), ("active", "0x%04X" % act)]
+    if rtype == REC_THERMO:
+        raw, rng = struct.unpack_from("<IB", p)
+        flag, fault, tc, cj = thermo_c(raw)
+        if flag:
+            return [("fault", "0x%02X" % fault)]
+        return [("tc_c", "%.2f" % tc), ("cj_c", "%.4f" % cj), ("range_fault", rng)]
+    if rtype == REC_LOG:
+        code, flags = struct.unpack_from("<HB", p)
+        return [("code", code), ("flags", flags), ("msg", p[3:].decode("ascii", "replace"))]
+    if rtype == REC_TEXT:
+        return [("text", p.decode("ascii", "replace").rstrip("\r\n"))]
+    if rtype == REC_FMT:
+        return [("flog", "%u ms %s" % e) for e in flog_entries(p)]
+    if rtype == REC_LOGDUMP:
+        out = []
+        for seq, ms, code, flags, msg, _ in LOGREC.iter_unpack(p[:len(p) - len(p) % LOGREC.size]):
+            text = msg.split(b"\0")[0].decode("ascii", "replace")
+            out.append(("rec", "#%u t=%u code=%u flags=0x%X msg=%s" % (seq, ms, code, flags, text)))
+        return out or [("end", "end of log")]
+    return [("raw", p.hex())]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("source", help="capture file, '-' for stdin, or a serial port")
+    ap.add_argument("--csv", action="store_true", help="one CSV row per field")
+    ap.add_argument("--baud", type=int, default=115200, help="serial rate (ignored by CDC)")
+    ap.add_argument("--elf", help="firmware ELF, to format FLOG() entries")
+    args = ap.parse_args()
+
+    global ELF
+    if args.elf:
+        ELF = Elf(args.elf)
+
+    if args.source == "-":
+        stream = sys.stdin.buffer
+    else:
+        try:
+            stream = open(args.source, "rb")
+        except OSError:
+            import serial  # pyserial, only needed for live ports
+            stream = serial.Serial(args.source, args.baud, timeout=None)
+
+    if args.csv:
+        print("t_us,seq,type,field,value")
+    expect = None
+    lost = 0
+    try:
+        for rec in frames(stream):
+            rtype, seq, t_us = struct.unpack_from("<BBI", rec)
+            if expect is not None and seq != expect:
+                lost += (seq - expect) & 0xFF
+            expect = (seq + 1) & 0xFF
+            name = TYPE_NAMES.get(rtype, "TYPE%u" % rtype)
+            fl = fields(rtype, rec[6:])
+            if args.csv:
+                for f, v in fl:
+                    v = str(v)
+                    if "," in v or '"' in v:
+                        v = '"' + v.replace('"', '""') + '"'
+                    print("%u,%u,%s,%s,%s" % (t_us, seq, name, f, v))
+            elif rtype == REC_TEXT:
+                print("%10.6f  %s" % (t_us / 1e6, fl[0][1]))
+            elif rtype in (REC_FMT, REC_LOGDUMP):
+                for f, v in fl:       # tick = board uptime, not stream time
+                    print("%10.6f  %-7s %s" % (t_us / 1e6, name, v))
+            elif rtype == REC_INPUTS:
+                on = [f for f, v in fl if v]
+                print("%10.6f  INPUTS  %s" % (t_us / 1e6, " ".join(on) or "-"))
+            else:
+                print("%10.6f  %-7s %s" % (t_us / 1e6, name, " ".join("%s=%s" % fv for fv in fl)))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    print("# records lost: %u, bad frames: %u" % (lost, frames.bad), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()